@@ -64,15 +64,30 @@
 #include "devinfoservice.h"
 #include "glucservice.h"
 
+#include "board.h"
 #include "board_key.h"
 #include "utc_clock.h"
 
 #include "glucose.h"
+#include "glucose_store.h"
+#include "glucose_gen.h"
 
 /*********************************************************************
  * MACROS
  */
 
+// Whether a send failed for lack of buffers and should be retried.
+#define GLUCOSE_SEND_BUSY(status)     (((status) == bleMemAllocError)     || \
+                                       ((status) == MSG_BUFFER_NOT_AVAIL) || \
+                                       ((status) == bleNoResources)       || \
+                                       ((status) == blePending))
+
+// Whether a session has a record or report left to send.
+#define GLUCOSE_SESSION_ACTIVE(pSession)  ((pSession)->sendRsp     || \
+                                           (pSession)->sendMeas    || \
+                                           (pSession)->sendContext || \
+                                           (pSession)->sendAll)
+
 /*********************************************************************
  * CONSTANTS
  */
@@ -116,29 +131,66 @@
 // Default GAP bonding I/O capabilities
 #define DEFAULT_IO_CAPABILITIES               GAPBOND_IO_CAP_DISPLAY_ONLY //GAPBOND_IO_CAP_NO_INPUT_NO_OUTPUT
 
-// Notification period in ms
+// Report retry period in ms, used if connection events are unavailable
 #define DEFAULT_NOTI_PERIOD                   100
 
+// Notifications a report may queue per connection event. A control point
+// response waits behind no more than these.
+#define GLUCOSE_NOTI_PER_CONN_EVT             6
+
 // Delay (in ms) after connection establishment before sending a parameter update requst
 #define GLUCOSE_SEND_PARAM_UPDATE_DELAY           6000
 
 // How often to read current current RPA (in ms)
 #define GLUCOSE_READ_RPA_EVT_PERIOD               3000
 
-// Meas state bit field
-#define GLUCOSE_MEAS_STATE_VALID              0x01
-#define GLUCOSE_MEAS_STATE_FILTER_PASS        0x02
-#define GLUCOSE_MEAS_STATE_ALL                (GLUCOSE_MEAS_STATE_VALID | GLUCOSE_MEAS_STATE_FILTER_PASS)
+// NVS region holding the glucose record log
+#define GLUCOSE_STORE_NVS_INDEX               Board_NVSINTERNAL
+
+// Delay (in ms) between erases of deleted record log sectors, done while
+// no report is in progress
+#define GLUCOSE_COMPACT_PERIOD                50
+
+// Record transfer over an L2CAP connection-oriented channel. Once a
+// collector opens a channel on this PSM, reports are sent as SDUs packing
+// whole records. Each record is its measurement length, its context length
+// (0 if none), then the measurement and context as sent over GATT.
+#define GLUCOSE_COC_PSM                       0x0080
+
+// Maximum SDU size received from and sent to the collector
+#define GLUCOSE_COC_MTU                       252
+
+// Credits given to the collector, and the count at which to give more
+#define GLUCOSE_COC_PEER_CREDITS              4
+#define GLUCOSE_COC_PEER_CREDIT_THRESHOLD     1
+
+// Size of a record in a channel SDU
+#define GLUCOSE_COC_REC_LEN(pRec)             (2 + (pRec)->measLen + \
+                                               (pRec)->contextLen)
 
 // Some values used to simulate measurements
-#define MEAS_IDX_MAX                          sizeof(glucoseMeasArray)/sizeof(glucoseMeas_t)
+#define SEED_REC_MAX                          sizeof(glucoseSeedMeas)/sizeof(glucoseMeas_t)
 
 // Maximum number of dynamically allocated measurements
-// (must be less than MEAS_IDX_MAX)
+// (must be less than SEED_REC_MAX)
 #define DYNAMIC_REC_MAX                       1
 
-#define GLUCOSE_MEAS_LEN                      17
-#define GLUCOSE_CONTEXT_LEN                   17
+// Number of synthetic records to fill an empty store with in place of the
+// sample records, to exercise record access with a full log (0 for none)
+#ifndef GLUCOSE_GEN_NUM_RECORDS
+#define GLUCOSE_GEN_NUM_RECORDS               0
+#endif
+
+// Seconds between synthetic record timestamps
+#define GLUCOSE_GEN_PERIOD                    300
+
+// Every nth synthetic record has a context (0 for none)
+#define GLUCOSE_GEN_CONTEXT_EVERY             2
+
+// Every nth synthetic record is deleted, leaving a gap in the sequence
+// numbers (0 for none)
+#define GLUCOSE_GEN_GAP_EVERY                 10
+
 #define GLUCOSE_CTL_PNT_LEN                   4
 
 // Task configuration
@@ -160,10 +212,12 @@
 #define GLUCOSE_ICALL_EVT                     ICALL_MSG_EVENT_ID // Event_Id_31
 #define GLUCOSE_QUEUE_EVT                     UTIL_QUEUE_EVENT_ID // Event_Id_30
 #define GLUCOSE_NOTI_TIMEOUT_EVT              Event_Id_00
+#define GLUCOSE_COMPACT_EVT                   Event_Id_01
 
 #define GLUCOSE_ALL_EVENTS                    (GLUCOSE_ICALL_EVT        | \
                                                GLUCOSE_QUEUE_EVT        | \
-                                               GLUCOSE_NOTI_TIMEOUT_EVT)
+                                               GLUCOSE_NOTI_TIMEOUT_EVT | \
+                                               GLUCOSE_COMPACT_EVT)
 
 #define AUTO_PHY_UPDATE            0xFF
 
@@ -185,8 +239,9 @@ typedef struct
 
 typedef struct
 {
-    uint8_t *pVal; // pointer to value.
-    uint8_t len;   // value length.
+    uint16_t connHandle; // connection the event occurred on.
+    uint8_t *pVal;       // pointer to value.
+    uint8_t len;         // value length.
 } glucoseServEvt_t;
 
 typedef struct
@@ -208,36 +263,6 @@ typedef struct
     uint8_t data[];
 } glucoseClockEventData_t;
 
-// Data in a glucose measurement as defined in the profile.
-typedef struct
-{
-    uint8_t state;
-    uint8_t flags;
-    uint16_t seqNum;
-    UTCTimeStruct baseTime;
-    int16 timeOffset;
-    uint16_t concentration;
-    uint8_t typeSampleLocation;
-    uint16_t sensorStatus;
-} glucoseMeas_t;
-
-// Context data as defined in profile.
-typedef struct
-{
-    uint8_t flags;
-    uint16_t seqNum;
-    uint8_t extendedFlags;
-    uint8_t carboId;
-    uint16_t carboVal;
-    uint8_t mealVal;
-    uint8_t TesterHealthVal;
-    uint16_t exerciseDuration;
-    uint8_t exerciseIntensity;
-    uint8_t medId;
-    uint16_t medVal;
-    uint16_t HbA1cVal;
-} glucoseContext_t;
-
 typedef enum
 {
     NOT_REGISTER = 0,
@@ -254,6 +279,27 @@ typedef struct
     uint16_t connHandle;
 } glucoseConnHandleEntry_t;
 
+// Record control point session of a connection
+typedef struct
+{
+    glucoseStoreFilter_t filter;     // Filter of the report in progress
+    glucoseStoreWire_t rec;          // Encoded record being sent
+    uint32_t recId;                  // Record store ID of rec (0 if none)
+    bool sendAll;                    // Report in progress
+    bool sendMeas;                   // rec's measurement waits to be sent
+    bool sendContext;                // rec's context waits to be sent
+    bool resumePending;              // Waiting for a connection event
+    uint8_t numQueued;               // Notifications this connection event
+    bool sendRsp;                    // Control point response waits
+    uint8_t rspOpcode;               // Opcode of the waiting response
+    uint8_t rspCode;                 // Status of the waiting response
+    uint16_t cocCID;                 // L2CAP channel for reports (0 if none)
+    uint16_t cocMtu;                 // Largest SDU the channel takes
+    bool cocBusy;                    // SDU being sent on the channel
+    glucoseStoreWire_t cocRec;       // First record of the SDU being sent
+    uint32_t cocRecId;               // Record store ID of cocRec
+} glucoseSession_t;
+
 // Connected device information
 typedef struct
 {
@@ -268,6 +314,7 @@ typedef struct
     uint8_t rqPhy;
     uint8_t phyRqFailCnt;                      // PHY change request count
     bool isAutoPHYEnable;                   // Flag to indicate auto phy change
+    glucoseSession_t session;               // Record control point session
 } glucoseConnRec_t;
 
 /*********************************************************************
@@ -301,6 +348,7 @@ static ICall_SyncHandle syncEvent;
 
 // Clock instances for internal periodic events.
 static Clock_Struct notiTimeoutClock;
+static Clock_Struct compactClock;
 
 // Queue object used for app messages
 static Queue_Struct appMsgQueue;
@@ -369,15 +417,6 @@ static uint8_t attDeviceName[GAP_DEVICE_NAME_LEN] = "Glucose Sensor";
 // Bonded peer address.
 static uint8_t glucoseBondedAddr[B_ADDR_LEN];
 
-// GAP connection handle.
-static uint16_t gapConnHandle;
-
-// Set to true if context should be sent with measurement data.
-static bool glucoseSendContext = false;
-
-// If true, then send all valid and selected glucose measurements.
-bool glucoseSendAllRecords = false;
-
 // Advertising handles
 static uint8 advHandleLegacy;
 static uint8 advHandleLongRange;
@@ -387,18 +426,17 @@ static bool isAdvertising = FALSE;
 // Connection state
 static bool isConnected = FALSE;
 
-// For the example application we have hard coded glucose measurements.
+// For the example application the record store is seeded with hard coded
+// glucose measurements. Sequence numbers are assigned by the store.
 // Note dates are in UTC time; day and month start at 0.
-static glucoseMeas_t glucoseMeasArray[] = {
+static const glucoseMeas_t glucoseSeedMeas[] = {
 //Meas 1
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL,   //mol/L
           1, { 14, 17, 23, 22, 1, 2013 }, 0, 0xC050, // 0.008 (8.0 mmol)
           (GLUCOSE_LOCATION_FINGER | GLUCOSE_TYPE_CAPILLARY_WHOLE), 0 },
         //Meas 2
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL,   //mol/L
           2, { 6, 0, 0, 2, 1, 2012 }, 0,                      // Time offset
           0xC03C,                 // 0.006
@@ -406,56 +444,49 @@ static glucoseMeas_t glucoseMeasArray[] = {
         },
         //Meas 3
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL,                              //mol/L
           3, { 11, 23, 0, 5, 2, 2012 }, 0, 0xC037,                // 5.5 mmol/L
           (GLUCOSE_LOCATION_EARLOBE | GLUCOSE_TYPE_VENOUS_WHOLE), 0x5555 },
         // Time offset +1 hr
         //Meas 4
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL,                              //mol/L
           4, { 12, 2, 0, 14, 1, 2011 }, 60, 0xB165,  // 3.57 mmol /L
           (GLUCOSE_LOCATION_CONTROL | GLUCOSE_TYPE_VENOUS_PLASMA), 0xAAAA },
         //Meas 5
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL,                              //mol/L
           5, { 13, 5, 12, 12, 1, 2011 }, 60, 0xB1F6, // 5.02 mmol /L
           (GLUCOSE_LOCATION_NOT_AVAIL | GLUCOSE_TYPE_ARTERIAL_WHOLE), 0xA5A5 },
         //Meas 6
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,   //kg/L
           6, { 7, 15, 0, 5, 2, 2011 }, 60, 0xB07E, // 126 mg/dl
           (GLUCOSE_LOCATION_FINGER | GLUCOSE_TYPE_ARTERIAL_PLASMA), 0x5A5A },
         // Time offset -2 hrs
         //Meas 7
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,   //kg/L
           7, { 9, 4, 0, 14, 4, 2011 }, -120, 0xB064,    // 100 mg/dl
           (GLUCOSE_LOCATION_FINGER | GLUCOSE_TYPE_UNDETER_WHOLE), 0x55AA },
         //Meas 8
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,    //kg/L
           8, { 0, 0, 0, 1, 1, 2013 }, -120, 0xB05A,  // 90 mg/dl
           (GLUCOSE_LOCATION_AST | GLUCOSE_TYPE_UNDETER_PLASMA), 0xAA55 },
         //Meas 9
         {
-        GLUCOSE_MEAS_STATE_ALL,
           GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,    //kg/L
           9, { 12, 0, 0, 5, 2, 2013 }, -120, 0xB048, // 72 mg/dl
           (GLUCOSE_LOCATION_EARLOBE | GLUCOSE_TYPE_ISF), 0x1111 }, };
 
 // Each measurement entry must have a corresponding context, it is only sent
 // based on the flag in the measurement, but it must exist for this app.
-static glucoseContext_t glucoseContextArray[] = {
+static const glucoseContext_t glucoseSeedContext[] = {
 //Context 1
         {
         GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-          1, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           9,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -465,7 +496,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 2
         {
         GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-          2, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           10,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -475,7 +506,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 3
         {
         GLUCOSE_CONTEXT_FLAG_ALL, //L
-          3, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           10,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -485,7 +516,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 4
         {
         GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-          4, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           10,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -495,7 +526,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 5
         {
         GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-          5, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           10,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -505,7 +536,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 6
         {
         GLUCOSE_CONTEXT_FLAG_ALL, //L
-          6, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           10,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -515,7 +546,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 7
         {
         GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-          7, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           10,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -525,7 +556,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 8
         {
         GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-          8, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           11,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -535,7 +566,7 @@ static glucoseContext_t glucoseContextArray[] = {
         //Context 9
         {
         GLUCOSE_CONTEXT_FLAG_ALL, //L
-          9, 0,
+          0,
           GLUCOSE_CARBO_BREAKFAST,
           12,
           GLUCOSE_MEAL_PREPRANDIAL,
@@ -546,10 +577,8 @@ static glucoseContext_t glucoseContextArray[] = {
 // GAP connected device address.
 static uint8_t connDeviceAddr[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 
-// initial index of measurement/context.
-static uint8_t glucoseMeasIdx = 0;
-
-static uint16_t seqNum = MEAS_IDX_MAX;
+// Record store ID of the record last sent with the key (0 if none).
+static uint32_t glucoseKeyRecId = 0;
 
 /*********************************************************************
  * LOCAL FUNCTIONS
@@ -568,7 +597,7 @@ static void GlucoseSensor_processGattMsg(gattMsgEvent_t *pMsg);
 static void GlucoseSensor_processAppMsg(glucoseEvt_t *pMsg);
 static bool GlucoseSensor_toggleAdvertising(void);
 static uint8_t GlucoseSensor_addConn(uint16_t connHandle);
-static void GlucoseSensor_contextSend(void);
+static bStatus_t GlucoseSensor_contextSend(glucoseConnRec_t *pConn);
 static uint8_t GlucoseSensor_clearConnListEntry(uint16_t connHandle);
 static status_t GlucoseSensor_stopAutoPhyChange(uint16_t connHandle);
 
@@ -576,53 +605,50 @@ static status_t GlucoseSensor_stopAutoPhyChange(uint16_t connHandle);
 static void GlucoseSensor_updateRPA(void);
 #endif // PRIVACY_1_2_CFG
 
-static void GlucoseSensor_ctlPntHandleOpcode(uint8_t opcode, uint8_t oper,
+static void GlucoseSensor_ctlPntHandleOpcode(uint16_t connHandle,
+                                             uint8_t opcode, uint8_t oper,
                                              uint8_t filterType, void *param1,
                                              void *param2);
-static void GlucoseSensor_ctlPntRsp(uint8_t rspCode, uint8_t opcode);
-static void GlucoseSensor_ctlPntNumRecRsp(uint16_t numRecords);
-static void GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
-                                         uint8_t value0, uint8_t value1);
-static uint8_t GlucoseSensor_filterRecords(uint8_t oper, uint8_t filterType,
-                                           void *param1, void *param2, bool set,
-                                           uint8_t mask, uint8_t opcode);
-static uint8_t GlucoseSensor_findNumValidRecords(void);
-static uint8_t GlucoseSensor_findFirstValidFilteredIdx(uint8_t startIndex);
-static uint8_t GlucoseSensor_markFirstValidRec(bool setBits, uint8_t mask);
-static uint8_t GlucoseSensor_markLastValidRec(bool setBits, uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecords(bool setBits, uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanSeqNum(uint16_t *pSeqNum,
-                                                             bool set,
-                                                             uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsLaterThanSeqNum(uint16_t *pSeqNum,
-                                                           bool set,
-                                                           uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsInRangeSeqNum(uint16_t *pSeqNum1,
-                                                         uint16_t *pSeqNum2,
-                                                         bool set,
-                                                         uint8_t mask);
+static bStatus_t GlucoseSensor_ctlPntRsp(uint16_t connHandle, uint8_t rspCode,
+                                         uint8_t opcode);
+static void GlucoseSensor_ctlPntNumRecRsp(uint16_t connHandle,
+                                          uint16_t numRecords);
+static bStatus_t GlucoseSensor_ctlPntIndicate(uint16_t connHandle,
+                                              uint8_t opcode, uint8_t oper,
+                                              uint8_t value0, uint8_t value1);
+static bool GlucoseSensor_buildFilter(uint16_t connHandle, uint8_t oper,
+                                      uint8_t filterType, void *param1,
+                                      void *param2, uint8_t opcode,
+                                      glucoseStoreFilter_t *pFilter);
+static void GlucoseSensor_seedRecords(void);
+#if GLUCOSE_GEN_NUM_RECORDS > 0
+static void GlucoseSensor_generateRecords(uint16_t numRecords);
+#endif
 
 static uint8_t GlucoseSensor_removeConn(uint16_t connHandle);
 static uint8_t GlucoseSensor_getConnIndex(uint16_t connHandle);
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanTime(UTCTimeStruct *pTime,
-                                                           bool set,
-                                                           uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsLaterThanTime(UTCTimeStruct *pTime,
-                                                         bool set,
-                                                         uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsInRangeTime(UTCTimeStruct *pTime1,
-                                                       UTCTimeStruct *pTime2,
-                                                       bool set, uint8_t mask);
-static void GlucoseSensor_measSend(void);
-static void GlucoseSensor_processCtlPntMsg(glucoseCtlPntMsg_t *pMsg);
+static bStatus_t GlucoseSensor_measSend(glucoseConnRec_t *pConn);
+static void GlucoseSensor_processCtlPntMsg(uint16_t connHandle,
+                                           glucoseCtlPntMsg_t *pMsg);
 static void GlucoseSensor_sendNext(void);
+static bStatus_t GlucoseSensor_sendStep(glucoseConnRec_t *pConn);
+static void GlucoseSensor_stopReport(glucoseConnRec_t *pConn);
+static void GlucoseSensor_compactStore(void);
+static void GlucoseSensor_resumeOnConnEvt(glucoseConnRec_t *pConn,
+                                          bool enable);
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+static bStatus_t GlucoseSensor_cocSend(glucoseConnRec_t *pConn);
+static void GlucoseSensor_processL2capSignalEvt(l2capSignalEvent_t *pMsg);
+#endif // L2CAP_COC_CFG
 static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime);
 static void GlucoseSensor_processConnEvt(Gap_ConnEventRpt_t *pReport);
+static void GlucoseSensor_connEvtCB(Gap_ConnEventRpt_t *pReport);
 
 // Glucose service.
-static void GlucoseSensor_serviceCB(uint8_t event, uint8_t *pValue,
-                                    uint8_t len);
-static void GlucoseSensor_processServiceEvt(uint8_t event, uint8_t *pValue,
+static void GlucoseSensor_serviceCB(uint16_t connHandle, uint8_t event,
+                                    uint8_t *pValue, uint8_t len);
+static void GlucoseSensor_processServiceEvt(uint16_t connHandle,
+                                            uint8_t event, uint8_t *pValue,
                                             uint8_t len);
 
 // Passcode.
@@ -701,6 +727,25 @@ void GlucoseSensor_createTask(void)
     Task_construct(&glucoseTask, GlucoseSensor_taskFxn, &taskParams, NULL);
 }
 
+/*********************************************************************
+ * @fn      GlucoseSensor_isReportActive
+ *
+ * @brief   Check whether a record report is in progress on a connection.
+ *          Used by the glucose service to reject control point requests
+ *          that would interrupt it.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  true if a report is in progress, false otherwise
+ */
+bool GlucoseSensor_isReportActive(uint16_t connHandle)
+{
+    uint8_t connIndex = GlucoseSensor_getConnIndex(connHandle);
+
+    return (connIndex < MAX_NUM_BLE_CONNS) &&
+           connList[connIndex].session.sendAll;
+}
+
 /*********************************************************************
  * @fn      Glucose_init
  *
@@ -737,9 +782,26 @@ void GlucoseSensor_init(void)
     Util_constructClock(&notiTimeoutClock, GlucoseSensor_clockHandler,
     DEFAULT_NOTI_PERIOD,
                         0, false, GLUCOSE_NOTI_TIMEOUT_EVT);
+    Util_constructClock(&compactClock, GlucoseSensor_clockHandler,
+                        GLUCOSE_COMPACT_PERIOD, 0, false, GLUCOSE_COMPACT_EVT);
 
     Board_initKeys(GlucoseSensor_keyPressHandler);
 
+    // Open the record store; seed it with sample or synthetic records when
+    // empty.
+    if ((GlucoseStore_init(GLUCOSE_STORE_NVS_INDEX) == SUCCESS) &&
+        (GlucoseStore_getNumRecords() == 0))
+    {
+#if GLUCOSE_GEN_NUM_RECORDS > 0
+        GlucoseSensor_generateRecords(GLUCOSE_GEN_NUM_RECORDS);
+#else
+        GlucoseSensor_seedRecords();
+#endif
+    }
+
+    // Erase sectors left deleted by the last run, or of an older format.
+    Util_startClock(&compactClock);
+
     // Initialize Connection List
     GlucoseSensor_clearConnListEntry(CONNHANDLE_ALL);
 
@@ -782,6 +844,24 @@ void GlucoseSensor_init(void)
     // Register for Glucose service callback.
     Glucose_Register(GlucoseSensor_serviceCB);
 
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+    // Accept L2CAP channels for bulk record transfer.
+    {
+        l2capPsm_t psm;
+
+        psm.psm = GLUCOSE_COC_PSM;
+        psm.mtu = GLUCOSE_COC_MTU;
+        psm.initPeerCredits = GLUCOSE_COC_PEER_CREDITS;
+        psm.peerCreditThreshold = GLUCOSE_COC_PEER_CREDIT_THRESHOLD;
+        psm.maxNumChannels = MAX_NUM_BLE_CONNS;
+        psm.pfnVerifySecCB = NULL;
+        psm.taskId = ICall_getLocalMsgEntityId(ICALL_SERVICE_CLASS_BLE_MSG,
+                                               selfEntity);
+
+        VOID L2CAP_RegisterPsm(&psm);
+    }
+#endif // L2CAP_COC_CFG
+
     // Start the Bond Manager.
     GAPBondMgr_Register((gapBondCBs_t* )&glucoseBondCB);
 
@@ -843,7 +923,7 @@ static void GlucoseSensor_initPHYRSSIArray(void)
     memset(connList, 0, sizeof(connList));
     for (uint8_t index = 0; index < MAX_NUM_BLE_CONNS; index++)
     {
-        connList[index].connHandle = GLUCOSE_INVALID_HANDLE;
+        connList[index].connHandle = CONNHANDLE_INVALID;
     }
 }
 
@@ -885,6 +965,7 @@ static uint8_t GlucoseSensor_clearConnListEntry(uint16_t connHandle)
             connList[i].rssiAvg = 0;
             connList[i].rssiCntr = 0;
             connList[i].isAutoPHYEnable = FALSE;
+            memset(&connList[i].session, 0, sizeof(glucoseSession_t));
         }
     }
 
@@ -957,9 +1038,23 @@ void GlucoseSensor_taskFxn(UArg a0, UArg a1)
             // Notification timeout.
             if (events & GLUCOSE_NOTI_TIMEOUT_EVT)
             {
+                uint8_t i;
+
+                // The timeout stands in for a connection event.
+                for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
+                {
+                    connList[i].session.numQueued = 0;
+                }
+
                 // Send next notification.
                 GlucoseSensor_sendNext();
             }
+
+            // Record log compaction.
+            if (events & GLUCOSE_COMPACT_EVT)
+            {
+                GlucoseSensor_compactStore();
+            }
         }
     }
 }
@@ -986,6 +1081,17 @@ static void GlucoseSensor_processStackMsg(ICall_Hdr *pMsg)
         GlucoseSensor_processGattMsg((gattMsgEvent_t*) pMsg);
         break;
 
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+    case L2CAP_SIGNAL_EVENT:
+        GlucoseSensor_processL2capSignalEvt((l2capSignalEvent_t*) pMsg);
+        break;
+
+    case L2CAP_DATA_EVENT:
+        // Nothing is expected from the collector; drop it.
+        BM_free(((l2capDataEvent_t*) pMsg)->pkt.pPayload);
+        break;
+#endif // L2CAP_COC_CFG
+
     case HCI_GAP_EVENT_EVENT:
     {
 
@@ -1112,7 +1218,8 @@ static void GlucoseSensor_processAppMsg(glucoseEvt_t *pMsg)
     {
         glucoseServEvt_t *pEvt = (glucoseServEvt_t*) pMsg->pData;
 
-        GlucoseSensor_processServiceEvt(pMsg->hdr.state, pEvt->pVal, pEvt->len);
+        GlucoseSensor_processServiceEvt(pEvt->connHandle, pMsg->hdr.state,
+                                        pEvt->pVal, pEvt->len);
 
         ICall_free(pEvt);
     }
@@ -1291,6 +1398,7 @@ static void GlucoseSensor_processGapMessage(gapEventHdr_t *pMsg)
     {
         gapTerminateLinkEvent_t *pPkt = (gapTerminateLinkEvent_t*) pMsg;
         isConnected = FALSE;
+
         GapAdv_disable(advHandleLegacy);
         isAdvertising = FALSE;
 
@@ -1491,6 +1599,8 @@ static uint8_t GlucoseSensor_removeConn(uint16_t connHandle)
             // Free ParamUpdateEventData
             ICall_free(connList[connIndex].pParamUpdateEventData);
         }
+        // Drop any report in progress
+        GlucoseSensor_stopReport(&connList[connIndex]);
         // Clear pending update requests from paramUpdateList
         GlucoseSensor_clearPendingParamUpdate(connHandle);
         // Stop Auto PHY Change
@@ -1583,48 +1693,56 @@ static void GlucoseSensor_handleKeys(uint8_t shift, uint8_t keys)
 {
     if (keys & KEY_LEFT)
     {
-        if (!glucoseSendAllRecords)
+        uint8_t i;
+
+        // Set simulated measurement record.
+        if (GlucoseStore_getNumRecords() > 0)
         {
-            // Set simulated measurement flag index.
-            if (GlucoseSensor_findNumValidRecords() > 0)
+            glucoseStoreFilter_t filter = { .oper = CTL_PNT_OPER_ALL };
+            glucoseStoreWire_t rec;
+
+            if (!GlucoseStore_find(&filter, &glucoseKeyRecId, &rec))
             {
-                GlucoseSensor_markAllRecords(true,
-                GLUCOSE_MEAS_STATE_FILTER_PASS);
+                glucoseKeyRecId = 0;
+                GlucoseStore_find(&filter, &glucoseKeyRecId, &rec);
+            }
 
-                glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(
-                        glucoseMeasIdx + 1);
-                if (glucoseMeasIdx == MEAS_IDX_MAX)
-                {
-                    glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(0);
-                }
+            // Send it on every connection without a report in progress.
+            for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
+            {
+                glucoseSession_t *pSession = &connList[i].session;
 
-                if (isConnected)
+                if ((connList[i].connHandle != CONNHANDLE_INVALID) &&
+                    !GLUCOSE_SESSION_ACTIVE(pSession))
                 {
-                    GlucoseSensor_measSend();
+                    pSession->rec = rec;
+                    pSession->recId = glucoseKeyRecId;
+                    pSession->sendMeas = true;
                 }
             }
-            else
+
+            GlucoseSensor_sendNext();
+        }
+        else
+        {
+            glucoseRecord_t record;
+            // Populate dynamic measurement records.
+            for (i = 0; i < DYNAMIC_REC_MAX; i++)
             {
-                uint8_t i;
-                // Populate dynamic measurement records.
-                for (i = 0; i < DYNAMIC_REC_MAX; i++)
-                {
-                    glucoseMeasArray[i].state |= GLUCOSE_MEAS_STATE_VALID;
-                    glucoseMeasArray[i].seqNum = ++seqNum;
-                    glucoseContextArray[i].seqNum = seqNum;
+                record.meas = glucoseSeedMeas[i];
+                record.context = glucoseSeedContext[i];
 
-                    // Set context info follows bit.
-                    if (i % 2)
-                    {
-                        glucoseMeasArray[i].flags |=
-                        GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
-                    }
-                    else
-                    {
-                        glucoseMeasArray[i].flags &=
-                                ~GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
-                    }
+                // Set context info follows bit.
+                if (i % 2)
+                {
+                    record.meas.flags |= GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
+                }
+                else
+                {
+                    record.meas.flags &= ~GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
                 }
+
+                GlucoseStore_append(&record);
             }
         }
     }
@@ -1640,6 +1758,60 @@ static void GlucoseSensor_handleKeys(uint8_t shift, uint8_t keys)
     }
 }
 
+/*********************************************************************
+ * @fn      GlucoseSensor_seedRecords
+ *
+ * @brief   Append the sample records to the record store.
+ *
+ * @return  none
+ */
+static void GlucoseSensor_seedRecords(void)
+{
+    glucoseRecord_t record;
+    uint8_t i;
+
+    for (i = 0; i < SEED_REC_MAX; i++)
+    {
+        record.meas = glucoseSeedMeas[i];
+        record.context = glucoseSeedContext[i];
+
+        if (GlucoseStore_append(&record) != SUCCESS)
+        {
+            break;
+        }
+    }
+}
+
+#if GLUCOSE_GEN_NUM_RECORDS > 0
+/*********************************************************************
+ * @fn      GlucoseSensor_generateRecords
+ *
+ * @brief   Append synthetic records to the record store. Field values
+ *          cycle through the sample records; timestamps are
+ *          GLUCOSE_GEN_PERIOD apart, and every GLUCOSE_GEN_CONTEXT_EVERY
+ *          record has a context. Every GLUCOSE_GEN_GAP_EVERY record is
+ *          deleted again to leave a gap in the sequence numbers.
+ *
+ * @param   numRecords - number of records to append
+ *
+ * @return  none
+ */
+static void GlucoseSensor_generateRecords(uint16_t numRecords)
+{
+    glucoseGenParams_t params = { .pMeas = glucoseSeedMeas,
+                                  .pContext = glucoseSeedContext,
+                                  .numTemplates = SEED_REC_MAX,
+                                  .period = GLUCOSE_GEN_PERIOD,
+                                  .contextEvery = GLUCOSE_GEN_CONTEXT_EVERY,
+                                  .gapEvery = GLUCOSE_GEN_GAP_EVERY };
+    UTCTimeStruct startTime = glucoseSeedMeas[0].baseTime;
+
+    params.startTime = UTC_convertUTCSecs(&startTime);
+
+    GlucoseGen_fill(&params, numRecords);
+}
+#endif // GLUCOSE_GEN_NUM_RECORDS
+
 /*********************************************************************
  * @fn      GlucoseSensor_toggleAdvertising
  *
@@ -1669,1143 +1841,981 @@ static bool GlucoseSensor_toggleAdvertising(void)
 /*********************************************************************
  * @fn      GlucoseSensor_sendNext
  *
- * @brief   Send next notification.
+ * @brief   Queue pending notifications until the stack runs out of
+ *          buffers or a connection uses up its share of the connection
+ *          event, then resume on a later connection event. Connections
+ *          with a report in progress take turns one PDU at a time, so
+ *          concurrent reports share the buffers fairly and none waits for
+ *          another to finish. A report's success response is queued only
+ *          behind its last record, so it is delivered after it.
  *
  * @return  none
  */
 static void GlucoseSensor_sendNext(void)
 {
-    if (glucoseSendContext)
-    {
-        glucoseSendContext = false;
-        GlucoseSensor_contextSend();
-    }
-    else if (glucoseSendAllRecords)
+    bool stalled[MAX_NUM_BLE_CONNS] = { false };
+    bool active;
+    uint8_t i;
+
+    do
     {
-        glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(
-                glucoseMeasIdx + 1);
+        active = false;
 
-        if (glucoseMeasIdx == MEAS_IDX_MAX)
+        for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
         {
-            glucoseMeasIdx = 0;
-            glucoseSendAllRecords = false;
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, CTL_PNT_OP_REQ);
+            if ((connList[i].connHandle != CONNHANDLE_INVALID) &&
+                !stalled[i] && GLUCOSE_SESSION_ACTIVE(&connList[i].session))
+            {
+                stalled[i] = GLUCOSE_SEND_BUSY(
+                        GlucoseSensor_sendStep(&connList[i]));
+                active = true;
+            }
         }
-        else
+    } while (active);
+
+    // A session waiting for its SDU to go out is resumed by the channel's
+    // done or terminated event, not by a connection event.
+    for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
+    {
+        if (connList[i].connHandle != CONNHANDLE_INVALID)
         {
-            GlucoseSensor_measSend();
+            GlucoseSensor_resumeOnConnEvt(&connList[i],
+                                          stalled[i] &&
+                                          !connList[i].session.cocBusy);
         }
     }
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_processCtlPntMsg
+ * @fn      GlucoseSensor_compactStore
  *
- * @brief   Process Control Point messages.
+ * @brief   Erase one deleted sector of the record log, and schedule the
+ *          next one. Erases wait while any connection has a report in
+ *          progress, as flash can't be read during an erase.
  *
  * @return  none
  */
-static void GlucoseSensor_processCtlPntMsg(glucoseCtlPntMsg_t *pMsg)
+static void GlucoseSensor_compactStore(void)
 {
-    uint8_t opcode = pMsg->data[0];
-    uint8_t oper = pMsg->data[1];
-    UTCTimeStruct time1, time2;
-    bool opcodeValid = true;
-    uint16_t seqNum1, seqNum2;
+    uint8_t i;
 
-    switch (opcode)
+    for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
     {
-    case CTL_PNT_OP_REQ:
-    case CTL_PNT_OP_CLR:
-    case CTL_PNT_OP_GET_NUM:
-        if (oper == CTL_PNT_OPER_NULL)
+        if ((connList[i].connHandle != CONNHANDLE_INVALID) &&
+            GLUCOSE_SESSION_ACTIVE(&connList[i].session))
         {
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_INVALID, opcode);
-            opcodeValid = false;
+            Util_startClock(&compactClock);
+            return;
         }
-        break;
+    }
 
-    case CTL_PNT_OP_ABORT:
-        if (oper != CTL_PNT_OPER_NULL)
+    if (GlucoseStore_compact())
+    {
+        Util_startClock(&compactClock);
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseSensor_sendStep
+ *
+ * @brief   Send the next PDU of a connection's session: a waiting
+ *          control point response, the current record's measurement, then
+ *          its context, then the next record of the report, or the
+ *          report's success response.
+ *
+ * @param   pConn - connection to send on
+ *
+ * @return  status of the send, SUCCESS if only the report advanced
+ */
+static bStatus_t GlucoseSensor_sendStep(glucoseConnRec_t *pConn)
+{
+    glucoseSession_t *pSession = &pConn->session;
+    bStatus_t status = SUCCESS;
+
+    if (pSession->sendRsp)
+    {
+        // A control point response goes ahead of any record.
+        status = GlucoseSensor_ctlPntRsp(pConn->connHandle, pSession->rspCode,
+                                         pSession->rspOpcode);
+        pSession->sendRsp = GLUCOSE_SEND_BUSY(status);
+    }
+    else if (pSession->sendMeas)
+    {
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+        if (pSession->sendAll && (pSession->cocCID != 0))
         {
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_INVALID, opcode);
-            opcodeValid = false;
+            return GlucoseSensor_cocSend(pConn);
         }
-        break;
+#endif // L2CAP_COC_CFG
 
-    default:
-        GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPCODE_NOT_SUPPORTED, opcode);
-        opcodeValid = false;
-        break;
+        status = GlucoseSensor_measSend(pConn);
+        pSession->sendMeas = GLUCOSE_SEND_BUSY(status);
     }
-
-    if (opcodeValid)
+    else if (pSession->sendContext)
     {
-        switch (oper)
+        status = GlucoseSensor_contextSend(pConn);
+        pSession->sendContext = GLUCOSE_SEND_BUSY(status);
+    }
+    else if (pSession->sendAll)
+    {
+        if (GlucoseStore_find(&pSession->filter, &pSession->recId,
+                              &pSession->rec))
         {
-        case CTL_PNT_OPER_NULL:
-        case CTL_PNT_OPER_ALL:
-        case CTL_PNT_OPER_FIRST:
-        case CTL_PNT_OPER_LAST:
-            if (pMsg->len == 2)
-            {
-                GlucoseSensor_ctlPntHandleOpcode(opcode, oper, 0, NULL, NULL);
-            }
-            else
-            {
-                // No operand should exist, but msg is longer than 2 bytes.
-                GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPERAND_INVALID, opcode);
-            }
-            break;
-
-        case CTL_PNT_OPER_RANGE:
-            // Check filter type.
-            if (pMsg->data[2] == CTL_PNT_FILTER_SEQNUM && pMsg->len == 7)
-            {
-                seqNum1 = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
-                seqNum2 = BUILD_UINT16(pMsg->data[5], pMsg->data[6]);
-
-                if (seqNum1 <= seqNum2)
-                {
-                    GlucoseSensor_ctlPntHandleOpcode(opcode, oper,
-                                                     pMsg->data[2], &seqNum1,
-                                                     &seqNum2);
-                }
-                else
-                {
-                    GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPERAND_INVALID,
-                                            opcode);
-                }
-            }
-            else if (pMsg->data[2] == CTL_PNT_FILTER_TIME && pMsg->len == 17)
-            {
-                time1.year = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
-                time1.month = pMsg->data[5];
-                time1.day = pMsg->data[6];
-                time1.hour = pMsg->data[7];
-                time1.minutes = pMsg->data[8];
-                time1.seconds = pMsg->data[9];
-
-                time2.year = BUILD_UINT16(pMsg->data[10], pMsg->data[11]);
-                time2.month = pMsg->data[12];
-                time2.day = pMsg->data[13];
-                time2.hour = pMsg->data[14];
-                time2.minutes = pMsg->data[15];
-                time2.seconds = pMsg->data[16];
-
-                GlucoseSensor_ctlPntHandleOpcode(opcode, oper, pMsg->data[2],
-                                                 &time1, &time2);
-            }
-            else
-            {
-                GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPERAND_INVALID, opcode);
-            }
-            break;
-
-        case CTL_PNT_OPER_LESS_EQUAL:
-        case CTL_PNT_OPER_GREATER_EQUAL:
-            // Check filter type.
-            if (pMsg->data[2] == CTL_PNT_FILTER_SEQNUM && pMsg->len == 5)
-            {
-                seqNum1 = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
-
-                GlucoseSensor_ctlPntHandleOpcode(opcode, oper, pMsg->data[2],
-                                                 &seqNum1, NULL);
-            }
-            else if (pMsg->data[2] == CTL_PNT_FILTER_TIME && pMsg->len == 10)
-            {
-                time1.year = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
-                time1.month = pMsg->data[5];
-                time1.day = pMsg->data[6];
-                time1.hour = pMsg->data[7];
-                time1.minutes = pMsg->data[8];
-                time1.seconds = pMsg->data[9];
-
-                GlucoseSensor_ctlPntHandleOpcode(opcode, oper, pMsg->data[2],
-                                                 &time1, NULL);
-            }
-            else
+            pSession->sendMeas = true;
+        }
+        else if (pSession->cocBusy)
+        {
+            // Complete the report only after its last SDU is out.
+            status = blePending;
+        }
+        else
+        {
+            status = GlucoseSensor_ctlPntRsp(pConn->connHandle,
+                                             CTL_PNT_RSP_SUCCESS,
+                                             CTL_PNT_OP_REQ);
+            if (!GLUCOSE_SEND_BUSY(status))
             {
-                GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_FILTER_NOT_SUPPORTED,
-                                        opcode);
+                pSession->recId = 0;
+                pSession->sendAll = false;
             }
-            break;
-
-        default:
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_NOT_SUPPORTED, opcode);
-            break;
         }
     }
+
+    return status;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_pairStateCB
+ * @fn      GlucoseSensor_stopReport
  *
- * @brief   Pairing state callback.
+ * @brief   Drop a connection's report and record in progress.
+ *
+ * @param   pConn - connection of the session
  *
  * @return  none
  */
-static void GlucoseSensor_pairStateCB(uint16_t connHandle, uint8_t state,
-                                      uint8_t status)
+static void GlucoseSensor_stopReport(glucoseConnRec_t *pConn)
 {
-    uint8_t *pData;
-
-    if ((pData = ICall_malloc(sizeof(uint8_t))))
-    {
-        *pData = status;
+    pConn->session.sendAll = false;
+    pConn->session.sendMeas = false;
+    pConn->session.sendContext = false;
 
-        GlucoseSensor_enqueueMsg(GLUCOSE_PAIRING_EVT, state, pData);
-    }
+    // Stop waiting to resume the report.
+    GlucoseSensor_resumeOnConnEvt(pConn, false);
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_processPairStateEvt
+ * @fn      GlucoseSensor_resumeOnConnEvt
  *
- * @brief   Pairing state callback event processor.
+ * @brief   Register or unregister for a connection's event reports, used
+ *          to resume a send that stalled for lack of buffers. If reports
+ *          can't be registered the notification timer retries instead.
+ *
+ * @param   pConn - connection of the stalled session
+ * @param   enable - true to resume on the next connection event
  *
  * @return  none
  */
-static void GlucoseSensor_processPairStateEvt(uint8_t state, uint8_t status)
+static void GlucoseSensor_resumeOnConnEvt(glucoseConnRec_t *pConn,
+                                          bool enable)
 {
-    if (state == GAPBOND_PAIRING_STATE_COMPLETE)
+    if (enable && !pConn->session.resumePending)
     {
-        if (status == SUCCESS)
+        if (Gap_RegisterConnEventCb(GlucoseSensor_connEvtCB, GAP_CB_REGISTER,
+                                    pConn->connHandle) == SUCCESS)
         {
-            // Store the address of the bonded address.
-            memcpy(glucoseBondedAddr, connDeviceAddr, B_ADDR_LEN);
+            pConn->session.resumePending = true;
+        }
+        else
+        {
+            Util_startClock(&notiTimeoutClock);
         }
     }
+    else if (!enable && pConn->session.resumePending)
+    {
+        Gap_RegisterConnEventCb(NULL, GAP_CB_UNREGISTER, pConn->connHandle);
+        pConn->session.resumePending = false;
+    }
 }
 
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
 /*********************************************************************
- * @fn      GlucoseSensor_passcodeCB
+ * @fn      GlucoseSensor_cocSend
  *
- * @brief   Passcode callback.
+ * @brief   Send the current record of a report, and as many of the
+ *          records that follow as fit, in one SDU on the session's L2CAP
+ *          channel. Only one SDU is sent at a time; the next goes once
+ *          the stack reports this one done.
  *
- * @return  none
+ * @param   pConn - connection to send on
+ *
+ * @return  SUCCESS, blePending while an SDU is being sent,
+ *          bleMemAllocError if no buffer is available, or the status of
+ *          the send
  */
-static void GlucoseSensor_passcodeCB(uint8_t *deviceAddr, uint16_t connHandle,
-                                     uint8_t uiInputs, uint8_t uiOutputs)
+static bStatus_t GlucoseSensor_cocSend(glucoseConnRec_t *pConn)
 {
-    uint16_t *pData;
+    glucoseSession_t *pSession = &pConn->session;
+    l2capPacket_t pkt;
+    bStatus_t status;
 
-    if ((pData = ICall_malloc(sizeof(uint16_t))))
+    if (pSession->cocBusy)
     {
-        *pData = connHandle;
+        return blePending;
+    }
 
-        GlucoseSensor_enqueueMsg(GLUCOSE_PASSCODE_EVT, 0, (uint8_t*) pData);
+    pkt.pPayload = L2CAP_bm_alloc(pSession->cocMtu);
+    if (pkt.pPayload == NULL)
+    {
+        return bleMemAllocError;
     }
-}
 
-/*********************************************************************
- * @fn      GlucoseSensor_advCallback
- *
- * @brief   GapAdv module callback
- *
- * @param   pMsg - message to process
- */
-static void GlucoseSensor_advCallback(uint32_t event, void *pBuf, uintptr_t arg)
-{
-    glucoseGapAdvEventData_t *pData = ICall_malloc(
-            sizeof(glucoseGapAdvEventData_t));
+    pkt.CID = pSession->cocCID;
+    pkt.len = 0;
 
-    if (pData)
+    // Remember where the SDU starts, to send it again if it's lost.
+    pSession->cocRec = pSession->rec;
+    pSession->cocRecId = pSession->recId;
+
+    // Pack records until the next one doesn't fit or the report is done.
+    do
     {
-        pData->event = event;
-        pData->pBuf = pBuf;
+        pkt.pPayload[pkt.len++] = pSession->rec.measLen;
+        pkt.pPayload[pkt.len++] = pSession->rec.contextLen;
+        memcpy(&pkt.pPayload[pkt.len], pSession->rec.meas,
+               pSession->rec.measLen);
+        pkt.len += pSession->rec.measLen;
+        memcpy(&pkt.pPayload[pkt.len], pSession->rec.context,
+               pSession->rec.contextLen);
+        pkt.len += pSession->rec.contextLen;
 
-        if (GlucoseSensor_enqueueMsg(GLUCOSE_ADV_EVT, NULL,
-                                     (uint8_t*) (pData)) != SUCCESS)
+        pSession->sendMeas = GlucoseStore_find(&pSession->filter,
+                                               &pSession->recId,
+                                               &pSession->rec);
+    } while (pSession->sendMeas &&
+             (pkt.len + GLUCOSE_COC_REC_LEN(&pSession->rec) <=
+              pSession->cocMtu));
+
+    status = L2CAP_SendSDU(&pkt);
+    if (status == SUCCESS)
+    {
+        pSession->cocBusy = true;
+    }
+    else
+    {
+        BM_free(pkt.pPayload);
+
+        // Rewind to the first record packed.
+        pSession->rec = pSession->cocRec;
+        pSession->recId = pSession->cocRecId;
+        pSession->sendMeas = true;
+
+        // Fall back to GATT if the channel can't be used.
+        if (!GLUCOSE_SEND_BUSY(status))
         {
-            ICall_free(pData);
+            pSession->cocCID = 0;
         }
     }
-}
 
-/*********************************************************************
- * @fn      GlucoseSensor_processPasscodeEvt.
- *
- * @brief   Passcode callback event processor.
- *
- * @return  none
- */
-static void GlucoseSensor_processPasscodeEvt(uint16_t connHandle)
-{
-    // This app uses a default passcode. A real-life scenario would handle all
-    // pairing scenarios and likely generate this randomly.
-    GAPBondMgr_PasscodeRsp(connHandle, SUCCESS, B_APP_DEFAULT_PASSCODE);
+    return status;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_measSend
+ * @fn      GlucoseSensor_processL2capSignalEvt
+ *
+ * @brief   Track the L2CAP channels collectors open for record transfer.
  *
- * @brief   Prepare and send a glucose measurement
+ * @param   pMsg - L2CAP signal event
  *
  * @return  none
  */
-static void GlucoseSensor_measSend(void)
+static void GlucoseSensor_processL2capSignalEvt(l2capSignalEvent_t *pMsg)
 {
-    if (glucoseMeasArray[glucoseMeasIdx].state == GLUCOSE_MEAS_STATE_ALL)
-    {
-        attHandleValueNoti_t glucoseMeas;
+    uint8_t connIndex = GlucoseSensor_getConnIndex(pMsg->connHandle);
+    glucoseSession_t *pSession;
 
-        glucoseMeas.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_NOTI,
-        GLUCOSE_MEAS_LEN,
-                                           NULL);
-        if (glucoseMeas.pValue != NULL)
-        {
-            // ATT value notification structure.
-            uint8_t *p = glucoseMeas.pValue;
-
-            uint8_t flags = glucoseMeasArray[glucoseMeasIdx].flags;
-
-            // Flags 1 byte long.
-            *p++ = flags;
-
-            // Sequence number.
-            *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].seqNum);
-            *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].seqNum);
+    if (connIndex >= MAX_NUM_BLE_CONNS)
+    {
+        return;
+    }
 
-            // Base time; convert day and month from utc time to characteristic format.
-            *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].baseTime.year);
-            *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].baseTime.year);
-            *p++ = (glucoseMeasArray[glucoseMeasIdx].baseTime.month + 1);
-            *p++ = (glucoseMeasArray[glucoseMeasIdx].baseTime.day + 1);
-            *p++ = glucoseMeasArray[glucoseMeasIdx].baseTime.hour;
-            *p++ = glucoseMeasArray[glucoseMeasIdx].baseTime.minutes;
-            *p++ = glucoseMeasArray[glucoseMeasIdx].baseTime.seconds;
+    pSession = &connList[connIndex].session;
 
-            // Time offset.
-            if (flags & GLUCOSE_MEAS_FLAG_TIME_OFFSET)
-            {
-                *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].timeOffset);
-                *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].timeOffset);
-            }
+    switch (pMsg->opcode)
+    {
+    case L2CAP_CHANNEL_ESTABLISHED_EVT:
+        // Use the channel if the collector takes at least a full record.
+        if ((pMsg->cmd.channelEstEvt.result == L2CAP_CONN_SUCCESS) &&
+            (pMsg->cmd.channelEstEvt.info.peerMtu >=
+             2 + GLUCOSE_STORE_MEAS_LEN + GLUCOSE_STORE_CONTEXT_LEN))
+        {
+            pSession->cocCID = pMsg->cmd.channelEstEvt.CID;
+            pSession->cocMtu = pMsg->cmd.channelEstEvt.info.peerMtu;
 
-            // Concentration.
-            if (flags & GLUCOSE_MEAS_FLAG_CONCENTRATION)
+            if (pSession->cocMtu > GLUCOSE_COC_MTU)
             {
-                *p++ = LO_UINT16(
-                        glucoseMeasArray[glucoseMeasIdx].concentration);
-                *p++ = HI_UINT16(
-                        glucoseMeasArray[glucoseMeasIdx].concentration);
-                *p++ = glucoseMeasArray[glucoseMeasIdx].typeSampleLocation;
+                pSession->cocMtu = GLUCOSE_COC_MTU;
             }
+        }
+        break;
 
-            if (flags & GLUCOSE_MEAS_FLAG_STATUS_ANNUNCIATION)
+    case L2CAP_CHANNEL_TERMINATED_EVT:
+        if (pMsg->cmd.channelTermEvt.CID == pSession->cocCID)
+        {
+            // The SDU being sent may be lost; a report in progress sends it
+            // again and carries on over GATT.
+            if (pSession->cocBusy && pSession->sendAll)
             {
-                *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].sensorStatus);
-                *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].sensorStatus);
+                pSession->rec = pSession->cocRec;
+                pSession->recId = pSession->cocRecId;
+                pSession->sendMeas = true;
             }
 
-            glucoseMeas.len = (uint8_t) (p - glucoseMeas.pValue);
+            pSession->cocCID = 0;
+            pSession->cocBusy = false;
+            GlucoseSensor_sendNext();
+        }
+        break;
 
-            if (flags & GLUCOSE_MEAS_FLAG_CONTEXT_INFO)
-            {
-                glucoseSendContext = true;
-            }
+    case L2CAP_SEND_SDU_DONE_EVT:
+        if (pMsg->cmd.sendSduDoneEvt.CID == pSession->cocCID)
+        {
+            pSession->cocBusy = false;
+            GlucoseSensor_sendNext();
+        }
+        break;
 
-            // Send Measurement.
-            if (Glucose_MeasSend(gapConnHandle, &glucoseMeas,
-                                 selfEntity) != SUCCESS)
-            {
-                GATT_bm_free((gattMsg_t*) &glucoseMeas, ATT_HANDLE_VALUE_NOTI);
-            }
+    case L2CAP_PEER_CREDIT_THRESHOLD_EVT:
+        L2CAP_FlowCtrlCredit(pMsg->cmd.creditEvt.CID,
+                             GLUCOSE_COC_PEER_CREDITS);
+        break;
 
-            // Start notification timer.
-            Util_startClock(&notiTimeoutClock);
-        }
+    default:
+        // Do nothing.
+        break;
     }
 }
+#endif // L2CAP_COC_CFG
 
 /*********************************************************************
- * @fn      GlucoseSensor_contextSend
+ * @fn      GlucoseSensor_processCtlPntMsg
+ *
+ * @brief   Process Control Point messages.
  *
- * @brief   Prepare and send a glucose measurement context.
+ * @param   connHandle - connection the message was written on
+ * @param   pMsg - control point message
  *
  * @return  none
  */
-static void GlucoseSensor_contextSend(void)
+static void GlucoseSensor_processCtlPntMsg(uint16_t connHandle,
+                                           glucoseCtlPntMsg_t *pMsg)
 {
-    if (glucoseMeasArray[glucoseMeasIdx].state == GLUCOSE_MEAS_STATE_ALL)
-    {
-        attHandleValueNoti_t glucoseContext;
+    uint8_t opcode = pMsg->data[0];
+    uint8_t oper = pMsg->data[1];
+    UTCTimeStruct time1, time2;
+    bool opcodeValid = true;
+    uint16_t seqNum1, seqNum2;
 
-        glucoseContext.pValue = GATT_bm_alloc(gapConnHandle,
-        ATT_HANDLE_VALUE_NOTI,
-                                              GLUCOSE_CONTEXT_LEN,
-                                              NULL);
-        if (glucoseContext.pValue != NULL)
+    switch (opcode)
+    {
+    case CTL_PNT_OP_REQ:
+    case CTL_PNT_OP_CLR:
+    case CTL_PNT_OP_GET_NUM:
+        if (oper == CTL_PNT_OPER_NULL)
         {
-            // ATT value notification structure.
-            uint8_t *p = glucoseContext.pValue;
-
-            uint8_t flags = glucoseContextArray[glucoseMeasIdx].flags;
+            GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_OPER_INVALID,
+                                    opcode);
+            opcodeValid = false;
+        }
+        break;
 
-            // Flags 1 byte long.
-            *p++ = flags;
+    case CTL_PNT_OP_ABORT:
+        if (oper != CTL_PNT_OPER_NULL)
+        {
+            GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_OPER_INVALID,
+                                    opcode);
+            opcodeValid = false;
+        }
+        break;
 
-            // Sequence number.
-            *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].seqNum);
-            *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].seqNum);
+    default:
+        GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_OPCODE_NOT_SUPPORTED,
+                                opcode);
+        opcodeValid = false;
+        break;
+    }
 
-            if (flags & GLUCOSE_CONTEXT_FLAG_EXTENDED)
+    if (opcodeValid)
+    {
+        switch (oper)
+        {
+        case CTL_PNT_OPER_NULL:
+        case CTL_PNT_OPER_ALL:
+        case CTL_PNT_OPER_FIRST:
+        case CTL_PNT_OPER_LAST:
+            if (pMsg->len == 2)
             {
-                *p++ = glucoseContextArray[glucoseMeasIdx].extendedFlags;
+                GlucoseSensor_ctlPntHandleOpcode(connHandle, opcode, oper, 0,
+                                                 NULL, NULL);
             }
-
-            if (flags & GLUCOSE_CONTEXT_FLAG_CARBO)
+            else
             {
-                *p++ = glucoseContextArray[glucoseMeasIdx].carboId;
-                *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].carboVal);
-                *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].carboVal);
+                // No operand should exist, but msg is longer than 2 bytes.
+                GlucoseSensor_ctlPntRsp(connHandle,
+                                        CTL_PNT_RSP_OPERAND_INVALID, opcode);
             }
+            break;
 
-            if (flags & GLUCOSE_CONTEXT_FLAG_MEAL)
+        case CTL_PNT_OPER_RANGE:
+            // Check filter type.
+            if (pMsg->data[2] == CTL_PNT_FILTER_SEQNUM && pMsg->len == 7)
             {
-                *p++ = glucoseContextArray[glucoseMeasIdx].mealVal;
-            }
+                seqNum1 = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
+                seqNum2 = BUILD_UINT16(pMsg->data[5], pMsg->data[6]);
 
-            if (flags & GLUCOSE_CONTEXT_FLAG_TESTER_HEALTH)
-            {
-                *p++ = glucoseContextArray[glucoseMeasIdx].TesterHealthVal;
+                if (seqNum1 <= seqNum2)
+                {
+                    GlucoseSensor_ctlPntHandleOpcode(connHandle, opcode, oper,
+                                                     pMsg->data[2], &seqNum1,
+                                                     &seqNum2);
+                }
+                else
+                {
+                    GlucoseSensor_ctlPntRsp(connHandle,
+                                            CTL_PNT_RSP_OPERAND_INVALID,
+                                            opcode);
+                }
             }
-
-            if (flags & GLUCOSE_CONTEXT_FLAG_EXERCISE)
+            else if (pMsg->data[2] == CTL_PNT_FILTER_TIME && pMsg->len == 17)
             {
-                *p++ = LO_UINT16(
-                        glucoseContextArray[glucoseMeasIdx].exerciseDuration);
-                *p++ = HI_UINT16(
-                        glucoseContextArray[glucoseMeasIdx].exerciseDuration);
-                *p++ = glucoseContextArray[glucoseMeasIdx].exerciseIntensity;
-            }
+                time1.year = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
+                time1.month = pMsg->data[5];
+                time1.day = pMsg->data[6];
+                time1.hour = pMsg->data[7];
+                time1.minutes = pMsg->data[8];
+                time1.seconds = pMsg->data[9];
 
-            if (flags & GLUCOSE_CONTEXT_FLAG_MEDICATION)
+                time2.year = BUILD_UINT16(pMsg->data[10], pMsg->data[11]);
+                time2.month = pMsg->data[12];
+                time2.day = pMsg->data[13];
+                time2.hour = pMsg->data[14];
+                time2.minutes = pMsg->data[15];
+                time2.seconds = pMsg->data[16];
+
+                GlucoseSensor_ctlPntHandleOpcode(connHandle, opcode, oper,
+                                                 pMsg->data[2], &time1,
+                                                 &time2);
+            }
+            else
             {
-                *p++ = glucoseContextArray[glucoseMeasIdx].medId;
-                *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].medVal);
-                *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].medVal);
+                GlucoseSensor_ctlPntRsp(connHandle,
+                                        CTL_PNT_RSP_OPERAND_INVALID, opcode);
             }
+            break;
 
-            if (flags & GLUCOSE_CONTEXT_FLAG_HbA1c)
+        case CTL_PNT_OPER_LESS_EQUAL:
+        case CTL_PNT_OPER_GREATER_EQUAL:
+            // Check filter type.
+            if (pMsg->data[2] == CTL_PNT_FILTER_SEQNUM && pMsg->len == 5)
             {
-                *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].HbA1cVal);
-                *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].HbA1cVal);
-            }
+                seqNum1 = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
 
-            glucoseContext.len = (uint8_t) (p - glucoseContext.pValue);
+                GlucoseSensor_ctlPntHandleOpcode(connHandle, opcode, oper,
+                                                 pMsg->data[2], &seqNum1,
+                                                 NULL);
+            }
+            else if (pMsg->data[2] == CTL_PNT_FILTER_TIME && pMsg->len == 10)
+            {
+                time1.year = BUILD_UINT16(pMsg->data[3], pMsg->data[4]);
+                time1.month = pMsg->data[5];
+                time1.day = pMsg->data[6];
+                time1.hour = pMsg->data[7];
+                time1.minutes = pMsg->data[8];
+                time1.seconds = pMsg->data[9];
 
-            // Send Measurement.
-            if (Glucose_ContextSend(gapConnHandle, &glucoseContext,
-                                    selfEntity) != SUCCESS)
+                GlucoseSensor_ctlPntHandleOpcode(connHandle, opcode, oper,
+                                                 pMsg->data[2], &time1, NULL);
+            }
+            else
             {
-                GATT_bm_free((gattMsg_t*) &glucoseContext,
-                ATT_HANDLE_VALUE_NOTI);
+                GlucoseSensor_ctlPntRsp(connHandle,
+                                        CTL_PNT_RSP_FILTER_NOT_SUPPORTED,
+                                        opcode);
             }
+            break;
 
-            // Start notification timer.
-            Util_startClock(&notiTimeoutClock);
-        }
-    }
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_ctlPntRsp
- *
- * @brief   Send a record control point response.
- *
- * @param   rspCode - the status code of the operation
- * @param   opcode - control point opcode
- *
- * @return  none
- */
-static void GlucoseSensor_ctlPntRsp(uint8_t rspCode, uint8_t opcode)
-{
-    GlucoseSensor_ctlPntIndicate(CTL_PNT_OP_REQ_RSP, CTL_PNT_OPER_NULL, opcode,
-                                 rspCode);
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_ctlPntNumRecRsp
- *
- * @brief   Send a record control point num records response.
- *
- * @param   numRecords - number of records found
- * @param   oper - operator used to filter the record list
- *
- * @return  none
- */
-static void GlucoseSensor_ctlPntNumRecRsp(uint16_t numRecords)
-{
-    GlucoseSensor_ctlPntIndicate(CTL_PNT_OP_NUM_RSP, CTL_PNT_OPER_NULL,
-                                 LO_UINT16(numRecords), HI_UINT16(numRecords));
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_ctlPntIndicate
- *
- * @brief   Send an indication containing a control point message.
- *
- * @param   opcode - opcode
- * @param   oper - operator
- * @param   value0 - first value
- * @param   value1 - second value
- *
- * @return  none
- */
-static void GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
-                                         uint8_t value0, uint8_t value1)
-{
-    attHandleValueInd_t glucoseCtlPntRsp;
-
-    glucoseCtlPntRsp.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_IND,
-    GLUCOSE_CTL_PNT_LEN,
-                                            NULL);
-    if (glucoseCtlPntRsp.pValue != NULL)
-    {
-        glucoseCtlPntRsp.len = GLUCOSE_CTL_PNT_LEN;
-        glucoseCtlPntRsp.pValue[0] = opcode;
-        glucoseCtlPntRsp.pValue[1] = oper;
-        glucoseCtlPntRsp.pValue[2] = value0;
-        glucoseCtlPntRsp.pValue[3] = value1;
-
-        // Send indication.
-        if (Glucose_CtlPntIndicate(gapConnHandle, &glucoseCtlPntRsp,
-                                   selfEntity) != SUCCESS)
-        {
-            GATT_bm_free((gattMsg_t*) &glucoseCtlPntRsp, ATT_HANDLE_VALUE_IND);
+        default:
+            GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_OPER_NOT_SUPPORTED,
+                                    opcode);
+            break;
         }
     }
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_serviceCB
- *
- * @brief   Callback function for glucose service.
+ * @fn      GlucoseSensor_pairStateCB
  *
- * @param   event - service event
+ * @brief   Pairing state callback.
  *
  * @return  none
  */
-static void GlucoseSensor_serviceCB(uint8_t event, uint8_t *valueP, uint8_t len)
+static void GlucoseSensor_pairStateCB(uint16_t connHandle, uint8_t state,
+                                      uint8_t status)
 {
-    glucoseServEvt_t *pData;
+    uint8_t *pData;
 
-    if ((pData = (glucoseServEvt_t*) ICall_malloc(sizeof(glucoseServEvt_t))))
+    if ((pData = ICall_malloc(sizeof(uint8_t))))
     {
-        if ((pData->pVal = (uint8_t*) ICall_malloc(len)))
-
-            memcpy(pData->pVal, valueP, len);
-
-        pData->len = len;
+        *pData = status;
 
-        GlucoseSensor_enqueueMsg(GLUCOSE_SERVICE_EVT, event, (uint8_t*) pData);
+        GlucoseSensor_enqueueMsg(GLUCOSE_PAIRING_EVT, state, pData);
     }
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_processServiceEvt
- *
- * @brief   Event processor for the glucose service callback function.
+ * @fn      GlucoseSensor_processPairStateEvt
  *
- * @param   event - service event
+ * @brief   Pairing state callback event processor.
  *
  * @return  none
  */
-static void GlucoseSensor_processServiceEvt(uint8_t event, uint8_t *valueP,
-                                            uint8_t len)
-{
-    switch (event)
-    {
-    // Control point command.
-    case GLUCOSE_CTL_PNT_CMD:
-    {
-        glucoseCtlPntMsg_t msg;
-
-        msg.len = len;
-
-        memcpy(msg.data, valueP, len);
-
-        // Free valueP
-        ICall_free(valueP);
-
-        // Process the control point command.
-        GlucoseSensor_processCtlPntMsg(&msg);
-    }
-        break;
-
-    default:
-        // Do nothing.
-        break;
-    }
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markAllRecords
- *
- * @brief   Set the valid/filtered flags in the measurement array.
- *
- * @param   setBits - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markAllRecords(bool setBits, uint8_t mask)
+static void GlucoseSensor_processPairStateEvt(uint8_t state, uint8_t status)
 {
-    uint8_t i;
-    uint8_t count = 0;
-
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    if (state == GAPBOND_PAIRING_STATE_COMPLETE)
     {
-        if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-        {
-            count++;
-        }
-
-        if (setBits)
-        {
-            glucoseMeasArray[i].state |= mask;
-        }
-        else
+        if (status == SUCCESS)
         {
-            glucoseMeasArray[i].state &= ~mask;
+            // Store the address of the bonded address.
+            memcpy(glucoseBondedAddr, connDeviceAddr, B_ADDR_LEN);
         }
     }
-
-    return count;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markFirstValidRec
- *
- * @brief   Set the state in the first valid record.
+ * @fn      GlucoseSensor_passcodeCB
  *
- * @param   setBits - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @brief   Passcode callback.
  *
- * @return  number of valid records set or cleared.
+ * @return  none
  */
-static uint8_t GlucoseSensor_markFirstValidRec(bool setBits, uint8_t mask)
+static void GlucoseSensor_passcodeCB(uint8_t *deviceAddr, uint16_t connHandle,
+                                     uint8_t uiInputs, uint8_t uiOutputs)
 {
-    uint8_t i;
+    uint16_t *pData;
 
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    if ((pData = ICall_malloc(sizeof(uint16_t))))
     {
-        if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-        {
-            if (setBits)
-            {
-                glucoseMeasArray[i].state |= mask;
-            }
-            else
-            {
-                glucoseMeasArray[i].state &= ~mask;
-            }
+        *pData = connHandle;
 
-            return 1;
-        }
+        GlucoseSensor_enqueueMsg(GLUCOSE_PASSCODE_EVT, 0, (uint8_t*) pData);
     }
-
-    return 0;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markLastValidRec
- *
- * @brief   Set the state in the last valid record.
+ * @fn      GlucoseSensor_advCallback
  *
- * @param   setBits - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @brief   GapAdv module callback
  *
- * @return  number of valid records set or cleared.
+ * @param   pMsg - message to process
  */
-static uint8_t GlucoseSensor_markLastValidRec(bool setBits, uint8_t mask)
+static void GlucoseSensor_advCallback(uint32_t event, void *pBuf, uintptr_t arg)
 {
-    uint8_t i;
+    glucoseGapAdvEventData_t *pData = ICall_malloc(
+            sizeof(glucoseGapAdvEventData_t));
 
-    for (i = MEAS_IDX_MAX; i > 0; i--)
+    if (pData)
     {
-        if (glucoseMeasArray[i - 1].state & GLUCOSE_MEAS_STATE_VALID)
-        {
-            if (setBits)
-            {
-                glucoseMeasArray[i - 1].state |= mask;
-            }
-            else
-            {
-                glucoseMeasArray[i - 1].state &= ~mask;
-            }
+        pData->event = event;
+        pData->pBuf = pBuf;
 
-            return 1;
+        if (GlucoseSensor_enqueueMsg(GLUCOSE_ADV_EVT, NULL,
+                                     (uint8_t*) (pData)) != SUCCESS)
+        {
+            ICall_free(pData);
         }
     }
-
-    return 0;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_verifyTime
- *
- * @brief   Verify time values are suitable for filtering.
+ * @fn      GlucoseSensor_processPasscodeEvt.
  *
- * @param   pTime - UTC time struct
+ * @brief   Passcode callback event processor.
  *
- * @return  true if time is ok, false otherwise
+ * @return  none
  */
-static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime)
+static void GlucoseSensor_processPasscodeEvt(uint16_t connHandle)
 {
-    // Sanity check year.
-    if (pTime->year < 2000 || pTime->year > 2111)
-    {
-        return false;
-    }
-    // Check day range.
-    if (pTime->day == 0 || pTime->day > 31)
-    {
-        return false;
-    }
-    // Check month range
-    if (pTime->month == 0 || pTime->month > 12)
-    {
-        return false;
-    }
-
-    // Adjust month and day; utc time uses 0-11 and 0-30,
-    // characteristic uses 1-12 and 1-31.
-    pTime->day--;
-    pTime->month--;
-
-    return true;
+    // This app uses a default passcode. A real-life scenario would handle all
+    // pairing scenarios and likely generate this randomly.
+    GAPBondMgr_PasscodeRsp(connHandle, SUCCESS, B_APP_DEFAULT_PASSCODE);
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsEarlierThanTime
+ * @fn      GlucoseSensor_measSend
  *
- * @brief   Mark all records earlier than a specific time.
+ * @brief   Send the current record's glucose measurement. Records are
+ *          stored encoded, so this is a copy.
  *
- * @param   pTime - time filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   pConn - connection to send on
  *
- * @return  number of valid records set or cleared.
+ * @return  SUCCESS, blePending if this connection event's notifications
+ *          are used up, bleMemAllocError if no buffer is available, or
+ *          the status of the send
  */
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanTime(UTCTimeStruct *pTime,
-                                                           bool set,
-                                                           uint8_t mask)
+static bStatus_t GlucoseSensor_measSend(glucoseConnRec_t *pConn)
 {
-    uint8_t i;
-    uint8_t count = 0;
-    UTCTime testTime;
+    glucoseSession_t *pSession = &pConn->session;
+    bStatus_t status = FAILURE;
 
-    if (GlucoseSensor_verifyTime(pTime) == false)
+    if (pSession->numQueued >= GLUCOSE_NOTI_PER_CONN_EVT)
     {
-        return 0;
+        status = blePending;
     }
-
-    testTime = UTC_convertUTCSecs(pTime);
-
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    else if (pSession->recId != 0)
     {
-        UTCTime recordTime = UTC_convertUTCSecs(&glucoseMeasArray[i].baseTime)
-                + glucoseMeasArray[i].timeOffset;
+        attHandleValueNoti_t glucoseMeas;
 
-        if (recordTime <= testTime)
+        glucoseMeas.pValue = GATT_bm_alloc(pConn->connHandle,
+                                           ATT_HANDLE_VALUE_NOTI,
+                                           pSession->rec.measLen, NULL);
+        if (glucoseMeas.pValue != NULL)
         {
-            if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-            {
-                count++;
-            }
+            memcpy(glucoseMeas.pValue, pSession->rec.meas,
+                   pSession->rec.measLen);
+            glucoseMeas.len = pSession->rec.measLen;
 
-            if (set)
+            // Send Measurement.
+            status = Glucose_MeasSend(pConn->connHandle, &glucoseMeas,
+                                      selfEntity);
+            if (status != SUCCESS)
             {
-                glucoseMeasArray[i].state |= mask;
+                GATT_bm_free((gattMsg_t*) &glucoseMeas, ATT_HANDLE_VALUE_NOTI);
             }
             else
             {
-                glucoseMeasArray[i].state &= ~mask;
+                pSession->numQueued++;
+                pSession->sendContext = (pSession->rec.contextLen != 0);
             }
         }
+        else
+        {
+            status = bleMemAllocError;
+        }
     }
 
-    return count;
+    return status;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsLaterThanTime
+ * @fn      GlucoseSensor_contextSend
  *
- * @brief   Mark all records later than a specific time.
+ * @brief   Send the current record's glucose measurement context.
  *
- * @param   pTime - time filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   pConn - connection to send on
  *
- * @return  number of valid records set or cleared.
+ * @return  SUCCESS, blePending if this connection event's notifications
+ *          are used up, bleMemAllocError if no buffer is available, or
+ *          the status of the send
  */
-static uint8_t GlucoseSensor_markAllRecordsLaterThanTime(UTCTimeStruct *pTime,
-                                                         bool set, uint8_t mask)
+static bStatus_t GlucoseSensor_contextSend(glucoseConnRec_t *pConn)
 {
-    uint8_t i;
-    uint8_t count = 0;
-    UTCTime testTime;
+    glucoseSession_t *pSession = &pConn->session;
+    bStatus_t status = FAILURE;
 
-    if (GlucoseSensor_verifyTime(pTime) == false)
+    if (pSession->numQueued >= GLUCOSE_NOTI_PER_CONN_EVT)
     {
-        return 0;
+        status = blePending;
     }
-
-    testTime = UTC_convertUTCSecs(pTime);
-
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    else if (pSession->recId != 0)
     {
-        UTCTime recordTime = UTC_convertUTCSecs(&glucoseMeasArray[i].baseTime)
-                + glucoseMeasArray[i].timeOffset;
+        attHandleValueNoti_t glucoseContext;
 
-        if (recordTime >= testTime)
+        glucoseContext.pValue = GATT_bm_alloc(pConn->connHandle,
+                                              ATT_HANDLE_VALUE_NOTI,
+                                              pSession->rec.contextLen,
+                                              NULL);
+        if (glucoseContext.pValue != NULL)
         {
-            if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-            {
-                count++;
-            }
+            memcpy(glucoseContext.pValue, pSession->rec.context,
+                   pSession->rec.contextLen);
+            glucoseContext.len = pSession->rec.contextLen;
 
-            if (set)
+            // Send Measurement.
+            status = Glucose_ContextSend(pConn->connHandle, &glucoseContext,
+                                         selfEntity);
+            if (status != SUCCESS)
             {
-                glucoseMeasArray[i].state |= mask;
+                GATT_bm_free((gattMsg_t*) &glucoseContext,
+                ATT_HANDLE_VALUE_NOTI);
             }
             else
             {
-                glucoseMeasArray[i].state &= ~mask;
+                pSession->numQueued++;
             }
         }
+        else
+        {
+            status = bleMemAllocError;
+        }
     }
 
-    return count;
+    return status;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsInRangeTime
+ * @fn      GlucoseSensor_ctlPntRsp
  *
- * @brief   Mark all records between two times.
+ * @brief   Send a record control point response.
  *
- * @param   pTime1 - time filter low end of range
- * @param   pTime2 - time filter high end of range
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   connHandle - connection to respond on
+ * @param   rspCode - the status code of the operation
+ * @param   opcode - control point opcode
  *
- * @return  number of valid records set or cleared.
+ * @return  status of the indication
  */
-static uint8_t GlucoseSensor_markAllRecordsInRangeTime(UTCTimeStruct *pTime1,
-                                                       UTCTimeStruct *pTime2,
-                                                       bool set, uint8_t mask)
+static bStatus_t GlucoseSensor_ctlPntRsp(uint16_t connHandle, uint8_t rspCode,
+                                         uint8_t opcode)
 {
-    uint8_t i;
-    uint8_t count = 0;
-    UTCTime lowEnd, highEnd;
-
-    if (GlucoseSensor_verifyTime(pTime1) == false)
-    {
-        return 0;
-    }
+    return GlucoseSensor_ctlPntIndicate(connHandle, CTL_PNT_OP_REQ_RSP,
+                                        CTL_PNT_OPER_NULL, opcode, rspCode);
+}
 
-    if (GlucoseSensor_verifyTime(pTime2) == false)
-    {
-        return 0;
-    }
+/*********************************************************************
+ * @fn      GlucoseSensor_ctlPntNumRecRsp
+ *
+ * @brief   Send a record control point num records response.
+ *
+ * @param   connHandle - connection to respond on
+ * @param   numRecords - number of records found
+ *
+ * @return  none
+ */
+static void GlucoseSensor_ctlPntNumRecRsp(uint16_t connHandle,
+                                          uint16_t numRecords)
+{
+    GlucoseSensor_ctlPntIndicate(connHandle, CTL_PNT_OP_NUM_RSP,
+                                 CTL_PNT_OPER_NULL, LO_UINT16(numRecords),
+                                 HI_UINT16(numRecords));
+}
 
-    lowEnd = UTC_convertUTCSecs(pTime1);
-    highEnd = UTC_convertUTCSecs(pTime2);
+/*********************************************************************
+ * @fn      GlucoseSensor_ctlPntIndicate
+ *
+ * @brief   Send an indication containing a control point message.
+ *
+ * @param   connHandle - connection to indicate on
+ * @param   opcode - opcode
+ * @param   oper - operator
+ * @param   value0 - first value
+ * @param   value1 - second value
+ *
+ * @return  SUCCESS, bleMemAllocError if no buffer is available, or the
+ *          status of the send
+ */
+static bStatus_t GlucoseSensor_ctlPntIndicate(uint16_t connHandle,
+                                              uint8_t opcode, uint8_t oper,
+                                              uint8_t value0, uint8_t value1)
+{
+    attHandleValueInd_t glucoseCtlPntRsp;
+    bStatus_t status = bleMemAllocError;
 
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    glucoseCtlPntRsp.pValue = GATT_bm_alloc(connHandle, ATT_HANDLE_VALUE_IND,
+                                            GLUCOSE_CTL_PNT_LEN, NULL);
+    if (glucoseCtlPntRsp.pValue != NULL)
     {
-        UTCTime recordTime = UTC_convertUTCSecs(&glucoseMeasArray[i].baseTime)
-                + glucoseMeasArray[i].timeOffset;
+        glucoseCtlPntRsp.len = GLUCOSE_CTL_PNT_LEN;
+        glucoseCtlPntRsp.pValue[0] = opcode;
+        glucoseCtlPntRsp.pValue[1] = oper;
+        glucoseCtlPntRsp.pValue[2] = value0;
+        glucoseCtlPntRsp.pValue[3] = value1;
 
-        if ((recordTime >= lowEnd) && (recordTime <= highEnd))
+        // Send indication.
+        status = Glucose_CtlPntIndicate(connHandle, &glucoseCtlPntRsp,
+                                        selfEntity);
+        if (status != SUCCESS)
         {
-            if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-            {
-                count++;
-            }
-
-            if (set)
-            {
-                glucoseMeasArray[i].state |= mask;
-            }
-            else
-            {
-                glucoseMeasArray[i].state &= ~mask;
-            }
+            GATT_bm_free((gattMsg_t*) &glucoseCtlPntRsp, ATT_HANDLE_VALUE_IND);
         }
     }
 
-    return count;
+    return status;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsEarlierThanSeqNum
+ * @fn      GlucoseSensor_serviceCB
  *
- * @brief   Mark all records earlier than a specific sequence number.
+ * @brief   Callback function for glucose service.
  *
- * @param   pSeqNum - filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   connHandle - connection the event occurred on
+ * @param   event - service event
  *
- * @return  number of valid records set or cleared.
+ * @return  none
  */
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanSeqNum(uint16_t *pSeqNum,
-                                                             bool set,
-                                                             uint8_t mask)
+static void GlucoseSensor_serviceCB(uint16_t connHandle, uint8_t event,
+                                    uint8_t *valueP, uint8_t len)
 {
-    uint8_t i;
-    uint8_t count = 0;
+    glucoseServEvt_t *pData;
 
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    if ((pData = (glucoseServEvt_t*) ICall_malloc(sizeof(glucoseServEvt_t))))
     {
-        if (glucoseMeasArray[i].seqNum <= *pSeqNum)
-        {
-            if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-            {
-                count++;
-            }
+        if ((pData->pVal = (uint8_t*) ICall_malloc(len)))
 
-            if (set)
-            {
-                glucoseMeasArray[i].state |= mask;
-            }
-            else
-            {
-                glucoseMeasArray[i].state &= ~mask;
-            }
-        }
-    }
+            memcpy(pData->pVal, valueP, len);
+
+        pData->connHandle = connHandle;
+        pData->len = len;
 
-    return count;
+        GlucoseSensor_enqueueMsg(GLUCOSE_SERVICE_EVT, event, (uint8_t*) pData);
+    }
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsLaterThanSeqNum
+ * @fn      GlucoseSensor_processServiceEvt
  *
- * @brief   Mark all records later than a specific sequence number.
+ * @brief   Event processor for the glucose service callback function.
  *
- * @param   pSeqNum - filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   connHandle - connection the event occurred on
+ * @param   event - service event
  *
- * @return  number of valid records set or cleared.
+ * @return  none
  */
-static uint8_t GlucoseSensor_markAllRecordsLaterThanSeqNum(uint16_t *pSeqNum,
-                                                           bool set,
-                                                           uint8_t mask)
+static void GlucoseSensor_processServiceEvt(uint16_t connHandle,
+                                            uint8_t event, uint8_t *valueP,
+                                            uint8_t len)
 {
-    uint8_t i;
-    uint8_t count = 0;
-
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    switch (event)
     {
-        if (glucoseMeasArray[i].seqNum >= *pSeqNum)
-        {
-            if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-            {
-                count++;
-            }
+    // Control point command.
+    case GLUCOSE_CTL_PNT_CMD:
+    {
+        glucoseCtlPntMsg_t msg;
 
-            if (set)
-            {
-                glucoseMeasArray[i].state |= mask;
-            }
-            else
-            {
-                glucoseMeasArray[i].state &= ~mask;
-            }
-        }
+        msg.len = len;
+
+        memcpy(msg.data, valueP, len);
+
+        // Free valueP
+        ICall_free(valueP);
+
+        // Process the control point command.
+        GlucoseSensor_processCtlPntMsg(connHandle, &msg);
     }
+        break;
 
-    return count;
+    default:
+        // Do nothing.
+        break;
+    }
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsInRangeSeqNum
+ * @fn      GlucoseSensor_verifyTime
  *
- * @brief   Mark all records between two sequence numbers.
+ * @brief   Verify time values are suitable for filtering.
  *
- * @param   pSeqNum1 - filter low end of range
- * @param   pSeqNum2 - filter high end of range
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   pTime - UTC time struct
  *
- * @return  number of valid records set or cleared.
+ * @return  true if time is ok, false otherwise
  */
-static uint8_t GlucoseSensor_markAllRecordsInRangeSeqNum(uint16_t *pSeqNum1,
-                                                         uint16_t *pSeqNum2,
-                                                         bool set, uint8_t mask)
+static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime)
 {
-    uint8_t i;
-    uint8_t count = 0;
-
-    for (i = 0; i < MEAS_IDX_MAX; i++)
+    // Sanity check year.
+    if (pTime->year < 2000 || pTime->year > 2111)
     {
-        if ((glucoseMeasArray[i].seqNum >= *pSeqNum1)
-                && (glucoseMeasArray[i].seqNum <= *pSeqNum2))
-        {
-            if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-            {
-                count++;
-            }
-
-            if (set)
-            {
-                glucoseMeasArray[i].state |= mask;
-            }
-            else
-            {
-                glucoseMeasArray[i].state &= ~mask;
-            }
-        }
+        return false;
+    }
+    // Check day range.
+    if (pTime->day == 0 || pTime->day > 31)
+    {
+        return false;
+    }
+    // Check month range
+    if (pTime->month == 0 || pTime->month > 12)
+    {
+        return false;
     }
 
-    return count;
+    // Adjust month and day; utc time uses 0-11 and 0-30,
+    // characteristic uses 1-12 and 1-31.
+    pTime->day--;
+    pTime->month--;
+
+    return true;
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_filterRecords
+ * @fn      GlucoseSensor_buildFilter
  *
- * @brief   Call the correct filter function for a particular operator.
+ * @brief   Build a record store filter for a particular operator.
  *
+ * @param   connHandle - connection to respond on if the operator is invalid
  * @param   oper - control point operator
  * @param   filterType - control point filter type
  * @param   param1 - filter (if applicable), otherwise NULL
  * @param   param2 - filter (if applicable), otherwise NULL
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
  * @param   opcode - control point opcode
+ * @param   pFilter - filter to build
  *
- * @return  number of valid records within filter times
+ * @return  true if the filter can select records, false otherwise
  */
-static uint8_t GlucoseSensor_filterRecords(uint8_t oper, uint8_t filterType,
-                                           void *param1, void *param2, bool set,
-                                           uint8_t mask, uint8_t opcode)
+static bool GlucoseSensor_buildFilter(uint16_t connHandle, uint8_t oper,
+                                      uint8_t filterType, void *param1,
+                                      void *param2, uint8_t opcode,
+                                      glucoseStoreFilter_t *pFilter)
 {
-    uint8_t numFiltered = 0;
+    pFilter->oper = oper;
+    pFilter->filterType = filterType;
 
     switch (oper)
     {
     case CTL_PNT_OPER_NULL:
-        GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_NOT_SUPPORTED, opcode);
-        break;
+        GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_OPER_NOT_SUPPORTED,
+                                opcode);
+        return false;
 
     case CTL_PNT_OPER_ALL:
-        numFiltered = GlucoseSensor_markAllRecords(set, mask);
-        break;
-
     case CTL_PNT_OPER_FIRST:
-        numFiltered = GlucoseSensor_markFirstValidRec(set, mask);
-        break;
-
     case CTL_PNT_OPER_LAST:
-        numFiltered = GlucoseSensor_markLastValidRec(set, mask);
         break;
 
     case CTL_PNT_OPER_RANGE:
-        if (filterType == CTL_PNT_FILTER_SEQNUM)
-        {
-            numFiltered = GlucoseSensor_markAllRecordsInRangeSeqNum(param1,
-                                                                    param2, set,
-                                                                    mask);
-        }
-        else
-        {
-            numFiltered = GlucoseSensor_markAllRecordsInRangeTime(param1,
-                                                                  param2, set,
-                                                                  mask);
-        }
-        break;
-
     case CTL_PNT_OPER_LESS_EQUAL:
-        if (filterType == CTL_PNT_FILTER_SEQNUM)
-        {
-            numFiltered = GlucoseSensor_markAllRecordsEarlierThanSeqNum(param1,
-                                                                        set,
-                                                                        mask);
-        }
-        else
-        {
-            numFiltered = GlucoseSensor_markAllRecordsEarlierThanTime(param1,
-                                                                      set,
-                                                                      mask);
-        }
-        break;
-
     case CTL_PNT_OPER_GREATER_EQUAL:
         if (filterType == CTL_PNT_FILTER_SEQNUM)
         {
-            numFiltered = GlucoseSensor_markAllRecordsLaterThanSeqNum(param1,
-                                                                      set,
-                                                                      mask);
+            pFilter->seqNum1 = *(uint16_t *)param1;
+
+            if (param2 != NULL)
+            {
+                pFilter->seqNum2 = *(uint16_t *)param2;
+            }
         }
         else
         {
-            numFiltered = GlucoseSensor_markAllRecordsLaterThanTime(param1, set,
-                                                                    mask);
-        }
-        break;
-
-    default:
-        GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_INVALID, opcode);
-        break;
-    }
+            if (GlucoseSensor_verifyTime(param1) == false)
+            {
+                return false;
+            }
 
-    return numFiltered;
-}
+            pFilter->time1 = UTC_convertUTCSecs(param1);
 
-/*********************************************************************
- * @fn      GlucoseSensor_findNumValidRecords
- *
- * @brief   Count number of valid records in the array.
- *
- * @return  number of valid records
- */
-static uint8_t GlucoseSensor_findNumValidRecords(void)
-{
-    uint8_t i;
-    uint8_t count = 0;
+            if (param2 != NULL)
+            {
+                if (GlucoseSensor_verifyTime(param2) == false)
+                {
+                    return false;
+                }
 
-    for (i = 0; i < MEAS_IDX_MAX; i++)
-    {
-        if (glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-        {
-            count++;
+                pFilter->time2 = UTC_convertUTCSecs(param2);
+            }
         }
-    }
-
-    return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_findFirstValidFilteredIdx
- *
- * @brief   Find the first valid entry, that also is in the last filter.
- *
- * @param   startIndex - starting index of search
- *
- * @return  index of next valid and filtered record or MEAS_IDX_MAX if none
- */
-static uint8_t GlucoseSensor_findFirstValidFilteredIdx(uint8_t startIndex)
-{
-    uint8_t i;
-
-    if (startIndex >= MEAS_IDX_MAX)
-    {
-        return MEAS_IDX_MAX;
-    }
+        break;
 
-    for (i = startIndex; i < MEAS_IDX_MAX; i++)
-    {
-        if (glucoseMeasArray[i].state == GLUCOSE_MEAS_STATE_ALL)
-        {
-            break;
-        }
+    default:
+        GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_OPER_INVALID, opcode);
+        return false;
     }
 
-    return i;
+    return true;
 }
 
 /*********************************************************************
@@ -2813,6 +2823,7 @@ static uint8_t GlucoseSensor_findFirstValidFilteredIdx(uint8_t startIndex)
  *
  * @brief   Handle control point opcodes.
  *
+ * @param   connHandle - connection the opcode was written on
  * @param   opcode - control point opcode
  * @param   oper - control point operator
  * @param   filterType - control point filter type
@@ -2821,68 +2832,87 @@ static uint8_t GlucoseSensor_findFirstValidFilteredIdx(uint8_t startIndex)
  *
  * @return  none
  */
-static void GlucoseSensor_ctlPntHandleOpcode(uint8_t opcode, uint8_t oper,
+static void GlucoseSensor_ctlPntHandleOpcode(uint16_t connHandle,
+                                             uint8_t opcode, uint8_t oper,
                                              uint8_t filterType, void *param1,
                                              void *param2)
 {
+    uint8_t connIndex = GlucoseSensor_getConnIndex(connHandle);
+    glucoseStoreFilter_t filter;
+    glucoseSession_t *pSession;
+
+    if (connIndex >= MAX_NUM_BLE_CONNS)
+    {
+        return;
+    }
+
+    pSession = &connList[connIndex].session;
+
     switch (opcode)
     {
     case CTL_PNT_OP_REQ:
-        //Clear all filter bits, before running the new test.
-        GlucoseSensor_markAllRecords(false, GLUCOSE_MEAS_STATE_FILTER_PASS);
+        pSession->recId = 0;
 
-        if (GlucoseSensor_filterRecords(oper, filterType, param1, param2, true,
-        GLUCOSE_MEAS_STATE_FILTER_PASS,
-                                        opcode) > 0)
+        if (GlucoseSensor_buildFilter(connHandle, oper, filterType, param1,
+                                      param2, opcode, &pSession->filter) &&
+            GlucoseStore_find(&pSession->filter, &pSession->recId,
+                              &pSession->rec))
         {
-            glucoseSendAllRecords = true;
-
-            glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(0);
+            pSession->sendAll = true;
+            pSession->sendMeas = true;
 
-            GlucoseSensor_measSend();
+            GlucoseSensor_sendNext();
         }
         else
         {
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_NO_RECORDS, opcode);
+            GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_NO_RECORDS, opcode);
         }
 
         break;
 
     case CTL_PNT_OP_CLR:
-        if (GlucoseSensor_filterRecords(oper, filterType, param1, param2, false,
-        GLUCOSE_MEAS_STATE_VALID,
-                                        opcode) > 0)
+        if (GlucoseSensor_buildFilter(connHandle, oper, filterType, param1,
+                                      param2, opcode, &filter) &&
+            (GlucoseStore_delete(&filter) > 0))
         {
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, opcode);
+            // The deleted sectors are erased later, in the background.
+            Util_startClock(&compactClock);
+
+            GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_SUCCESS, opcode);
         }
         else
         {
-            GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_NO_RECORDS, opcode);
+            GlucoseSensor_ctlPntRsp(connHandle, CTL_PNT_RSP_NO_RECORDS, opcode);
         }
 
         break;
 
     case CTL_PNT_OP_ABORT:
-        glucoseSendAllRecords = false;
-
-        glucoseSendContext = false;
+        // Drop the report's pending records; reports on other connections
+        // carry on. At most one connection event of notifications is
+        // queued ahead of the response, which is retried on the next
+        // event if there's no buffer for it now.
+        GlucoseSensor_stopReport(&connList[connIndex]);
 
-        //Stop notification timer.
-        Util_stopClock(&notiTimeoutClock);
+        pSession->rspOpcode = opcode;
+        pSession->rspCode = CTL_PNT_RSP_SUCCESS;
+        pSession->sendRsp = true;
 
-        GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, opcode);
+        GlucoseSensor_sendNext();
 
         break;
 
     case CTL_PNT_OP_GET_NUM:
-        // Clear all previous filter bits before running the test.
-        GlucoseSensor_markAllRecords(false, GLUCOSE_MEAS_STATE_FILTER_PASS);
-
-        GlucoseSensor_ctlPntNumRecRsp(
-                GlucoseSensor_filterRecords(oper, filterType, param1, param2,
-                true,
-                                            GLUCOSE_MEAS_STATE_FILTER_PASS,
-                                            opcode));
+        if (GlucoseSensor_buildFilter(connHandle, oper, filterType, param1,
+                                      param2, opcode, &filter))
+        {
+            GlucoseSensor_ctlPntNumRecRsp(connHandle,
+                                          GlucoseStore_count(&filter));
+        }
+        else
+        {
+            GlucoseSensor_ctlPntNumRecRsp(connHandle, 0);
+        }
         break;
 
     default:
@@ -2963,6 +2993,30 @@ static void GlucoseSensor_processConnEvt(Gap_ConnEventRpt_t *pReport)
         HCI_ReadRssiCmd(pReport->handle);
     }
 
+    // Buffers freed up during the event; resume a stalled report.
+    connList[connIndex].session.numQueued = 0;
+
+    if (connList[connIndex].session.resumePending)
+    {
+        GlucoseSensor_sendNext();
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseSensor_connEvtCB
+ *
+ * @brief   Connection event callback.
+ *
+ * @param pReport pointer to connection event report
+ */
+static void GlucoseSensor_connEvtCB(Gap_ConnEventRpt_t *pReport)
+{
+    // Enqueue the event for processing in the app context.
+    if (GlucoseSensor_enqueueMsg(GLUCOSE_CONN_EVT, 0,
+                                 (uint8_t*) pReport) == FALSE)
+    {
+        ICall_freeMsg(pReport);
+    }
 }
 
 #if defined(BLE_V42_FEATURES) && (BLE_V42_FEATURES & PRIVACY_1_2_CFG)
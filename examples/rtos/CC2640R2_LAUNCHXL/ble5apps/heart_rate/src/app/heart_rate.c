@@ -68,13 +68,21 @@
 #include "board_key.h"
 
 #include "heart_rate.h"
+#include "heart_rate_ecg.h"
 
 /*********************************************************************
  * MACROS
  */
 
-// Convert BPM to RR-Interval for data simulation purposes.
-#define HEARTRATE_BPM2RR(bpm)            ((uint16) 60 * 1024 / (uint16) (bpm))
+// Convert BPM and ms to ECG samples for data simulation purposes.
+#define HEARTRATE_BPM2SAMPLES(bpm)                                        \
+    ((uint16) (60 * HEARTRATE_ECG_SAMPLE_RATE) / (uint16) (bpm))
+#define HEARTRATE_MS2SAMPLES(ms)                                          \
+    ((ms) * HEARTRATE_ECG_SAMPLE_RATE / 1000)
+
+// Number of RR-intervals in the ring not yet sent to a connection.
+#define HEARTRATE_RR_PENDING(pConn)      ((uint8_t) (heartRateRrHead - \
+                                                     (pConn)->rrTail))
 
 /*********************************************************************
  * CONSTANTS
@@ -122,10 +130,52 @@
 // Arbitrary values used to simulate measurements.
 #define HEARTRATE_BPM_DEFAULT                           73
 #define HEARTRATE_BPM_MAX                               80
-#define HEARTRATE_ENERGY_INCREMENT                      10
 #define HEARTRATE_FLAGS_IDX_MAX                         7
 
-#define HEARTRATE_MEAS_LEN                              9
+// ECG sample rate in Hz, and the sensor clock period in ms that samples
+// it. Independent of the measurement notification period.
+#define HEARTRATE_ECG_SAMPLE_RATE                       250
+#define HEARTRATE_SENSOR_PERIOD          (1000 / HEARTRATE_ECG_SAMPLE_RATE)
+
+// Simulated ECG: R-wave and T-wave peak amplitudes (ADC counts), and
+// half-widths and delays from the start of the beat (ms).
+#define HEARTRATE_SIM_R_AMP                             1000
+#define HEARTRATE_SIM_R_HALF_WIDTH                      20
+#define HEARTRATE_SIM_T_AMP                             250
+#define HEARTRATE_SIM_T_DELAY                           240
+#define HEARTRATE_SIM_T_HALF_WIDTH                      80
+
+// Energy expended model, after Keytel et al. for a 70 kg, 35 year old
+// man: 0.631 kJ/min per bpm less 34.1 kJ/min, but no less than a resting
+// 80 W. Over one beat of RR s that comes to 631 J - 569 W * RR.
+#define HEARTRATE_ENERGY_PER_BEAT                       631  // J
+#define HEARTRATE_ENERGY_OFFSET                         569  // W
+#define HEARTRATE_ENERGY_REST                           80   // W
+
+// One kJ in the units of the energy accumulator, J/1024.
+#define HEARTRATE_ENERGY_KJ                      ((uint32_t) 1000 * 1024)
+
+// The energy expended field saturates at this value, in kJ.
+#define HEARTRATE_ENERGY_MAX                            0xFFFF
+
+// Energy expended is only sent in every Nth measurement, as the profile
+// suggests, to keep notifications short.
+#define HEARTRATE_ENERGY_NOTI_PERIOD                    10
+
+// Number of sensor samples buffered between measurements, a power of two
+#define HEARTRATE_SAMPLE_RING_SIZE                      16
+
+// Size of the ATT notification header (opcode and handle)
+#define HEARTRATE_NOTI_HDR_LEN                          3
+
+// Number of RR-intervals kept until they are sent, a power of two. Each
+// notification carries as many of them as the MTU allows; the oldest are
+// dropped if the ring fills up.
+#define HEARTRATE_RR_RING_SIZE                          32
+
+// Longest measurement: flags, 16 bit heart rate, energy expended and a
+// full ring of RR-intervals
+#define HEARTRATE_MEAS_MAX_LEN            (5 + (HEARTRATE_RR_RING_SIZE * 2))
 
 // Task configuration
 #define HEARTRATE_TASK_PRIORITY                         1
@@ -157,8 +207,6 @@
                                                          HEARTRATE_MEAS_PERIODIC_EVT | \
                                                          HEARTRATE_BATT_PERIODIC_EVT)
 
-#define HEARTRATE_MEAS_LEN                              9
-
 #define AUTO_PHY_UPDATE            0xFF
 
 // For storing the active connections
@@ -177,6 +225,12 @@ typedef struct
     uint8_t *pData;  // event data
 } heartRateEvt_t;
 
+// A heart rate sensor sample: one detected beat.
+typedef struct
+{
+    uint16_t rrInterval;  // Time since the previous beat, 1/1024 s
+} heartRateSample_t;
+
 typedef enum
 {
     NOT_REGISTER = 0,
@@ -231,6 +285,7 @@ typedef struct
     uint8_t rqPhy;
     uint8_t phyRqFailCnt;                      // PHY change request count
     bool isAutoPHYEnable;                   // Flag to indicate auto phy change
+    uint8_t rrTail;                 // Next RR-interval to send to this link
 } heartRateConnRec_t;
 
 /*********************************************************************
@@ -267,6 +322,9 @@ static Clock_Struct measPerClock;
 
 static Clock_Struct battPerClock;
 
+// Clock for sampling the heart rate sensor.
+static Clock_Struct sensorClock;
+
 // Per-handle connection info
 static heartRateConnRec_t connList[MAX_NUM_BLE_CONNS];
 
@@ -331,18 +389,40 @@ static uint8_t advertData[] = {
 // Device name attribute value.
 static uint8_t attDeviceName[GAP_DEVICE_NAME_LEN] = "Heart Rate Sensor";
 
-// GAP connection handle.
-static uint16_t gapConnHandle;
-
 // Advertising handles
 static uint8 advHandleLegacy;
 static uint8 advHandleLongRange;
 
 // Components of heart rate measurement structure.
-static uint8_t heartRateBpm = HEARTRATE_BPM_DEFAULT;
+static uint16_t heartRateBpm = HEARTRATE_BPM_DEFAULT;
 static uint16_t heartRateEnergyLvl = 0;
-static uint16_t heartRateRrInterval = HEARTRATE_BPM2RR(HEARTRATE_BPM_DEFAULT);
-static uint16_t heartRateRrInterval2 = HEARTRATE_BPM2RR(HEARTRATE_BPM_DEFAULT);
+
+// Energy expended not yet making up a whole kJ, in J/1024.
+static uint32_t heartRateEnergyFrac = 0;
+
+// Measurements since energy expended was last sent.
+static uint8_t heartRateEnergyNotiCnt = 0;
+
+// RR-intervals (1/1024 s) not yet notified. Each connection has its own
+// tail, so a link that misses a notification catches up on the next one.
+// The indices run freely and are masked on access.
+static uint16_t heartRateRrRing[HEARTRATE_RR_RING_SIZE];
+static uint8_t heartRateRrHead = 0;
+
+// Measurement encoded once for all connections, with the RR-intervals
+// pending for the link furthest behind.
+static uint8_t heartRateMeasBuf[HEARTRATE_MEAS_MAX_LEN];
+
+// Sensor samples not yet aggregated into a measurement. The sensor clock
+// is the only writer and advances the head; the application task is the
+// only reader and advances the tail, so neither needs a lock.
+static heartRateSample_t heartRateSampleRing[HEARTRATE_SAMPLE_RING_SIZE];
+static volatile uint8_t heartRateSampleHead = 0;
+static volatile uint8_t heartRateSampleTail = 0;
+
+// Simulated sensor state, only used by the sensor clock.
+static uint8_t heartRateSimBpm = HEARTRATE_BPM_DEFAULT;
+static uint16_t heartRateSimPhase = 0;    // ECG samples into the beat
 
 // Advertising state
 static bool isAdvertising = FALSE;
@@ -389,6 +469,18 @@ static void HeartRate_clockHandler(UArg arg);
 static void HeartRate_measPerTask(void);
 static void HeartRate_battPerTask(void);
 static void HeartRate_measNotify(void);
+static void HeartRate_measNotifyConn(heartRateConnRec_t *pConn,
+                                     uint8_t hdrLen, uint8_t maxRr);
+static void HeartRate_rrPush(uint16_t rrInterval);
+static void HeartRate_sensorClockHandler(UArg arg);
+static int16_t HeartRate_simulateEcg(void);
+static int16_t HeartRate_simulateWave(uint16_t phase, uint16_t start,
+                                      uint16_t halfWidth, int16_t amp);
+static bool HeartRate_samplePut(const heartRateSample_t *pSample);
+static bool HeartRate_sampleGet(heartRateSample_t *pSample);
+static void HeartRate_aggregateSamples(void);
+static void HeartRate_energyAccumulate(uint16_t rrInterval);
+static void HeartRate_energyReset(void);
 static bool HeartRate_toggleAdvertising(void);
 static uint8_t HeartRate_addConn(uint16_t connHandle);
 static void HeartRate_processParamUpdate(uint16_t connHandle);
@@ -512,6 +604,10 @@ void HeartRate_init(void)
     DEFAULT_BATT_PERIOD,
                         0, false,
                         HEARTRATE_BATT_PERIODIC_EVT);
+    Util_constructClock(&sensorClock, HeartRate_sensorClockHandler,
+                        HEARTRATE_SENSOR_PERIOD, HEARTRATE_SENSOR_PERIOD,
+                        false, 0);
+    HeartRateEcg_init(HEARTRATE_ECG_SAMPLE_RATE);
 
     // Initialize keys on SRF06.
     Board_initKeys(HeartRate_keyPressHandler);
@@ -1065,6 +1161,7 @@ static void HeartRate_processGapMessage(gapEventHdr_t *pMsg)
         if (pPkt->hdr.status == SUCCESS)
         {
             isConnected = TRUE;
+
             // Add connection to list and start RSSI
             HeartRate_addConn(pPkt->connectionHandle);
 
@@ -1086,12 +1183,14 @@ static void HeartRate_processGapMessage(gapEventHdr_t *pMsg)
     case GAP_LINK_TERMINATED_EVENT:
     {
         gapTerminateLinkEvent_t *pPkt = (gapTerminateLinkEvent_t*) pMsg;
-        isConnected = FALSE;
         GapAdv_disable(advHandleLegacy);
         isAdvertising = FALSE;
 
         uint8_t numActive = linkDB_NumActive();
 
+        // Measurements carry on for the links that remain.
+        isConnected = (numActive > 0);
+
         // Remove the connection from the list and disable RSSI if needed
         HeartRate_removeConn(pPkt->connectionHandle);
 
@@ -1319,6 +1418,9 @@ static uint8_t HeartRate_addConn(uint16_t connHandle)
             // Found available entry to put a new connection info in
             connList[i].connHandle = connHandle;
 
+            // Only beats from here on are sent to the new link.
+            connList[i].rrTail = heartRateRrHead;
+
             // Allocate data to send through clock handler
             connList[i].pParamUpdateEventData = ICall_malloc(
                     sizeof(heartRateClockEventData_t) + sizeof(uint16_t));
@@ -1429,66 +1531,415 @@ static bool HeartRate_toggleAdvertising(void)
 /*********************************************************************
  * @fn      HeartRate_measNotify
  *
- * @brief   Prepare and send a heart rate measurement notification.
+ * @brief   Prepare a heart rate measurement and send it to every
+ *          connection that has enabled notifications. The measurement is
+ *          encoded once; each link gets a copy with the RR-intervals it
+ *          hasn't received yet, as many as fit in its MTU.
  *
  * @return  none
  */
 static void HeartRate_measNotify(void)
 {
-    attHandleValueNoti_t heartRateMeas;
+    uint8_t *p = heartRateMeasBuf;
+    uint8_t flags = heartRateflags[flagsIdx];
+    uint8_t hdrLen;
+    uint8_t maxRr = 0;
+    uint8_t i;
 
-    heartRateMeas.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_NOTI,
-    HEARTRATE_MEAS_LEN,
-                                         NULL);
-    if (heartRateMeas.pValue != NULL)
+    // Contact status comes from the ECG, if it's supported.
+    if (flags & HEARTRATE_FLAGS_CONTACT_NOT_DET)
     {
-        uint8_t *p = heartRateMeas.pValue;
-        uint8_t flags = heartRateflags[flagsIdx];
+        flags = (flags & ~HEARTRATE_FLAGS_CONTACT_DET) |
+                (HeartRateEcg_getContact() ? HEARTRATE_FLAGS_CONTACT_DET :
+                                             HEARTRATE_FLAGS_CONTACT_NOT_DET);
+    }
+
+    // Energy expended is only sent every HEARTRATE_ENERGY_NOTI_PERIOD
+    // measurements.
+    if (heartRateEnergyNotiCnt != 0)
+    {
+        flags &= ~HEARTRATE_FLAGS_ENERGY_EXP;
+    }
+
+    if (++heartRateEnergyNotiCnt == HEARTRATE_ENERGY_NOTI_PERIOD)
+    {
+        heartRateEnergyNotiCnt = 0;
+    }
+
+    // A heart rate above 255 bpm only fits the 16 bit format.
+    if (heartRateBpm > 0xFF)
+    {
+        flags |= HEARTRATE_FLAGS_FORMAT_UINT16;
+    }
+
+    // Build heart rate measurement structure.
+    *p++ = flags;
+    *p++ = LO_UINT16(heartRateBpm);
+
+    if (flags & HEARTRATE_FLAGS_FORMAT_UINT16)
+    {
+        // Additional byte for 16 bit format.
+        *p++ = HI_UINT16(heartRateBpm);
+    }
 
-        // Build heart rate measurement structure from simulated values.
-        *p++ = flags;
-        *p++ = heartRateBpm;
+    if (flags & HEARTRATE_FLAGS_ENERGY_EXP)
+    {
+        *p++ = LO_UINT16(heartRateEnergyLvl);
+        *p++ = HI_UINT16(heartRateEnergyLvl);
+    }
 
-        if (flags & HEARTRATE_FLAGS_FORMAT_UINT16)
+    hdrLen = (uint8_t) (p - heartRateMeasBuf);
+
+    if (flags & HEARTRATE_FLAGS_RR)
+    {
+        for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
         {
-            // Additional byte for 16 bit format.
-            *p++ = 0;
+            if ((connList[i].connHandle != CONNHANDLE_INVALID) &&
+                (HEARTRATE_RR_PENDING(&connList[i]) > maxRr))
+            {
+                maxRr = HEARTRATE_RR_PENDING(&connList[i]);
+            }
         }
 
-        if (flags & HEARTRATE_FLAGS_ENERGY_EXP)
+        // Oldest first.
+        for (i = 0; i < maxRr; i++)
         {
-            *p++ = LO_UINT16(heartRateEnergyLvl);
-            *p++ = HI_UINT16(heartRateEnergyLvl);
+            uint8_t idx = (uint8_t) (heartRateRrHead - maxRr + i) &
+                          (HEARTRATE_RR_RING_SIZE - 1);
+
+            *p++ = LO_UINT16(heartRateRrRing[idx]);
+            *p++ = HI_UINT16(heartRateRrRing[idx]);
         }
+    }
 
-        if (flags & HEARTRATE_FLAGS_RR)
+    for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
+    {
+        if ((connList[i].connHandle != CONNHANDLE_INVALID) &&
+            HeartRate_MeasNotifyEnabled(connList[i].connHandle))
         {
-            *p++ = LO_UINT16(heartRateRrInterval);
-            *p++ = HI_UINT16(heartRateRrInterval);
-            *p++ = LO_UINT16(heartRateRrInterval2);
-            *p++ = HI_UINT16(heartRateRrInterval2);
+            HeartRate_measNotifyConn(&connList[i], hdrLen, maxRr);
         }
+    }
+}
 
-        heartRateMeas.len = (uint8) (p - heartRateMeas.pValue);
+/*********************************************************************
+ * @fn      HeartRate_measNotifyConn
+ *
+ * @brief   Send the encoded measurement to one connection. If the link is
+ *          out of buffers it misses this measurement, and its RR-intervals
+ *          stay queued for the next one; other links are not held up.
+ *
+ * @param   pConn - connection
+ * @param   hdrLen - length of the measurement without RR-intervals
+ * @param   maxRr - number of RR-intervals in the encoded measurement
+ *
+ * @return  none
+ */
+static void HeartRate_measNotifyConn(heartRateConnRec_t *pConn,
+                                     uint8_t hdrLen, uint8_t maxRr)
+{
+    attHandleValueNoti_t heartRateMeas;
+    linkDBInfo_t linkInfo;
+    uint8_t numRr = 0;
+    uint8_t skip = 0;
+
+    if (linkDB_GetInfo(pConn->connHandle, &linkInfo) != SUCCESS)
+    {
+        return;
+    }
+
+    if (heartRateMeasBuf[0] & HEARTRATE_FLAGS_RR)
+    {
+        numRr = HEARTRATE_RR_PENDING(pConn);
+        skip = maxRr - numRr;
+
+        if (numRr > (linkInfo.MTU - HEARTRATE_NOTI_HDR_LEN - hdrLen) / 2)
+        {
+            numRr = (linkInfo.MTU - HEARTRATE_NOTI_HDR_LEN - hdrLen) / 2;
+        }
+    }
+
+    heartRateMeas.pValue = GATT_bm_alloc(pConn->connHandle,
+                                         ATT_HANDLE_VALUE_NOTI,
+                                         hdrLen + (numRr * 2), NULL);
+    if (heartRateMeas.pValue != NULL)
+    {
+        memcpy(heartRateMeas.pValue, heartRateMeasBuf, hdrLen);
+        memcpy(heartRateMeas.pValue + hdrLen,
+               heartRateMeasBuf + hdrLen + (skip * 2), numRr * 2);
+
+        // The RR-interval field is only present if there's an RR-interval.
+        if (numRr == 0)
+        {
+            heartRateMeas.pValue[0] &= ~HEARTRATE_FLAGS_RR;
+        }
+
+        heartRateMeas.len = hdrLen + (numRr * 2);
 
-        // Send notification.
-        if (HeartRate_MeasNotify(gapConnHandle, &heartRateMeas) != SUCCESS)
+        // Send notification. RR-intervals that weren't sent stay queued.
+        if (HeartRate_MeasNotify(pConn->connHandle, &heartRateMeas)
+            != SUCCESS)
         {
             GATT_bm_free((gattMsg_t*) &heartRateMeas, ATT_HANDLE_VALUE_NOTI);
         }
+        else
+        {
+            pConn->rrTail += numRr;
+        }
+    }
+}
 
-        // Update simulated values.
-        heartRateEnergyLvl += HEARTRATE_ENERGY_INCREMENT;
-        if (++heartRateBpm == HEARTRATE_BPM_MAX)
+/*********************************************************************
+ * @fn      HeartRate_rrPush
+ *
+ * @brief   Queue an RR-interval for the next notification. A link that
+ *          already has a full ring pending loses its oldest RR-interval.
+ *
+ * @param   rrInterval - RR-interval in 1/1024 s
+ *
+ * @return  none
+ */
+static void HeartRate_rrPush(uint16_t rrInterval)
+{
+    uint8_t i;
+
+    for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
+    {
+        if (HEARTRATE_RR_PENDING(&connList[i]) == HEARTRATE_RR_RING_SIZE)
         {
-            heartRateBpm = HEARTRATE_BPM_DEFAULT;
+            connList[i].rrTail++;
         }
+    }
+
+    heartRateRrRing[heartRateRrHead & (HEARTRATE_RR_RING_SIZE - 1)] =
+            rrInterval;
+    heartRateRrHead++;
+}
 
-        heartRateRrInterval = heartRateRrInterval2 = HEARTRATE_BPM2RR(
-                heartRateBpm);
+/*********************************************************************
+ * @fn      HeartRate_sensorClockHandler
+ *
+ * @brief   Take an ECG sample and run beat detection on it. Runs in clock
+ *          (SWI) context, so a detected beat is only queued; it is
+ *          aggregated into a measurement later by the application task.
+ *
+ * @param   arg - unused
+ *
+ * @return  none
+ */
+static void HeartRate_sensorClockHandler(UArg arg)
+{
+    heartRateSample_t sample;
+
+    if (HeartRateEcg_process(HeartRate_simulateEcg(), &sample.rrInterval))
+    {
+        // If the task has fallen behind, the beat is lost.
+        HeartRate_samplePut(&sample);
     }
 }
 
+/*********************************************************************
+ * @fn      HeartRate_simulateEcg
+ *
+ * @brief   Simulate an ECG sample: an R-wave and a T-wave on a flat
+ *          baseline, at a heart rate that steps up with each beat.
+ *
+ * @return  ECG sample
+ */
+static int16_t HeartRate_simulateEcg(void)
+{
+    uint16_t phase = heartRateSimPhase;
+
+    if (++heartRateSimPhase >= HEARTRATE_BPM2SAMPLES(heartRateSimBpm))
+    {
+        heartRateSimPhase = 0;
+
+        if (++heartRateSimBpm == HEARTRATE_BPM_MAX)
+        {
+            heartRateSimBpm = HEARTRATE_BPM_DEFAULT;
+        }
+    }
+
+    return HeartRate_simulateWave(phase, 0,
+                    HEARTRATE_MS2SAMPLES(HEARTRATE_SIM_R_HALF_WIDTH),
+                    HEARTRATE_SIM_R_AMP) +
+           HeartRate_simulateWave(phase,
+                    HEARTRATE_MS2SAMPLES(HEARTRATE_SIM_T_DELAY),
+                    HEARTRATE_MS2SAMPLES(HEARTRATE_SIM_T_HALF_WIDTH),
+                    HEARTRATE_SIM_T_AMP);
+}
+
+/*********************************************************************
+ * @fn      HeartRate_simulateWave
+ *
+ * @brief   Sample a triangular wave of the simulated ECG.
+ *
+ * @param   phase - ECG samples into the beat
+ * @param   start - start of the wave, in samples into the beat
+ * @param   halfWidth - half the width of the wave, in samples
+ * @param   amp - peak amplitude
+ *
+ * @return  the wave's contribution to the sample
+ */
+static int16_t HeartRate_simulateWave(uint16_t phase, uint16_t start,
+                                      uint16_t halfWidth, int16_t amp)
+{
+    int16_t offset = (int16_t) (phase - start) - (int16_t) halfWidth;
+
+    if ((phase < start) || (phase >= start + (2 * halfWidth)))
+    {
+        return 0;
+    }
+
+    if (offset < 0)
+    {
+        offset = -offset;
+    }
+
+    return (int16_t) (amp - ((int32_t) amp * offset) / halfWidth);
+}
+
+/*********************************************************************
+ * @fn      HeartRate_samplePut
+ *
+ * @brief   Queue a sensor sample. Only called by the sensor clock.
+ *
+ * @param   pSample - sample
+ *
+ * @return  true if queued, false if the ring is full
+ */
+static bool HeartRate_samplePut(const heartRateSample_t *pSample)
+{
+    uint8_t head = heartRateSampleHead;
+
+    if ((uint8_t) (head - heartRateSampleTail) == HEARTRATE_SAMPLE_RING_SIZE)
+    {
+        return false;
+    }
+
+    heartRateSampleRing[head & (HEARTRATE_SAMPLE_RING_SIZE - 1)] = *pSample;
+
+    // Publish the sample only once it's written.
+    heartRateSampleHead = head + 1;
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      HeartRate_sampleGet
+ *
+ * @brief   Take the oldest sensor sample. Only called by the application
+ *          task.
+ *
+ * @param   pSample - sample
+ *
+ * @return  true if a sample was taken, false if the ring is empty
+ */
+static bool HeartRate_sampleGet(heartRateSample_t *pSample)
+{
+    uint8_t tail = heartRateSampleTail;
+
+    if (tail == heartRateSampleHead)
+    {
+        return false;
+    }
+
+    *pSample = heartRateSampleRing[tail & (HEARTRATE_SAMPLE_RING_SIZE - 1)];
+
+    // Free the slot only once it's read.
+    heartRateSampleTail = tail + 1;
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      HeartRate_aggregateSamples
+ *
+ * @brief   Turn the sensor samples since the last measurement into the
+ *          next measurement: each beat's RR-interval is queued and its
+ *          energy expended added, and the heart rate is the mean over the
+ *          beats. With no beats, the last heart rate is kept.
+ *
+ * @return  none
+ */
+static void HeartRate_aggregateSamples(void)
+{
+    heartRateSample_t sample;
+    uint32_t rrSum = 0;
+    uint16_t numBeats = 0;
+
+    while (HeartRate_sampleGet(&sample))
+    {
+        HeartRate_rrPush(sample.rrInterval);
+        HeartRate_energyAccumulate(sample.rrInterval);
+        rrSum += sample.rrInterval;
+        numBeats++;
+    }
+
+    if (rrSum > 0)
+    {
+        heartRateBpm = (uint16_t) (((uint32_t) 60 * 1024 * numBeats +
+                                    (rrSum / 2)) / rrSum);
+    }
+}
+
+/*********************************************************************
+ * @fn      HeartRate_energyAccumulate
+ *
+ * @brief   Add the energy expended over a beat, estimated from its heart
+ *          rate. Fractions of a kJ are carried over, so that no energy is
+ *          lost to rounding. The total saturates at HEARTRATE_ENERGY_MAX,
+ *          as the profile requires.
+ *
+ * @param   rrInterval - length of the beat, 1/1024 s
+ *
+ * @return  none
+ */
+static void HeartRate_energyAccumulate(uint16_t rrInterval)
+{
+    int32_t energy = ((int32_t) HEARTRATE_ENERGY_PER_BEAT * 1024) -
+                     ((int32_t) HEARTRATE_ENERGY_OFFSET * rrInterval);
+    int32_t rest = (int32_t) HEARTRATE_ENERGY_REST * rrInterval;
+
+    if (heartRateEnergyLvl == HEARTRATE_ENERGY_MAX)
+    {
+        return;
+    }
+
+    if (energy < rest)
+    {
+        energy = rest;
+    }
+
+    heartRateEnergyFrac += (uint32_t) energy;
+
+    while (heartRateEnergyFrac >= HEARTRATE_ENERGY_KJ)
+    {
+        heartRateEnergyFrac -= HEARTRATE_ENERGY_KJ;
+
+        if (++heartRateEnergyLvl == HEARTRATE_ENERGY_MAX)
+        {
+            heartRateEnergyFrac = 0;
+            break;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      HeartRate_energyReset
+ *
+ * @brief   Reset energy expended, as requested through the heart rate
+ *          control point. The next measurement carries the reset value.
+ *
+ * @return  none
+ */
+static void HeartRate_energyReset(void)
+{
+    heartRateEnergyLvl = 0;
+    heartRateEnergyFrac = 0;
+    heartRateEnergyNotiCnt = 0;
+}
+
 /*********************************************************************
  * @fn      HeartRate_serviceCB
  *
@@ -1521,17 +1972,29 @@ static void HeartRate_heartRateEvt(uint8_t event)
         if (isConnected)
         {
             Util_startClock(&measPerClock);
+            Util_startClock(&sensorClock);
         }
     }
     else if (event == HEARTRATE_MEAS_NOTI_DISABLED)
     {
-        // Stop periodic measurement.
+        uint8_t i;
+
+        // Stop periodic measurement once no link wants it.
+        for (i = 0; i < MAX_NUM_BLE_CONNS; i++)
+        {
+            if ((connList[i].connHandle != CONNHANDLE_INVALID) &&
+                HeartRate_MeasNotifyEnabled(connList[i].connHandle))
+            {
+                return;
+            }
+        }
+
         Util_stopClock(&measPerClock);
+        Util_stopClock(&sensorClock);
     }
     else if (event == HEARTRATE_COMMAND_SET)
     {
-        // Reset energy expended.
-        heartRateEnergyLvl = 0;
+        HeartRate_energyReset();
     }
 }
 
@@ -1651,12 +2114,20 @@ static void HeartRate_measPerTask(void)
 {
     if (isConnected)
     {
+        // Collect the beats since the last measurement.
+        HeartRate_aggregateSamples();
+
         // Send heart rate measurement notification.
         HeartRate_measNotify();
 
         // Restart timer.
         Util_startClock(&measPerClock);
     }
+    else
+    {
+        // Stop sampling until measurements resume.
+        Util_stopClock(&sensorClock);
+    }
 }
 
 /*********************************************************************
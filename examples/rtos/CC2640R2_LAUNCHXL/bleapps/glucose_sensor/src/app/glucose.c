@@ -74,6 +74,8 @@
 
 
 #include "glucose.h"
+#include "glucose_store.h"
+#include "glucose_gen.h"
 
 /*********************************************************************
  * MACROS
@@ -88,6 +90,12 @@
 // Gets whether the RegisterCause was registered to recieve connection event
 #define CONNECTION_EVENT_REGISTRATION_CAUSE(RegisterCause) (connectionEventRegisterCauseBitMap & RegisterCause )
 
+// Whether a send failed for lack of buffers and should be retried.
+#define GLUCOSE_SEND_BUSY(status)     (((status) == bleMemAllocError)     || \
+                                       ((status) == MSG_BUFFER_NOT_AVAIL) || \
+                                       ((status) == bleNoResources)       || \
+                                       ((status) == blePending))
+
 /*********************************************************************
  * CONSTANTS
  */
@@ -135,23 +143,60 @@
 // Default GAP bonding I/O capabilities
 #define DEFAULT_IO_CAPABILITIES               GAPBOND_IO_CAP_DISPLAY_ONLY //GAPBOND_IO_CAP_NO_INPUT_NO_OUTPUT
 
-// Notification period in ms
+// Report retry period in ms, used if connection events are unavailable
 #define DEFAULT_NOTI_PERIOD                   100
 
-// Meas state bit field
-#define GLUCOSE_MEAS_STATE_VALID              0x01
-#define GLUCOSE_MEAS_STATE_FILTER_PASS        0x02
-#define GLUCOSE_MEAS_STATE_ALL                (GLUCOSE_MEAS_STATE_VALID | GLUCOSE_MEAS_STATE_FILTER_PASS)
+// Notifications a report may queue per connection event. A control point
+// response waits behind no more than these.
+#define GLUCOSE_NOTI_PER_CONN_EVT             6
+
+// NVS region holding the glucose record log
+#define GLUCOSE_STORE_NVS_INDEX               Board_NVSINTERNAL
+
+// Delay (in ms) between erases of deleted record log sectors, done while
+// no report is in progress
+#define GLUCOSE_COMPACT_PERIOD                50
+
+// Record transfer over an L2CAP connection-oriented channel. Once the
+// collector opens a channel on this PSM, reports are sent as SDUs packing
+// whole records. Each record is its measurement length, its context length
+// (0 if none), then the measurement and context as sent over GATT.
+#define GLUCOSE_COC_PSM                       0x0080
+
+// Maximum SDU size received from and sent to the collector
+#define GLUCOSE_COC_MTU                       252
+
+// Credits given to the collector, and the count at which to give more
+#define GLUCOSE_COC_PEER_CREDITS              4
+#define GLUCOSE_COC_PEER_CREDIT_THRESHOLD     1
+
+// Size of a record in a channel SDU
+#define GLUCOSE_COC_REC_LEN(pRec)             (2 + (pRec)->measLen + \
+                                               (pRec)->contextLen)
 
 // Some values used to simulate measurements
-#define MEAS_IDX_MAX                          sizeof(glucoseMeasArray)/sizeof(glucoseMeas_t)
+#define SEED_REC_MAX                          sizeof(glucoseSeedMeas)/sizeof(glucoseMeas_t)
 
 // Maximum number of dynamically allocated measurements
-// (must be less than MEAS_IDX_MAX)
+// (must be less than SEED_REC_MAX)
 #define DYNAMIC_REC_MAX                       1
 
-#define GLUCOSE_MEAS_LEN                      17
-#define GLUCOSE_CONTEXT_LEN                   17
+// Number of synthetic records to fill an empty store with in place of the
+// sample records, to exercise record access with a full log (0 for none)
+#ifndef GLUCOSE_GEN_NUM_RECORDS
+#define GLUCOSE_GEN_NUM_RECORDS               0
+#endif
+
+// Seconds between synthetic record timestamps
+#define GLUCOSE_GEN_PERIOD                    300
+
+// Every nth synthetic record has a context (0 for none)
+#define GLUCOSE_GEN_CONTEXT_EVERY             2
+
+// Every nth synthetic record is deleted, leaving a gap in the sequence
+// numbers (0 for none)
+#define GLUCOSE_GEN_GAP_EVERY                 10
+
 #define GLUCOSE_CTL_PNT_LEN                   4
 
 // Task configuration
@@ -168,10 +213,12 @@
 #define GLUCOSE_ICALL_EVT                     ICALL_MSG_EVENT_ID // Event_Id_31
 #define GLUCOSE_QUEUE_EVT                     UTIL_QUEUE_EVENT_ID // Event_Id_30
 #define GLUCOSE_NOTI_TIMEOUT_EVT              Event_Id_00
+#define GLUCOSE_COMPACT_EVT                   Event_Id_01
 
 #define GLUCOSE_ALL_EVENTS                    (GLUCOSE_ICALL_EVT        | \
                                                GLUCOSE_QUEUE_EVT        | \
-                                               GLUCOSE_NOTI_TIMEOUT_EVT)
+                                               GLUCOSE_NOTI_TIMEOUT_EVT | \
+                                               GLUCOSE_COMPACT_EVT)
 
 /*********************************************************************
  * TYPEDEFS
@@ -196,42 +243,14 @@ typedef struct {
   uint8_t data[GLUCOSE_CTL_PNT_MAX_SIZE];
 } glucoseCtlPntMsg_t;
 
-// Data in a glucose measurement as defined in the profile.
-typedef struct {
-  uint8_t state;
-  uint8_t flags;
-  uint16_t seqNum;
-  UTCTimeStruct baseTime;
-  int16 timeOffset;
-  uint16_t concentration;
-  uint8_t typeSampleLocation;
-  uint16_t sensorStatus;
-} glucoseMeas_t;
-
-// Context data as defined in profile.
-typedef struct {
-  uint8_t flags;
-  uint16_t seqNum;
-  uint8_t extendedFlags;
-  uint8_t carboId;
-  uint16_t carboVal;
-  uint8_t mealVal;
-  uint8_t TesterHealthVal;
-  uint16_t exerciseDuration;
-  uint8_t exerciseIntensity;
-  uint8_t medId;
-  uint16_t medVal;
-  uint16_t HbA1cVal;
-} glucoseContext_t;
-
-
 typedef enum
 {
    NOT_REGISTER       = 0,
    FOR_AOA_SCAN       = 1,
    FOR_ATT_RSP        = 2,
    FOR_AOA_SEND       = 4,
-   FOR_TOF_SEND       = 8
+   FOR_TOF_SEND       = 8,
+   FOR_RACP_REPORT    = 16
 }connectionEventRegisterCause_u;
 
 /*********************************************************************
@@ -265,6 +284,7 @@ static ICall_SyncHandle syncEvent;
 
 // Clock instances for internal periodic events.
 static Clock_Struct notiTimeoutClock;
+static Clock_Struct compactClock;
 
 // Queue object used for app messages.
 static Queue_Struct appMsg;
@@ -315,22 +335,34 @@ static uint8_t glucoseBondedAddr[B_ADDR_LEN];
 // GAP connection handle.
 static uint16_t gapConnHandle;
 
+// Set to true if the current record's measurement is waiting to be sent.
+static bool glucoseSendMeas = false;
+
 // Set to true if context should be sent with measurement data.
 static bool glucoseSendContext = false;
 
+// Notifications queued this connection event.
+static uint8_t glucoseNumQueued = 0;
+
+// Set to true if a control point response is waiting to be sent, with
+// its opcode and status.
+static bool glucoseSendRsp = false;
+static uint8_t glucoseRspOpcode;
+static uint8_t glucoseRspCode;
+
 // Advertising user-cancelled state.
 static bool glucoseAdvCancelled = FALSE;
 
 // If true, then send all valid and selected glucose measurements.
 bool glucoseSendAllRecords = false;
 
-// For the example application we have hard coded glucose measurements.
+// For the example application the record store is seeded with hard coded
+// glucose measurements. Sequence numbers are assigned by the store.
 // Note dates are in UTC time; day and month start at 0.
-static glucoseMeas_t glucoseMeasArray[] =
+static const glucoseMeas_t glucoseSeedMeas[] =
 {
   //Meas 1
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL,   //mol/L
   1,
   {14,17,23,22,1,2013},
@@ -341,7 +373,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   },
   //Meas 2
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL,   //mol/L
   2,
   {6,0,0,2,1,2012},
@@ -352,7 +383,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   },
   //Meas 3
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL,                              //mol/L
   3,
   {11,23,0,5,2,2012},
@@ -364,7 +394,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   // Time offset +1 hr
   //Meas 4
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL,                              //mol/L
   4,
   {12,2,0,14,1,2011},
@@ -375,7 +404,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   },
   //Meas 5
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL,                              //mol/L
   5,
   {13,5,12,12,1,2011},
@@ -386,7 +414,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   },
   //Meas 6
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,   //kg/L
   6,
   {7,15,0,5,2,2011},
@@ -398,7 +425,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   // Time offset -2 hrs
   //Meas 7
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,   //kg/L
   7,
   {9,4,0,14,4,2011},
@@ -409,7 +435,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   },
   //Meas 8
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,    //kg/L
   8,
   {0,0,0,1,1,2013},
@@ -420,7 +445,6 @@ static glucoseMeas_t glucoseMeasArray[] =
   },
   //Meas 9
   {
-  GLUCOSE_MEAS_STATE_ALL,
   GLUCOSE_MEAS_FLAG_ALL & ~GLUCOSE_MEAS_FLAG_UNITS,    //kg/L
   9,
   {12,0,0,5,2,2013},
@@ -433,12 +457,11 @@ static glucoseMeas_t glucoseMeasArray[] =
 
 // Each measurement entry must have a corresponding context, it is only sent
 // based on the flag in the measurement, but it must exist for this app.
-static glucoseContext_t glucoseContextArray[] =
+static const glucoseContext_t glucoseSeedContext[] =
 {
   //Context 1
   {
    GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-   1,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    9,
@@ -453,7 +476,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 2
   {
    GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-   2,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    10,
@@ -468,7 +490,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 3
   {
    GLUCOSE_CONTEXT_FLAG_ALL, //L
-   3,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    10,
@@ -483,7 +504,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 4
   {
    GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-   4,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    10,
@@ -498,7 +518,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 5
   {
    GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-   5,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    10,
@@ -513,7 +532,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 6
   {
    GLUCOSE_CONTEXT_FLAG_ALL, //L
-   6,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    10,
@@ -528,7 +546,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 7
   {
    GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-   7,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    10,
@@ -543,7 +560,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 8
   {
    GLUCOSE_CONTEXT_FLAG_ALL & ~GLUCOSE_CONTEXT_FLAG_MEDICATION_UNITS, //kg
-   8,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    11,
@@ -558,7 +574,6 @@ static glucoseContext_t glucoseContextArray[] =
   //Context 9
   {
    GLUCOSE_CONTEXT_FLAG_ALL, //L
-   9,
    0,
    GLUCOSE_CARBO_BREAKFAST,
    12,
@@ -575,10 +590,22 @@ static glucoseContext_t glucoseContextArray[] =
 // GAP connected device address.
 static uint8_t connDeviceAddr[6] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
 
-// initial index of measurement/context.
-static uint8_t glucoseMeasIdx = 0;
+// Encoded record being sent and its record store ID (0 if none).
+static glucoseStoreWire_t glucoseCurRec;
+static uint32_t glucoseCurRecId = 0;
+
+// Filter of the record report in progress.
+static glucoseStoreFilter_t glucoseReportFilter;
 
-static uint16_t seqNum = MEAS_IDX_MAX;
+// L2CAP channel for reports (0 if none) and the largest SDU it takes.
+static uint16_t glucoseCocCID = 0;
+static uint16_t glucoseCocMtu;
+
+// Set to true while an SDU is being sent on the channel, with the record
+// it starts with, to go back to if the channel closes before it's done.
+static bool glucoseCocBusy = false;
+static glucoseStoreWire_t glucoseCocRec;
+static uint32_t glucoseCocRecId;
 
 /*********************************************************************
  * LOCAL FUNCTIONS
@@ -593,48 +620,37 @@ static void GlucoseSensor_processStackMsg(ICall_Hdr *pMsg);
 static void GlucoseSensor_processGattMsg(gattMsgEvent_t *pMsg);
 static void GlucoseSensor_processAppMsg(glucoseEvt_t *pMsg);
 
-static void GlucoseSensor_contextSend(void);
+static bStatus_t GlucoseSensor_contextSend(void);
 static void GlucoseSensor_ctlPntHandleOpcode(uint8_t opcode, uint8_t oper,
                                              uint8_t filterType, void *param1,
                                              void *param2);
-static void GlucoseSensor_ctlPntRsp(uint8_t rspCode, uint8_t opcode);
+static bStatus_t GlucoseSensor_ctlPntRsp(uint8_t rspCode, uint8_t opcode);
 static void GlucoseSensor_ctlPntNumRecRsp(uint16_t numRecords);
-static void GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
-                                         uint8_t value0, uint8_t value1);
-static uint8_t GlucoseSensor_filterRecords(uint8_t oper, uint8_t filterType,
-                                           void *param1, void *param2, bool set,
-                                           uint8_t mask, uint8_t opcode);
-static uint8_t GlucoseSensor_findNumValidRecords(void);
-static uint8_t GlucoseSensor_findFirstValidFilteredIdx(uint8_t startIndex);
-static uint8_t GlucoseSensor_markFirstValidRec(bool setBits, uint8_t mask);
-static uint8_t GlucoseSensor_markLastValidRec(bool setBits, uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecords(bool setBits, uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanSeqNum(uint16_t *pSeqNum,
-                                                             bool set,
-                                                             uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsLaterThanSeqNum(uint16_t *pSeqNum,
-                                                           bool set,
-                                                           uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsInRangeSeqNum(uint16_t *pSeqNum1,
-                                                         uint16_t *pSeqNum2,
-                                                         bool set,
-                                                         uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanTime(UTCTimeStruct *pTime,
-                                                           bool set,
-                                                           uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsLaterThanTime(UTCTimeStruct *pTime,
-                                                         bool set,
-                                                         uint8_t mask);
-static uint8_t GlucoseSensor_markAllRecordsInRangeTime(UTCTimeStruct *pTime1,
-                                                       UTCTimeStruct *pTime2,
-                                                       bool set, uint8_t mask);
-static void GlucoseSensor_measSend(void);
+static bStatus_t GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
+                                              uint8_t value0, uint8_t value1);
+static bool GlucoseSensor_buildFilter(uint8_t oper, uint8_t filterType,
+                                      void *param1, void *param2,
+                                      uint8_t opcode,
+                                      glucoseStoreFilter_t *pFilter);
+static void GlucoseSensor_seedRecords(void);
+#if GLUCOSE_GEN_NUM_RECORDS > 0
+static void GlucoseSensor_generateRecords(uint16_t numRecords);
+#endif
+static bStatus_t GlucoseSensor_measSend(void);
 static void GlucoseSensor_processCtlPntMsg(glucoseCtlPntMsg_t *pMsg);
 static void GlucoseSensor_sendNext(void);
+static void GlucoseSensor_resumeOnConnEvt(bool enable);
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+static bStatus_t GlucoseSensor_cocSend(void);
+static void GlucoseSensor_processL2capSignalEvt(l2capSignalEvent_t *pMsg);
+#endif // L2CAP_COC_CFG
+static void GlucoseSensor_compactStore(void);
 static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime);
 
 static void GlucoseSensor_connEvtCB(Gap_ConnEventRpt_t *pReport);
 static void GlucoseSensor_processConnEvt(Gap_ConnEventRpt_t *pReport);
+bStatus_t GlucoseSensor_RegistertToAllConnectionEvent (connectionEventRegisterCause_u connectionEventRegisterCause);
+bStatus_t GlucoseSensor_UnRegistertToAllConnectionEvent (connectionEventRegisterCause_u connectionEventRegisterCause);
 
 // GAP Peripheral state.
 static void GlucoseSensor_stateChangeCB(gaprole_States_t newState);
@@ -738,9 +754,26 @@ void GlucoseSensor_init(void)
   // Create one-shot clocks for internal periodic events.
   Util_constructClock(&notiTimeoutClock, GlucoseSensor_clockHandler,
                       DEFAULT_NOTI_PERIOD, 0, false, GLUCOSE_NOTI_TIMEOUT_EVT);
+  Util_constructClock(&compactClock, GlucoseSensor_clockHandler,
+                      GLUCOSE_COMPACT_PERIOD, 0, false, GLUCOSE_COMPACT_EVT);
 
   Board_initKeys(GlucoseSensor_keyPressHandler);
 
+  // Open the record store; seed it with sample or synthetic records when
+  // empty.
+  if ((GlucoseStore_init(GLUCOSE_STORE_NVS_INDEX) == SUCCESS) &&
+      (GlucoseStore_getNumRecords() == 0))
+  {
+#if GLUCOSE_GEN_NUM_RECORDS > 0
+    GlucoseSensor_generateRecords(GLUCOSE_GEN_NUM_RECORDS);
+#else
+    GlucoseSensor_seedRecords();
+#endif
+  }
+
+  // Erase sectors left deleted by the last run, or of an older format.
+  Util_startClock(&compactClock);
+
   // Setup the GAP Peripheral Role Profile.
   {
 #if AUTO_ADV
@@ -807,6 +840,24 @@ void GlucoseSensor_init(void)
   // Register for Glucose service callback.
   Glucose_Register(GlucoseSensor_serviceCB);
 
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+  // Accept an L2CAP channel for bulk record transfer.
+  {
+    l2capPsm_t psm;
+
+    psm.psm = GLUCOSE_COC_PSM;
+    psm.mtu = GLUCOSE_COC_MTU;
+    psm.initPeerCredits = GLUCOSE_COC_PEER_CREDITS;
+    psm.peerCreditThreshold = GLUCOSE_COC_PEER_CREDIT_THRESHOLD;
+    psm.maxNumChannels = 1; // The peripheral role takes one connection
+    psm.pfnVerifySecCB = NULL;
+    psm.taskId = ICall_getLocalMsgEntityId(ICALL_SERVICE_CLASS_BLE_MSG,
+                                           selfEntity);
+
+    VOID L2CAP_RegisterPsm(&psm);
+  }
+#endif // L2CAP_COC_CFG
+
   // Start the Device.
   VOID GAPRole_StartDevice(&glucose_PeripheralCBs);
 
@@ -890,9 +941,18 @@ void GlucoseSensor_taskFxn(UArg a0, UArg a1)
       // Notification timeout.
       if (events & GLUCOSE_NOTI_TIMEOUT_EVT)
       {
+        // The timeout stands in for a connection event.
+        glucoseNumQueued = 0;
+
         // Send next notification.
         GlucoseSensor_sendNext();
       }
+
+      // Record log compaction.
+      if (events & GLUCOSE_COMPACT_EVT)
+      {
+        GlucoseSensor_compactStore();
+      }
     }
   }
 }
@@ -914,6 +974,17 @@ static void GlucoseSensor_processStackMsg(ICall_Hdr *pMsg)
       GlucoseSensor_processGattMsg((gattMsgEvent_t *)pMsg);
       break;
 
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+    case L2CAP_SIGNAL_EVENT:
+      GlucoseSensor_processL2capSignalEvt((l2capSignalEvent_t *)pMsg);
+      break;
+
+    case L2CAP_DATA_EVENT:
+      // Nothing is expected from the collector; drop it.
+      BM_free(((l2capDataEvent_t *)pMsg)->pkt.pPayload);
+      break;
+#endif // L2CAP_COC_CFG
+
     case HCI_GAP_EVENT_EVENT:
       {
 
@@ -1086,41 +1157,44 @@ static void GlucoseSensor_handleKeys(uint8_t shift, uint8_t keys)
   {
     if(!glucoseSendAllRecords)
     {
-      // Set simulated measurement flag index.
-      if(GlucoseSensor_findNumValidRecords() > 0)
+      // Set simulated measurement record.
+      if(GlucoseStore_getNumRecords() > 0)
       {
-        GlucoseSensor_markAllRecords(true, GLUCOSE_MEAS_STATE_FILTER_PASS);
+        glucoseStoreFilter_t filter = { .oper = CTL_PNT_OPER_ALL };
 
-        glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(glucoseMeasIdx+1);
-        if (glucoseMeasIdx == MEAS_IDX_MAX)
+        if (!GlucoseStore_find(&filter, &glucoseCurRecId, &glucoseCurRec))
         {
-          glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(0);
+          glucoseCurRecId = 0;
+          GlucoseStore_find(&filter, &glucoseCurRecId, &glucoseCurRec);
         }
 
         if(gapProfileState == GAPROLE_CONNECTED)
         {
-          GlucoseSensor_measSend();
+          glucoseSendMeas = true;
+          GlucoseSensor_sendNext();
         }
       }
       else
       {
+        glucoseRecord_t record;
     	uint8_t i;
         // Populate dynamic measurement records.
         for (i = 0; i < DYNAMIC_REC_MAX; i++)
         {
-          glucoseMeasArray[i].state |= GLUCOSE_MEAS_STATE_VALID;
-          glucoseMeasArray[i].seqNum = ++seqNum;
-          glucoseContextArray[i].seqNum = seqNum;
+          record.meas = glucoseSeedMeas[i];
+          record.context = glucoseSeedContext[i];
 
           // Set context info follows bit.
           if (i % 2)
           {
-            glucoseMeasArray[i].flags |= GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
+            record.meas.flags |= GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
           }
           else
           {
-            glucoseMeasArray[i].flags &= ~GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
+            record.meas.flags &= ~GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
           }
+
+          GlucoseStore_append(&record);
         }
       }
     }
@@ -1153,34 +1227,321 @@ static void GlucoseSensor_handleKeys(uint8_t shift, uint8_t keys)
   }
 }
 
+/*********************************************************************
+ * @fn      GlucoseSensor_seedRecords
+ *
+ * @brief   Append the sample records to the record store.
+ *
+ * @return  none
+ */
+static void GlucoseSensor_seedRecords(void)
+{
+  glucoseRecord_t record;
+  uint8_t i;
+
+  for (i = 0; i < SEED_REC_MAX; i++)
+  {
+    record.meas = glucoseSeedMeas[i];
+    record.context = glucoseSeedContext[i];
+
+    if (GlucoseStore_append(&record) != SUCCESS)
+    {
+      break;
+    }
+  }
+}
+
+#if GLUCOSE_GEN_NUM_RECORDS > 0
+/*********************************************************************
+ * @fn      GlucoseSensor_generateRecords
+ *
+ * @brief   Append synthetic records to the record store. Field values
+ *          cycle through the sample records; timestamps are
+ *          GLUCOSE_GEN_PERIOD apart, and every GLUCOSE_GEN_CONTEXT_EVERY
+ *          record has a context. Every GLUCOSE_GEN_GAP_EVERY record is
+ *          deleted again to leave a gap in the sequence numbers.
+ *
+ * @param   numRecords - number of records to append
+ *
+ * @return  none
+ */
+static void GlucoseSensor_generateRecords(uint16_t numRecords)
+{
+  glucoseGenParams_t params = { .pMeas = glucoseSeedMeas,
+                                .pContext = glucoseSeedContext,
+                                .numTemplates = SEED_REC_MAX,
+                                .period = GLUCOSE_GEN_PERIOD,
+                                .contextEvery = GLUCOSE_GEN_CONTEXT_EVERY,
+                                .gapEvery = GLUCOSE_GEN_GAP_EVERY };
+  UTCTimeStruct startTime = glucoseSeedMeas[0].baseTime;
+
+  params.startTime = UTC_convertUTCSecs(&startTime);
+
+  GlucoseGen_fill(&params, numRecords);
+}
+#endif // GLUCOSE_GEN_NUM_RECORDS
+
 /*********************************************************************
  * @fn      GlucoseSensor_sendNext
  *
- * @brief   Send next notification.
+ * @brief   Queue pending notifications until the stack runs out of
+ *          buffers or the connection event's share, then resume on a later
+ *          connection event. A waiting control point response goes first.
+ *          A report's success response is queued only behind its last
+ *          record, so it is delivered after it.
  *
  * @return  none
  */
 static void GlucoseSensor_sendNext(void)
 {
-  if(glucoseSendContext)
+  bStatus_t status = SUCCESS;
+
+  while(!GLUCOSE_SEND_BUSY(status))
   {
-    glucoseSendContext = false;
-    GlucoseSensor_contextSend();
+    if(glucoseSendRsp)
+    {
+      // A control point response goes ahead of any record.
+      status = GlucoseSensor_ctlPntRsp(glucoseRspCode, glucoseRspOpcode);
+      glucoseSendRsp = GLUCOSE_SEND_BUSY(status);
+    }
+    else if(glucoseSendMeas)
+    {
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+      if(glucoseSendAllRecords && (glucoseCocCID != 0))
+      {
+        if(glucoseCocBusy)
+        {
+          // The next SDU goes once the stack reports this one done.
+          break;
+        }
+
+        status = GlucoseSensor_cocSend();
+        continue;
+      }
+#endif // L2CAP_COC_CFG
+
+      status = GlucoseSensor_measSend();
+      glucoseSendMeas = GLUCOSE_SEND_BUSY(status);
+    }
+    else if(glucoseSendContext)
+    {
+      status = GlucoseSensor_contextSend();
+      glucoseSendContext = GLUCOSE_SEND_BUSY(status);
+    }
+    else if(glucoseSendAllRecords)
+    {
+      if (GlucoseStore_find(&glucoseReportFilter, &glucoseCurRecId,
+                            &glucoseCurRec))
+      {
+        glucoseSendMeas = true;
+      }
+      else if(glucoseCocBusy)
+      {
+        // Complete the report only after its last SDU is out.
+        break;
+      }
+      else
+      {
+        status = GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, CTL_PNT_OP_REQ);
+        if(!GLUCOSE_SEND_BUSY(status))
+        {
+          glucoseCurRecId = 0;
+          glucoseSendAllRecords = false;
+        }
+      }
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  GlucoseSensor_resumeOnConnEvt(GLUCOSE_SEND_BUSY(status));
+}
+
+/*********************************************************************
+ * @fn      GlucoseSensor_resumeOnConnEvt
+ *
+ * @brief   Register or unregister for connection events, used to resume
+ *          a send that stalled for lack of buffers. If they can't be
+ *          registered the notification timer retries instead.
+ *
+ * @param   enable - true to resume on the next connection event
+ *
+ * @return  none
+ */
+static void GlucoseSensor_resumeOnConnEvt(bool enable)
+{
+  if(enable && !CONNECTION_EVENT_REGISTRATION_CAUSE(FOR_RACP_REPORT))
+  {
+    if(GlucoseSensor_RegistertToAllConnectionEvent(FOR_RACP_REPORT) != SUCCESS)
+    {
+      Util_startClock(&notiTimeoutClock);
+    }
+  }
+  else if(!enable && CONNECTION_EVENT_REGISTRATION_CAUSE(FOR_RACP_REPORT))
+  {
+    GlucoseSensor_UnRegistertToAllConnectionEvent(FOR_RACP_REPORT);
+  }
+}
+
+#if defined(BLE_V41_FEATURES) && (BLE_V41_FEATURES & L2CAP_COC_CFG)
+/*********************************************************************
+ * @fn      GlucoseSensor_cocSend
+ *
+ * @brief   Send the current record of a report, and as many of the
+ *          records that follow as fit, in one SDU on the L2CAP channel.
+ *          Only one SDU is sent at a time; the next goes once the stack
+ *          reports this one done.
+ *
+ * @return  SUCCESS, bleMemAllocError if no buffer is available, or the
+ *          status of the send
+ */
+static bStatus_t GlucoseSensor_cocSend(void)
+{
+  l2capPacket_t pkt;
+  bStatus_t status;
+
+  pkt.pPayload = L2CAP_bm_alloc(glucoseCocMtu);
+  if(pkt.pPayload == NULL)
+  {
+    return bleMemAllocError;
+  }
+
+  pkt.CID = glucoseCocCID;
+  pkt.len = 0;
+
+  // Remember where the SDU starts, to send it again if it's lost.
+  glucoseCocRec = glucoseCurRec;
+  glucoseCocRecId = glucoseCurRecId;
+
+  // Pack records until the next one doesn't fit or the report is done.
+  do
+  {
+    pkt.pPayload[pkt.len++] = glucoseCurRec.measLen;
+    pkt.pPayload[pkt.len++] = glucoseCurRec.contextLen;
+    memcpy(&pkt.pPayload[pkt.len], glucoseCurRec.meas, glucoseCurRec.measLen);
+    pkt.len += glucoseCurRec.measLen;
+    memcpy(&pkt.pPayload[pkt.len], glucoseCurRec.context,
+           glucoseCurRec.contextLen);
+    pkt.len += glucoseCurRec.contextLen;
+
+    glucoseSendMeas = GlucoseStore_find(&glucoseReportFilter,
+                                        &glucoseCurRecId, &glucoseCurRec);
+  } while(glucoseSendMeas &&
+          (pkt.len + GLUCOSE_COC_REC_LEN(&glucoseCurRec) <= glucoseCocMtu));
+
+  status = L2CAP_SendSDU(&pkt);
+  if(status == SUCCESS)
+  {
+    glucoseCocBusy = true;
   }
-  else if(glucoseSendAllRecords)
+  else
   {
-    glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(glucoseMeasIdx + 1);
+    BM_free(pkt.pPayload);
+
+    // Rewind to the first record packed.
+    glucoseCurRec = glucoseCocRec;
+    glucoseCurRecId = glucoseCocRecId;
+    glucoseSendMeas = true;
 
-    if (glucoseMeasIdx == MEAS_IDX_MAX)
+    // Fall back to GATT if the channel can't be used.
+    if(!GLUCOSE_SEND_BUSY(status))
     {
-      glucoseMeasIdx = 0;
-      glucoseSendAllRecords = false;
-      GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, CTL_PNT_OP_REQ);
+      glucoseCocCID = 0;
     }
-    else
+  }
+
+  return status;
+}
+
+/*********************************************************************
+ * @fn      GlucoseSensor_processL2capSignalEvt
+ *
+ * @brief   Track the L2CAP channel the collector opens for record
+ *          transfer.
+ *
+ * @param   pMsg - L2CAP signal event
+ *
+ * @return  none
+ */
+static void GlucoseSensor_processL2capSignalEvt(l2capSignalEvent_t *pMsg)
+{
+  if(pMsg->connHandle != gapConnHandle)
+  {
+    return;
+  }
+
+  switch(pMsg->opcode)
+  {
+  case L2CAP_CHANNEL_ESTABLISHED_EVT:
+    // Use the channel if the collector takes at least a full record.
+    if((pMsg->cmd.channelEstEvt.result == L2CAP_CONN_SUCCESS) &&
+       (pMsg->cmd.channelEstEvt.info.peerMtu >=
+        2 + GLUCOSE_STORE_MEAS_LEN + GLUCOSE_STORE_CONTEXT_LEN))
+    {
+      glucoseCocCID = pMsg->cmd.channelEstEvt.CID;
+      glucoseCocMtu = pMsg->cmd.channelEstEvt.info.peerMtu;
+
+      if(glucoseCocMtu > GLUCOSE_COC_MTU)
+      {
+        glucoseCocMtu = GLUCOSE_COC_MTU;
+      }
+    }
+    break;
+
+  case L2CAP_CHANNEL_TERMINATED_EVT:
+    if(pMsg->cmd.channelTermEvt.CID == glucoseCocCID)
+    {
+      // The SDU being sent may be lost; a report in progress sends it
+      // again and carries on over GATT.
+      if(glucoseCocBusy && glucoseSendAllRecords)
+      {
+        glucoseCurRec = glucoseCocRec;
+        glucoseCurRecId = glucoseCocRecId;
+        glucoseSendMeas = true;
+      }
+
+      glucoseCocCID = 0;
+      glucoseCocBusy = false;
+      GlucoseSensor_sendNext();
+    }
+    break;
+
+  case L2CAP_SEND_SDU_DONE_EVT:
+    if(pMsg->cmd.sendSduDoneEvt.CID == glucoseCocCID)
     {
-      GlucoseSensor_measSend();
+      glucoseCocBusy = false;
+      GlucoseSensor_sendNext();
     }
+    break;
+
+  case L2CAP_PEER_CREDIT_THRESHOLD_EVT:
+    L2CAP_FlowCtrlCredit(pMsg->cmd.creditEvt.CID, GLUCOSE_COC_PEER_CREDITS);
+    break;
+
+  default:
+    // Do nothing.
+    break;
+  }
+}
+#endif // L2CAP_COC_CFG
+
+/*********************************************************************
+ * @fn      GlucoseSensor_compactStore
+ *
+ * @brief   Erase one deleted sector of the record log, and schedule the
+ *          next one. Erases wait while a report is in progress, as flash
+ *          can't be read during an erase.
+ *
+ * @return  none
+ */
+static void GlucoseSensor_compactStore(void)
+{
+  if(glucoseSendRsp || glucoseSendMeas || glucoseSendContext ||
+     glucoseSendAllRecords || GlucoseStore_compact())
+  {
+    Util_startClock(&compactClock);
   }
 }
 
@@ -1362,9 +1723,14 @@ static void GlucoseSensor_processStateChangeEvt(gaprole_States_t newState)
 
     // Clear state variables.
     glucoseSendAllRecords = false;
+    glucoseSendMeas = false;
     glucoseSendContext = false;
+    glucoseSendRsp = false;
+    glucoseCocCID = 0;
+    glucoseCocBusy = false;
 
-    // Stop notification timer.
+    // Stop waiting to resume the report.
+    GlucoseSensor_resumeOnConnEvt(false);
     Util_stopClock(&notiTimeoutClock);
 
     if (newState == GAPROLE_WAITING_AFTER_TIMEOUT)
@@ -1512,165 +1878,100 @@ static void GlucoseSensor_processPasscodeEvt(uint16_t connHandle)
 /*********************************************************************
  * @fn      GlucoseSensor_measSend
  *
- * @brief   Prepare and send a glucose measurement
+ * @brief   Send the current record's glucose measurement. Records are
+ *          stored encoded, so this is a copy.
  *
- * @return  none
+ * @return  SUCCESS, blePending if this connection event's notifications
+ *          are used up, bleMemAllocError if no buffer is available, or
+ *          the status of the send
  */
-static void GlucoseSensor_measSend(void)
+static bStatus_t GlucoseSensor_measSend(void)
 {
-  if(glucoseMeasArray[glucoseMeasIdx].state == GLUCOSE_MEAS_STATE_ALL)
+  bStatus_t status = FAILURE;
+
+  if(glucoseNumQueued >= GLUCOSE_NOTI_PER_CONN_EVT)
+  {
+    status = blePending;
+  }
+  else if(glucoseCurRecId != 0)
   {
     attHandleValueNoti_t glucoseMeas;
 
     glucoseMeas.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_NOTI,
-                                       GLUCOSE_MEAS_LEN, NULL);
+                                       glucoseCurRec.measLen, NULL);
     if (glucoseMeas.pValue != NULL)
     {
-      // ATT value notification structure.
-      uint8_t *p = glucoseMeas.pValue;
-
-      uint8_t flags = glucoseMeasArray[glucoseMeasIdx].flags;
-
-      // Flags 1 byte long.
-      *p++ = flags;
-
-      // Sequence number.
-      *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].seqNum);
-      *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].seqNum);
-
-      // Base time; convert day and month from utc time to characteristic format.
-      *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].baseTime.year);
-      *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].baseTime.year);
-      *p++ = (glucoseMeasArray[glucoseMeasIdx].baseTime.month + 1);
-      *p++ = (glucoseMeasArray[glucoseMeasIdx].baseTime.day + 1);
-      *p++ = glucoseMeasArray[glucoseMeasIdx].baseTime.hour;
-      *p++ = glucoseMeasArray[glucoseMeasIdx].baseTime.minutes;
-      *p++ = glucoseMeasArray[glucoseMeasIdx].baseTime.seconds;
-
-      // Time offset.
-      if(flags & GLUCOSE_MEAS_FLAG_TIME_OFFSET)
-      {
-        *p++ =  LO_UINT16(glucoseMeasArray[glucoseMeasIdx].timeOffset);
-        *p++ =  HI_UINT16(glucoseMeasArray[glucoseMeasIdx].timeOffset);
-      }
-
-      // Concentration.
-      if(flags & GLUCOSE_MEAS_FLAG_CONCENTRATION)
-      {
-        *p++ = LO_UINT16(glucoseMeasArray[glucoseMeasIdx].concentration);
-        *p++ = HI_UINT16(glucoseMeasArray[glucoseMeasIdx].concentration);
-        *p++ =  glucoseMeasArray[glucoseMeasIdx].typeSampleLocation;
-      }
-
-      if(flags & GLUCOSE_MEAS_FLAG_STATUS_ANNUNCIATION)
-      {
-        *p++ =  LO_UINT16(glucoseMeasArray[glucoseMeasIdx].sensorStatus);
-        *p++ =  HI_UINT16(glucoseMeasArray[glucoseMeasIdx].sensorStatus);
-      }
-
-      glucoseMeas.len = (uint8_t) (p - glucoseMeas.pValue);
-
-      if(flags & GLUCOSE_MEAS_FLAG_CONTEXT_INFO)
-      {
-        glucoseSendContext = true;
-      }
+      memcpy(glucoseMeas.pValue, glucoseCurRec.meas, glucoseCurRec.measLen);
+      glucoseMeas.len = glucoseCurRec.measLen;
 
       // Send Measurement.
-      if (Glucose_MeasSend(gapConnHandle, &glucoseMeas,  selfEntity) != SUCCESS)
+      status = Glucose_MeasSend(gapConnHandle, &glucoseMeas,  selfEntity);
+      if (status != SUCCESS)
       {
         GATT_bm_free((gattMsg_t *)&glucoseMeas, ATT_HANDLE_VALUE_NOTI);
       }
-
-      // Start notification timer.
-      Util_startClock(&notiTimeoutClock);
+      else
+      {
+        glucoseNumQueued++;
+        glucoseSendContext = (glucoseCurRec.contextLen != 0);
+      }
+    }
+    else
+    {
+      status = bleMemAllocError;
     }
   }
+
+  return status;
 }
 
 /*********************************************************************
  * @fn      GlucoseSensor_contextSend
  *
- * @brief   Prepare and send a glucose measurement context.
+ * @brief   Send the current record's glucose measurement context.
  *
- * @return  none
+ * @return  SUCCESS, blePending if this connection event's notifications
+ *          are used up, bleMemAllocError if no buffer is available, or
+ *          the status of the send
  */
-static void GlucoseSensor_contextSend(void)
+static bStatus_t GlucoseSensor_contextSend(void)
 {
-  if(glucoseMeasArray[glucoseMeasIdx].state == GLUCOSE_MEAS_STATE_ALL)
+  bStatus_t status = FAILURE;
+
+  if(glucoseNumQueued >= GLUCOSE_NOTI_PER_CONN_EVT)
+  {
+    status = blePending;
+  }
+  else if(glucoseCurRecId != 0)
   {
     attHandleValueNoti_t glucoseContext;
 
     glucoseContext.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_NOTI,
-                                          GLUCOSE_CONTEXT_LEN, NULL);
+                                          glucoseCurRec.contextLen, NULL);
     if (glucoseContext.pValue != NULL)
     {
-      // ATT value notification structure.
-      uint8_t *p = glucoseContext.pValue;
-
-      uint8_t flags = glucoseContextArray[glucoseMeasIdx].flags;
-
-      // Flags 1 byte long.
-      *p++ = flags;
-
-      // Sequence number.
-      *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].seqNum);
-      *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].seqNum);
-
-      if(flags & GLUCOSE_CONTEXT_FLAG_EXTENDED)
-      {
-        *p++ = glucoseContextArray[glucoseMeasIdx].extendedFlags;
-      }
-
-      if(flags & GLUCOSE_CONTEXT_FLAG_CARBO)
-      {
-        *p++ = glucoseContextArray[glucoseMeasIdx].carboId;
-        *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].carboVal);
-        *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].carboVal);
-      }
-
-      if (flags & GLUCOSE_CONTEXT_FLAG_MEAL)
-      {
-        *p++ = glucoseContextArray[glucoseMeasIdx].mealVal;
-      }
-
-      if(flags & GLUCOSE_CONTEXT_FLAG_TESTER_HEALTH)
-      {
-        *p++ = glucoseContextArray[glucoseMeasIdx].TesterHealthVal;
-      }
-
-      if(flags & GLUCOSE_CONTEXT_FLAG_EXERCISE)
-      {
-        *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].exerciseDuration);
-        *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].exerciseDuration);
-        *p++ = glucoseContextArray[glucoseMeasIdx].exerciseIntensity;
-      }
-
-      if(flags & GLUCOSE_CONTEXT_FLAG_MEDICATION)
-      {
-        *p++ = glucoseContextArray[glucoseMeasIdx].medId;
-        *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].medVal);
-        *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].medVal);
-      }
-
-      if(flags & GLUCOSE_CONTEXT_FLAG_HbA1c)
-      {
-        *p++ = LO_UINT16(glucoseContextArray[glucoseMeasIdx].HbA1cVal);
-        *p++ = HI_UINT16(glucoseContextArray[glucoseMeasIdx].HbA1cVal);
-      }
-
-      glucoseContext.len = (uint8_t) (p - glucoseContext.pValue);
+      memcpy(glucoseContext.pValue, glucoseCurRec.context,
+             glucoseCurRec.contextLen);
+      glucoseContext.len = glucoseCurRec.contextLen;
 
       // Send Measurement.
-      if (Glucose_ContextSend(gapConnHandle, &glucoseContext,
-                              selfEntity) != SUCCESS)
+      status = Glucose_ContextSend(gapConnHandle, &glucoseContext, selfEntity);
+      if (status != SUCCESS)
       {
         GATT_bm_free((gattMsg_t *)&glucoseContext, ATT_HANDLE_VALUE_NOTI);
       }
-
-      // Start notification timer.
-      Util_startClock(&notiTimeoutClock);
+      else
+      {
+        glucoseNumQueued++;
+      }
+    }
+    else
+    {
+      status = bleMemAllocError;
     }
   }
+
+  return status;
 }
 
 /*********************************************************************
@@ -1681,12 +1982,12 @@ static void GlucoseSensor_contextSend(void)
  * @param   rspCode - the status code of the operation
  * @param   opcode - control point opcode
  *
- * @return  none
+ * @return  status of the indication
  */
-static void GlucoseSensor_ctlPntRsp(uint8_t rspCode, uint8_t opcode)
+static bStatus_t GlucoseSensor_ctlPntRsp(uint8_t rspCode, uint8_t opcode)
 {
-  GlucoseSensor_ctlPntIndicate(CTL_PNT_OP_REQ_RSP, CTL_PNT_OPER_NULL,
-                               opcode, rspCode);
+  return GlucoseSensor_ctlPntIndicate(CTL_PNT_OP_REQ_RSP, CTL_PNT_OPER_NULL,
+                                      opcode, rspCode);
 }
 
 /*********************************************************************
@@ -1715,12 +2016,14 @@ static void GlucoseSensor_ctlPntNumRecRsp(uint16_t numRecords)
  * @param   value0 - first value
  * @param   value1 - second value
  *
- * @return  none
+ * @return  SUCCESS, bleMemAllocError if no buffer is available, or the
+ *          status of the send
  */
-static void GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
-                                         uint8_t value0, uint8_t value1)
+static bStatus_t GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
+                                              uint8_t value0, uint8_t value1)
 {
   attHandleValueInd_t glucoseCtlPntRsp;
+  bStatus_t status = bleMemAllocError;
 
   glucoseCtlPntRsp.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_IND,
                                           GLUCOSE_CTL_PNT_LEN, NULL);
@@ -1733,12 +2036,15 @@ static void GlucoseSensor_ctlPntIndicate(uint8_t opcode, uint8_t oper,
     glucoseCtlPntRsp.pValue[3] = value1;
 
     // Send indication.
-    if (Glucose_CtlPntIndicate(gapConnHandle, &glucoseCtlPntRsp,
-                               selfEntity) != SUCCESS)
+    status = Glucose_CtlPntIndicate(gapConnHandle, &glucoseCtlPntRsp,
+                                    selfEntity);
+    if (status != SUCCESS)
     {
       GATT_bm_free((gattMsg_t *)&glucoseCtlPntRsp, ATT_HANDLE_VALUE_IND);
     }
   }
+
+  return status;
 }
 
 /*********************************************************************
@@ -1803,118 +2109,15 @@ static void GlucoseSensor_processServiceEvt(uint8_t event, uint8_t* valueP, uint
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecords
+ * @fn      GlucoseSensor_verifyTime
  *
- * @brief   Set the valid/filtered flags in the measurement array.
+ * @brief   Verify time values are suitable for filtering.
  *
- * @param   setBits - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   pTime - UTC time struct
  *
- * @return  number of valid records set or cleared.
+ * @return  true if time is ok, false otherwise
  */
-static uint8_t GlucoseSensor_markAllRecords(bool setBits, uint8_t mask)
-{
-  uint8_t i;
-  uint8_t count = 0;
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-    {
-      count++;
-    }
-
-    if(setBits)
-    {
-      glucoseMeasArray[i].state |= mask;
-    }
-    else
-    {
-      glucoseMeasArray[i].state &= ~mask;
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markFirstValidRec
- *
- * @brief   Set the state in the first valid record.
- *
- * @param   setBits - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markFirstValidRec(bool setBits, uint8_t mask)
-{
-  uint8_t i;
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-    {
-      if(setBits)
-      {
-        glucoseMeasArray[i].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-
-      return 1;
-    }
-  }
-
-  return 0;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markLastValidRec
- *
- * @brief   Set the state in the last valid record.
- *
- * @param   setBits - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markLastValidRec(bool setBits, uint8_t mask)
-{
-  uint8_t i;
-
-  for(i = MEAS_IDX_MAX; i > 0; i--)
-  {
-    if(glucoseMeasArray[i-1].state & GLUCOSE_MEAS_STATE_VALID)
-    {
-      if(setBits)
-      {
-        glucoseMeasArray[i-1].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i-1].state &= ~mask;
-      }
-
-      return 1;
-    }
-  }
-
-  return 0;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_verifyTime
- *
- * @brief   Verify time values are suitable for filtering.
- *
- * @param   pTime - UTC time struct
- *
- * @return  true if time is ok, false otherwise
- */
-static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime)
+static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime)
 {
   // Sanity check year.
   if (pTime->year < 2000 || pTime->year > 2111)
@@ -1941,106 +2144,77 @@ static uint8_t GlucoseSensor_verifyTime(UTCTimeStruct *pTime)
 }
 
 /*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsEarlierThanTime
+ * @fn      GlucoseSensor_buildFilter
  *
- * @brief   Mark all records earlier than a specific time.
+ * @brief   Build a record store filter for a particular operator.
  *
- * @param   pTime - time filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
+ * @param   oper - control point operator
+ * @param   filterType - control point filter type
+ * @param   param1 - filter (if applicable), otherwise NULL
+ * @param   param2 - filter (if applicable), otherwise NULL
+ * @param   opcode - control point opcode
+ * @param   pFilter - filter to build
  *
- * @return  number of valid records set or cleared.
+ * @return  true if the filter can select records, false otherwise
  */
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanTime(UTCTimeStruct *pTime,
-                                                           bool set,
-                                                           uint8_t mask)
+static bool GlucoseSensor_buildFilter(uint8_t oper, uint8_t filterType,
+                                      void *param1, void *param2,
+                                      uint8_t opcode,
+                                      glucoseStoreFilter_t *pFilter)
 {
-  uint8_t i;
-  uint8_t count = 0;
-  UTCTime testTime;
+  pFilter->oper = oper;
+  pFilter->filterType = filterType;
 
-  if (GlucoseSensor_verifyTime(pTime) == false)
+  switch(oper)
   {
-    return 0;
-  }
-
-  testTime = UTC_convertUTCSecs(pTime);
+    case CTL_PNT_OPER_NULL:
+      GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_NOT_SUPPORTED, opcode);
+      return false;
 
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    UTCTime recordTime = UTC_convertUTCSecs(&glucoseMeasArray[i].baseTime) +
-                         glucoseMeasArray[i].timeOffset;
+    case CTL_PNT_OPER_ALL:
+    case CTL_PNT_OPER_FIRST:
+    case CTL_PNT_OPER_LAST:
+      break;
 
-    if(recordTime <= testTime)
-    {
-      if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
+    case CTL_PNT_OPER_RANGE:
+    case CTL_PNT_OPER_LESS_EQUAL:
+    case CTL_PNT_OPER_GREATER_EQUAL:
+      if (filterType == CTL_PNT_FILTER_SEQNUM)
       {
-        count++;
-      }
+        pFilter->seqNum1 = *(uint16_t *)param1;
 
-      if(set)
-      {
-        glucoseMeasArray[i].state |= mask;
+        if (param2 != NULL)
+        {
+          pFilter->seqNum2 = *(uint16_t *)param2;
+        }
       }
       else
       {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsLaterThanTime
- *
- * @brief   Mark all records later than a specific time.
- *
- * @param   pTime - time filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markAllRecordsLaterThanTime(UTCTimeStruct *pTime,
-                                                         bool set, uint8_t mask)
-{
-  uint8_t i;
-  uint8_t count = 0;
-  UTCTime testTime;
-
-  if (GlucoseSensor_verifyTime(pTime) == false)
-  {
-    return 0;
-  }
+        if (GlucoseSensor_verifyTime(param1) == false)
+        {
+          return false;
+        }
 
-  testTime = UTC_convertUTCSecs(pTime);
+        pFilter->time1 = UTC_convertUTCSecs(param1);
 
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    UTCTime recordTime = UTC_convertUTCSecs(&glucoseMeasArray[i].baseTime) +
-                         glucoseMeasArray[i].timeOffset;
+        if (param2 != NULL)
+        {
+          if (GlucoseSensor_verifyTime(param2) == false)
+          {
+            return false;
+          }
 
-    if(recordTime >= testTime)
-    {
-      if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-      {
-        count++;
+          pFilter->time2 = UTC_convertUTCSecs(param2);
+        }
       }
+      break;
 
-      if(set)
-      {
-        glucoseMeasArray[i].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-    }
+    default:
+      GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_INVALID, opcode);
+      return false;
   }
 
-  return count;
+  return true;
 }
 
 /*********************************************************************
@@ -2095,329 +2269,6 @@ bStatus_t GlucoseSensor_UnRegistertToAllConnectionEvent (connectionEventRegister
   return(status);
 }
 
-/*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsInRangeTime
- *
- * @brief   Mark all records between two times.
- *
- * @param   pTime1 - time filter low end of range
- * @param   pTime2 - time filter high end of range
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markAllRecordsInRangeTime(UTCTimeStruct *pTime1,
-                                                       UTCTimeStruct *pTime2,
-                                                       bool set, uint8_t mask)
-{
-  uint8_t i;
-  uint8_t count = 0;
-  UTCTime lowEnd, highEnd;
-
-  if (GlucoseSensor_verifyTime(pTime1) == false)
-  {
-    return 0;
-  }
-
-  if (GlucoseSensor_verifyTime(pTime2) == false)
-  {
-    return 0;
-  }
-
-  lowEnd = UTC_convertUTCSecs(pTime1);
-  highEnd = UTC_convertUTCSecs(pTime2);
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    UTCTime recordTime = UTC_convertUTCSecs(&glucoseMeasArray[i].baseTime) +
-                         glucoseMeasArray[i].timeOffset;
-
-    if((recordTime >= lowEnd) && (recordTime <= highEnd))
-    {
-      if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-      {
-        count++;
-      }
-
-      if(set)
-      {
-        glucoseMeasArray[i].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsEarlierThanSeqNum
- *
- * @brief   Mark all records earlier than a specific sequence number.
- *
- * @param   pSeqNum - filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markAllRecordsEarlierThanSeqNum(uint16_t *pSeqNum,
-                                                             bool set,
-                                                             uint8_t mask)
-{
-  uint8_t i;
-  uint8_t count = 0;
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    if(glucoseMeasArray[i].seqNum <= *pSeqNum)
-    {
-      if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-      {
-        count++;
-      }
-
-      if(set)
-      {
-        glucoseMeasArray[i].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsLaterThanSeqNum
- *
- * @brief   Mark all records later than a specific sequence number.
- *
- * @param   pSeqNum - filter
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markAllRecordsLaterThanSeqNum(uint16_t *pSeqNum,
-                                                           bool set,
-                                                           uint8_t mask)
-{
-  uint8_t i;
-  uint8_t count = 0;
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    if(glucoseMeasArray[i].seqNum >= *pSeqNum)
-    {
-      if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-      {
-        count++;
-      }
-
-      if(set)
-      {
-        glucoseMeasArray[i].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_markAllRecordsInRangeSeqNum
- *
- * @brief   Mark all records between two sequence numbers.
- *
- * @param   pSeqNum1 - filter low end of range
- * @param   pSeqNum2 - filter high end of range
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- *
- * @return  number of valid records set or cleared.
- */
-static uint8_t GlucoseSensor_markAllRecordsInRangeSeqNum(uint16_t *pSeqNum1,
-                                                         uint16_t *pSeqNum2,
-                                                         bool set, uint8_t mask)
-{
-  uint8_t i;
-  uint8_t count = 0;
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    if((glucoseMeasArray[i].seqNum >= *pSeqNum1) &&
-       (glucoseMeasArray[i].seqNum <= *pSeqNum2))
-    {
-      if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-      {
-        count++;
-      }
-
-      if(set)
-      {
-        glucoseMeasArray[i].state |= mask;
-      }
-      else
-      {
-        glucoseMeasArray[i].state &= ~mask;
-      }
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_filterRecords
- *
- * @brief   Call the correct filter function for a particular operator.
- *
- * @param   oper - control point operator
- * @param   filterType - control point filter type
- * @param   param1 - filter (if applicable), otherwise NULL
- * @param   param2 - filter (if applicable), otherwise NULL
- * @param   set - if true bits are set, otherwise cleared
- * @param   mask - bits to set or clear
- * @param   opcode - control point opcode
- *
- * @return  number of valid records within filter times
- */
-static uint8_t GlucoseSensor_filterRecords(uint8_t oper, uint8_t filterType,
-                                           void *param1, void *param2, bool set,
-                                           uint8_t mask, uint8_t opcode)
-{
-  uint8_t numFiltered = 0;
-
-  switch(oper)
-  {
-    case CTL_PNT_OPER_NULL:
-      GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_NOT_SUPPORTED, opcode);
-      break;
-
-    case CTL_PNT_OPER_ALL:
-      numFiltered = GlucoseSensor_markAllRecords(set, mask);
-      break;
-
-    case CTL_PNT_OPER_FIRST:
-      numFiltered = GlucoseSensor_markFirstValidRec(set, mask);
-      break;
-
-    case CTL_PNT_OPER_LAST:
-      numFiltered = GlucoseSensor_markLastValidRec(set, mask);
-      break;
-
-    case CTL_PNT_OPER_RANGE:
-      if (filterType == CTL_PNT_FILTER_SEQNUM)
-      {
-        numFiltered = GlucoseSensor_markAllRecordsInRangeSeqNum(param1, param2,
-                                                                set, mask);
-      }
-      else
-      {
-        numFiltered = GlucoseSensor_markAllRecordsInRangeTime(param1, param2,
-                                                              set, mask);
-      }
-      break;
-
-    case CTL_PNT_OPER_LESS_EQUAL:
-      if (filterType == CTL_PNT_FILTER_SEQNUM)
-      {
-        numFiltered = GlucoseSensor_markAllRecordsEarlierThanSeqNum(param1, set,
-                                                                    mask);
-      }
-      else
-      {
-        numFiltered = GlucoseSensor_markAllRecordsEarlierThanTime(param1, set,
-                                                                  mask);
-      }
-      break;
-
-    case CTL_PNT_OPER_GREATER_EQUAL:
-      if (filterType == CTL_PNT_FILTER_SEQNUM)
-      {
-        numFiltered = GlucoseSensor_markAllRecordsLaterThanSeqNum(param1, set,
-                                                                  mask);
-      }
-      else
-      {
-        numFiltered = GlucoseSensor_markAllRecordsLaterThanTime(param1, set,
-                                                                mask);
-      }
-      break;
-
-    default:
-      GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_OPER_INVALID, opcode);
-      break;
-  }
-
-  return numFiltered;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_findNumValidRecords
- *
- * @brief   Count number of valid records in the array.
- *
- * @return  number of valid records
- */
-static uint8_t GlucoseSensor_findNumValidRecords(void)
-{
-  uint8_t i;
-  uint8_t count = 0;
-
-  for(i = 0; i < MEAS_IDX_MAX; i++)
-  {
-    if(glucoseMeasArray[i].state & GLUCOSE_MEAS_STATE_VALID)
-    {
-      count++;
-    }
-  }
-
-  return count;
-}
-
-/*********************************************************************
- * @fn      GlucoseSensor_findFirstValidFilteredIdx
- *
- * @brief   Find the first valid entry, that also is in the last filter.
- *
- * @param   startIndex - starting index of search
- *
- * @return  index of next valid and filtered record or MEAS_IDX_MAX if none
- */
-static uint8_t GlucoseSensor_findFirstValidFilteredIdx(uint8_t startIndex)
-{
-  uint8_t i;
-
-  if(startIndex >= MEAS_IDX_MAX)
-  {
-    return MEAS_IDX_MAX;
-  }
-
-  for(i = startIndex; i < MEAS_IDX_MAX; i++)
-  {
-    if(glucoseMeasArray[i].state == GLUCOSE_MEAS_STATE_ALL)
-    {
-      break;
-    }
-  }
-
-  return i;
-}
-
-
 /*********************************************************************
  * @fn      GlucoseSensor_ctlPntHandleOpcode
  *
@@ -2435,20 +2286,22 @@ static void GlucoseSensor_ctlPntHandleOpcode(uint8_t opcode, uint8_t oper,
                                              uint8_t filterType, void *param1,
                                              void *param2)
 {
+  glucoseStoreFilter_t filter;
+
   switch(opcode)
   {
   case CTL_PNT_OP_REQ:
-    //Clear all filter bits, before running the new test.
-    GlucoseSensor_markAllRecords(false, GLUCOSE_MEAS_STATE_FILTER_PASS);
+    glucoseCurRecId = 0;
 
-    if(GlucoseSensor_filterRecords(oper, filterType, param1, param2, true,
-                                   GLUCOSE_MEAS_STATE_FILTER_PASS, opcode) > 0)
+    if(GlucoseSensor_buildFilter(oper, filterType, param1, param2, opcode,
+                                 &glucoseReportFilter) &&
+       GlucoseStore_find(&glucoseReportFilter, &glucoseCurRecId,
+                         &glucoseCurRec))
     {
       glucoseSendAllRecords = true;
+      glucoseSendMeas = true;
 
-      glucoseMeasIdx = GlucoseSensor_findFirstValidFilteredIdx(0);
-
-      GlucoseSensor_measSend();
+      GlucoseSensor_sendNext();
     }
     else
     {
@@ -2458,9 +2311,13 @@ static void GlucoseSensor_ctlPntHandleOpcode(uint8_t opcode, uint8_t oper,
     break;
 
   case CTL_PNT_OP_CLR:
-    if(GlucoseSensor_filterRecords(oper, filterType, param1, param2, false,
-                                   GLUCOSE_MEAS_STATE_VALID, opcode) > 0)
+    if(GlucoseSensor_buildFilter(oper, filterType, param1, param2, opcode,
+                                 &filter) &&
+       (GlucoseStore_delete(&filter) > 0))
     {
+      // The deleted sectors are erased later, in the background.
+      Util_startClock(&compactClock);
+
       GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, opcode);
     }
     else
@@ -2471,26 +2328,33 @@ static void GlucoseSensor_ctlPntHandleOpcode(uint8_t opcode, uint8_t oper,
     break;
 
   case CTL_PNT_OP_ABORT:
+    // Drop the report's pending records. At most one connection event of
+    // notifications is queued ahead of the response, which is retried on
+    // the next event if there's no buffer for it now.
     glucoseSendAllRecords = false;
 
+    glucoseSendMeas = false;
+
     glucoseSendContext = false;
 
-    //Stop notification timer.
-    Util_stopClock(&notiTimeoutClock);
+    glucoseRspOpcode = opcode;
+    glucoseRspCode = CTL_PNT_RSP_SUCCESS;
+    glucoseSendRsp = true;
 
-    GlucoseSensor_ctlPntRsp(CTL_PNT_RSP_SUCCESS, opcode);
+    GlucoseSensor_sendNext();
 
     break;
 
   case CTL_PNT_OP_GET_NUM:
-    // Clear all previous filter bits before running the test.
-    GlucoseSensor_markAllRecords(false, GLUCOSE_MEAS_STATE_FILTER_PASS);
-
-    GlucoseSensor_ctlPntNumRecRsp(GlucoseSensor_filterRecords(oper, filterType,
-                                                              param1, param2,
-                                                              true,
-                                                              GLUCOSE_MEAS_STATE_FILTER_PASS,
-                                                              opcode));
+    if(GlucoseSensor_buildFilter(oper, filterType, param1, param2, opcode,
+                                 &filter))
+    {
+      GlucoseSensor_ctlPntNumRecRsp(GlucoseStore_count(&filter));
+    }
+    else
+    {
+      GlucoseSensor_ctlPntNumRecRsp(0);
+    }
     break;
 
   default:
@@ -2569,6 +2433,13 @@ static void GlucoseSensor_processConnEvt(Gap_ConnEventRpt_t *pReport)
       }
     }
 
+    if( CONNECTION_EVENT_REGISTRATION_CAUSE(FOR_RACP_REPORT))
+    {
+      // Buffers freed up during the event; resume the stalled report.
+      glucoseNumQueued = 0;
+      GlucoseSensor_sendNext();
+    }
+
 }
 
 /*********************************************************************
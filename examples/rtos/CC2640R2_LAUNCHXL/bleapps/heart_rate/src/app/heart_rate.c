@@ -72,13 +72,21 @@
 #include "board.h"
 
 #include "heart_rate.h"
+#include "heart_rate_ecg.h"
 
 /*********************************************************************
  * MACROS
  */
 
-// Convert BPM to RR-Interval for data simulation purposes.
-#define HEARTRATE_BPM2RR(bpm)            ((uint16) 60 * 1024 / (uint16) (bpm))
+// Convert BPM and ms to ECG samples for data simulation purposes.
+#define HEARTRATE_BPM2SAMPLES(bpm)                                        \
+    ((uint16) (60 * HEARTRATE_ECG_SAMPLE_RATE) / (uint16) (bpm))
+#define HEARTRATE_MS2SAMPLES(ms)                                          \
+    ((ms) * HEARTRATE_ECG_SAMPLE_RATE / 1000)
+
+// Number of RR-intervals in the ring.
+#define HEARTRATE_RR_COUNT()             ((uint8_t) (heartRateRrHead - \
+                                                     heartRateRrTail))
 
 // Set the register cause to the registration bit-mask
 #define CONNECTION_EVENT_REGISTER_BIT_SET(RegisterCause) (connectionEventRegisterCauseBitMap |= RegisterCause )
@@ -136,10 +144,48 @@
 // Arbitrary values used to simulate measurements.
 #define HEARTRATE_BPM_DEFAULT                           73
 #define HEARTRATE_BPM_MAX                               80
-#define HEARTRATE_ENERGY_INCREMENT                      10
 #define HEARTRATE_FLAGS_IDX_MAX                         7
 
-#define HEARTRATE_MEAS_LEN                              9
+// ECG sample rate in Hz, and the sensor clock period in ms that samples
+// it. Independent of the measurement notification period.
+#define HEARTRATE_ECG_SAMPLE_RATE                       250
+#define HEARTRATE_SENSOR_PERIOD          (1000 / HEARTRATE_ECG_SAMPLE_RATE)
+
+// Simulated ECG: R-wave and T-wave peak amplitudes (ADC counts), and
+// half-widths and delays from the start of the beat (ms).
+#define HEARTRATE_SIM_R_AMP                             1000
+#define HEARTRATE_SIM_R_HALF_WIDTH                      20
+#define HEARTRATE_SIM_T_AMP                             250
+#define HEARTRATE_SIM_T_DELAY                           240
+#define HEARTRATE_SIM_T_HALF_WIDTH                      80
+
+// Energy expended model, after Keytel et al. for a 70 kg, 35 year old
+// man: 0.631 kJ/min per bpm less 34.1 kJ/min, but no less than a resting
+// 80 W. Over one beat of RR s that comes to 631 J - 569 W * RR.
+#define HEARTRATE_ENERGY_PER_BEAT                       631  // J
+#define HEARTRATE_ENERGY_OFFSET                         569  // W
+#define HEARTRATE_ENERGY_REST                           80   // W
+
+// One kJ in the units of the energy accumulator, J/1024.
+#define HEARTRATE_ENERGY_KJ                      ((uint32_t) 1000 * 1024)
+
+// The energy expended field saturates at this value, in kJ.
+#define HEARTRATE_ENERGY_MAX                            0xFFFF
+
+// Energy expended is only sent in every Nth measurement, as the profile
+// suggests, to keep notifications short.
+#define HEARTRATE_ENERGY_NOTI_PERIOD                    10
+
+// Number of sensor samples buffered between measurements, a power of two
+#define HEARTRATE_SAMPLE_RING_SIZE                      16
+
+// Size of the ATT notification header (opcode and handle)
+#define HEARTRATE_NOTI_HDR_LEN                          3
+
+// Number of RR-intervals kept until they are sent, a power of two. Each
+// notification carries as many of them as the MTU allows; the oldest are
+// dropped if the ring fills up.
+#define HEARTRATE_RR_RING_SIZE                          32
 
 // Task configuration
 #define HEARTRATE_TASK_PRIORITY                         1
@@ -163,7 +209,6 @@
                                                          HEARTRATE_MEAS_PERIODIC_EVT | \
                                                          HEARTRATE_BATT_PERIODIC_EVT)
 
-#define HEARTRATE_MEAS_LEN                              9
 /*********************************************************************
  * TYPEDEFS
  */
@@ -175,6 +220,12 @@ typedef struct
     uint8_t *pData;  // event data
 } heartRateEvt_t;
 
+// A heart rate sensor sample: one detected beat.
+typedef struct
+{
+    uint16_t rrInterval;  // Time since the previous beat, 1/1024 s
+} heartRateSample_t;
+
 typedef enum
 {
     NOT_REGISTER = 0,
@@ -220,6 +271,9 @@ static Clock_Struct measPerClock;
 
 static Clock_Struct battPerClock;
 
+// Clock for sampling the heart rate sensor.
+static Clock_Struct sensorClock;
+
 // Queue object used for app messages
 static Queue_Struct appMsg;
 static Queue_Handle appMsgQueue;
@@ -256,11 +310,35 @@ static uint8_t attDeviceName[GAP_DEVICE_NAME_LEN] = "Heart Rate Sensor";
 // GAP connection handle.
 static uint16_t gapConnHandle;
 
+// ATT MTU of the connection.
+static uint16_t heartRateMtu = ATT_MTU_SIZE;
+
 // Components of heart rate measurement structure.
-static uint8_t heartRateBpm = HEARTRATE_BPM_DEFAULT;
+static uint16_t heartRateBpm = HEARTRATE_BPM_DEFAULT;
 static uint16_t heartRateEnergyLvl = 0;
-static uint16_t heartRateRrInterval = HEARTRATE_BPM2RR(HEARTRATE_BPM_DEFAULT);
-static uint16_t heartRateRrInterval2 = HEARTRATE_BPM2RR(HEARTRATE_BPM_DEFAULT);
+
+// Energy expended not yet making up a whole kJ, in J/1024.
+static uint32_t heartRateEnergyFrac = 0;
+
+// Measurements since energy expended was last sent.
+static uint8_t heartRateEnergyNotiCnt = 0;
+
+// RR-intervals (1/1024 s) not yet notified. The indices run freely and
+// are masked on access.
+static uint16_t heartRateRrRing[HEARTRATE_RR_RING_SIZE];
+static uint8_t heartRateRrHead = 0;
+static uint8_t heartRateRrTail = 0;
+
+// Sensor samples not yet aggregated into a measurement. The sensor clock
+// is the only writer and advances the head; the application task is the
+// only reader and advances the tail, so neither needs a lock.
+static heartRateSample_t heartRateSampleRing[HEARTRATE_SAMPLE_RING_SIZE];
+static volatile uint8_t heartRateSampleHead = 0;
+static volatile uint8_t heartRateSampleTail = 0;
+
+// Simulated sensor state, only used by the sensor clock.
+static uint8_t heartRateSimBpm = HEARTRATE_BPM_DEFAULT;
+static uint16_t heartRateSimPhase = 0;    // ECG samples into the beat
 
 // Advertising user-cancelled state.
 static bool advCancelled = FALSE;
@@ -296,6 +374,16 @@ static void HeartRate_clockHandler(UArg arg);
 static void HeartRate_measPerTask(void);
 static void HeartRate_battPerTask(void);
 static void HeartRate_measNotify(void);
+static void HeartRate_rrPush(uint16_t rrInterval);
+static void HeartRate_sensorClockHandler(UArg arg);
+static int16_t HeartRate_simulateEcg(void);
+static int16_t HeartRate_simulateWave(uint16_t phase, uint16_t start,
+                                      uint16_t halfWidth, int16_t amp);
+static bool HeartRate_samplePut(const heartRateSample_t *pSample);
+static bool HeartRate_sampleGet(heartRateSample_t *pSample);
+static void HeartRate_aggregateSamples(void);
+static void HeartRate_energyAccumulate(uint16_t rrInterval);
+static void HeartRate_energyReset(void);
 static bool HeartRate_toggleAdvertising(void);
 
 // Events and callbacks for profiles and keys.
@@ -398,6 +486,10 @@ void HeartRate_init(void)
     DEFAULT_BATT_PERIOD,
                         0, false,
                         HEARTRATE_BATT_PERIODIC_EVT);
+    Util_constructClock(&sensorClock, HeartRate_sensorClockHandler,
+                        HEARTRATE_SENSOR_PERIOD, HEARTRATE_SENSOR_PERIOD,
+                        false, 0);
+    HeartRateEcg_init(HEARTRATE_ECG_SAMPLE_RATE);
 
     // Initialize keys on SRF06.
     Board_initKeys(HeartRate_keyPressHandler);
@@ -682,6 +774,12 @@ static void HeartRate_processStackMsg(ICall_Hdr *pMsg)
  */
 static void HeartRate_processGattMsg(gattMsgEvent_t *pMsg)
 {
+    if (pMsg->method == ATT_MTU_UPDATED_EVENT)
+    {
+        // Sets how many RR-intervals fit in a notification.
+        heartRateMtu = pMsg->msg.mtuEvt.MTU;
+    }
+
     GATT_bm_free(&pMsg->msg, pMsg->method);
 }
 
@@ -822,30 +920,86 @@ static bool HeartRate_toggleAdvertising(void)
 /*********************************************************************
  * @fn      HeartRate_measNotify
  *
- * @brief   Prepare and send a heart rate measurement notification.
+ * @brief   Prepare and send a heart rate measurement notification. All
+ *          pending RR-intervals that fit in the connection's MTU are
+ *          sent; the rest wait for the next notification.
  *
  * @return  none
  */
 static void HeartRate_measNotify(void)
 {
     attHandleValueNoti_t heartRateMeas;
+    uint8_t flags = heartRateflags[flagsIdx];
+    uint16_t len;
+    uint8_t numRr = 0;
+
+    // Contact status comes from the ECG, if it's supported.
+    if (flags & HEARTRATE_FLAGS_CONTACT_NOT_DET)
+    {
+        flags = (flags & ~HEARTRATE_FLAGS_CONTACT_DET) |
+                (HeartRateEcg_getContact() ? HEARTRATE_FLAGS_CONTACT_DET :
+                                             HEARTRATE_FLAGS_CONTACT_NOT_DET);
+    }
+
+    // Energy expended is only sent every HEARTRATE_ENERGY_NOTI_PERIOD
+    // measurements.
+    if (heartRateEnergyNotiCnt != 0)
+    {
+        flags &= ~HEARTRATE_FLAGS_ENERGY_EXP;
+    }
+
+    if (++heartRateEnergyNotiCnt == HEARTRATE_ENERGY_NOTI_PERIOD)
+    {
+        heartRateEnergyNotiCnt = 0;
+    }
+
+    // A heart rate above 255 bpm only fits the 16 bit format.
+    if (heartRateBpm > 0xFF)
+    {
+        flags |= HEARTRATE_FLAGS_FORMAT_UINT16;
+    }
+
+    // Flags and heart rate value.
+    len = (flags & HEARTRATE_FLAGS_FORMAT_UINT16) ? 3 : 2;
+
+    if (flags & HEARTRATE_FLAGS_ENERGY_EXP)
+    {
+        len += 2;
+    }
+
+    if (flags & HEARTRATE_FLAGS_RR)
+    {
+        numRr = HEARTRATE_RR_COUNT();
+
+        if (numRr > (heartRateMtu - HEARTRATE_NOTI_HDR_LEN - len) / 2)
+        {
+            numRr = (heartRateMtu - HEARTRATE_NOTI_HDR_LEN - len) / 2;
+        }
+
+        // The RR-interval field is only present if there's an RR-interval.
+        if (numRr == 0)
+        {
+            flags &= ~HEARTRATE_FLAGS_RR;
+        }
+
+        len += numRr * 2;
+    }
 
     heartRateMeas.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_NOTI,
-    HEARTRATE_MEAS_LEN,
-                                         NULL);
+                                         len, NULL);
     if (heartRateMeas.pValue != NULL)
     {
         uint8_t *p = heartRateMeas.pValue;
-        uint8_t flags = heartRateflags[flagsIdx];
+        uint8_t i;
 
-        // Build heart rate measurement structure from simulated values.
+        // Build heart rate measurement structure.
         *p++ = flags;
-        *p++ = heartRateBpm;
+        *p++ = LO_UINT16(heartRateBpm);
 
         if (flags & HEARTRATE_FLAGS_FORMAT_UINT16)
         {
             // Additional byte for 16 bit format.
-            *p++ = 0;
+            *p++ = HI_UINT16(heartRateBpm);
         }
 
         if (flags & HEARTRATE_FLAGS_ENERGY_EXP)
@@ -854,34 +1008,275 @@ static void HeartRate_measNotify(void)
             *p++ = HI_UINT16(heartRateEnergyLvl);
         }
 
-        if (flags & HEARTRATE_FLAGS_RR)
+        // Oldest first.
+        for (i = 0; i < numRr; i++)
         {
-            *p++ = LO_UINT16(heartRateRrInterval);
-            *p++ = HI_UINT16(heartRateRrInterval);
-            *p++ = LO_UINT16(heartRateRrInterval2);
-            *p++ = HI_UINT16(heartRateRrInterval2);
+            uint8_t idx = (heartRateRrTail + i) & (HEARTRATE_RR_RING_SIZE - 1);
+
+            *p++ = LO_UINT16(heartRateRrRing[idx]);
+            *p++ = HI_UINT16(heartRateRrRing[idx]);
         }
 
         heartRateMeas.len = (uint8) (p - heartRateMeas.pValue);
 
-        // Send notification.
+        // Send notification. RR-intervals that weren't sent stay queued.
         if (HeartRate_MeasNotify(gapConnHandle, &heartRateMeas) != SUCCESS)
         {
             GATT_bm_free((gattMsg_t*) &heartRateMeas, ATT_HANDLE_VALUE_NOTI);
         }
+        else
+        {
+            heartRateRrTail += numRr;
+        }
+    }
+}
 
-        // Update simulated values.
-        heartRateEnergyLvl += HEARTRATE_ENERGY_INCREMENT;
-        if (++heartRateBpm == HEARTRATE_BPM_MAX)
+/*********************************************************************
+ * @fn      HeartRate_rrPush
+ *
+ * @brief   Queue an RR-interval for the next notification, dropping the
+ *          oldest one if the ring is full.
+ *
+ * @param   rrInterval - RR-interval in 1/1024 s
+ *
+ * @return  none
+ */
+static void HeartRate_rrPush(uint16_t rrInterval)
+{
+    if (HEARTRATE_RR_COUNT() == HEARTRATE_RR_RING_SIZE)
+    {
+        heartRateRrTail++;
+    }
+
+    heartRateRrRing[heartRateRrHead & (HEARTRATE_RR_RING_SIZE - 1)] =
+            rrInterval;
+    heartRateRrHead++;
+}
+
+/*********************************************************************
+ * @fn      HeartRate_sensorClockHandler
+ *
+ * @brief   Take an ECG sample and run beat detection on it. Runs in clock
+ *          (SWI) context, so a detected beat is only queued; it is
+ *          aggregated into a measurement later by the application task.
+ *
+ * @param   arg - unused
+ *
+ * @return  none
+ */
+static void HeartRate_sensorClockHandler(UArg arg)
+{
+    heartRateSample_t sample;
+
+    if (HeartRateEcg_process(HeartRate_simulateEcg(), &sample.rrInterval))
+    {
+        // If the task has fallen behind, the beat is lost.
+        HeartRate_samplePut(&sample);
+    }
+}
+
+/*********************************************************************
+ * @fn      HeartRate_simulateEcg
+ *
+ * @brief   Simulate an ECG sample: an R-wave and a T-wave on a flat
+ *          baseline, at a heart rate that steps up with each beat.
+ *
+ * @return  ECG sample
+ */
+static int16_t HeartRate_simulateEcg(void)
+{
+    uint16_t phase = heartRateSimPhase;
+
+    if (++heartRateSimPhase >= HEARTRATE_BPM2SAMPLES(heartRateSimBpm))
+    {
+        heartRateSimPhase = 0;
+
+        if (++heartRateSimBpm == HEARTRATE_BPM_MAX)
         {
-            heartRateBpm = HEARTRATE_BPM_DEFAULT;
+            heartRateSimBpm = HEARTRATE_BPM_DEFAULT;
         }
+    }
+
+    return HeartRate_simulateWave(phase, 0,
+                    HEARTRATE_MS2SAMPLES(HEARTRATE_SIM_R_HALF_WIDTH),
+                    HEARTRATE_SIM_R_AMP) +
+           HeartRate_simulateWave(phase,
+                    HEARTRATE_MS2SAMPLES(HEARTRATE_SIM_T_DELAY),
+                    HEARTRATE_MS2SAMPLES(HEARTRATE_SIM_T_HALF_WIDTH),
+                    HEARTRATE_SIM_T_AMP);
+}
 
-        heartRateRrInterval = heartRateRrInterval2 = HEARTRATE_BPM2RR(
-                heartRateBpm);
+/*********************************************************************
+ * @fn      HeartRate_simulateWave
+ *
+ * @brief   Sample a triangular wave of the simulated ECG.
+ *
+ * @param   phase - ECG samples into the beat
+ * @param   start - start of the wave, in samples into the beat
+ * @param   halfWidth - half the width of the wave, in samples
+ * @param   amp - peak amplitude
+ *
+ * @return  the wave's contribution to the sample
+ */
+static int16_t HeartRate_simulateWave(uint16_t phase, uint16_t start,
+                                      uint16_t halfWidth, int16_t amp)
+{
+    int16_t offset = (int16_t) (phase - start) - (int16_t) halfWidth;
+
+    if ((phase < start) || (phase >= start + (2 * halfWidth)))
+    {
+        return 0;
+    }
+
+    if (offset < 0)
+    {
+        offset = -offset;
+    }
+
+    return (int16_t) (amp - ((int32_t) amp * offset) / halfWidth);
+}
+
+/*********************************************************************
+ * @fn      HeartRate_samplePut
+ *
+ * @brief   Queue a sensor sample. Only called by the sensor clock.
+ *
+ * @param   pSample - sample
+ *
+ * @return  true if queued, false if the ring is full
+ */
+static bool HeartRate_samplePut(const heartRateSample_t *pSample)
+{
+    uint8_t head = heartRateSampleHead;
+
+    if ((uint8_t) (head - heartRateSampleTail) == HEARTRATE_SAMPLE_RING_SIZE)
+    {
+        return false;
+    }
+
+    heartRateSampleRing[head & (HEARTRATE_SAMPLE_RING_SIZE - 1)] = *pSample;
+
+    // Publish the sample only once it's written.
+    heartRateSampleHead = head + 1;
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      HeartRate_sampleGet
+ *
+ * @brief   Take the oldest sensor sample. Only called by the application
+ *          task.
+ *
+ * @param   pSample - sample
+ *
+ * @return  true if a sample was taken, false if the ring is empty
+ */
+static bool HeartRate_sampleGet(heartRateSample_t *pSample)
+{
+    uint8_t tail = heartRateSampleTail;
+
+    if (tail == heartRateSampleHead)
+    {
+        return false;
+    }
+
+    *pSample = heartRateSampleRing[tail & (HEARTRATE_SAMPLE_RING_SIZE - 1)];
+
+    // Free the slot only once it's read.
+    heartRateSampleTail = tail + 1;
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      HeartRate_aggregateSamples
+ *
+ * @brief   Turn the sensor samples since the last measurement into the
+ *          next measurement: each beat's RR-interval is queued and its
+ *          energy expended added, and the heart rate is the mean over the
+ *          beats. With no beats, the last heart rate is kept.
+ *
+ * @return  none
+ */
+static void HeartRate_aggregateSamples(void)
+{
+    heartRateSample_t sample;
+    uint32_t rrSum = 0;
+    uint16_t numBeats = 0;
+
+    while (HeartRate_sampleGet(&sample))
+    {
+        HeartRate_rrPush(sample.rrInterval);
+        HeartRate_energyAccumulate(sample.rrInterval);
+        rrSum += sample.rrInterval;
+        numBeats++;
+    }
+
+    if (rrSum > 0)
+    {
+        heartRateBpm = (uint16_t) (((uint32_t) 60 * 1024 * numBeats +
+                                    (rrSum / 2)) / rrSum);
     }
 }
 
+/*********************************************************************
+ * @fn      HeartRate_energyAccumulate
+ *
+ * @brief   Add the energy expended over a beat, estimated from its heart
+ *          rate. Fractions of a kJ are carried over, so that no energy is
+ *          lost to rounding. The total saturates at HEARTRATE_ENERGY_MAX,
+ *          as the profile requires.
+ *
+ * @param   rrInterval - length of the beat, 1/1024 s
+ *
+ * @return  none
+ */
+static void HeartRate_energyAccumulate(uint16_t rrInterval)
+{
+    int32_t energy = ((int32_t) HEARTRATE_ENERGY_PER_BEAT * 1024) -
+                     ((int32_t) HEARTRATE_ENERGY_OFFSET * rrInterval);
+    int32_t rest = (int32_t) HEARTRATE_ENERGY_REST * rrInterval;
+
+    if (heartRateEnergyLvl == HEARTRATE_ENERGY_MAX)
+    {
+        return;
+    }
+
+    if (energy < rest)
+    {
+        energy = rest;
+    }
+
+    heartRateEnergyFrac += (uint32_t) energy;
+
+    while (heartRateEnergyFrac >= HEARTRATE_ENERGY_KJ)
+    {
+        heartRateEnergyFrac -= HEARTRATE_ENERGY_KJ;
+
+        if (++heartRateEnergyLvl == HEARTRATE_ENERGY_MAX)
+        {
+            heartRateEnergyFrac = 0;
+            break;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      HeartRate_energyReset
+ *
+ * @brief   Reset energy expended, as requested through the heart rate
+ *          control point. The next measurement carries the reset value.
+ *
+ * @return  none
+ */
+static void HeartRate_energyReset(void)
+{
+    heartRateEnergyLvl = 0;
+    heartRateEnergyFrac = 0;
+    heartRateEnergyNotiCnt = 0;
+}
+
 /*********************************************************************
  * @fn      HeartRate_stateChangeCB
  *
@@ -919,6 +1314,8 @@ static void HeartRate_stateChangeEvt(gaprole_States_t newState)
     {
         // Get connection handle.
         GAPRole_GetParameter(GAPROLE_CONNHANDLE, &gapConnHandle);
+
+        heartRateMtu = ATT_MTU_SIZE;
     }
     // If disconnected
     else if (gapProfileState == GAPROLE_CONNECTED
@@ -926,6 +1323,10 @@ static void HeartRate_stateChangeEvt(gaprole_States_t newState)
     {
         // Stop periodic measurement of heart rate.
         Util_stopClock(&measPerClock);
+        Util_stopClock(&sensorClock);
+
+        // Drop RR-intervals that were never sent.
+        heartRateRrTail = heartRateRrHead;
 
         if (newState == GAPROLE_WAITING_AFTER_TIMEOUT)
         {
@@ -1044,17 +1445,18 @@ static void HeartRate_heartRateEvt(uint8_t event)
         if (gapProfileState == GAPROLE_CONNECTED)
         {
             Util_startClock(&measPerClock);
+            Util_startClock(&sensorClock);
         }
     }
     else if (event == HEARTRATE_MEAS_NOTI_DISABLED)
     {
         // Stop periodic measurement.
         Util_stopClock(&measPerClock);
+        Util_stopClock(&sensorClock);
     }
     else if (event == HEARTRATE_COMMAND_SET)
     {
-        // Reset energy expended.
-        heartRateEnergyLvl = 0;
+        HeartRate_energyReset();
     }
 }
 
@@ -1166,12 +1568,20 @@ static void HeartRate_measPerTask(void)
 {
     if (gapProfileState == GAPROLE_CONNECTED)
     {
+        // Collect the beats since the last measurement.
+        HeartRate_aggregateSamples();
+
         // Send heart rate measurement notification.
         HeartRate_measNotify();
 
         // Restart timer.
         Util_startClock(&measPerClock);
     }
+    else
+    {
+        // Stop sampling until measurements resume.
+        Util_stopClock(&sensorClock);
+    }
 }
 
 /*********************************************************************
@@ -52,6 +52,7 @@
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
 #include "icall_ble_api.h"
+#include "gatt_service_def.h"
 
 #include "glucservice.h"
 
@@ -63,14 +64,6 @@
  * CONSTANTS
  */
 
-// Position of glucose measurement value in attribute array.
-#define GLUCOSE_MEAS_VALUE_POS         2
-#define GLUCOSE_MEAS_CONFIG_POS        3
-#define GLUCOSE_CONTEXT_VALUE_POS      5
-#define GLUCOSE_CONTEXT_CONFIG_POS     6
-#define GLUCOSE_CTL_PNT_VALUE_POS      10
-#define GLUCOSE_CTL_PNT_CONFIG_POS     11
-
 /*********************************************************************
  * TYPEDEFS
  */
@@ -113,13 +106,13 @@ CONST uint8 recordControlPointUUID[ATT_BT_UUID_SIZE] =
  * EXTERNAL VARIABLES
  */
 
-/* TRUE if record transfer in progress */
-extern bool glucoseSendAllRecords;
-
 /*********************************************************************
  * EXTERNAL FUNCTIONS
  */
 
+/* TRUE if record transfer in progress on the connection */
+extern bool GlucoseSensor_isReportActive(uint16 connHandle);
+
 /*********************************************************************
  * LOCAL VARIABLES
  */
@@ -134,137 +127,57 @@ static glucoseServiceCB_t glucoseServiceCB;
 static CONST gattAttrType_t glucoseService = {ATT_BT_UUID_SIZE, glucoseServUUID};
 
 // Glucose Characteristic.
-static uint8 glucoseProps = GATT_PROP_NOTIFY;
-static gattCharCfg_t *glucoseMeasConfig;
 static uint8 glucoseMeas = 0;
 
 // Measurement Context.
-static uint8  glucoseContextProps = GATT_PROP_NOTIFY;
 static uint8  glucoseContext=0;
-static gattCharCfg_t *glucoseContextConfig;
 
 // Glucose Feature.
-static uint8 glucoseFeatureProps = GATT_PROP_READ;
 static uint16 glucoseFeature = GLUCOSE_FEAT_ALL;
 
 // Glucose Control.
-static uint8  glucoseControlProps = GATT_PROP_INDICATE | GATT_PROP_WRITE;
 static uint8  glucoseControl=0;
-static gattCharCfg_t *glucoseControlConfig;
 
 /*********************************************************************
- * Profile Attributes - Table
+ * Profile Attributes - Definition
  */
 
-static gattAttribute_t glucoseAttrTbl[] =
-{
-  // Glucose Service
-  {
-    { ATT_BT_UUID_SIZE, primaryServiceUUID }, /* type */
-    GATT_PERMIT_READ,                         /* permissions */
-    0,                                        /* handle */
-    (uint8 *)&glucoseService                /* pValue */
-  },
-
-    // 1. Characteristic Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &glucoseProps
-    },
-
-    // 2. Characteristic Value
-    {
-      { ATT_BT_UUID_SIZE, glucoseMeasUUID },
-      0, //return READ_NOT_PERMITTED
-      0,
-      &glucoseMeas
-    },
-
-    // 3.Characteristic Configuration
-    {
-      { ATT_BT_UUID_SIZE, clientCharCfgUUID },
-      GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
-      0,
-      (uint8 *)&glucoseMeasConfig
-    },
-
-    //////////////////////////////////////////////
-    // MEASUREMENT CONTEXT
-    //////////////////////////////////////////////
-
-    // 4.Characteristic Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &glucoseContextProps
-    },
-
-    // 5.Characteristic Value
-    {
-      { ATT_BT_UUID_SIZE, glucoseContextUUID },
-      0, //return READ_NOT_PERMITTED
-      0,
-      &glucoseContext
-    },
-
-    // 6.Characteristic Configuration
-    {
-      { ATT_BT_UUID_SIZE, clientCharCfgUUID },
-      GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
-      0,
-      (uint8 *)&glucoseContextConfig
-    },
-
-    //////////////////////////////////////////////
-    // GLUCOSE FEATURE
-    //////////////////////////////////////////////
-
-    // 7.Characteristic Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &glucoseFeatureProps
-    },
+#define GLUCOSE_DEF(SERVICE, CHAR, CHAR_CCC, DESC)                             \
+  /* Glucose Service */                                                        \
+  SERVICE( GLUCOSE, glucoseService )                                           \
+  /* Glucose Measurement, value reads return READ_NOT_PERMITTED */             \
+  CHAR_CCC( GLUCOSE_MEAS, GATT_PROP_NOTIFY,                                    \
+            ATT_BT_UUID_SIZE, glucoseMeasUUID, 0, &glucoseMeas,                \
+            GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE, glucoseMeasConfig )  \
+  /* Measurement Context, value reads return READ_NOT_PERMITTED */             \
+  CHAR_CCC( GLUCOSE_CONTEXT, GATT_PROP_NOTIFY,                                 \
+            ATT_BT_UUID_SIZE, glucoseContextUUID, 0, &glucoseContext,          \
+            GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,                      \
+            glucoseContextConfig )                                             \
+  /* Glucose Feature */                                                        \
+  CHAR( GLUCOSE_FEATURE, GATT_PROP_READ,                                       \
+        ATT_BT_UUID_SIZE, glucoseFeatureUUID,                                  \
+        GATT_PERMIT_ENCRYPT_READ, &glucoseFeature )                            \
+  /* Record Access Control Point */                                            \
+  CHAR_CCC( GLUCOSE_CTL_PNT, GATT_PROP_INDICATE | GATT_PROP_WRITE,             \
+            ATT_BT_UUID_SIZE, recordControlPointUUID,                          \
+            GATT_PERMIT_AUTHEN_WRITE, &glucoseControl,                         \
+            GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,                      \
+            glucoseControlConfig )
+
+// Characteristic properties (for declarations) and CCC tables
+GATT_SERVICE_DEF_VARS( GLUCOSE_DEF )
+
+// Attribute positions in the table
+GATT_SERVICE_DEF_INDEX( GLUCOSE_DEF, GLUCOSE_NUM_ATTRS );
 
-    // 8.Characteristic Value
-    {
-      { ATT_BT_UUID_SIZE, glucoseFeatureUUID },
-      GATT_PERMIT_ENCRYPT_READ,
-      0,
-      (uint8 *) &glucoseFeature
-    },
-
-    //////////////////////////////////////////////
-    // GLUCOSE CONTROL POINT
-    //////////////////////////////////////////////
-
-    // 9.Characteristic Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &glucoseControlProps
-    },
-
-    // 10.Characteristic Value
-    {
-      { ATT_BT_UUID_SIZE, recordControlPointUUID },
-      GATT_PERMIT_AUTHEN_WRITE,
-      0,
-      &glucoseControl
-    },
+/*********************************************************************
+ * Profile Attributes - Table
+ */
 
-    // 11.Characteristic Configuration
-    {
-      { ATT_BT_UUID_SIZE, clientCharCfgUUID },
-      GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
-      0,
-      (uint8 *)&glucoseControlConfig
-    }
+static gattAttribute_t glucoseAttrTbl[GLUCOSE_NUM_ATTRS] =
+{
+  GATT_SERVICE_DEF_TABLE( GLUCOSE_DEF )
 };
 
 /*********************************************************************
@@ -466,7 +379,7 @@ bStatus_t Glucose_MeasSend(uint16 connHandle, attHandleValueNoti_t *pNoti,
   if (value & GATT_CLIENT_CFG_NOTIFY)
   {
     // Set the handle.
-    pNoti->handle = glucoseAttrTbl[GLUCOSE_MEAS_VALUE_POS].handle;
+    pNoti->handle = glucoseAttrTbl[GLUCOSE_MEAS_VALUE_IDX].handle;
 
     // Send the Indication.
     return GATT_Notification(connHandle, pNoti, FALSE);
@@ -495,7 +408,7 @@ bStatus_t Glucose_ContextSend(uint16 connHandle,
   if (value & GATT_CLIENT_CFG_NOTIFY)
   {
     // Set the handle.
-    pNoti->handle = glucoseAttrTbl[GLUCOSE_CONTEXT_VALUE_POS].handle;
+    pNoti->handle = glucoseAttrTbl[GLUCOSE_CONTEXT_VALUE_IDX].handle;
 
     // Send the Indication.
     return GATT_Notification(connHandle, pNoti, FALSE);
@@ -525,7 +438,7 @@ bStatus_t Glucose_CtlPntIndicate(uint16 connHandle,
   if (value & GATT_CLIENT_CFG_INDICATE)
   {
     // Set the handle.
-    pInd->handle = glucoseAttrTbl[GLUCOSE_CTL_PNT_VALUE_POS].handle;
+    pInd->handle = glucoseAttrTbl[GLUCOSE_CTL_PNT_VALUE_IDX].handle;
 
     // Send the Indication.
     return GATT_Indication(connHandle, pInd, FALSE, taskId);
@@ -624,8 +537,8 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
 
   case  GATT_CLIENT_CHAR_CFG_UUID:
       // Glucose Notifications.
-      if ((pAttr->handle == glucoseAttrTbl[GLUCOSE_MEAS_CONFIG_POS].handle ||
-           pAttr->handle == glucoseAttrTbl[GLUCOSE_CONTEXT_CONFIG_POS].handle))
+      if ((pAttr->handle == glucoseAttrTbl[GLUCOSE_MEAS_CCC_IDX].handle ||
+           pAttr->handle == glucoseAttrTbl[GLUCOSE_CONTEXT_CCC_IDX].handle))
       {
         status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
                                                  offset, GATT_CLIENT_CFG_NOTIFY);
@@ -633,20 +546,24 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
         {
           uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
 
-          if(pAttr->handle == glucoseAttrTbl[GLUCOSE_MEAS_CONFIG_POS].handle)
+          if(pAttr->handle == glucoseAttrTbl[GLUCOSE_MEAS_CCC_IDX].handle)
           {
-            (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_MEAS_NTF_DISABLED :
-                                                 GLUCOSE_MEAS_NTF_ENABLED, NULL, NULL);
+            (*glucoseServiceCB)(connHandle,
+                                (charCfg == 0) ? GLUCOSE_MEAS_NTF_DISABLED :
+                                                 GLUCOSE_MEAS_NTF_ENABLED,
+                                NULL, NULL);
           }
           else
           {
-            (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_CONTEXT_NTF_DISABLED :
-                                                 GLUCOSE_CONTEXT_NTF_ENABLED, NULL, NULL);
+            (*glucoseServiceCB)(connHandle,
+                                (charCfg == 0) ? GLUCOSE_CONTEXT_NTF_DISABLED :
+                                                 GLUCOSE_CONTEXT_NTF_ENABLED,
+                                NULL, NULL);
           }
         }
       }
       // Glucose Indications.
-      else if (pAttr->handle == glucoseAttrTbl[GLUCOSE_CTL_PNT_CONFIG_POS].handle)
+      else if (pAttr->handle == glucoseAttrTbl[GLUCOSE_CTL_PNT_CCC_IDX].handle)
       {
         status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
                                                  offset, GATT_CLIENT_CFG_INDICATE);
@@ -654,8 +571,10 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
         {
             uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
 
-            (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_CTL_PNT_IND_DISABLED :
-                                                 GLUCOSE_CTL_PNT_IND_ENABLED, NULL, NULL);
+            (*glucoseServiceCB)(connHandle,
+                                (charCfg == 0) ? GLUCOSE_CTL_PNT_IND_DISABLED :
+                                                 GLUCOSE_CTL_PNT_IND_ENABLED,
+                                NULL, NULL);
         }
       }
       else
@@ -670,7 +589,8 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
         uint8 opcode = pValue[0];
 
         // If transfer in progress
-        if (opcode != CTL_PNT_OP_ABORT && glucoseSendAllRecords)
+        if (opcode != CTL_PNT_OP_ABORT &&
+            GlucoseSensor_isReportActive(connHandle))
         {
           status = GLUCOSE_ERR_IN_PROGRESS;
         }
@@ -683,7 +603,7 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
         }
         else
         {
-          (*glucoseServiceCB)(GLUCOSE_CTL_PNT_CMD, pValue, len);
+          (*glucoseServiceCB)(connHandle, GLUCOSE_CTL_PNT_CMD, pValue, len);
         }
       }
       else
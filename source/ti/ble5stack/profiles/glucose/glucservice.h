@@ -251,8 +251,8 @@ extern "C"
  */
 
 // Glucose Service callback function.
-typedef void (*glucoseServiceCB_t)(uint8 event, uint8* data,
-                                   uint8 dataLen);
+typedef void (*glucoseServiceCB_t)(uint16 connHandle, uint8 event,
+                                   uint8* data, uint8 dataLen);
 
 /*********************************************************************
  * MACROS
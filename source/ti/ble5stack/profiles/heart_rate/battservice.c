@@ -59,6 +59,7 @@
 #include "icall_ble_api.h"
 
 #include "hiddev.h"
+#include "gattservapp_ext.h"
 #include "battservice.h"
 
 
@@ -218,7 +219,6 @@ static bStatus_t battWriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
                                  uint8_t *pValue, uint16_t len, uint16_t offset,
                                  uint8 method );
 
-static void battNotify(uint16_t connHandle);
 static uint8_t battMeasure(void);
 static void battNotifyLevel(void);
 
@@ -540,39 +540,6 @@ static bStatus_t battWriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
   return (status);
 }
 
-/*********************************************************************
- * @fn          battNotify
- *
- * @brief       Send a notification of the level state characteristic.
- *
- * @param       connHandle - linkDB item
- *
- * @return      None.
- */
-static void battNotify(uint16_t connHandle)
-{
-  uint16_t value = GATTServApp_ReadCharCfg(connHandle,
-                                           battLevelClientCharCfg);
-  if (value & GATT_CLIENT_CFG_NOTIFY)
-  {
-    attHandleValueNoti_t noti;
-
-    noti.pValue = GATT_bm_alloc(connHandle, ATT_HANDLE_VALUE_NOTI,
-                                BATT_LEVEL_VALUE_LEN, NULL);
-    if (noti.pValue != NULL)
-    {
-      noti.handle = battAttrTbl[BATT_LEVEL_VALUE_IDX].handle;
-      noti.len = BATT_LEVEL_VALUE_LEN;
-      noti.pValue[0] = battLevel;
-
-      if (GATT_Notification(connHandle, &noti, FALSE) != SUCCESS)
-      {
-        GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
-      }
-    }
-  }
-}
-
 /*********************************************************************
  * @fn      battMeasure
  *
@@ -622,17 +589,11 @@ static uint8_t battMeasure(void)
  */
 static void battNotifyLevel(void)
 {
-  uint8_t i;
-  for (i = 0; i < linkDBNumConns; i++)
-  {
-    uint16_t connHandle = battLevelClientCharCfg[i].connHandle;
-
-    if (connHandle != CONNHANDLE_INVALID)
-    {
-      // Send notification to connected device.
-      battNotify(connHandle);
-    }
-  }
+  // The level reads the same on every connection, so it is measured and
+  // serialised once and copied to each subscribed client
+  GATTServApp_ProcessCharCfgFanOut(battLevelClientCharCfg, &battLevel, FALSE,
+                                   battAttrTbl, GATT_NUM_ATTRS(battAttrTbl),
+                                   INVALID_TASK_ID, battReadAttrCB, NULL);
 }
 
 
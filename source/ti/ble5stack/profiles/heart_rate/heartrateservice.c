@@ -52,6 +52,7 @@
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
 #include "icall_ble_api.h"
+#include "gattservapp_ext.h"
 
 #include "heartrateservice.h"
 
@@ -216,6 +217,33 @@ static bStatus_t heartRate_WriteAttrCB(uint16_t connHandle,
                                        gattAttribute_t *pAttr, uint8_t *pValue,
                                        uint16_t len, uint16_t offset,
                                        uint8_t method);
+static bStatus_t heartRate_ReadSensLoc(uint16_t connHandle,
+                                       gattAttribute_t *pAttr, uint8_t *pValue,
+                                       uint16_t *pLen, uint16_t offset,
+                                       uint16_t maxLen, uint8_t method);
+static bStatus_t heartRate_WriteCommand(uint16_t connHandle,
+                                        gattAttribute_t *pAttr, uint8_t *pValue,
+                                        uint16_t len, uint16_t offset,
+                                        uint8_t method);
+static bStatus_t heartRate_WriteMeasConfig(uint16_t connHandle,
+                                           gattAttribute_t *pAttr,
+                                           uint8_t *pValue, uint16_t len,
+                                           uint16_t offset, uint8_t method);
+
+/*********************************************************************
+ * Profile Attributes - Handlers
+ */
+
+// Per characteristic handlers, looked up by attribute handle.
+static CONST gattServAppAttrHandler_t heartRateAttrHandlers[] =
+{
+  { (uint8 *)&heartRateMeasClientCharCfg, NULL,                  heartRate_WriteMeasConfig },
+  { &heartRateSensLoc,                    heartRate_ReadSensLoc, NULL },
+  { &heartRateCommand,                    NULL,                  heartRate_WriteCommand }
+};
+
+static uint8 heartRateHandlerIdx[GATT_NUM_ATTRS(heartRateAttrTbl)];
+static gattServAppAttrDispatch_t heartRateDispatch;
 
 /*********************************************************************
  * PROFILE CALLBACKS
@@ -272,6 +300,18 @@ bStatus_t HeartRate_AddService(uint32 services)
                                          GATT_NUM_ATTRS(heartRateAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &heartRateCBs);
+
+    if (status == SUCCESS)
+    {
+      // Map the assigned handles to the characteristic handlers.
+      status = GATTServApp_InitAttrDispatch(&heartRateDispatch,
+                                            heartRateAttrTbl,
+                                            GATT_NUM_ATTRS(heartRateAttrTbl),
+                                            heartRateAttrHandlers,
+                                            sizeof(heartRateAttrHandlers) /
+                                            sizeof(heartRateAttrHandlers[0]),
+                                            heartRateHandlerIdx);
+    }
   }
   else
   {
@@ -399,6 +439,24 @@ bStatus_t HeartRate_MeasNotify(uint16 connHandle, attHandleValueNoti_t *pNoti)
   return bleIncorrectMode;
 }
 
+/*********************************************************************
+ * @fn          HeartRate_MeasNotifyEnabled
+ *
+ * @brief       Check whether a connection has enabled heart rate
+ *              measurement notifications.
+ *
+ * @param       connHandle - connection handle
+ *
+ * @return      TRUE if notifications are enabled, FALSE otherwise
+ */
+uint8 HeartRate_MeasNotifyEnabled(uint16 connHandle)
+{
+  uint16 value = GATTServApp_ReadCharCfg(connHandle,
+                                         heartRateMeasClientCharCfg);
+
+  return (value & GATT_CLIENT_CFG_NOTIFY) ? TRUE : FALSE;
+}
+
 /*********************************************************************
  * @fn          heartRate_ReadAttrCB
  *
@@ -419,27 +477,14 @@ static bStatus_t heartRate_ReadAttrCB(uint16_t connHandle,
                                       uint16_t *pLen, uint16_t offset,
                                       uint16_t maxLen, uint8_t method)
 {
-  bStatus_t status = SUCCESS;
-
   // Make sure it's not a blob operation (no attributes in the profile are long)
   if (offset > 0)
   {
     return (ATT_ERR_ATTR_NOT_LONG);
   }
 
-  uint16 uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
-
-  if (uuid == BODY_SENSOR_LOC_UUID)
-  {
-    *pLen = 1;
-    pValue[0] = *pAttr->pValue;
-  }
-  else
-  {
-    status = ATT_ERR_ATTR_NOT_FOUND;
-  }
-
-  return (status);
+  return GATTServApp_DispatchReadAttr(&heartRateDispatch, connHandle, pAttr,
+                                      pValue, pLen, offset, maxLen, method);
 }
 
 /*********************************************************************
@@ -461,49 +506,108 @@ static bStatus_t heartRate_WriteAttrCB(uint16_t connHandle,
                                        uint16_t len, uint16_t offset,
                                        uint8_t method)
 {
-  bStatus_t status = SUCCESS;
+  return GATTServApp_DispatchWriteAttr(&heartRateDispatch, connHandle, pAttr,
+                                       pValue, len, offset, method);
+}
+
+/*********************************************************************
+ * @fn      heartRate_ReadSensLoc
+ *
+ * @brief   Read the Body Sensor Location characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t heartRate_ReadSensLoc(uint16_t connHandle,
+                                       gattAttribute_t *pAttr, uint8_t *pValue,
+                                       uint16_t *pLen, uint16_t offset,
+                                       uint16_t maxLen, uint8_t method)
+{
+  *pLen = 1;
+  pValue[0] = *pAttr->pValue;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      heartRate_WriteCommand
+ *
+ * @brief   Write the Heart Rate Control Point characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t heartRate_WriteCommand(uint16_t connHandle,
+                                        gattAttribute_t *pAttr, uint8_t *pValue,
+                                        uint16_t len, uint16_t offset,
+                                        uint8_t method)
+{
+  if (offset > 0)
+  {
+    return (ATT_ERR_ATTR_NOT_LONG);
+  }
 
-  uint16 uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
-  switch (uuid)
+  if (len != 1)
   {
-    case HEARTRATE_CTRL_PT_UUID:
-      if (offset > 0)
-      {
-        status = ATT_ERR_ATTR_NOT_LONG;
-      }
-      else if (len != 1)
-      {
-        status = ATT_ERR_INVALID_VALUE_SIZE;
-      }
-      else if (*pValue != HEARTRATE_COMMAND_ENERGY_EXP)
-      {
-        status = HEARTRATE_ERR_NOT_SUP;
-      }
-      else
-      {
-        *(pAttr->pValue) = pValue[0];
+    return (ATT_ERR_INVALID_VALUE_SIZE);
+  }
 
-        (*heartRateServiceCB)(HEARTRATE_COMMAND_SET);
+  if (*pValue != HEARTRATE_COMMAND_ENERGY_EXP)
+  {
+    return (HEARTRATE_ERR_NOT_SUP);
+  }
 
-      }
-      break;
+  *(pAttr->pValue) = pValue[0];
 
-    case GATT_CLIENT_CHAR_CFG_UUID:
-      status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
-                                               offset, GATT_CLIENT_CFG_NOTIFY);
-      if (status == SUCCESS)
-      {
-        uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
+  (*heartRateServiceCB)(HEARTRATE_COMMAND_SET);
 
-        (*heartRateServiceCB)((charCfg == GATT_CFG_NO_OPERATION) ?
-                                HEARTRATE_MEAS_NOTI_DISABLED :
-                                HEARTRATE_MEAS_NOTI_ENABLED);
-      }
-      break;
+  return (SUCCESS);
+}
 
-    default:
-      status = ATT_ERR_ATTR_NOT_FOUND;
-      break;
+/*********************************************************************
+ * @fn      heartRate_WriteMeasConfig
+ *
+ * @brief   Write the Client Characteristic Configuration of the Heart
+ *          Rate Measurement characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t heartRate_WriteMeasConfig(uint16_t connHandle,
+                                           gattAttribute_t *pAttr,
+                                           uint8_t *pValue, uint16_t len,
+                                           uint16_t offset, uint8_t method)
+{
+  bStatus_t status;
+
+  status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                          offset, GATT_CLIENT_CFG_NOTIFY);
+  if (status == SUCCESS)
+  {
+    uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
+
+    (*heartRateServiceCB)((charCfg == GATT_CFG_NO_OPERATION) ?
+                            HEARTRATE_MEAS_NOTI_DISABLED :
+                            HEARTRATE_MEAS_NOTI_ENABLED);
   }
 
   return (status);
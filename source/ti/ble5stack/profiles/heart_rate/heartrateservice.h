@@ -184,6 +184,18 @@ extern bStatus_t HeartRate_GetParameter(uint8 param, void *value);
 extern bStatus_t HeartRate_MeasNotify(uint16 connHandle,
                                       attHandleValueNoti_t *pNoti);
 
+/*********************************************************************
+ * @fn          HeartRate_MeasNotifyEnabled
+ *
+ * @brief       Check whether a connection has enabled heart rate
+ *              measurement notifications.
+ *
+ * @param       connHandle - connection handle
+ *
+ * @return      TRUE if notifications are enabled, FALSE otherwise
+ */
+extern uint8 HeartRate_MeasNotifyEnabled(uint16 connHandle);
+
 
 /*********************************************************************
 *********************************************************************/
@@ -52,6 +52,15 @@
 // Service not discovered
 #define SSC_SERVICE_NOT_DISCOVERED    (0xFF)
 
+// Size of the L2CAP basic header carried in the first LL fragment of a write
+#define SSC_L2CAP_HDR_SIZE            4
+
+// Overhead of a write without response in the LL payload
+#define SSC_WRITE_OVERHEAD            (SSC_L2CAP_HDR_SIZE + ATT_WRITE_REQ_HDR_SIZE)
+
+// No command is waiting to be written to a server
+#define SSC_OP_NONE                   0xFF
+
 /*********************************************************************
  * MACROS
  */
@@ -64,6 +73,29 @@
  * TYPEDEFS
  */
 
+// TX credit state kept per connection
+typedef struct
+{
+    bool     inUse;
+    uint16_t connHandle;
+    uint16_t maxTxOctets;   // LL payload size used to count the fragments of a write
+    uint8_t  credits;       // LL packets that may still be handed to the controller
+} SimpleStreamClientLink_t;
+
+// Reliable mode stream state kept per server
+typedef struct
+{
+    bool     inUse;
+    bool     synced;          // FALSE until the first offset is received from a new server
+    bool     resumeRequested; // Set while waiting for data to be resent after a gap
+    uint8_t  addrType;
+    uint8_t  addr[B_ADDR_LEN];
+    uint16_t connHandle;      // CONNHANDLE_INVALID while disconnected
+    uint32_t rxOffset;        // Stream offset of the next expected byte
+    uint32_t ackOffset;       // Stream offset last acknowledged to the server
+    uint8_t  pendingOp;       // Command waiting for a TX credit, SSC_OP_NONE if none
+} SimpleStreamClientPeer_t;
+
 /*********************************************************************
 * GLOBAL VARIABLES
 */
@@ -94,6 +126,20 @@ static List_List streamOutQueue;
 
 static uint16_t heapHeadroom = 0;
 
+// LL packets allowed to be outstanding in the controller on each connection
+static uint8_t txCreditWindow = SIMPLESTREAMCLIENT_DEFAULT_CREDIT_WINDOW;
+
+// TX credits of the connections the stream is sent on
+static SimpleStreamClientLink_t streamLinks[SIMPLESTREAMCLIENT_MAX_LINKS];
+
+// Reliable stream mode
+static bool     reliableMode = FALSE;
+static uint16_t reliableAckInterval = SIMPLESTREAMCLIENT_DEFAULT_ACK_INTERVAL;
+static SimpleStreamClientPeer_t streamPeers[SIMPLESTREAMCLIENT_MAX_LINKS];
+
+// Stream statistics
+static SimpleStreamClientStats_t streamStats = { .minFreeHeap = UINT32_MAX };
+
 /*********************************************************************
 * Service Discovery Table
 */
@@ -127,6 +173,13 @@ simpleService_t streamServiceHandle =
 static bStatus_t SimpleStreamClient_transmitNode( SimpleStreamNode_t *node );
 static bStatus_t SimpleStreamClient_queueData( SimpleStreamNode_t *node );
 static void      SimpleStreamClient_clearQueue();
+static bStatus_t SimpleStreamClient_pump();
+static SimpleStreamClientLink_t *SimpleStreamClient_findLink( uint16_t connHandle );
+static SimpleStreamClientLink_t *SimpleStreamClient_getLink( uint16_t connHandle );
+static SimpleStreamClientPeer_t *SimpleStreamClient_getPeer( uint16_t connHandle );
+static bStatus_t SimpleStreamClient_writeCommand( SimpleStreamClientPeer_t *pPeer );
+static void      SimpleStreamClient_flushCommands();
+static void      SimpleStreamClient_recordLatency( SimpleStreamNode_t *node );
 /*********************************************************************
  * PROFILE CALLBACKS
  */
@@ -170,13 +223,32 @@ static bStatus_t SimpleStreamClient_queueData( SimpleStreamNode_t *node )
  *
  * @return      SUCCESS, FAILURE, INVALIDPARAMETER, MSG_BUFFER_NOT_AVAIL,
  *              bleNotCOnnected, bleMemAllocError, blePending, bleInvaludMtuSize or
- *              bleTimeout
+ *              bleTimeout. blePending is also returned when the credit
+ *              window of the node's connection is exhausted.
  */
 static bStatus_t SimpleStreamClient_transmitNode( SimpleStreamNode_t* node)
 {
     bStatus_t ret = SUCCESS;
     linkDBInfo_t connInfo;
     attWriteReq_t req;
+    SimpleStreamClientLink_t *pLink = SimpleStreamClient_findLink(node->connHandle);
+    uint16_t creditLen;
+    uint16_t hdrLen = reliableMode ? 1 : 0;
+
+    if (pLink == NULL)
+    {
+        return bleNotConnected;
+    }
+
+    // Octets the remaining credits can carry, the write overhead included
+    creditLen = pLink->credits * pLink->maxTxOctets;
+
+    // Wait for completed packets before handing more data to the controller
+    if (creditLen <= (SSC_WRITE_OVERHEAD + hdrLen))
+    {
+        streamStats.creditStalls++;
+        return blePending;
+    }
 
     // Find out what the maximum MTU size is
     ret = linkDB_GetInfo(node->connHandle, &connInfo);
@@ -186,19 +258,40 @@ static bStatus_t SimpleStreamClient_transmitNode( SimpleStreamNode_t* node)
 
         // Determine allocation size
         uint16_t allocLen = (node->len - node->offset);
-        if ( allocLen > (connInfo.MTU - ATT_WRITE_REQ_HDR_SIZE) )
+        if ( allocLen > (connInfo.MTU - ATT_WRITE_REQ_HDR_SIZE - hdrLen) )
         {
-            allocLen = connInfo.MTU - ATT_WRITE_REQ_HDR_SIZE;
+            allocLen = connInfo.MTU - ATT_WRITE_REQ_HDR_SIZE - hdrLen;
+        }
+
+        // Only send as many LL fragments as there are credits left
+        if ( allocLen > (creditLen - SSC_WRITE_OVERHEAD - hdrLen) )
+        {
+            allocLen = creditLen - SSC_WRITE_OVERHEAD - hdrLen;
         }
 
         req.pValue = (uint8 *)GATT_bm_alloc( node->connHandle, ATT_WRITE_CMD,
-                                              allocLen, &req.len );
+                                              allocLen + hdrLen, &req.len );
+
+        // A reliable mode write must fit the opcode and some data
+        if ( (req.pValue != NULL) && (req.len <= hdrLen) )
+        {
+            GATT_bm_free( (gattMsg_t *)&req, ATT_WRITE_CMD );
+            req.pValue = NULL;
+        }
 
         // If allocation was successful, copy out data out of the buffer and send it
         if (NULL != req.pValue) {
 
+            uint16_t dataLen = req.len - hdrLen;
+
+            if (reliableMode)
+            {
+                // The server expects an opcode in front of every write
+                req.pValue[0] = SIMPLESTREAMSERVER_OP_DATA;
+            }
+
             req.handle = streamServiceHandle.chars[0].handle;
-            memcpy(req.pValue, (void *) ((uint8_t *) node->payload + node->offset), req.len);
+            memcpy(req.pValue + hdrLen, (void *) ((uint8_t *) node->payload + node->offset), dataLen);
             req.cmd = TRUE;
             req.sig = FALSE;
 
@@ -212,19 +305,52 @@ static bStatus_t SimpleStreamClient_transmitNode( SimpleStreamNode_t* node)
             else
             {
                 // Increment node data offset
-                node->offset += req.len;
+                node->offset += dataLen;
+
+                // Every LL fragment of the write occupies a controller TX buffer
+                pLink->credits -= (req.len + SSC_WRITE_OVERHEAD + pLink->maxTxOctets - 1) /
+                                  pLink->maxTxOctets;
+
+                streamStats.bytesSent += dataLen;
+                streamStats.packetsSent++;
             }
         }
         else
         {
             // Unable to allocate space for a notification, return failure
             ret = bleMemAllocError;
+            streamStats.allocFailures++;
         }
     }
 
     return ret;
 }
 
+/*********************************************************************
+ * @fn      SimpleStreamClient_recordLatency
+ *
+ * @brief   Adds the time a node took from being queued to being fully
+ *          sent to the latency histogram.
+ *
+ * @param   node - the node that was fully sent
+ *
+ * @return  None
+ */
+static void SimpleStreamClient_recordLatency( SimpleStreamNode_t *node )
+{
+    uint32_t latencyMs = ((ICall_getTicks() - node->timestamp) * ICall_getTickPeriod()) / 1000;
+    uint8_t bucket = 0;
+
+    // Bucket n holds [2^n, 2^(n+1)) ms, bucket 0 also holds 0 and 1 ms
+    while ( (latencyMs > 1) && (bucket < (SIMPLESTREAMCLIENT_LATENCY_BUCKETS - 1)) )
+    {
+        latencyMs >>= 1;
+        bucket++;
+    }
+
+    streamStats.latencyHist[bucket]++;
+}
+
 /*********************************************************************
  * @fn      SimpleStreamClient_clearQueue
  *
@@ -236,19 +362,125 @@ static bStatus_t SimpleStreamClient_transmitNode( SimpleStreamNode_t* node)
  */
 void SimpleStreamClient_clearQueue()
 {
+    uint8_t i;
+
     // Pop and free the whole queue
     while(!List_empty(&streamOutQueue))
     {
         SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_get(&streamOutQueue);
         ICall_free(node);
     }
+
+    // Outstanding packets are flushed with the links that went down,
+    // packets still in flight on a live link keep their credits
+    for (i = 0; i < SIMPLESTREAMCLIENT_MAX_LINKS; i++)
+    {
+        if (streamLinks[i].inUse && !linkDB_Up(streamLinks[i].connHandle))
+        {
+            streamLinks[i].inUse = FALSE;
+        }
+
+        // Reliable mode streams are kept to be resumed on reconnection
+        if (streamPeers[i].inUse && (streamPeers[i].connHandle != CONNHANDLE_INVALID) &&
+            !linkDB_Up(streamPeers[i].connHandle))
+        {
+            streamPeers[i].connHandle = CONNHANDLE_INVALID;
+            streamPeers[i].pendingOp  = SSC_OP_NONE;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_pump
+ *
+ * @brief   Refills the controller from the outgoing stream queue if
+ *          there is any data waiting.
+ *
+ * @param   None
+ *
+ * @return  SUCCESS or SimpleStreamClient_processStream return value
+ */
+static bStatus_t SimpleStreamClient_pump()
+{
+    bStatus_t ret = SUCCESS;
+
+    // Acknowledgements go first, they open the server's send window
+    if (reliableMode)
+    {
+        SimpleStreamClient_flushCommands();
+    }
+
+    if (!List_empty(&streamOutQueue))
+    {
+        ret = SimpleStreamClient_processStream();
+    }
+
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_findLink
+ *
+ * @brief   Finds the TX credit state of a connection.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  Pointer to the link, NULL if not found
+ */
+static SimpleStreamClientLink_t *SimpleStreamClient_findLink( uint16_t connHandle )
+{
+    uint8_t i;
+
+    for (i = 0; i < SIMPLESTREAMCLIENT_MAX_LINKS; i++)
+    {
+        if (streamLinks[i].inUse && (streamLinks[i].connHandle == connHandle))
+        {
+            return &streamLinks[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_getLink
+ *
+ * @brief   Finds the TX credit state of a connection, setting up a full
+ *          credit window if the stream has not been sent on it yet.
+ *          Entries of links that went down are reused.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  Pointer to the link, NULL if none is available
+ */
+static SimpleStreamClientLink_t *SimpleStreamClient_getLink( uint16_t connHandle )
+{
+    SimpleStreamClientLink_t *pLink = SimpleStreamClient_findLink(connHandle);
+    uint8_t i;
+
+    for (i = 0; (pLink == NULL) && (i < SIMPLESTREAMCLIENT_MAX_LINKS); i++)
+    {
+        if (!streamLinks[i].inUse || !linkDB_Up(streamLinks[i].connHandle))
+        {
+            pLink = &streamLinks[i];
+
+            pLink->inUse       = TRUE;
+            pLink->connHandle  = connHandle;
+            pLink->maxTxOctets = SIMPLESTREAMCLIENT_DEFAULT_TX_OCTETS;
+            pLink->credits     = txCreditWindow;
+        }
+    }
+
+    return pLink;
 }
 
 /*********************************************************************
  * @fn      SimpleStreamClient_processStream
  *
  * @brief   Sends out as much as possible from the outgoing stream
- *          queue using BLE notifications
+ *          queue using BLE notifications. Data for a connection that
+ *          has run out of credits is skipped, in order, so it does not
+ *          hold back the other connections.
  *
  * @param   connHandle  - connection message was received on
  * @param   *pValue     - pointer to data buffer
@@ -261,9 +493,10 @@ void SimpleStreamClient_clearQueue()
 bStatus_t SimpleStreamClient_processStream()
 {
     bStatus_t ret = SUCCESS;
+    bool creditStall = FALSE;
 
     // Send data starting from the list head
-    SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_get(&streamOutQueue);
+    SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_head(&streamOutQueue);
 
     while ((ret == SUCCESS) && (node != NULL))
     {
@@ -272,18 +505,29 @@ bStatus_t SimpleStreamClient_processStream()
         // Check that we really did send all data before freeing the node
         if ((node->len - node->offset) == 0)
         {
+            SimpleStreamNode_t *next = (SimpleStreamNode_t *) List_next((List_Elem *) node);
+
+            List_remove(&streamOutQueue, (List_Elem *) node);
+            SimpleStreamClient_recordLatency(node);
             ICall_free(node);
             // Move to next queue entry
-            node = (SimpleStreamNode_t *) List_get(&streamOutQueue);
+            node = next;
         }
-
-        if (ret != SUCCESS)
+        else if (ret == blePending)
         {
-            // We could not send all the data contained in the node, add it back to the queue
-            List_putHead(&streamOutQueue, (List_Elem *) node);
+            // The connection has no credits left until packets complete. Its
+            // later nodes are skipped as well since its credits stay the same.
+            creditStall = TRUE;
+            ret = SUCCESS;
+            node = (SimpleStreamNode_t *) List_next((List_Elem *) node);
         }
     }
 
+    if ((ret == SUCCESS) && creditStall)
+    {
+        ret = blePending;
+    }
+
     return ret;
 }
 
@@ -343,6 +587,11 @@ void* SimpleStreamClient_allocateWithHeadroom(uint16_t allocSize)
     // Get the current free heap
     ICall_getHeapStats(&stats);
 
+    if (stats.totalFreeSize < streamStats.minFreeHeap)
+    {
+        streamStats.minFreeHeap = stats.totalFreeSize;
+    }
+
     if (((int16_t) allocSize) < ((int32_t)(stats.totalFreeSize - heapHeadroom)))
     {
         allocatedBuffer = ICall_malloc(allocSize);
@@ -374,8 +623,15 @@ bStatus_t SimpleStreamClient_sendData(uint16_t connHandle, void *data, uint16_t
     SimpleStreamNode_t* newNode;
 
     // Reject if service is not yet discovered
-    if (NULL != streamServiceHandle.chars[0].handle)
+    if (GATT_INVALID_HANDLE != streamServiceHandle.chars[0].handle)
     {
+        // Credits are kept per connection
+        if (SimpleStreamClient_getLink(connHandle) == NULL)
+        {
+            streamStats.sendsRejected++;
+            return bleNoResources;
+        }
+
         // Store the data into the queue
         newNode = (SimpleStreamNode_t*) SimpleStreamClient_allocateWithHeadroom(sizeof(SimpleStreamNode_t) + len);
         if (newNode != NULL)
@@ -383,6 +639,7 @@ bStatus_t SimpleStreamClient_sendData(uint16_t connHandle, void *data, uint16_t
             newNode->connHandle = connHandle;
             newNode->offset     = 0;
             newNode->len        = len;
+            newNode->timestamp  = ICall_getTicks();
             memcpy(newNode->payload, data, len);
 
             // Add the data to the stream queue
@@ -390,6 +647,7 @@ bStatus_t SimpleStreamClient_sendData(uint16_t connHandle, void *data, uint16_t
 
             if (ret == SUCCESS)
             {
+                streamStats.bytesQueued += len;
                 ret = SimpleStreamClient_processStream();
             }
             else if (ret == FAILURE)
@@ -397,6 +655,10 @@ bStatus_t SimpleStreamClient_sendData(uint16_t connHandle, void *data, uint16_t
                 ICall_free(newNode);
             }
         }
+        else
+        {
+            streamStats.sendsRejected++;
+        }
     }
     else
     {
@@ -406,6 +668,147 @@ bStatus_t SimpleStreamClient_sendData(uint16_t connHandle, void *data, uint16_t
     return ret;
 }
 
+/*********************************************************************
+ * @fn      SimpleStreamClient_setCreditWindow
+ *
+ * @brief   Sets how many LL packets may be outstanding in the controller
+ *          on each connection at any time.
+ *
+ * @param   window - number of TX credits, must be at least 1
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t SimpleStreamClient_setCreditWindow(uint8_t window)
+{
+    uint8_t inUse;
+    uint8_t i;
+
+    if (window == 0)
+    {
+        return INVALIDPARAMETER;
+    }
+
+    for (i = 0; i < SIMPLESTREAMCLIENT_MAX_LINKS; i++)
+    {
+        if (!streamLinks[i].inUse)
+        {
+            continue;
+        }
+
+        // Credits already in use stay in use
+        inUse = txCreditWindow - streamLinks[i].credits;
+
+        streamLinks[i].credits = (window > inUse) ? (window - inUse) : 0;
+    }
+
+    txCreditWindow = window;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_setTxOctets
+ *
+ * @brief   Sets the LL payload size of a connection, as reported by the
+ *          HCI_BLE_DATA_LENGTH_CHANGE_EVENT. It decides how many LL
+ *          packets, and thus TX credits, a write is split into.
+ *
+ * @param   connHandle  - connection handle
+ * @param   maxTxOctets - maximum LL payload size, 27 to 251
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleNoResources
+ */
+bStatus_t SimpleStreamClient_setTxOctets(uint16_t connHandle, uint16_t maxTxOctets)
+{
+    SimpleStreamClientLink_t *pLink;
+
+    if ((maxTxOctets < SIMPLESTREAMCLIENT_DEFAULT_TX_OCTETS) || (maxTxOctets > 251))
+    {
+        return INVALIDPARAMETER;
+    }
+
+    pLink = SimpleStreamClient_getLink(connHandle);
+    if (pLink == NULL)
+    {
+        return bleNoResources;
+    }
+
+    pLink->maxTxOctets = maxTxOctets;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_processCompletedPackets
+ *
+ * @brief   Returns TX credits for packets the controller reported as
+ *          completed and refills the controller from the outgoing
+ *          stream queue.
+ *
+ * @param   connHandle - connection the packets were completed on
+ * @param   numPkts    - number of completed packets
+ *
+ * @return  SUCCESS or SimpleStreamClient_processStream return value
+ */
+bStatus_t SimpleStreamClient_processCompletedPackets(uint16_t connHandle, uint16_t numPkts)
+{
+    SimpleStreamClientLink_t *pLink = SimpleStreamClient_findLink(connHandle);
+
+    if (pLink == NULL)
+    {
+        // Not a connection the stream is sent on
+        return SUCCESS;
+    }
+
+    if ((uint16_t)(pLink->credits + numPkts) > txCreditWindow)
+    {
+        pLink->credits = txCreditWindow;
+    }
+    else
+    {
+        pLink->credits += numPkts;
+    }
+
+    return SimpleStreamClient_pump();
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_processConnEvt
+ *
+ * @brief   Refills the controller from the outgoing stream queue at the
+ *          end of a connection event, retrying data held back for lack
+ *          of stack buffers. Credits are only returned by
+ *          SimpleStreamClient_processCompletedPackets.
+ *
+ * @param   pReport - connection event report
+ *
+ * @return  SUCCESS or SimpleStreamClient_processStream return value
+ */
+bStatus_t SimpleStreamClient_processConnEvt(Gap_ConnEventRpt_t *pReport)
+{
+    uint8_t i;
+
+    if (pReport == NULL)
+    {
+        return INVALIDPARAMETER;
+    }
+
+    // Acknowledge whatever was received since the last acknowledgement so
+    // the server can release it without waiting for a full ack interval
+    for (i = 0; reliableMode && (i < SIMPLESTREAMCLIENT_MAX_LINKS); i++)
+    {
+        SimpleStreamClientPeer_t *pPeer = &streamPeers[i];
+
+        if (pPeer->inUse && (pPeer->connHandle == pReport->handle) &&
+            (pPeer->pendingOp == SSC_OP_NONE) && (pPeer->rxOffset != pPeer->ackOffset))
+        {
+            pPeer->pendingOp = SIMPLESTREAMSERVER_OP_ACK;
+        }
+    }
+
+    return SimpleStreamClient_pump();
+}
+
 /*********************************************************************
  * @fn      SimpleStreamClient_enableNotifications
  *
@@ -434,3 +837,337 @@ bStatus_t SimpleStreamClient_enableNotifications(uint16_t connHandle)
 
     return retVal;
 }
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_setReliableMode
+ *
+ * @brief   Enables or disables the reliable stream mode. It must match
+ *          the mode of the server. Known server stream offsets are
+ *          discarded.
+ *
+ * @param   enable      - TRUE to enable the reliable mode
+ * @param   ackInterval - received bytes between acknowledgements, 0 for
+ *                        SIMPLESTREAMCLIENT_DEFAULT_ACK_INTERVAL
+ *
+ * @return  none
+ */
+void SimpleStreamClient_setReliableMode(bool enable, uint16_t ackInterval)
+{
+    memset(streamPeers, 0, sizeof(streamPeers));
+
+    reliableMode        = enable;
+    reliableAckInterval = (ackInterval != 0) ? ackInterval : SIMPLESTREAMCLIENT_DEFAULT_ACK_INTERVAL;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_processIncoming
+ *
+ * @brief   Processes a DataOut notification. In reliable mode the stream
+ *          offset header is removed, data already received is dropped,
+ *          received data is acknowledged and the server is asked to
+ *          resend data that went missing. Otherwise the notification is
+ *          passed through as is.
+ *
+ * @param   connHandle - connection the notification was received on
+ * @param   pValue     - notification value
+ * @param   len        - length of the notification value
+ * @param   ppData     - set to the new stream data in pValue
+ * @param   pDataLen   - set to the length of the new stream data, 0 if none
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleNoResources
+ */
+bStatus_t SimpleStreamClient_processIncoming(uint16_t connHandle, uint8_t *pValue, uint16_t len,
+                                             uint8_t **ppData, uint16_t *pDataLen)
+{
+    SimpleStreamClientPeer_t *pPeer;
+    uint32_t offset;
+    uint32_t skip;
+
+    if ((pValue == NULL) || (ppData == NULL) || (pDataLen == NULL))
+    {
+        return INVALIDPARAMETER;
+    }
+
+    *ppData   = pValue;
+    *pDataLen = len;
+
+    if (!reliableMode)
+    {
+        return SUCCESS;
+    }
+
+    *pDataLen = 0;
+
+    if (len < SIMPLESTREAMSERVER_RELIABLE_HDR_SIZE)
+    {
+        return INVALIDPARAMETER;
+    }
+
+    pPeer = SimpleStreamClient_getPeer(connHandle);
+    if (pPeer == NULL)
+    {
+        return bleNoResources;
+    }
+
+    offset = BUILD_UINT32(pValue[0], pValue[1], pValue[2], pValue[3]);
+    pValue += SIMPLESTREAMSERVER_RELIABLE_HDR_SIZE;
+    len    -= SIMPLESTREAMSERVER_RELIABLE_HDR_SIZE;
+
+    // Join a stream we know nothing about where the server is
+    if (!pPeer->synced)
+    {
+        pPeer->rxOffset  = offset;
+        pPeer->ackOffset = offset;
+        pPeer->synced    = TRUE;
+    }
+
+    if (offset > pPeer->rxOffset)
+    {
+        // Data went missing, ask once for it to be resent. Later data
+        // already on its way is dropped until the resent data arrives.
+        if (!pPeer->resumeRequested)
+        {
+            pPeer->resumeRequested = TRUE;
+            pPeer->pendingOp       = SIMPLESTREAMSERVER_OP_RESUME;
+            SimpleStreamClient_pump();
+        }
+
+        return SUCCESS;
+    }
+
+    // Skip the part that was already received
+    skip = pPeer->rxOffset - offset;
+    if (skip >= len)
+    {
+        return SUCCESS;
+    }
+
+    pPeer->resumeRequested = FALSE;
+    pPeer->rxOffset       += (len - skip);
+
+    *ppData   = pValue + skip;
+    *pDataLen = len - skip;
+
+    if ((pPeer->pendingOp == SSC_OP_NONE) &&
+        ((pPeer->rxOffset - pPeer->ackOffset) >= reliableAckInterval))
+    {
+        pPeer->pendingOp = SIMPLESTREAMSERVER_OP_ACK;
+        SimpleStreamClient_pump();
+    }
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_resumeStream
+ *
+ * @brief   Asks the server to resume the reliable mode stream on a new
+ *          connection from the last byte received. Call it once
+ *          notifications are enabled. Nothing is sent to a server the
+ *          client has not received from before.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  SUCCESS or bleNoResources
+ */
+bStatus_t SimpleStreamClient_resumeStream(uint16_t connHandle)
+{
+    if (SimpleStreamClient_getPeer(connHandle) == NULL)
+    {
+        return bleNoResources;
+    }
+
+    SimpleStreamClient_pump();
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_getPeer
+ *
+ * @brief   Finds the reliable mode stream of the server on a connection,
+ *          identified by its device address. A stream found on a new
+ *          connection gets a resume request. A new stream is created if
+ *          the server has none, reusing the stream of a disconnected
+ *          server if all are taken.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  Pointer to the peer, NULL if none is available
+ */
+static SimpleStreamClientPeer_t *SimpleStreamClient_getPeer( uint16_t connHandle )
+{
+    SimpleStreamClientPeer_t *pFound = NULL;
+    SimpleStreamClientPeer_t *pFree  = NULL;
+    linkDBInfo_t connInfo;
+    uint8_t i;
+
+    for (i = 0; i < SIMPLESTREAMCLIENT_MAX_LINKS; i++)
+    {
+        if (streamPeers[i].inUse && (streamPeers[i].connHandle == connHandle))
+        {
+            return &streamPeers[i];
+        }
+    }
+
+    if (linkDB_GetInfo(connHandle, &connInfo) != SUCCESS)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < SIMPLESTREAMCLIENT_MAX_LINKS; i++)
+    {
+        SimpleStreamClientPeer_t *pPeer = &streamPeers[i];
+
+        if (pPeer->inUse && (pPeer->addrType == connInfo.addrType) &&
+            !memcmp(pPeer->addr, connInfo.addr, B_ADDR_LEN))
+        {
+            pFound = pPeer;
+        }
+        else if ((pFree == NULL) &&
+                 (!pPeer->inUse || (pPeer->connHandle == CONNHANDLE_INVALID)))
+        {
+            pFree = pPeer;
+        }
+    }
+
+    if (pFound != NULL)
+    {
+        // The server is back on a new link, continue where the stream left off
+        pFound->connHandle      = connHandle;
+        pFound->resumeRequested = pFound->synced;
+        pFound->pendingOp       = pFound->synced ? SIMPLESTREAMSERVER_OP_RESUME : SSC_OP_NONE;
+
+        return pFound;
+    }
+
+    if (pFree != NULL)
+    {
+        memset(pFree, 0, sizeof(SimpleStreamClientPeer_t));
+
+        pFree->inUse      = TRUE;
+        pFree->addrType   = connInfo.addrType;
+        memcpy(pFree->addr, connInfo.addr, B_ADDR_LEN);
+        pFree->connHandle = connHandle;
+        pFree->pendingOp  = SSC_OP_NONE;
+    }
+
+    return pFree;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_writeCommand
+ *
+ * @brief   Writes the pending ack or resume request of a server, carrying
+ *          the offset of the next byte expected from it.
+ *
+ * @param   pPeer - reliable mode stream of the server
+ *
+ * @return  SUCCESS, blePending, bleMemAllocError or GATT_WriteNoRsp
+ *          return value
+ */
+static bStatus_t SimpleStreamClient_writeCommand( SimpleStreamClientPeer_t *pPeer )
+{
+    SimpleStreamClientLink_t *pLink = SimpleStreamClient_getLink(pPeer->connHandle);
+    attWriteReq_t req;
+    bStatus_t ret;
+
+    // A command always fits a single LL packet
+    if ((pLink == NULL) || (pLink->credits == 0))
+    {
+        streamStats.creditStalls++;
+        return blePending;
+    }
+
+    req.pValue = (uint8 *)GATT_bm_alloc( pPeer->connHandle, ATT_WRITE_CMD,
+                                          SIMPLESTREAMSERVER_OP_CMD_LEN, NULL );
+    if (req.pValue == NULL)
+    {
+        streamStats.allocFailures++;
+        return bleMemAllocError;
+    }
+
+    req.handle    = streamServiceHandle.chars[0].handle;
+    req.len       = SIMPLESTREAMSERVER_OP_CMD_LEN;
+    req.pValue[0] = pPeer->pendingOp;
+    req.pValue[1] = BREAK_UINT32(pPeer->rxOffset, 0);
+    req.pValue[2] = BREAK_UINT32(pPeer->rxOffset, 1);
+    req.pValue[3] = BREAK_UINT32(pPeer->rxOffset, 2);
+    req.pValue[4] = BREAK_UINT32(pPeer->rxOffset, 3);
+    req.cmd       = TRUE;
+    req.sig       = FALSE;
+
+    ret = GATT_WriteNoRsp( pPeer->connHandle, &req );
+
+    if (ret != SUCCESS)
+    {
+        GATT_bm_free( (gattMsg_t *)&req, ATT_WRITE_CMD );
+    }
+    else
+    {
+        pLink->credits--;
+
+        pPeer->ackOffset = pPeer->rxOffset;
+        pPeer->pendingOp = SSC_OP_NONE;
+    }
+
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_flushCommands
+ *
+ * @brief   Writes the pending acks and resume requests. Those that cannot
+ *          be written yet are retried on the next refill.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SimpleStreamClient_flushCommands()
+{
+    uint8_t i;
+
+    for (i = 0; i < SIMPLESTREAMCLIENT_MAX_LINKS; i++)
+    {
+        SimpleStreamClientPeer_t *pPeer = &streamPeers[i];
+
+        if (pPeer->inUse && (pPeer->connHandle != CONNHANDLE_INVALID) &&
+            (pPeer->pendingOp != SSC_OP_NONE))
+        {
+            SimpleStreamClient_writeCommand(pPeer);
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_getStats
+ *
+ * @brief   Copies the stream statistics gathered since the last reset.
+ *
+ * @param   pStats - statistics to fill in
+ *
+ * @return  none
+ */
+void SimpleStreamClient_getStats(SimpleStreamClientStats_t *pStats)
+{
+    if (pStats != NULL)
+    {
+        *pStats = streamStats;
+    }
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamClient_resetStats
+ *
+ * @brief   Clears the stream statistics.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SimpleStreamClient_resetStats(void)
+{
+    memset(&streamStats, 0, sizeof(streamStats));
+    streamStats.minFreeHeap = UINT32_MAX;
+}
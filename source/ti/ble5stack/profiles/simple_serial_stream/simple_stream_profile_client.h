@@ -62,6 +62,35 @@ extern "C"
 #define SIMPLESTREAMSERVER_DATAIN_UUID 0xC0C1
 #define SIMPLESTREAMSERVER_DATAOUT_UUID 0xC0C2
 
+// Reliable stream mode, see simple_stream_profile_server.h
+#define SIMPLESTREAMSERVER_RELIABLE_HDR_SIZE    4
+#define SIMPLESTREAMSERVER_OP_DATA              0x00  // Application data follows
+#define SIMPLESTREAMSERVER_OP_ACK               0x01  // 32-bit cumulative ack follows
+#define SIMPLESTREAMSERVER_OP_RESUME            0x02  // 32-bit offset to resend from follows
+#define SIMPLESTREAMSERVER_OP_CMD_LEN           5
+
+// Default number of received bytes between acknowledgements in reliable mode,
+// a quarter of the server's default send window
+#define SIMPLESTREAMCLIENT_DEFAULT_ACK_INTERVAL 512
+
+// Default number of LL packets that may be outstanding in the controller
+// on each connection at any time. A write without response is split into
+// as many LL packets as it takes to carry it with the link's LL payload size.
+#define SIMPLESTREAMCLIENT_DEFAULT_CREDIT_WINDOW 4
+
+// LL payload size assumed until SimpleStreamClient_setTxOctets is called
+#define SIMPLESTREAMCLIENT_DEFAULT_TX_OCTETS 27
+
+// Number of connections the stream can be sent on at the same time
+#ifndef SIMPLESTREAMCLIENT_MAX_LINKS
+#define SIMPLESTREAMCLIENT_MAX_LINKS 4
+#endif
+
+// Number of buckets in the queue latency histogram. Bucket 0 counts nodes sent
+// within 2 ms of being queued, bucket n counts [2^n, 2^(n+1)) ms and the last
+// bucket everything slower.
+#define SIMPLESTREAMCLIENT_LATENCY_BUCKETS 12
+
 // Server profile UUIDs
 extern const uint8_t SimpleStreamServerUUID[ATT_UUID_SIZE];
 extern const uint8_t SimpleStreamServer_DataInUUID[ATT_UUID_SIZE];
@@ -81,9 +110,23 @@ typedef struct
     uint16_t connHandle;
     uint16_t offset;
     uint16_t len;
+    uint32_t timestamp;     // ICall tick the node was queued at
     uint8_t payload[];
 } SimpleStreamNode_t;
 
+// Stream statistics, see SimpleStreamClient_getStats
+typedef struct
+{
+    uint32_t bytesQueued;       // Bytes accepted by SimpleStreamClient_sendData
+    uint32_t bytesSent;         // Payload bytes sent in write without response packets
+    uint32_t packetsSent;       // Write without response packets sent
+    uint32_t minFreeHeap;       // Smallest free heap seen when allocating a node
+    uint16_t allocFailures;     // Packets not sent for lack of stack buffers
+    uint16_t creditStalls;      // Packets held back because a connection's credit window was exhausted
+    uint16_t sendsRejected;     // SimpleStreamClient_sendData calls refused
+    uint32_t latencyHist[SIMPLESTREAMCLIENT_LATENCY_BUCKETS]; // Time from queued to fully sent
+} SimpleStreamClientStats_t;
+
 /*********************************************************************
  * MACROS
  */
@@ -131,6 +174,95 @@ extern void     SimpleStreamClient_setHeadroomLimit(uint16_t minHeapHeadroom);
  *                                           enough heap, it will allocate the memory.
  */
 extern void*    SimpleStreamClient_allocateWithHeadroom(uint16_t allocSize);
+
+/*
+ * SimpleStreamClient_setCreditWindow - Sets how many LL packets may be outstanding in the
+ *                                      controller on each connection at any time.
+ *
+ *    window - number of TX credits, must be at least 1
+ */
+extern bStatus_t SimpleStreamClient_setCreditWindow(uint8_t window);
+
+/*
+ * SimpleStreamClient_setTxOctets - Sets the LL payload size of a connection, as reported
+ *                                  by the HCI_BLE_DATA_LENGTH_CHANGE_EVENT. Writes use
+ *                                  one TX credit per LL packet they are split into.
+ *
+ *    connHandle  - connection handle
+ *    maxTxOctets - maximum LL payload size, 27 to 251
+ */
+extern bStatus_t SimpleStreamClient_setTxOctets(uint16_t connHandle, uint16_t maxTxOctets);
+
+/*
+ * SimpleStreamClient_processCompletedPackets - Returns TX credits of a connection for the
+ *                                              LL packets the controller reported as
+ *                                              completed and refills the controller from
+ *                                              the outgoing stream queue.
+ *
+ *    connHandle - connection the packets were completed on
+ *    numPkts    - number of completed packets
+ */
+extern bStatus_t SimpleStreamClient_processCompletedPackets(uint16_t connHandle, uint16_t numPkts);
+
+/*
+ * SimpleStreamClient_processConnEvt - Refills the controller from the outgoing stream queue
+ *                                     at the end of a connection event, retrying data held
+ *                                     back for lack of stack buffers. It does not return
+ *                                     TX credits, completed packet events must be routed
+ *                                     to SimpleStreamClient_processCompletedPackets.
+ *
+ *    pReport - connection event report from Gap_RegisterConnEventCb
+ */
+extern bStatus_t SimpleStreamClient_processConnEvt(Gap_ConnEventRpt_t *pReport);
+
+/*
+ * SimpleStreamClient_setReliableMode - Enables or disables the reliable stream mode, it
+ *                                      must match the mode of the server. Writes are
+ *                                      prefixed with SIMPLESTREAMSERVER_OP_DATA and the
+ *                                      received stream is acknowledged. Known server
+ *                                      stream offsets are discarded.
+ *
+ *    enable      - TRUE to enable the reliable mode
+ *    ackInterval - received bytes between acknowledgements, 0 for the default
+ */
+extern void      SimpleStreamClient_setReliableMode(bool enable, uint16_t ackInterval);
+
+/*
+ * SimpleStreamClient_processIncoming - Processes a DataOut notification. In reliable mode
+ *                                      the stream offset header is removed, duplicate data
+ *                                      is dropped, the data is acknowledged and the server
+ *                                      is asked to resend missing data. Only the returned
+ *                                      data is to be passed on to the application.
+ *
+ *    connHandle - connection the notification was received on
+ *    pValue     - notification value
+ *    len        - length of the notification value
+ *    ppData     - set to the new stream data in pValue
+ *    pDataLen   - set to the length of the new stream data, 0 if none
+ */
+extern bStatus_t SimpleStreamClient_processIncoming(uint16_t connHandle, uint8_t *pValue, uint16_t len,
+                                                    uint8_t **ppData, uint16_t *pDataLen);
+
+/*
+ * SimpleStreamClient_resumeStream - Asks the server to resume the reliable mode stream from
+ *                                   the last byte received. Call it on reconnection once
+ *                                   notifications are enabled.
+ *
+ *    connHandle - connection handle
+ */
+extern bStatus_t SimpleStreamClient_resumeStream(uint16_t connHandle);
+
+/*
+ * SimpleStreamClient_getStats - Copies the stream statistics gathered since the last reset.
+ *
+ *    pStats - statistics to fill in
+ */
+extern void      SimpleStreamClient_getStats(SimpleStreamClientStats_t *pStats);
+
+/*
+ * SimpleStreamClient_resetStats - Clears the stream statistics.
+ */
+extern void      SimpleStreamClient_resetStats(void);
 /*********************************************************************
 *********************************************************************/
 
@@ -44,6 +44,7 @@
 #include <icall.h>
 #include <simple_stream_profile_server.h>
 #include "icall_ble_api.h"
+#include "gatt_service_def.h"
 
 
 /*********************************************************************
@@ -53,6 +54,9 @@
 // The size of the notification header is opcode + handle
 #define SSS_NOTI_HDR_SIZE   (ATT_OPCODE_SIZE + 2)
 
+// No acknowledgement is waiting to be processed for a session
+#define SSS_OP_NONE         0xFF
+
 /*********************************************************************
  * MACROS
  */
@@ -65,6 +69,23 @@
  * TYPEDEFS
  */
 
+// Reliable mode stream state kept per peer device
+typedef struct
+{
+    bool      inUse;
+    uint8_t   addrType;
+    uint8_t   addr[B_ADDR_LEN];
+    uint16_t  connHandle;     // CONNHANDLE_INVALID while the stream is suspended
+    uint32_t  queueOffset;    // Stream offset given to the next queued byte
+    uint32_t  sendOffset;     // Stream offset of the next byte to notify
+    uint32_t  ackOffset;      // Stream offset acknowledged by the peer
+    uint32_t  highOffset;     // Stream offset following the furthest byte ever notified
+    List_List unacked;        // Sent nodes waiting for an ack, all nodes while suspended
+    uint8_t   pendingOp;      // Ack received in stack context, SSS_OP_NONE if none
+    uint16_t  pendingConnHandle;
+    uint32_t  pendingOffset;
+} SimpleStreamSession_t;
+
 /*********************************************************************
 * GLOBAL VARIABLES
 */
@@ -97,6 +118,28 @@ static List_List streamOutQueue;
 
 static uint16_t heapHeadroom = 0;
 
+// Outgoing queue depth, counted in bytes not yet sent and in nodes
+static uint32_t streamOutQueuedBytes = 0;
+static uint16_t streamOutQueuedNodes = 0;
+
+// Outgoing queue watermarks, a high watermark of 0 disables the limit
+static uint32_t queueHighWatermark = 0;
+static uint32_t queueLowWatermark  = 0;
+
+// Set when the producer has been refused and is waiting for the low watermark
+static bool     streamThrottled = FALSE;
+
+// Reliable stream mode
+static bool     reliableMode = FALSE;
+static uint32_t reliableSendWindow = SIMPLESTREAMSERVER_DEFAULT_SEND_WINDOW;
+static SimpleStreamSession_t streamSessions[SIMPLESTREAMSERVER_MAX_PEERS];
+
+// Set from stack context when any session has an ack waiting to be processed
+static volatile bool streamAckPending = FALSE;
+
+// Stream statistics
+static SimpleStreamServerStats_t streamStats = { .minFreeHeap = UINT32_MAX };
+
 /*********************************************************************
 * Profile Attributes - variables
 */
@@ -104,68 +147,42 @@ static uint16_t heapHeadroom = 0;
 // Service declaration
 static CONST gattAttrType_t SimpleStreamServerDecl = { ATT_UUID_SIZE, SimpleStreamServerUUID };
 
-// Characteristic "DataIn" Properties (for declaration)
-static uint8_t SimpleStreamServer_DataInProps = GATT_PROP_WRITE;
-
 // Characteristic "DataIn" Value variable
 static uint8_t SimpleStreamServer_DataInVal[SIMPLESTREAMSERVER_DATAIN_LEN] = {0};
-// Characteristic "DataOut" Properties (for declaration)
-static uint8_t SimpleStreamServer_DataOutProps = GATT_PROP_NOTIFY;
 
 // Characteristic "DataOut" Value variable
 static uint8_t SimpleStreamServer_DataOutVal[SIMPLESTREAMSERVER_DATAOUT_LEN] = {0};
 
-// Characteristic "DataOut" CCCD
-static gattCharCfg_t *SimpleStreamServer_DataOutConfig;
+/*********************************************************************
+* Profile Attributes - Definition
+*/
+
+#define SIMPLESTREAMSERVER_DEF(SERVICE, CHAR, CHAR_CCC, DESC)                        \
+  /* SimpleStreamServer Service Declaration */                                       \
+  SERVICE( SIMPLESTREAMSERVER, SimpleStreamServerDecl )                              \
+  /* DataIn Characteristic */                                                        \
+  CHAR( SIMPLESTREAMSERVER_DATAIN, GATT_PROP_WRITE,                                  \
+        ATT_UUID_SIZE, SimpleStreamServer_DataInUUID,                                \
+        GATT_PERMIT_WRITE, SimpleStreamServer_DataInVal )                            \
+  /* DataOut Characteristic */                                                       \
+  CHAR_CCC( SIMPLESTREAMSERVER_DATAOUT, GATT_PROP_NOTIFY,                            \
+            ATT_UUID_SIZE, SimpleStreamServer_DataOutUUID,                           \
+            0, SimpleStreamServer_DataOutVal,                                        \
+            GATT_PERMIT_READ | GATT_PERMIT_WRITE, SimpleStreamServer_DataOutConfig )
+
+// Characteristic properties (for declarations) and CCC tables
+GATT_SERVICE_DEF_VARS( SIMPLESTREAMSERVER_DEF )
+
+// Attribute positions in the table
+GATT_SERVICE_DEF_INDEX( SIMPLESTREAMSERVER_DEF, SIMPLESTREAMSERVER_NUM_ATTRS );
 
 /*********************************************************************
 * Profile Attributes - Table
 */
 
-static gattAttribute_t SimpleStreamServerAttrTbl[] =
+static gattAttribute_t SimpleStreamServerAttrTbl[SIMPLESTREAMSERVER_NUM_ATTRS] =
 {
-  // SimpleStreamServer Service Declaration
-  {
-    { ATT_BT_UUID_SIZE, primaryServiceUUID },
-    GATT_PERMIT_READ,
-    0,
-    (uint8_t *)&SimpleStreamServerDecl
-  },
-    // DataIn Characteristic Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &SimpleStreamServer_DataInProps
-    },
-      // DataIn Characteristic Value
-      {
-        { ATT_UUID_SIZE, SimpleStreamServer_DataInUUID },
-        GATT_PERMIT_WRITE,
-        0,
-        SimpleStreamServer_DataInVal
-      },
-    // DataOut Characteristic Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &SimpleStreamServer_DataOutProps
-    },
-      // DataOut Characteristic Value
-      {
-        { ATT_UUID_SIZE, SimpleStreamServer_DataOutUUID },
-        0,
-        0,
-        SimpleStreamServer_DataOutVal
-      },
-      // DataOut CCCD
-      {
-        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
-        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
-        0,
-        (uint8 *)&SimpleStreamServer_DataOutConfig
-      },
+  GATT_SERVICE_DEF_TABLE( SIMPLESTREAMSERVER_DEF )
 };
 
 /*********************************************************************
@@ -180,6 +197,18 @@ static bStatus_t SimpleStreamServer_WriteAttrCB( uint16_t connHandle, gattAttrib
 static bStatus_t SimpleStreamServer_transmitNode( SimpleStreamNode_t *node );
 static bStatus_t SimpleStreamServer_queueData( SimpleStreamNode_t *node );
 static void      SimpleStreamServer_clearQueue();
+static void      SimpleStreamServer_checkLowWatermark();
+static bStatus_t SimpleStreamServer_pump();
+static SimpleStreamSession_t *SimpleStreamServer_findSession( uint16_t connHandle );
+static SimpleStreamSession_t *SimpleStreamServer_getSession( uint16_t connHandle );
+static void      SimpleStreamServer_storeAck( uint16_t connHandle, uint8_t opcode, uint32_t offset );
+static void      SimpleStreamServer_processAcks();
+static void      SimpleStreamServer_releaseAcked( SimpleStreamSession_t *pSession, uint32_t offset );
+static void      SimpleStreamServer_detachSession( SimpleStreamSession_t *pSession );
+static void      SimpleStreamServer_attachSession( SimpleStreamSession_t *pSession,
+                                                   uint16_t connHandle, uint32_t offset );
+static void      SimpleStreamServer_dropSession( SimpleStreamSession_t *pSession );
+static void      SimpleStreamServer_recordLatency( SimpleStreamNode_t *node );
 /*********************************************************************
  * PROFILE CALLBACKS
  */
@@ -298,8 +327,8 @@ static bStatus_t SimpleStreamServer_WriteAttrCB( uint16_t connHandle, gattAttrib
   bStatus_t status  = SUCCESS;
   uint8_t   paramID = 0xFF;
 
-  // See if request is regarding a Client Characterisic Configuration
-  if ( ! memcmp(pAttr->type.uuid, clientCharCfgUUID, pAttr->type.len) )
+  // See if request is regarding the DataOut Client Characterisic Configuration
+  if ( pAttr == &SimpleStreamServerAttrTbl[SIMPLESTREAMSERVER_DATAOUT_CCC_IDX] )
   {
     // Allow only notifications.
     status = GATTServApp_ProcessCCCWriteReq( connHandle, pAttr, pValue, len,
@@ -314,15 +343,47 @@ static bStatus_t SimpleStreamServer_WriteAttrCB( uint16_t connHandle, gattAttrib
     }
   }
   // See if request is regarding the DataIn Characteristic Value
-  else if ( ! memcmp(pAttr->type.uuid, SimpleStreamServer_DataInUUID, pAttr->type.len) )
+  else if ( pAttr == &SimpleStreamServerAttrTbl[SIMPLESTREAMSERVER_DATAIN_VALUE_IDX] )
   {
-      // Only notify application if there is any data in the payload
-      if ( len > 0 )
+      // In reliable mode every write starts with an opcode
+      if ( reliableMode && (len > 0) && (pValue[0] != SIMPLESTREAMSERVER_OP_DATA) )
       {
-          if ( pAppCBs && pAppCBs->pfnIncomingDataCb )
+          if ( ( (pValue[0] == SIMPLESTREAMSERVER_OP_ACK) ||
+                 (pValue[0] == SIMPLESTREAMSERVER_OP_RESUME) ) &&
+               ( len == SIMPLESTREAMSERVER_OP_CMD_LEN ) )
+          {
+              uint32_t ackOffset = BUILD_UINT32(pValue[1], pValue[2], pValue[3], pValue[4]);
+
+              SimpleStreamServer_storeAck(connHandle, pValue[0], ackOffset);
+
+              if ( pAppCBs && pAppCBs->pfnStreamAckCb )
+              {
+                  // Call app function from stack task context.
+                  pAppCBs->pfnStreamAckCb(connHandle, pValue[0], ackOffset);
+              }
+          }
+          else
+          {
+              status = ATT_ERR_INVALID_VALUE;
+          }
+      }
+      else
+      {
+          if ( reliableMode && (len > 0) )
+          {
+              // Strip the data opcode
+              pValue++;
+              len--;
+          }
+
+          // Only notify application if there is any data in the payload
+          if ( len > 0 )
           {
-              // Call app function from stack task context.
-              pAppCBs->pfnIncomingDataCb(connHandle, paramID, len, pValue);
+              if ( pAppCBs && pAppCBs->pfnIncomingDataCb )
+              {
+                  // Call app function from stack task context.
+                  pAppCBs->pfnIncomingDataCb(connHandle, paramID, len, pValue);
+              }
           }
       }
   }
@@ -370,6 +431,14 @@ static bStatus_t SimpleStreamServer_queueData( SimpleStreamNode_t *node )
              ( pItem->value & GATT_CLIENT_CFG_NOTIFY ))
         {
             List_put(&streamOutQueue, (List_Elem *) node);
+
+            streamOutQueuedBytes += (node->len - node->offset);
+            streamOutQueuedNodes++;
+
+            if ( streamOutQueuedBytes > streamStats.peakQueuedBytes )
+            {
+                streamStats.peakQueuedBytes = streamOutQueuedBytes;
+            }
         }
         else
         {
@@ -401,31 +470,73 @@ static bStatus_t SimpleStreamServer_transmitNode( SimpleStreamNode_t* node)
     bStatus_t ret = SUCCESS;
     attHandleValueNoti_t noti;
     linkDBInfo_t connInfo;
+    SimpleStreamSession_t *pSession = NULL;
+    uint16_t hdrLen = 0;
 
     // Find out what the maximum MTU size is
     ret = linkDB_GetInfo(node->connHandle, &connInfo);
 
+    if ( (ret == SUCCESS) && reliableMode )
+    {
+        pSession = SimpleStreamServer_findSession(node->connHandle);
+        hdrLen   = SIMPLESTREAMSERVER_RELIABLE_HDR_SIZE;
+
+        if ( pSession == NULL )
+        {
+            ret = bleNotConnected;
+        }
+        else if ( (pSession->sendOffset - pSession->ackOffset) >= reliableSendWindow )
+        {
+            // Send window is closed, wait for the peer to acknowledge
+            ret = blePending;
+        }
+    }
+
     // Queue up as many notification slots as possible
     if ( (ret == SUCCESS) && (node != NULL) ) {
 
         // Determine allocation size
         uint16_t allocLen = (node->len - node->offset);
-        if ( allocLen > (connInfo.MTU - SSS_NOTI_HDR_SIZE) )
+        if ( allocLen > (connInfo.MTU - SSS_NOTI_HDR_SIZE - hdrLen) )
         {
-            allocLen = connInfo.MTU - SSS_NOTI_HDR_SIZE;
+            allocLen = connInfo.MTU - SSS_NOTI_HDR_SIZE - hdrLen;
+        }
+        if ( (pSession != NULL) &&
+             (allocLen > (reliableSendWindow - (pSession->sendOffset - pSession->ackOffset))) )
+        {
+            allocLen = reliableSendWindow - (pSession->sendOffset - pSession->ackOffset);
         }
 
         noti.len = 0;
         noti.pValue = (uint8 *)GATT_bm_alloc( node->connHandle, ATT_HANDLE_VALUE_NOTI,
-                                              allocLen, &noti.len );
+                                              allocLen + hdrLen, &noti.len );
+
+        // A reliable mode notification must fit the header and some data
+        if ( (noti.pValue != NULL) && (noti.len <= hdrLen) )
+        {
+            GATT_bm_free( (gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI );
+            noti.pValue = NULL;
+        }
 
         // If allocation was successful, copy out data out of the buffer and send it
         if (noti.pValue) {
 
-            memcpy(noti.pValue, (void *) ((uint8_t *) node->payload + node->offset), noti.len);
+            uint16_t dataLen = noti.len - hdrLen;
 
-            // The outgoing data attribute offset is 4
-            noti.handle = SimpleStreamServerAttrTbl[4].handle;
+            if ( pSession != NULL )
+            {
+                // Prefix the data with its stream offset
+                uint32_t streamOffset = node->streamOffset + node->offset;
+
+                noti.pValue[0] = BREAK_UINT32(streamOffset, 0);
+                noti.pValue[1] = BREAK_UINT32(streamOffset, 1);
+                noti.pValue[2] = BREAK_UINT32(streamOffset, 2);
+                noti.pValue[3] = BREAK_UINT32(streamOffset, 3);
+            }
+
+            memcpy(noti.pValue + hdrLen, (void *) ((uint8_t *) node->payload + node->offset), dataLen);
+
+            noti.handle = SimpleStreamServerAttrTbl[SIMPLESTREAMSERVER_DATAOUT_VALUE_IDX].handle;
 
             ret = GATT_Notification( node->connHandle, &noti, FALSE );
 
@@ -437,19 +548,67 @@ static bStatus_t SimpleStreamServer_transmitNode( SimpleStreamNode_t* node)
             else
             {
                 // Increment node data offset
-                node->offset += noti.len;
+                node->offset += dataLen;
+
+                streamStats.bytesSent += dataLen;
+                streamStats.packetsSent++;
+
+                if ( pSession != NULL )
+                {
+                    uint32_t endOffset = pSession->sendOffset + dataLen;
+
+                    // Data below the furthest byte ever notified is a resend
+                    if ( pSession->sendOffset < pSession->highOffset )
+                    {
+                        streamStats.bytesResent += ((endOffset < pSession->highOffset) ?
+                                                    endOffset : pSession->highOffset) -
+                                                   pSession->sendOffset;
+                    }
+                    if ( endOffset > pSession->highOffset )
+                    {
+                        pSession->highOffset = endOffset;
+                    }
+
+                    pSession->sendOffset = endOffset;
+                }
             }
         }
         else
         {
             // Unable to allocate space for a notification, return failure
             ret = bleMemAllocError;
+            streamStats.allocFailures++;
         }
     }
 
     return ret;
 }
 
+/*********************************************************************
+ * @fn      SimpleStreamServer_recordLatency
+ *
+ * @brief   Adds the time a node took from being queued to being fully
+ *          sent to the latency histogram.
+ *
+ * @param   node - the node that was fully sent
+ *
+ * @return  None
+ */
+static void SimpleStreamServer_recordLatency( SimpleStreamNode_t *node )
+{
+    uint32_t latencyMs = ((ICall_getTicks() - node->timestamp) * ICall_getTickPeriod()) / 1000;
+    uint8_t bucket = 0;
+
+    // Bucket n holds [2^n, 2^(n+1)) ms, bucket 0 also holds 0 and 1 ms
+    while ( (latencyMs > 1) && (bucket < (SIMPLESTREAMSERVER_LATENCY_BUCKETS - 1)) )
+    {
+        latencyMs >>= 1;
+        bucket++;
+    }
+
+    streamStats.latencyHist[bucket]++;
+}
+
 /*********************************************************************
  * @fn      SimpleStreamServer_clearQueue
  *
@@ -461,19 +620,58 @@ static bStatus_t SimpleStreamServer_transmitNode( SimpleStreamNode_t* node)
  */
 void SimpleStreamServer_clearQueue()
 {
+    uint8_t i;
+
     // Pop and free the whole queue
     while(!List_empty(&streamOutQueue))
     {
         SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_get(&streamOutQueue);
         ICall_free(node);
     }
+
+    // Nothing is queued anymore, there is no producer to wake up
+    streamOutQueuedBytes = 0;
+    streamOutQueuedNodes = 0;
+    streamThrottled      = FALSE;
+
+    // Forget the reliable mode stream offsets and unacknowledged data
+    for ( i = 0; i < SIMPLESTREAMSERVER_MAX_PEERS; i++ )
+    {
+        SimpleStreamServer_dropSession(&streamSessions[i]);
+    }
+    streamAckPending = FALSE;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_checkLowWatermark
+ *
+ * @brief   Notifies the application if a throttled producer may resume
+ *          because the outgoing queue has drained to the low watermark.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void SimpleStreamServer_checkLowWatermark()
+{
+    if ( streamThrottled && (streamOutQueuedBytes <= queueLowWatermark) )
+    {
+        streamThrottled = FALSE;
+
+        if ( pAppCBs && pAppCBs->pfnQueueLowCb )
+        {
+            pAppCBs->pfnQueueLowCb(streamOutQueuedBytes);
+        }
+    }
 }
 
 /*********************************************************************
  * @fn      SimpleStreamServer_processStream
  *
  * @brief   Sends out as much as possible from the outgoing stream
- *          queue using BLE notifications
+ *          queue using BLE notifications. In reliable mode, data of a
+ *          peer whose send window is closed is skipped, in order, so it
+ *          does not hold back the other peers.
  *
  * @param   connHandle  - connection message was received on
  * @param   *pValue     - pointer to data buffer
@@ -486,32 +684,141 @@ void SimpleStreamServer_clearQueue()
 bStatus_t SimpleStreamServer_processStream()
 {
     bStatus_t ret = SUCCESS;
+    bool windowClosed = FALSE;
+
+    // Apply acknowledgements received since the last call, they may
+    // free memory, open the send window or resume a stream
+    if ( streamAckPending )
+    {
+        SimpleStreamServer_processAcks();
+    }
 
     // Send data starting from the list head
-    SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_get(&streamOutQueue);
+    SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_head(&streamOutQueue);
 
     while ((ret == SUCCESS) && (node != NULL))
     {
+        uint16_t prevOffset = node->offset;
+
         ret = SimpleStreamServer_transmitNode(node);
 
+        // Account for the data that made it into a notification
+        streamOutQueuedBytes -= (node->offset - prevOffset);
+
         // Check that we really did send all data before freeing the node
         if ((node->len - node->offset) == 0)
         {
-            ICall_free(node);
+            SimpleStreamNode_t *next = (SimpleStreamNode_t *) List_next((List_Elem *) node);
+            SimpleStreamSession_t *pSession = NULL;
+
+            List_remove(&streamOutQueue, (List_Elem *) node);
+            SimpleStreamServer_recordLatency(node);
+
+            if ( reliableMode )
+            {
+                pSession = SimpleStreamServer_findSession(node->connHandle);
+            }
+
+            if ( pSession != NULL )
+            {
+                // Keep the data until the peer has acknowledged it
+                List_put(&pSession->unacked, (List_Elem *) node);
+            }
+            else
+            {
+                ICall_free(node);
+            }
+            streamOutQueuedNodes--;
             // Move to next queue entry
-            node = (SimpleStreamNode_t *) List_get(&streamOutQueue);
+            node = next;
         }
-
-        if (ret != SUCCESS)
+        else if (ret == blePending)
         {
-            // We could not send all the data contained in the node, add it back to the queue
-            List_putHead(&streamOutQueue, (List_Elem *) node);
+            // The peer's send window is closed until it acknowledges. Its
+            // later nodes are skipped as well since the window stays closed.
+            windowClosed = TRUE;
+            ret = SUCCESS;
+            node = (SimpleStreamNode_t *) List_next((List_Elem *) node);
         }
     }
 
+    if ((ret == SUCCESS) && windowClosed)
+    {
+        ret = blePending;
+    }
+
+    SimpleStreamServer_checkLowWatermark();
+
     return ret;
 }
 
+/*********************************************************************
+ * @fn      SimpleStreamServer_pump
+ *
+ * @brief   Refills the notification path from the outgoing stream
+ *          queue if there is any data waiting.
+ *
+ * @param   None
+ *
+ * @return  SUCCESS or SimpleStreamServer_processStream return value
+ */
+static bStatus_t SimpleStreamServer_pump()
+{
+    bStatus_t ret = SUCCESS;
+
+    if (!List_empty(&streamOutQueue) || streamAckPending)
+    {
+        ret = SimpleStreamServer_processStream();
+    }
+
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_processCompletedPackets
+ *
+ * @brief   Refills the notification path from the outgoing stream
+ *          queue after the controller reported completed packets,
+ *          i.e. as soon as LL buffers have been freed.
+ *
+ * @param   connHandle - connection the packets were completed on
+ * @param   numPkts    - number of completed packets
+ *
+ * @return  SUCCESS or SimpleStreamServer_processStream return value
+ */
+bStatus_t SimpleStreamServer_processCompletedPackets(uint16_t connHandle, uint16_t numPkts)
+{
+    bStatus_t ret = SUCCESS;
+
+    if (numPkts > 0)
+    {
+        ret = SimpleStreamServer_pump();
+    }
+
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_processConnEvt
+ *
+ * @brief   Refills the notification path from the outgoing stream
+ *          queue at the end of a connection event.
+ *
+ * @param   pReport - connection event report
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or SimpleStreamServer_processStream
+ *          return value
+ */
+bStatus_t SimpleStreamServer_processConnEvt(Gap_ConnEventRpt_t *pReport)
+{
+    if (pReport == NULL)
+    {
+        return INVALIDPARAMETER;
+    }
+
+    return SimpleStreamServer_pump();
+}
+
 /*********************************************************************
  * @fn      SimpleStreamServer_disconnectStream
  *
@@ -524,8 +831,29 @@ bStatus_t SimpleStreamServer_processStream()
  */
 void SimpleStreamServer_disconnectStream()
 {
-    // Clear the outgoing stream queue
-    SimpleStreamServer_clearQueue();
+    if ( reliableMode )
+    {
+        uint8_t i;
+
+        // Suspend the streams of the links that went down, their data is
+        // kept until the peer reconnects and resumes
+        for ( i = 0; i < SIMPLESTREAMSERVER_MAX_PEERS; i++ )
+        {
+            SimpleStreamSession_t *pSession = &streamSessions[i];
+
+            if ( pSession->inUse &&
+                 (pSession->connHandle != CONNHANDLE_INVALID) &&
+                 !linkDB_Up(pSession->connHandle) )
+            {
+                SimpleStreamServer_detachSession(pSession);
+            }
+        }
+    }
+    else
+    {
+        // Clear the outgoing stream queue
+        SimpleStreamServer_clearQueue();
+    }
 }
 
 /*********************************************************************
@@ -568,6 +896,11 @@ void* SimpleStreamServer_allocateWithHeadroom(uint16_t allocSize)
     // Get the current free heap
     ICall_getHeapStats(&stats);
 
+    if ( stats.totalFreeSize < streamStats.minFreeHeap )
+    {
+        streamStats.minFreeHeap = stats.totalFreeSize;
+    }
+
     if (((uint16_t) allocSize) < ((int32_t)(stats.totalFreeSize - heapHeadroom)))
     {
         allocatedBuffer = ICall_malloc(allocSize);
@@ -597,6 +930,27 @@ bStatus_t SimpleStreamServer_sendData(uint16_t connHandle, void *data, uint16_t
 {
     bStatus_t ret = bleMemAllocError;
     SimpleStreamNode_t* newNode;
+    SimpleStreamSession_t *pSession = NULL;
+
+    // Refuse new data while above the high watermark, the producer is
+    // told to resume through pfnQueueLowCb
+    if ( (queueHighWatermark != 0) &&
+         ((streamOutQueuedBytes + len) > queueHighWatermark) )
+    {
+        streamThrottled = TRUE;
+        streamStats.sendsRejected++;
+        return bleNoResources;
+    }
+
+    // In reliable mode the data is appended to the peer's stream
+    if ( reliableMode )
+    {
+        pSession = SimpleStreamServer_getSession(connHandle);
+        if ( pSession == NULL )
+        {
+            return bleNoResources;
+        }
+    }
 
     // Store the data into the queue
     newNode = (SimpleStreamNode_t*) SimpleStreamServer_allocateWithHeadroom(sizeof(SimpleStreamNode_t) + len);
@@ -605,6 +959,8 @@ bStatus_t SimpleStreamServer_sendData(uint16_t connHandle, void *data, uint16_t
         newNode->connHandle = connHandle;
         newNode->offset     = 0;
         newNode->len        = len;
+        newNode->streamOffset = (pSession != NULL) ? pSession->queueOffset : 0;
+        newNode->timestamp  = ICall_getTicks();
         memcpy(newNode->payload, data, len);
 
         // Add the data to the stream queue
@@ -612,6 +968,12 @@ bStatus_t SimpleStreamServer_sendData(uint16_t connHandle, void *data, uint16_t
 
         if (ret == SUCCESS)
         {
+            if ( pSession != NULL )
+            {
+                pSession->queueOffset += len;
+            }
+            streamStats.bytesQueued += len;
+
             ret = SimpleStreamServer_processStream();
         }
         else if (ret == FAILURE)
@@ -619,6 +981,510 @@ bStatus_t SimpleStreamServer_sendData(uint16_t connHandle, void *data, uint16_t
             ICall_free(newNode);
         }
     }
+    else
+    {
+        streamStats.sendsRejected++;
+
+        if (!List_empty(&streamOutQueue))
+        {
+            // Out of heap, let the producer know once the queue has drained
+            streamThrottled = TRUE;
+        }
+    }
 
     return ret;
 }
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_setWatermarks
+ *
+ * @brief   Sets the outgoing queue watermarks. New data is refused while
+ *          the queue would grow above the high watermark and the
+ *          application is notified through pfnQueueLowCb once the queue
+ *          has drained to the low watermark.
+ *
+ * @param   highWatermark - queue size (bytes) at which new data is refused,
+ *                          0 to disable the limit
+ * @param   lowWatermark  - queue size (bytes) at which the producer may resume
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t SimpleStreamServer_setWatermarks(uint32_t highWatermark, uint32_t lowWatermark)
+{
+    if ( (highWatermark != 0) && (lowWatermark > highWatermark) )
+    {
+        return INVALIDPARAMETER;
+    }
+
+    queueHighWatermark = highWatermark;
+    queueLowWatermark  = lowWatermark;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_getQueuedBytes
+ *
+ * @brief   Returns the number of bytes waiting in the outgoing stream queue.
+ *
+ * @param   none
+ *
+ * @return  Number of queued bytes
+ */
+uint32_t SimpleStreamServer_getQueuedBytes(void)
+{
+    return streamOutQueuedBytes;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_getQueuedNodes
+ *
+ * @brief   Returns the number of data nodes waiting in the outgoing
+ *          stream queue.
+ *
+ * @param   none
+ *
+ * @return  Number of queued nodes
+ */
+uint16_t SimpleStreamServer_getQueuedNodes(void)
+{
+    return streamOutQueuedNodes;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_setReliableMode
+ *
+ * @brief   Enables or disables the reliable stream mode. Any queued data
+ *          and stream offsets are discarded.
+ *
+ * @param   enable     - TRUE to enable the reliable mode
+ * @param   sendWindow - unacknowledged bytes allowed in flight, 0 for
+ *                       SIMPLESTREAMSERVER_DEFAULT_SEND_WINDOW
+ *
+ * @return  none
+ */
+void SimpleStreamServer_setReliableMode(bool enable, uint32_t sendWindow)
+{
+    // Start from a clean stream in the new mode
+    SimpleStreamServer_clearQueue();
+
+    reliableMode       = enable;
+    reliableSendWindow = (sendWindow != 0) ? sendWindow : SIMPLESTREAMSERVER_DEFAULT_SEND_WINDOW;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_getAckedOffset
+ *
+ * @brief   Returns the stream offset acknowledged by the peer on the
+ *          given connection.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  Acknowledged stream offset, 0 if there is no stream
+ */
+uint32_t SimpleStreamServer_getAckedOffset(uint16_t connHandle)
+{
+    SimpleStreamSession_t *pSession = SimpleStreamServer_findSession(connHandle);
+
+    return (pSession != NULL) ? pSession->ackOffset : 0;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_findSession
+ *
+ * @brief   Finds the reliable mode stream attached to a connection.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  Pointer to the session, NULL if not found
+ */
+static SimpleStreamSession_t *SimpleStreamServer_findSession( uint16_t connHandle )
+{
+    uint8_t i;
+
+    for ( i = 0; i < SIMPLESTREAMSERVER_MAX_PEERS; i++ )
+    {
+        if ( streamSessions[i].inUse && (streamSessions[i].connHandle == connHandle) )
+        {
+            return &streamSessions[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_getSession
+ *
+ * @brief   Finds the reliable mode stream of the peer on a connection,
+ *          identified by its device address. A suspended stream is
+ *          resumed from the last acknowledged offset. A new stream is
+ *          created if the peer has none, reusing a suspended stream of
+ *          another peer if all are taken.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  Pointer to the session, NULL if none is available
+ */
+static SimpleStreamSession_t *SimpleStreamServer_getSession( uint16_t connHandle )
+{
+    SimpleStreamSession_t *pFound = NULL;
+    SimpleStreamSession_t *pFree  = NULL;
+    SimpleStreamSession_t *pIdle  = NULL;
+    linkDBInfo_t connInfo;
+    uint8_t i;
+
+    if ( linkDB_GetInfo(connHandle, &connInfo) != SUCCESS )
+    {
+        return NULL;
+    }
+
+    for ( i = 0; i < SIMPLESTREAMSERVER_MAX_PEERS; i++ )
+    {
+        SimpleStreamSession_t *pSession = &streamSessions[i];
+
+        if ( !pSession->inUse )
+        {
+            if ( pFree == NULL )
+            {
+                pFree = pSession;
+            }
+        }
+        else if ( (pSession->addrType == connInfo.addrType) &&
+                  !memcmp(pSession->addr, connInfo.addr, B_ADDR_LEN) )
+        {
+            pFound = pSession;
+        }
+        else if ( pSession->connHandle == connHandle )
+        {
+            // The handle now belongs to another peer, the old link is gone
+            SimpleStreamServer_detachSession(pSession);
+        }
+
+        if ( pSession->inUse && (pSession->connHandle == CONNHANDLE_INVALID) &&
+             (pSession != pFound) && (pIdle == NULL) )
+        {
+            pIdle = pSession;
+        }
+    }
+
+    if ( pFound != NULL )
+    {
+        if ( pFound->connHandle != connHandle )
+        {
+            // The peer is back on a new link, resume where it left off
+            if ( pFound->connHandle != CONNHANDLE_INVALID )
+            {
+                SimpleStreamServer_detachSession(pFound);
+            }
+            SimpleStreamServer_attachSession(pFound, connHandle, pFound->ackOffset);
+        }
+
+        return pFound;
+    }
+
+    if ( pFree == NULL )
+    {
+        // Give up the stream of a peer that has not come back
+        pFree = pIdle;
+        if ( pFree != NULL )
+        {
+            SimpleStreamServer_dropSession(pFree);
+        }
+    }
+
+    if ( pFree != NULL )
+    {
+        ICall_CSState key = ICall_enterCriticalSection();
+
+        pFree->addrType    = connInfo.addrType;
+        memcpy(pFree->addr, connInfo.addr, B_ADDR_LEN);
+        pFree->connHandle  = connHandle;
+        pFree->queueOffset = 0;
+        pFree->sendOffset  = 0;
+        pFree->ackOffset   = 0;
+        pFree->highOffset  = 0;
+        pFree->pendingOp   = SSS_OP_NONE;
+        List_clearList(&pFree->unacked);
+        pFree->inUse       = TRUE;
+
+        ICall_leaveCriticalSection(key);
+    }
+
+    return pFree;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_storeAck
+ *
+ * @brief   Stores an ack or resume request received from the peer. It is
+ *          applied from the application task by the next call to
+ *          SimpleStreamServer_processStream.
+ *
+ * @param   connHandle - connection the request was received on
+ * @param   opcode     - SIMPLESTREAMSERVER_OP_ACK or SIMPLESTREAMSERVER_OP_RESUME
+ * @param   offset     - stream offset received from the peer
+ *
+ * @return  none
+ */
+static void SimpleStreamServer_storeAck( uint16_t connHandle, uint8_t opcode, uint32_t offset )
+{
+    linkDBInfo_t connInfo;
+    ICall_CSState key;
+    uint8_t i;
+
+    if ( linkDB_GetInfo(connHandle, &connInfo) != SUCCESS )
+    {
+        return;
+    }
+
+    key = ICall_enterCriticalSection();
+
+    for ( i = 0; i < SIMPLESTREAMSERVER_MAX_PEERS; i++ )
+    {
+        SimpleStreamSession_t *pSession = &streamSessions[i];
+
+        if ( pSession->inUse && (pSession->addrType == connInfo.addrType) &&
+             !memcmp(pSession->addr, connInfo.addr, B_ADDR_LEN) )
+        {
+            // A resume request is not overridden by a later ack
+            if ( (pSession->pendingOp != SIMPLESTREAMSERVER_OP_RESUME) ||
+                 (opcode == SIMPLESTREAMSERVER_OP_RESUME) )
+            {
+                pSession->pendingOp = opcode;
+            }
+            pSession->pendingConnHandle = connHandle;
+            pSession->pendingOffset     = offset;
+            streamAckPending            = TRUE;
+            break;
+        }
+    }
+
+    ICall_leaveCriticalSection(key);
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_processAcks
+ *
+ * @brief   Applies the acks and resume requests stored from stack context.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SimpleStreamServer_processAcks()
+{
+    uint8_t i;
+
+    streamAckPending = FALSE;
+
+    for ( i = 0; i < SIMPLESTREAMSERVER_MAX_PEERS; i++ )
+    {
+        SimpleStreamSession_t *pSession = &streamSessions[i];
+        ICall_CSState key;
+        uint8_t  opcode;
+        uint16_t connHandle;
+        uint32_t offset;
+
+        key = ICall_enterCriticalSection();
+        opcode     = pSession->pendingOp;
+        connHandle = pSession->pendingConnHandle;
+        offset     = pSession->pendingOffset;
+        pSession->pendingOp = SSS_OP_NONE;
+        ICall_leaveCriticalSection(key);
+
+        if ( !pSession->inUse || (opcode == SSS_OP_NONE) )
+        {
+            continue;
+        }
+
+        // Acknowledged data is gone and data never queued cannot be resent
+        if ( offset < pSession->ackOffset )
+        {
+            offset = pSession->ackOffset;
+        }
+        if ( offset > pSession->queueOffset )
+        {
+            offset = pSession->queueOffset;
+        }
+
+        if ( (opcode == SIMPLESTREAMSERVER_OP_ACK) && (pSession->connHandle == connHandle) )
+        {
+            if ( offset > pSession->sendOffset )
+            {
+                offset = pSession->sendOffset;
+            }
+
+            SimpleStreamServer_releaseAcked(pSession, offset);
+        }
+        else
+        {
+            // Resend everything the peer has not received, on the link it
+            // asked from. This also resumes a suspended stream.
+            if ( pSession->connHandle != CONNHANDLE_INVALID )
+            {
+                SimpleStreamServer_detachSession(pSession);
+            }
+            SimpleStreamServer_attachSession(pSession, connHandle, offset);
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_releaseAcked
+ *
+ * @brief   Frees the sent nodes the peer has acknowledged.
+ *
+ * @param   pSession - stream session
+ * @param   offset   - acknowledged stream offset
+ *
+ * @return  none
+ */
+static void SimpleStreamServer_releaseAcked( SimpleStreamSession_t *pSession, uint32_t offset )
+{
+    SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_head(&pSession->unacked);
+
+    while ( (node != NULL) && ((node->streamOffset + node->len) <= offset) )
+    {
+        List_remove(&pSession->unacked, (List_Elem *) node);
+        ICall_free(node);
+
+        node = (SimpleStreamNode_t *) List_head(&pSession->unacked);
+    }
+
+    pSession->ackOffset = offset;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_detachSession
+ *
+ * @brief   Suspends a stream. Its nodes are taken out of the outgoing
+ *          queue and kept, in stream order, until the stream is resumed.
+ *
+ * @param   pSession - stream session
+ *
+ * @return  none
+ */
+static void SimpleStreamServer_detachSession( SimpleStreamSession_t *pSession )
+{
+    List_Elem *curr = List_head(&streamOutQueue);
+
+    while ( curr != NULL )
+    {
+        List_Elem *next = List_next(curr);
+        SimpleStreamNode_t *node = (SimpleStreamNode_t *) curr;
+
+        if ( node->connHandle == pSession->connHandle )
+        {
+            List_remove(&streamOutQueue, curr);
+            streamOutQueuedBytes -= (node->len - node->offset);
+            streamOutQueuedNodes--;
+
+            List_put(&pSession->unacked, curr);
+        }
+
+        curr = next;
+    }
+
+    pSession->connHandle = CONNHANDLE_INVALID;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_attachSession
+ *
+ * @brief   Resumes a suspended stream on a connection. Nodes the peer
+ *          has received are freed and the rest is put back in front of
+ *          the outgoing queue, to be sent again from the given offset.
+ *
+ * @param   pSession   - stream session
+ * @param   connHandle - connection to resume the stream on
+ * @param   offset     - stream offset to resume from
+ *
+ * @return  none
+ */
+static void SimpleStreamServer_attachSession( SimpleStreamSession_t *pSession,
+                                              uint16_t connHandle, uint32_t offset )
+{
+    SimpleStreamServer_releaseAcked(pSession, offset);
+
+    pSession->sendOffset = offset;
+    pSession->connHandle = connHandle;
+
+    // Put the remaining nodes back in the queue, last one first
+    while ( !List_empty(&pSession->unacked) )
+    {
+        SimpleStreamNode_t *node = (SimpleStreamNode_t *) List_tail(&pSession->unacked);
+
+        List_remove(&pSession->unacked, (List_Elem *) node);
+
+        node->connHandle = connHandle;
+        node->offset     = (offset > node->streamOffset) ? (uint16_t)(offset - node->streamOffset) : 0;
+
+        streamOutQueuedBytes += (node->len - node->offset);
+        streamOutQueuedNodes++;
+
+        List_putHead(&streamOutQueue, (List_Elem *) node);
+    }
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_dropSession
+ *
+ * @brief   Frees a stream session and all the data it holds.
+ *
+ * @param   pSession - stream session
+ *
+ * @return  none
+ */
+static void SimpleStreamServer_dropSession( SimpleStreamSession_t *pSession )
+{
+    if ( !pSession->inUse )
+    {
+        return;
+    }
+
+    // Nodes still in the outgoing queue are moved to the session first
+    if ( pSession->connHandle != CONNHANDLE_INVALID )
+    {
+        SimpleStreamServer_detachSession(pSession);
+    }
+
+    while ( !List_empty(&pSession->unacked) )
+    {
+        ICall_free(List_get(&pSession->unacked));
+    }
+
+    pSession->inUse = FALSE;
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_getStats
+ *
+ * @brief   Copies the stream statistics gathered since the last reset.
+ *
+ * @param   pStats - statistics to fill in
+ *
+ * @return  none
+ */
+void SimpleStreamServer_getStats(SimpleStreamServerStats_t *pStats)
+{
+    if ( pStats != NULL )
+    {
+        *pStats = streamStats;
+    }
+}
+
+/*********************************************************************
+ * @fn      SimpleStreamServer_resetStats
+ *
+ * @brief   Clears the stream statistics.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SimpleStreamServer_resetStats(void)
+{
+    memset(&streamStats, 0, sizeof(streamStats));
+    streamStats.minFreeHeap = UINT32_MAX;
+}
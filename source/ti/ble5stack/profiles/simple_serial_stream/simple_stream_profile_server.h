@@ -67,6 +67,28 @@ extern "C"
 #define SIMPLESTREAMSERVER_DATAOUT_UUID 0xC0C2
 #define SIMPLESTREAMSERVER_DATAOUT_LEN  1
 
+// Reliable stream mode
+// Every DataOut notification starts with the 32-bit (little endian) stream
+// offset of its first payload byte. Every DataIn write starts with an opcode.
+#define SIMPLESTREAMSERVER_RELIABLE_HDR_SIZE    4
+#define SIMPLESTREAMSERVER_OP_DATA              0x00  // Application data follows
+#define SIMPLESTREAMSERVER_OP_ACK               0x01  // 32-bit cumulative ack follows
+#define SIMPLESTREAMSERVER_OP_RESUME            0x02  // 32-bit offset to resend from follows
+#define SIMPLESTREAMSERVER_OP_CMD_LEN           5
+
+// Default number of unacknowledged bytes in flight in reliable mode
+#define SIMPLESTREAMSERVER_DEFAULT_SEND_WINDOW  2048
+
+// Number of peers the reliable mode keeps a stream offset for
+#ifndef SIMPLESTREAMSERVER_MAX_PEERS
+#define SIMPLESTREAMSERVER_MAX_PEERS            4
+#endif
+
+// Number of buckets in the queue latency histogram. Bucket 0 counts nodes sent
+// within 2 ms of being queued, bucket n counts [2^n, 2^(n+1)) ms and the last
+// bucket everything slower.
+#define SIMPLESTREAMSERVER_LATENCY_BUCKETS      12
+
 // Profile UUIDs
 extern const uint8_t SimpleStreamServerUUID[ATT_UUID_SIZE];
 extern const uint8_t SimpleStreamServer_DataInUUID[ATT_UUID_SIZE];
@@ -83,9 +105,25 @@ typedef struct
     uint16_t connHandle;
     uint16_t offset;
     uint16_t len;
+    uint32_t streamOffset;  // Stream offset of payload[0], reliable mode only
+    uint32_t timestamp;     // ICall tick the node was queued at
     uint8_t payload[];
 } SimpleStreamNode_t;
 
+// Stream statistics, see SimpleStreamServer_getStats
+typedef struct
+{
+    uint32_t bytesQueued;       // Bytes accepted by SimpleStreamServer_sendData
+    uint32_t bytesSent;         // Payload bytes sent in notifications, resent bytes included
+    uint32_t bytesResent;       // Part of bytesSent that had been sent before a stream was resumed
+    uint32_t packetsSent;       // Notifications sent
+    uint32_t peakQueuedBytes;   // Largest outgoing queue seen
+    uint32_t minFreeHeap;       // Smallest free heap seen when allocating a node
+    uint16_t allocFailures;     // Notifications not sent for lack of stack buffers
+    uint16_t sendsRejected;     // SimpleStreamServer_sendData calls refused
+    uint32_t latencyHist[SIMPLESTREAMSERVER_LATENCY_BUCKETS]; // Time from queued to fully sent
+} SimpleStreamServerStats_t;
+
 /*********************************************************************
  * MACROS
  */
@@ -100,10 +138,18 @@ typedef void (*SimpleStreamServerCCCUpdate_t)(uint16_t value);
 // Callback when new data is received
 typedef void (*SimpleStreamServerIncomingData_t)(uint16_t connHandle, uint8_t paramID, uint16_t len, uint8_t *pValue);
 
+// Callback when the outgoing queue has drained below the low watermark
+typedef void (*SimpleStreamServerQueueLow_t)(uint32_t queuedBytes);
+
+// Callback when the peer acknowledged or asked to resume the stream (reliable mode)
+typedef void (*SimpleStreamServerStreamAck_t)(uint16_t connHandle, uint8_t opcode, uint32_t offset);
+
 typedef struct
 {
     SimpleStreamServerCCCUpdate_t           pfnCccUpdateCb;
     SimpleStreamServerIncomingData_t        pfnIncomingDataCb;  // Called when receiving data
+    SimpleStreamServerQueueLow_t            pfnQueueLowCb;      // Called when the producer may resume
+    SimpleStreamServerStreamAck_t           pfnStreamAckCb;     // Called when receiving an ack
 } SimpleStreamServerCBs_t;
 
 
@@ -160,6 +206,83 @@ extern void     SimpleStreamServer_setHeadroomLimit(uint16_t minHeapHeadroom);
  *                                           enough heap, it will allocate the memory.
  */
 extern void*    SimpleStreamServer_allocateWithHeadroom(uint16_t allocSize);
+
+/*
+ * SimpleStreamServer_setWatermarks - Sets the outgoing queue watermarks (in bytes).
+ *                                    SimpleStreamServer_sendData is rejected with
+ *                                    bleNoResources while the queue would exceed the
+ *                                    high watermark. pfnQueueLowCb is called once the
+ *                                    queue has drained to the low watermark.
+ *                                    A high watermark of 0 disables the limit.
+ *
+ *    highWatermark - queue size at which new data is refused
+ *    lowWatermark  - queue size at which the producer is told to resume
+ */
+extern bStatus_t SimpleStreamServer_setWatermarks(uint32_t highWatermark, uint32_t lowWatermark);
+
+/*
+ * SimpleStreamServer_getQueuedBytes - Returns the number of bytes waiting in the
+ *                                     outgoing stream queue.
+ */
+extern uint32_t  SimpleStreamServer_getQueuedBytes(void);
+
+/*
+ * SimpleStreamServer_getQueuedNodes - Returns the number of data nodes waiting in the
+ *                                     outgoing stream queue.
+ */
+extern uint16_t  SimpleStreamServer_getQueuedNodes(void);
+
+/*
+ * SimpleStreamServer_processCompletedPackets - Refills the notification path from the
+ *                                              outgoing stream queue after the controller
+ *                                              reported completed packets.
+ *
+ *    connHandle - connection the packets were completed on
+ *    numPkts    - number of completed packets
+ */
+extern bStatus_t SimpleStreamServer_processCompletedPackets(uint16_t connHandle, uint16_t numPkts);
+
+/*
+ * SimpleStreamServer_processConnEvt - Refills the notification path from the outgoing
+ *                                     stream queue at the end of a connection event.
+ *                                     Forward reports from Gap_RegisterConnEventCb while
+ *                                     SimpleStreamServer_getQueuedNodes() is non-zero.
+ *
+ *    pReport - connection event report
+ */
+extern bStatus_t SimpleStreamServer_processConnEvt(Gap_ConnEventRpt_t *pReport);
+
+/*
+ * SimpleStreamServer_setReliableMode - Enables or disables the reliable stream mode.
+ *                                      Notifications are kept until the peer acknowledges
+ *                                      them and survive SimpleStreamServer_disconnectStream.
+ *                                      The stream is resumed from the last acknowledged
+ *                                      offset when the peer reconnects. Any queued data
+ *                                      and stream offsets are discarded.
+ *
+ *    enable     - TRUE to enable the reliable mode
+ *    sendWindow - unacknowledged bytes allowed in flight, 0 for the default
+ */
+extern void      SimpleStreamServer_setReliableMode(bool enable, uint32_t sendWindow);
+
+/*
+ * SimpleStreamServer_getAckedOffset - Returns the stream offset acknowledged by the peer
+ *                                     on the given connection (reliable mode).
+ */
+extern uint32_t  SimpleStreamServer_getAckedOffset(uint16_t connHandle);
+
+/*
+ * SimpleStreamServer_getStats - Copies the stream statistics gathered since the last reset.
+ *                               Goodput is (bytesSent - bytesResent) over the sampling time.
+ *
+ *    pStats - statistics to fill in
+ */
+extern void      SimpleStreamServer_getStats(SimpleStreamServerStats_t *pStats);
+
+/*
+ * SimpleStreamServer_resetStats - Clears the stream statistics.
+ */
+extern void      SimpleStreamServer_resetStats(void);
 /*********************************************************************
 *********************************************************************/
 
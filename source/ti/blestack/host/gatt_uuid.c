@@ -64,10 +64,29 @@
  * CONSTANTS
  */
 
+// Number of 128-bit UUID tables that can be registered
+#ifndef GATT_UUID128_MAX_TBLS
+  #define GATT_UUID128_MAX_TBLS     4
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// 16-bit UUID record lookup entry
+typedef struct
+{
+  uint16 uuid;        // 16-bit UUID
+  const uint8 *pRec;  // UUID record
+} gattUUIDRec_t;
+
+// Registered 128-bit UUID table
+typedef struct
+{
+  const uint8 * const *pTbl;  // Table of 128-bit UUID records
+  uint8 numUUIDs;             // Number of records in the table
+} gattUUID128Tbl_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -224,6 +243,43 @@ CONST uint8 reportRefUUID[ATT_BT_UUID_SIZE] =
  * LOCAL VARIABLES
  */
 
+// 16-bit UUID records, sorted by UUID for a binary search
+static CONST gattUUIDRec_t gattUUIDRecTbl[] =
+{
+  /*** GATT Services ***/
+  { GAP_SERVICE_UUID,                gapServiceUUID },
+  { GATT_SERVICE_UUID,               gattServiceUUID },
+
+  /*** GATT Declarations ***/
+  { GATT_PRIMARY_SERVICE_UUID,       primaryServiceUUID },
+  { GATT_SECONDARY_SERVICE_UUID,     secondaryServiceUUID },
+  { GATT_INCLUDE_UUID,               includeUUID },
+  { GATT_CHARACTER_UUID,             characterUUID },
+
+  /*** GATT Descriptors ***/
+  { GATT_CHAR_EXT_PROPS_UUID,        charExtPropsUUID },
+  { GATT_CHAR_USER_DESC_UUID,        charUserDescUUID },
+  { GATT_CLIENT_CHAR_CFG_UUID,       clientCharCfgUUID },
+  { GATT_SERV_CHAR_CFG_UUID,         servCharCfgUUID },
+  { GATT_CHAR_FORMAT_UUID,           charFormatUUID },
+  { GATT_CHAR_AGG_FORMAT_UUID,       charAggFormatUUID },
+  { GATT_VALID_RANGE_UUID,           validRangeUUID },
+  { GATT_EXT_REPORT_REF_UUID,        extReportRefUUID },
+  { GATT_REPORT_REF_UUID,            reportRefUUID },
+
+  /*** GATT Characteristics ***/
+  { DEVICE_NAME_UUID,                deviceNameUUID },
+  { APPEARANCE_UUID,                 appearanceUUID },
+  { PERI_PRIVACY_FLAG_UUID,          periPrivacyFlagUUID },
+  { RECONNECT_ADDR_UUID,             reconnectAddrUUID },
+  { PERI_CONN_PARAM_UUID,            periConnParamUUID },
+  { SERVICE_CHANGED_UUID,            serviceChangedUUID },
+  { CENTRAL_ADDRESS_RESOLUTION_UUID, centAddrResUUID },
+};
+
+// Registered 128-bit UUID tables
+static gattUUID128Tbl_t gattUUID128Tbls[GATT_UUID128_MAX_TBLS];
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -237,6 +293,10 @@ CONST uint8 reportRefUUID[ATT_BT_UUID_SIZE] =
  *
  * @brief   Find the UUID record for a given UUID.
  *
+ *          16-bit UUIDs are looked up with a binary search of a sorted
+ *          table. 128-bit UUIDs are looked up in the tables registered
+ *          with GATT_RegisterUUID128Tbl().
+ *
  * @param   pUUID - UUID to look for.
  * @param   len - length of UUID.
  *
@@ -250,112 +310,128 @@ const uint8 *GATT_FindUUIDRec( const uint8 *pUUID, uint8 len )
   {
     // 16-bit UUID
     uint16 uuid = BUILD_UINT16( pUUID[0], pUUID[1] );
-    switch ( uuid )
-    {
-      /*** GATT Services ***/
-
-      case GAP_SERVICE_UUID:
-        pRec = gapServiceUUID;
-        break;
-
-      case GATT_SERVICE_UUID:
-        pRec = gattServiceUUID;
-        break;
-
-      /*** GATT Declarations ***/
-
-      case GATT_PRIMARY_SERVICE_UUID:
-        pRec = primaryServiceUUID;
-        break;
-
-      case GATT_SECONDARY_SERVICE_UUID:
-        pRec = secondaryServiceUUID;
-        break;
-
-      case GATT_INCLUDE_UUID:
-        pRec = includeUUID;
-        break;
-
-      case GATT_CHARACTER_UUID:
-        pRec = characterUUID;
-        break;
-
-      /*** GATT Descriptors ***/
-
-      case GATT_CHAR_EXT_PROPS_UUID:
-        pRec = charExtPropsUUID;
-        break;
+    uint8 low = 0;
+    uint8 high = sizeof( gattUUIDRecTbl ) / sizeof( gattUUIDRecTbl[0] );
 
-      case GATT_CHAR_USER_DESC_UUID:
-        pRec = charUserDescUUID;
-        break;
-
-      case GATT_CLIENT_CHAR_CFG_UUID:
-        pRec = clientCharCfgUUID;
-        break;
-
-      case GATT_SERV_CHAR_CFG_UUID:
-        pRec = servCharCfgUUID;
-        break;
+    while ( low < high )
+    {
+      uint8 mid = ( low + high ) >> 1;
 
-      case GATT_CHAR_FORMAT_UUID:
-        pRec = charFormatUUID;
+      if ( gattUUIDRecTbl[mid].uuid == uuid )
+      {
+        pRec = gattUUIDRecTbl[mid].pRec;
         break;
+      }
+      else if ( gattUUIDRecTbl[mid].uuid < uuid )
+      {
+        low = mid + 1;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+  }
+  else if ( len == ATT_UUID_SIZE )
+  {
+    // 128-bit UUID
+    uint8 i, j;
 
-      case GATT_CHAR_AGG_FORMAT_UUID:
-        pRec = charAggFormatUUID;
-        break;
+    for ( i = 0; ( i < GATT_UUID128_MAX_TBLS ) && ( pRec == NULL ); i++ )
+    {
+      for ( j = 0; j < gattUUID128Tbls[i].numUUIDs; j++ )
+      {
+        const uint8 *pEntry = gattUUID128Tbls[i].pTbl[j];
+
+        // Vendor UUIDs of one service mostly differ in bytes 12 and 13
+        if ( ( pEntry[12] == pUUID[12] ) && ( pEntry[13] == pUUID[13] ) &&
+             ( osal_memcmp( pEntry, pUUID, ATT_UUID_SIZE ) == TRUE ) )
+        {
+          pRec = pEntry;
+          break;
+        }
+      }
+    }
+  }
 
-      case GATT_VALID_RANGE_UUID:
-        pRec = validRangeUUID;
-        break;
+  return ( pRec );
+}
 
-      case GATT_EXT_REPORT_REF_UUID:
-        pRec = extReportRefUUID;
-        break;
+/*********************************************************************
+ * @fn      GATT_RegisterUUID128Tbl
+ *
+ * @brief   Register a table of 128-bit UUID records so that
+ *          GATT_FindUUIDRec() resolves them to the same constant
+ *          storage. Registering a table again is harmless.
+ *
+ * @param   pTbl - table of pointers to 128-bit UUID records. Must stay
+ *                 valid while registered.
+ * @param   numUUIDs - number of records in the table.
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleNoResources if the maximum
+ *          number of tables is registered.
+ */
+bStatus_t GATT_RegisterUUID128Tbl( const uint8 * const *pTbl, uint8 numUUIDs )
+{
+  gattUUID128Tbl_t *pFree = NULL;
+  uint8 i;
 
-      case GATT_REPORT_REF_UUID:
-        pRec = reportRefUUID;
-        break;
+  if ( ( pTbl == NULL ) || ( numUUIDs == 0 ) )
+  {
+    return ( INVALIDPARAMETER );
+  }
 
-      /*** GATT Characteristics ***/
+  for ( i = 0; i < GATT_UUID128_MAX_TBLS; i++ )
+  {
+    if ( gattUUID128Tbls[i].pTbl == pTbl )
+    {
+      gattUUID128Tbls[i].numUUIDs = numUUIDs;
 
-      case DEVICE_NAME_UUID:
-        pRec = deviceNameUUID;
-        break;
+      return ( SUCCESS );
+    }
 
-      case APPEARANCE_UUID:
-        pRec = appearanceUUID;
-        break;
+    if ( ( gattUUID128Tbls[i].pTbl == NULL ) && ( pFree == NULL ) )
+    {
+      pFree = &(gattUUID128Tbls[i]);
+    }
+  }
 
-      case RECONNECT_ADDR_UUID:
-        pRec = reconnectAddrUUID;
-        break;
+  if ( pFree == NULL )
+  {
+    return ( bleNoResources );
+  }
 
-      case PERI_PRIVACY_FLAG_UUID:
-        pRec = periPrivacyFlagUUID;
-        break;
+  pFree->pTbl = pTbl;
+  pFree->numUUIDs = numUUIDs;
 
-      case PERI_CONN_PARAM_UUID:
-        pRec = periConnParamUUID;
-        break;
+  return ( SUCCESS );
+}
 
-      case SERVICE_CHANGED_UUID:
-        pRec = serviceChangedUUID;
-        break;
+/*********************************************************************
+ * @fn      GATT_DeregisterUUID128Tbl
+ *
+ * @brief   Deregister a table of 128-bit UUID records.
+ *
+ * @param   pTbl - table passed to GATT_RegisterUUID128Tbl().
+ *
+ * @return  SUCCESS or INVALIDPARAMETER if the table is not registered.
+ */
+bStatus_t GATT_DeregisterUUID128Tbl( const uint8 * const *pTbl )
+{
+  uint8 i;
 
-      /*** GATT Units ***/
+  for ( i = 0; i < GATT_UUID128_MAX_TBLS; i++ )
+  {
+    if ( ( pTbl != NULL ) && ( gattUUID128Tbls[i].pTbl == pTbl ) )
+    {
+      gattUUID128Tbls[i].pTbl = NULL;
+      gattUUID128Tbls[i].numUUIDs = 0;
 
-      default:
-        break;
+      return ( SUCCESS );
     }
   }
-  else if ( len == ATT_UUID_SIZE )
-  {
-    // 128-bit UUID
-  }
 
-  return ( pRec );
+  return ( INVALIDPARAMETER );
 }
 
 /****************************************************************************
@@ -48,9 +48,12 @@
 /*******************************************************************************
  * INCLUDES
  */
+#include <string.h>
+
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
 #include "icall_ble_api.h"
+#include "gattservapp_util.h"
 
 /*********************************************************************
  * MACROS
@@ -60,10 +63,37 @@
  * CONSTANTS
  */
 
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+// Number of attribute tables that can be indexed
+#ifndef GATTSERVAPP_ATTR_INDEX_MAX_TBLS
+  #define GATTSERVAPP_ATTR_INDEX_MAX_TBLS     8
+#endif
+
+// Total number of attributes that can be indexed, over all tables
+#ifndef GATTSERVAPP_ATTR_INDEX_POOL_SIZE
+  #define GATTSERVAPP_ATTR_INDEX_POOL_SIZE    128
+#endif
+
+// Smaller attribute tables are searched linearly
+#ifndef GATTSERVAPP_ATTR_INDEX_MIN_ATTRS
+  #define GATTSERVAPP_ATTR_INDEX_MIN_ATTRS    16
+#endif
+#endif // GATTSERVAPP_ATTR_INDEX
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+// Attribute table index, attribute positions sorted by value pointer
+typedef struct
+{
+  gattAttribute_t *pAttrTbl;   // Indexed attribute table
+  uint16 numAttrs;             // Number of attributes in the table
+  uint16 *pIdx;                // Sorted attribute positions, in attrIdxPool
+} gattServAppAttrIdx_t;
+#endif // GATTSERVAPP_ATTR_INDEX
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -80,6 +110,12 @@
  * LOCAL VARIABLES
  */
 
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+static gattServAppAttrIdx_t attrIdxTbl[GATTSERVAPP_ATTR_INDEX_MAX_TBLS];
+static uint16 attrIdxPool[GATTSERVAPP_ATTR_INDEX_POOL_SIZE];
+static uint16 attrIdxPoolUsed = 0;
+#endif // GATTSERVAPP_ATTR_INDEX
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -89,6 +125,14 @@ static gattCharCfg_t *gattServApp_FindCharCfgItem( uint16 connHandle,
 static bStatus_t gattServApp_SendNotiInd( uint16 connHandle, uint8 cccValue,
                                           uint8 authenticated, gattAttribute_t *pAttr,
                                           uint8 taskId, pfnGATTReadAttrCB_t pfnReadAttrCB );
+static bStatus_t gattServApp_SendBuf( uint16 connHandle, uint8 cccValue,
+                                      uint8 authenticated, attHandleValueNoti_t *pNoti,
+                                      uint8 taskId );
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+static gattServAppAttrIdx_t *gattServApp_GetAttrIdx( gattAttribute_t *pAttrTbl,
+                                                     uint16 numAttrs );
+static void gattServApp_ReleaseAttrIdx( gattAttribute_t *pAttrTbl );
+#endif // GATTSERVAPP_ATTR_INDEX
 
 /*********************************************************************
  * API FUNCTIONS
@@ -154,6 +198,7 @@ bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
 {
   uint8 i;
   bStatus_t status = SUCCESS;
+  gattAttribute_t *pAttr;
 
   // Verify input parameters
   if ( ( charCfgTbl == NULL ) || ( pValue == NULL ) ||
@@ -162,6 +207,13 @@ bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
     return ( INVALIDPARAMETER );
   }
 
+  // Find the characteristic value attribute, it is the same for all clients
+  pAttr = GATTServApp_FindAttr( attrTbl, numAttrs, pValue );
+  if ( pAttr == NULL )
+  {
+    return ( status );
+  }
+
   for ( i = 0; i < linkDBNumConns; i++ )
   {
     gattCharCfg_t *pItem = &(charCfgTbl[i]);
@@ -169,23 +221,16 @@ bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
     if ( ( pItem->connHandle != INVALID_CONNHANDLE ) &&
          ( pItem->value != GATT_CFG_NO_OPERATION ) )
     {
-      gattAttribute_t *pAttr;
-
-      // Find the characteristic value attribute
-      pAttr = GATTServApp_FindAttr( attrTbl, numAttrs, pValue );
-      if ( pAttr != NULL )
+      if ( pItem->value & GATT_CLIENT_CFG_NOTIFY )
       {
-        if ( pItem->value & GATT_CLIENT_CFG_NOTIFY )
-        {
-           status |= gattServApp_SendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_NOTIFY,
-                                              authenticated, pAttr, taskId, pfnReadAttrCB );
-        }
+         status |= gattServApp_SendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_NOTIFY,
+                                            authenticated, pAttr, taskId, pfnReadAttrCB );
+      }
 
-        if ( pItem->value & GATT_CLIENT_CFG_INDICATE )
-        {
-           status |= gattServApp_SendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_INDICATE,
-                                              authenticated, pAttr, taskId, pfnReadAttrCB );
-        }
+      if ( pItem->value & GATT_CLIENT_CFG_INDICATE )
+      {
+         status |= gattServApp_SendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_INDICATE,
+                                            authenticated, pAttr, taskId, pfnReadAttrCB );
       }
     }
   } // for
@@ -193,12 +238,57 @@ bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
   return ( status );
 }
 
+/*********************************************************************
+ * @fn          GATTServApp_DeregisterServiceIdx
+ *
+ * @brief       Deregister a service's attribute list and callback
+ *              functions from the GATT Server Application, and drop
+ *              the value pointer index built for its attribute table.
+ *              Use it instead of GATTServApp_DeregisterService() so
+ *              that the index pool is given back and a table later
+ *              registered at the same address is not looked up with a
+ *              stale index.
+ *
+ * @param       handle - handle of service to be deregistered
+ * @param       p2pAttrs - pointer to array of attribute records (to be
+ *                         returned), may be NULL
+ *
+ * @return      SUCCESS: Service deregistered successfully.
+ *              FAILURE: Service not found.
+ */
+bStatus_t GATTServApp_DeregisterServiceIdx( uint16 handle,
+                                            gattAttribute_t **p2pAttrs )
+{
+  gattAttribute_t *pAttrs = NULL;
+  bStatus_t status;
+
+  status = GATTServApp_DeregisterService( handle, &pAttrs );
+
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+  if ( ( status == SUCCESS ) && ( pAttrs != NULL ) )
+  {
+    gattServApp_ReleaseAttrIdx( pAttrs );
+  }
+#endif // GATTSERVAPP_ATTR_INDEX
+
+  if ( p2pAttrs != NULL )
+  {
+    *p2pAttrs = pAttrs;
+  }
+
+  return ( status );
+}
+
 /*********************************************************************
  * @fn          GATTServApp_FindAttr
  *
  * @brief       Find the attribute record within a service attribute
  *              table for a given attribute value pointer.
  *
+ *              When built with GATTSERVAPP_ATTR_INDEX, large tables
+ *              are indexed by value pointer on first use and searched
+ *              with a binary search.
+ *
  * @param       pAttrTbl - pointer to attribute table
  * @param       numAttrs - number of attributes in attribute table
  * @param       pValue - pointer to attribute value
@@ -209,6 +299,42 @@ gattAttribute_t *GATTServApp_FindAttr( gattAttribute_t *pAttrTbl,
                                        uint16 numAttrs, uint8 *pValue )
 {
   uint16  i;
+
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+  if ( numAttrs >= GATTSERVAPP_ATTR_INDEX_MIN_ATTRS )
+  {
+    gattServAppAttrIdx_t *pIdx = gattServApp_GetAttrIdx( pAttrTbl, numAttrs );
+    if ( pIdx != NULL )
+    {
+      uint16 low = 0;
+      uint16 high = numAttrs;
+
+      // Binary search for the first entry not below pValue
+      while ( low < high )
+      {
+        uint16 mid = low + ( ( high - low ) >> 1 );
+
+        if ( (uintptr_t)pAttrTbl[pIdx->pIdx[mid]].pValue < (uintptr_t)pValue )
+        {
+          low = mid + 1;
+        }
+        else
+        {
+          high = mid;
+        }
+      }
+
+      if ( ( low < numAttrs ) && ( pAttrTbl[pIdx->pIdx[low]].pValue == pValue ) )
+      {
+        // Attribute record found
+        return ( &(pAttrTbl[pIdx->pIdx[low]]) );
+      }
+
+      return ( (gattAttribute_t *)NULL );
+    }
+  }
+#endif // GATTSERVAPP_ATTR_INDEX
+
   for ( i = 0; i < numAttrs; i++ )
   {
     if ( pAttrTbl[i].pValue == pValue )
@@ -411,15 +537,7 @@ static bStatus_t gattServApp_SendNotiInd( uint16 connHandle, uint8 cccValue,
     {
       noti.handle = pAttr->handle;
 
-      if ( cccValue & GATT_CLIENT_CFG_NOTIFY )
-      {
-        status = GATT_Notification( connHandle, &noti, authenticated );
-      }
-      else // GATT_CLIENT_CFG_INDICATE
-      {
-        status = GATT_Indication( connHandle, (attHandleValueInd_t *)&noti,
-                                  authenticated, taskId );
-      }
+      status = gattServApp_SendBuf( connHandle, cccValue, authenticated, &noti, taskId );
     }
 
     if ( status != SUCCESS )
@@ -435,6 +553,145 @@ static bStatus_t gattServApp_SendNotiInd( uint16 connHandle, uint8 cccValue,
   return ( status );
 }
 
+/*********************************************************************
+ * @fn      gattServApp_SendBuf
+ *
+ * @brief   Send a filled notification or indication buffer. The buffer
+ *          is owned by the stack on success, and by the caller otherwise.
+ *
+ * @param   connHandle - connection handle.
+ * @param   cccValue - client characteristic configuration value.
+ * @param   authenticated - whether an authenticated link is required.
+ * @param   pNoti - notification to send.
+ * @param   taskId - task to be notified of confirmation.
+ *
+ * @return  Success or Failure
+ */
+static bStatus_t gattServApp_SendBuf( uint16 connHandle, uint8 cccValue,
+                                      uint8 authenticated, attHandleValueNoti_t *pNoti,
+                                      uint8 taskId )
+{
+  if ( cccValue & GATT_CLIENT_CFG_NOTIFY )
+  {
+    return ( GATT_Notification( connHandle, pNoti, authenticated ) );
+  }
+  else // GATT_CLIENT_CFG_INDICATE
+  {
+    return ( GATT_Indication( connHandle, (attHandleValueInd_t *)pNoti,
+                              authenticated, taskId ) );
+  }
+}
+
+
+#if defined ( GATTSERVAPP_ATTR_INDEX )
+/*********************************************************************
+ * @fn      gattServApp_GetAttrIdx
+ *
+ * @brief   Get the value pointer index of an attribute table, building
+ *          it on first use. Attribute positions are sorted by value
+ *          pointer so that the first of several attributes sharing a
+ *          value pointer is still found first.
+ *
+ * @param   pAttrTbl - pointer to attribute table
+ * @param   numAttrs - number of attributes in attribute table
+ *
+ * @return  pointer to the index. NULL, if out of index memory.
+ */
+static gattServAppAttrIdx_t *gattServApp_GetAttrIdx( gattAttribute_t *pAttrTbl,
+                                                     uint16 numAttrs )
+{
+  gattServAppAttrIdx_t *pFree = NULL;
+  uint16 i;
+
+  for ( i = 0; i < GATTSERVAPP_ATTR_INDEX_MAX_TBLS; i++ )
+  {
+    if ( attrIdxTbl[i].pAttrTbl == pAttrTbl )
+    {
+      // Only use the index for the table size it was built for
+      return ( attrIdxTbl[i].numAttrs == numAttrs ) ? &(attrIdxTbl[i]) : NULL;
+    }
+
+    if ( ( attrIdxTbl[i].pAttrTbl == NULL ) && ( pFree == NULL ) )
+    {
+      pFree = &(attrIdxTbl[i]);
+    }
+  }
+
+  if ( ( pFree == NULL ) ||
+       ( numAttrs > ( GATTSERVAPP_ATTR_INDEX_POOL_SIZE - attrIdxPoolUsed ) ) )
+  {
+    // Out of index memory, the table is searched linearly
+    return ( (gattServAppAttrIdx_t *)NULL );
+  }
+
+  pFree->pIdx = &(attrIdxPool[attrIdxPoolUsed]);
+
+  // Insertion sort, stable and done once per table
+  for ( i = 0; i < numAttrs; i++ )
+  {
+    uint16 j = i;
+
+    while ( ( j > 0 ) &&
+            ( (uintptr_t)pAttrTbl[pFree->pIdx[j - 1]].pValue > (uintptr_t)pAttrTbl[i].pValue ) )
+    {
+      pFree->pIdx[j] = pFree->pIdx[j - 1];
+      j--;
+    }
+
+    pFree->pIdx[j] = i;
+  }
+
+  attrIdxPoolUsed += numAttrs;
+  pFree->numAttrs = numAttrs;
+  pFree->pAttrTbl = pAttrTbl;
+
+  return ( pFree );
+}
+
+/*********************************************************************
+ * @fn      gattServApp_ReleaseAttrIdx
+ *
+ * @brief   Drop the value pointer index of an attribute table, if any.
+ *          The indexes built after it are moved down so that the pool
+ *          stays contiguous.
+ *
+ * @param   pAttrTbl - pointer to attribute table
+ *
+ * @return  none
+ */
+static void gattServApp_ReleaseAttrIdx( gattAttribute_t *pAttrTbl )
+{
+  uint16 i;
+
+  for ( i = 0; i < GATTSERVAPP_ATTR_INDEX_MAX_TBLS; i++ )
+  {
+    if ( attrIdxTbl[i].pAttrTbl == pAttrTbl )
+    {
+      uint16 *pIdx = attrIdxTbl[i].pIdx;
+      uint16 numAttrs = attrIdxTbl[i].numAttrs;
+      uint16 j;
+
+      VOID memmove( pIdx, pIdx + numAttrs,
+                    ( &(attrIdxPool[attrIdxPoolUsed]) - ( pIdx + numAttrs ) ) * sizeof( uint16 ) );
+
+      for ( j = 0; j < GATTSERVAPP_ATTR_INDEX_MAX_TBLS; j++ )
+      {
+        if ( ( attrIdxTbl[j].pAttrTbl != NULL ) && ( attrIdxTbl[j].pIdx > pIdx ) )
+        {
+          attrIdxTbl[j].pIdx -= numAttrs;
+        }
+      }
+
+      attrIdxPoolUsed -= numAttrs;
+      attrIdxTbl[i].pAttrTbl = NULL;
+      attrIdxTbl[i].numAttrs = 0;
+      attrIdxTbl[i].pIdx = NULL;
+
+      return;
+    }
+  }
+}
+#endif // GATTSERVAPP_ATTR_INDEX
 
 /****************************************************************************
 ****************************************************************************/
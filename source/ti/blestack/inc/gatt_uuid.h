@@ -164,6 +164,10 @@ extern CONST uint8 manuAddrUUID[];
  */
 extern const uint8 *GATT_FindUUIDRec( const uint8 *pUUID, uint8 len );
 
+extern bStatus_t GATT_RegisterUUID128Tbl( const uint8 * const *pTbl, uint8 numUUIDs );
+
+extern bStatus_t GATT_DeregisterUUID128Tbl( const uint8 * const *pTbl );
+
 /*********************************************************************
 *********************************************************************/
 
@@ -0,0 +1,104 @@
+/******************************************************************************
+
+ @file  gattservapp_util.h
+
+ @brief This file contains the GATT Server Application utility extensions
+        not declared by gattservapp.h
+
+ Group: WCS, BTS
+ Target Device: cc2640r2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2013-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+#ifndef GATTSERVAPP_UTIL_H
+#define GATTSERVAPP_UTIL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "gattservapp.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * VARIABLES
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/**
+ * @brief   Deregister a service and drop the value pointer index that
+ *          GATTServApp_FindAttr() built for its attribute table in
+ *          builds defining GATTSERVAPP_ATTR_INDEX. Use it instead of
+ *          GATTServApp_DeregisterService().
+ *
+ * @param   handle - handle of service to be deregistered.
+ * @param   p2pAttrs - pointer to array of attribute records (to be
+ *                     returned), may be NULL.
+ *
+ * @return  SUCCESS or FAILURE if the service was not found.
+ */
+extern bStatus_t GATTServApp_DeregisterServiceIdx( uint16 handle,
+                                                   gattAttribute_t **p2pAttrs );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GATTSERVAPP_UTIL_H */
@@ -50,6 +50,7 @@
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
 #include "icall_ble_api.h"
+#include "gattservapp_ext.h"
 
 #include "bpservice.h"
 
@@ -63,9 +64,7 @@
 
 // Position of bloodPressure measurement value in attribute array
 #define BLOODPRESSURE_MEAS_VALUE_POS       2
-#define BLOODPRESSURE_MEAS_CONFIG_POS      3
 #define BLOODPRESSURE_IMEAS_VALUE_POS      5
-#define BLOODPRESSURE_IMEAS_CONFIG_POS     6
 
 #define BLOODPRESSURE_MULTI_BOND_BIT       5
 
@@ -247,6 +246,34 @@ static bStatus_t BloodPressure_WriteAttrCB(uint16_t connHandle,
                                            gattAttribute_t *pAttr,
                                            uint8_t *pValue, uint16_t len,
                                            uint16_t offset, uint8_t method);
+static bStatus_t BloodPressure_ReadFeature(uint16_t connHandle,
+                                           gattAttribute_t *pAttr,
+                                           uint8_t *pValue, uint16_t *pLen,
+                                           uint16_t offset, uint16_t maxLen,
+                                           uint8_t method);
+static bStatus_t BloodPressure_WriteMeasConfig(uint16_t connHandle,
+                                               gattAttribute_t *pAttr,
+                                               uint8_t *pValue, uint16_t len,
+                                               uint16_t offset, uint8_t method);
+static bStatus_t BloodPressure_WriteIMeasConfig(uint16_t connHandle,
+                                                gattAttribute_t *pAttr,
+                                                uint8_t *pValue, uint16_t len,
+                                                uint16_t offset, uint8_t method);
+
+/*********************************************************************
+ * Profile Attributes - Handlers
+ */
+
+// Per characteristic handlers, looked up by attribute handle.
+static CONST gattServAppAttrHandler_t bloodPressureAttrHandlers[] =
+{
+  { (uint8 *)&bloodPressureMeasConfig,  NULL,                      BloodPressure_WriteMeasConfig },
+  { (uint8 *)&bloodPressureIMeasConfig, NULL,                      BloodPressure_WriteIMeasConfig },
+  { (uint8 *)&bpFeature,                BloodPressure_ReadFeature, NULL }
+};
+
+static uint8 bloodPressureHandlerIdx[GATT_NUM_ATTRS(bloodPressureAttrTbl)];
+static gattServAppAttrDispatch_t bloodPressureDispatch;
 
 /*********************************************************************
  * PROFILE CALLBACKS
@@ -315,6 +342,18 @@ bStatus_t BloodPressure_AddService(uint32 services)
                                          GATT_NUM_ATTRS(bloodPressureAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &bloodPressureCBs);
+
+    if (status == SUCCESS)
+    {
+      // Map the assigned handles to the characteristic handlers.
+      status = GATTServApp_InitAttrDispatch(&bloodPressureDispatch,
+                                            bloodPressureAttrTbl,
+                                            GATT_NUM_ATTRS(bloodPressureAttrTbl),
+                                            bloodPressureAttrHandlers,
+                                            sizeof(bloodPressureAttrHandlers) /
+                                            sizeof(bloodPressureAttrHandlers[0]),
+                                            bloodPressureHandlerIdx);
+    }
   }
   else
   {
@@ -472,37 +511,15 @@ static uint8 BloodPressure_ReadAttrCB(uint16_t connHandle,
                                       uint16_t *pLen, uint16_t offset,
                                       uint16_t maxLen, uint8_t method)
 {
-  bStatus_t status = SUCCESS;
-
   // Make sure it's not a blob operation (no attributes in the profile are long)
   if (offset > 0)
   {
     return (ATT_ERR_ATTR_NOT_LONG);
   }
 
-  if (pAttr->type.len == ATT_BT_UUID_SIZE)
-  {
-    // 16-bit UUID
-    uint16 uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
-    switch (uuid)
-    {
-      case BLOODPRESSURE_FEATURE_UUID:
-        {
-          *pLen = 2;
-          pValue[0] = LO_UINT16(bpFeature);
-          pValue[1] = HI_UINT16(bpFeature);
-        }
-        break;
-
-      default:
-        // Should never get here!
-        *pLen = 0;
-        status = ATT_ERR_ATTR_NOT_FOUND;
-        break;
-    }
-  }
-
-  return (status);
+  return GATTServApp_DispatchReadAttr(&bloodPressureDispatch, connHandle,
+                                      pAttr, pValue, pLen, offset, maxLen,
+                                      method);
 }
 
 /*********************************************************************
@@ -523,52 +540,107 @@ static bStatus_t BloodPressure_WriteAttrCB(uint16_t connHandle,
                                            uint8_t *pValue, uint16_t len,
                                            uint16_t offset, uint8_t method)
 {
-  bStatus_t status = SUCCESS;
-  uint16 uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
+  return GATTServApp_DispatchWriteAttr(&bloodPressureDispatch, connHandle,
+                                       pAttr, pValue, len, offset, method);
+}
 
-  switch (uuid)
+/*********************************************************************
+ * @fn      BloodPressure_ReadFeature
+ *
+ * @brief   Read the Blood Pressure Feature characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t BloodPressure_ReadFeature(uint16_t connHandle,
+                                           gattAttribute_t *pAttr,
+                                           uint8_t *pValue, uint16_t *pLen,
+                                           uint16_t offset, uint16_t maxLen,
+                                           uint8_t method)
+{
+  *pLen = 2;
+  pValue[0] = LO_UINT16(bpFeature);
+  pValue[1] = HI_UINT16(bpFeature);
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      BloodPressure_WriteMeasConfig
+ *
+ * @brief   Write the Client Characteristic Configuration of the Blood
+ *          Pressure Measurement characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  Success or Failure
+ */
+static bStatus_t BloodPressure_WriteMeasConfig(uint16_t connHandle,
+                                               gattAttribute_t *pAttr,
+                                               uint8_t *pValue, uint16_t len,
+                                               uint16_t offset, uint8_t method)
+{
+  bStatus_t status;
+
+  // BloodPressure Indications.
+  status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                          offset, GATT_CLIENT_CFG_INDICATE);
+  if (status == SUCCESS)
   {
-    case GATT_CLIENT_CHAR_CFG_UUID:
-      if (pAttr->handle ==
-           bloodPressureAttrTbl[BLOODPRESSURE_MEAS_CONFIG_POS].handle)
-      {
-        // BloodPressure Indications.
-        status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
-                                                offset,
-                                                GATT_CLIENT_CFG_INDICATE);
-        if (status == SUCCESS)
-        {
-          uint16 value = BUILD_UINT16(pValue[0], pValue[1]);
-
-          (*bloodPressureServiceCB)((value == GATT_CFG_NO_OPERATION) ?
-                                     BLOODPRESSURE_MEAS_NOTI_DISABLED :
-                                     BLOODPRESSURE_MEAS_NOTI_ENABLED);
-        }
-      }
-      else if (pAttr->handle ==
-                bloodPressureAttrTbl[BLOODPRESSURE_IMEAS_CONFIG_POS].handle)
-      {
-        // BloodPressure Notifications.
-        status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
-                                                offset, GATT_CLIENT_CFG_NOTIFY);
-        if (status == SUCCESS)
-        {
-          uint16 value = BUILD_UINT16(pValue[0], pValue[1]);
-
-          (*bloodPressureServiceCB)((value == GATT_CFG_NO_OPERATION)  ?
-                                     BLOODPRESSURE_IMEAS_NOTI_DISABLED :
-                                     BLOODPRESSURE_IMEAS_NOTI_ENABLED);
-        }
-      }
-      else
-      {
-        status = ATT_ERR_INVALID_HANDLE;
-      }
-      break;
+    uint16 value = BUILD_UINT16(pValue[0], pValue[1]);
 
-    default:
-      status = ATT_ERR_ATTR_NOT_FOUND;
-      break;
+    (*bloodPressureServiceCB)((value == GATT_CFG_NO_OPERATION) ?
+                               BLOODPRESSURE_MEAS_NOTI_DISABLED :
+                               BLOODPRESSURE_MEAS_NOTI_ENABLED);
+  }
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      BloodPressure_WriteIMeasConfig
+ *
+ * @brief   Write the Client Characteristic Configuration of the
+ *          Intermediate Cuff Pressure characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  Success or Failure
+ */
+static bStatus_t BloodPressure_WriteIMeasConfig(uint16_t connHandle,
+                                                gattAttribute_t *pAttr,
+                                                uint8_t *pValue, uint16_t len,
+                                                uint16_t offset, uint8_t method)
+{
+  bStatus_t status;
+
+  // BloodPressure Notifications.
+  status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                          offset, GATT_CLIENT_CFG_NOTIFY);
+  if (status == SUCCESS)
+  {
+    uint16 value = BUILD_UINT16(pValue[0], pValue[1]);
+
+    (*bloodPressureServiceCB)((value == GATT_CFG_NO_OPERATION)  ?
+                               BLOODPRESSURE_IMEAS_NOTI_DISABLED :
+                               BLOODPRESSURE_IMEAS_NOTI_ENABLED);
   }
 
   return (status);
@@ -52,6 +52,7 @@
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
 #include "icall_ble_api.h"
+#include "gattservapp_ext.h"
 
 #include "glucservice.h"
 
@@ -65,11 +66,8 @@
 
 // Position of glucose measurement value in attribute array.
 #define GLUCOSE_MEAS_VALUE_POS         2
-#define GLUCOSE_MEAS_CONFIG_POS        3
 #define GLUCOSE_CONTEXT_VALUE_POS      5
-#define GLUCOSE_CONTEXT_CONFIG_POS     6
 #define GLUCOSE_CTL_PNT_VALUE_POS      10
-#define GLUCOSE_CTL_PNT_CONFIG_POS     11
 
 /*********************************************************************
  * TYPEDEFS
@@ -277,6 +275,36 @@ static bStatus_t glucose_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
 static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
                                      uint8_t *pValue, uint16_t len,
                                      uint16_t offset, uint8_t method);
+static bStatus_t glucose_ReadFeature(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t *pLen,
+                                     uint16_t offset, uint16_t maxLen,
+                                     uint8_t method);
+static bStatus_t glucose_WriteNtfConfig(uint16_t connHandle, gattAttribute_t *pAttr,
+                                        uint8_t *pValue, uint16_t len,
+                                        uint16_t offset, uint8_t method);
+static bStatus_t glucose_WriteCtlPntConfig(uint16_t connHandle, gattAttribute_t *pAttr,
+                                           uint8_t *pValue, uint16_t len,
+                                           uint16_t offset, uint8_t method);
+static bStatus_t glucose_WriteCtlPnt(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t len,
+                                     uint16_t offset, uint8_t method);
+
+/*********************************************************************
+ * Profile Attributes - Handlers
+ */
+
+// Per characteristic handlers, looked up by attribute handle.
+static CONST gattServAppAttrHandler_t glucoseAttrHandlers[] =
+{
+  { (uint8 *)&glucoseFeature,       glucose_ReadFeature, NULL },
+  { (uint8 *)&glucoseMeasConfig,    NULL,                glucose_WriteNtfConfig },
+  { (uint8 *)&glucoseContextConfig, NULL,                glucose_WriteNtfConfig },
+  { (uint8 *)&glucoseControlConfig, NULL,                glucose_WriteCtlPntConfig },
+  { &glucoseControl,                NULL,                glucose_WriteCtlPnt }
+};
+
+static uint8 glucoseHandlerIdx[GATT_NUM_ATTRS(glucoseAttrTbl)];
+static gattServAppAttrDispatch_t glucoseDispatch;
 
 /*********************************************************************
  * PROFILE CALLBACKS
@@ -359,6 +387,17 @@ bStatus_t Glucose_AddService(uint32 services)
                                          GATT_NUM_ATTRS(glucoseAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &glucoseCBs);
+
+    if (status == SUCCESS)
+    {
+      // Map the assigned handles to the characteristic handlers.
+      status = GATTServApp_InitAttrDispatch(&glucoseDispatch, glucoseAttrTbl,
+                                            GATT_NUM_ATTRS(glucoseAttrTbl),
+                                            glucoseAttrHandlers,
+                                            sizeof(glucoseAttrHandlers) /
+                                            sizeof(glucoseAttrHandlers[0]),
+                                            glucoseHandlerIdx);
+    }
   }
   else
   {
@@ -554,8 +593,6 @@ static bStatus_t glucose_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
                                     uint16_t offset, uint16_t maxLen,
                                     uint8_t method)
 {
-  bStatus_t status = SUCCESS;
-
   // Make sure it's not a blob operation
   // (no attributes in the profile are long).
   if (offset > 0)
@@ -563,31 +600,10 @@ static bStatus_t glucose_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
     return (ATT_ERR_ATTR_NOT_LONG);
   }
 
-  if (pAttr->type.len == ATT_BT_UUID_SIZE)
-  {
-    // 16-bit UUID.
-    uint16 uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
-    switch (uuid)
-    {
-      // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
-      // gattserverapp handles those types for reads.
-
-      case GLUCOSE_FEATURE_UUID:
-        *pLen = 2;
-        pValue[0] = LO_UINT16(glucoseFeature);
-        pValue[1] = HI_UINT16(glucoseFeature);
-        break;
-
-      default:
-        // Should never get here!
-        // (characteristics 3 and 4 do not have read permissions).
-        *pLen = 0;
-        status = ATT_ERR_ATTR_NOT_FOUND;
-        break;
-    }
-  }
-
-  return (status);
+  // No need to handle "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID";
+  // gattserverapp handles those types for reads.
+  return GATTServApp_DispatchReadAttr(&glucoseDispatch, connHandle, pAttr,
+                                      pValue, pLen, offset, maxLen, method);
 }
 
 /*********************************************************************
@@ -608,8 +624,6 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
                                      uint8_t *pValue, uint16_t len,
                                      uint16_t offset, uint8_t method)
 {
-  bStatus_t status = SUCCESS;
-
   // Make sure it's not a blob operation
   // (no attributes in the profile are long).
   if (offset > 0)
@@ -617,89 +631,161 @@ static bStatus_t glucose_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr
     return (ATT_ERR_ATTR_NOT_LONG);
   }
 
-  uint16 uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
+  return GATTServApp_DispatchWriteAttr(&glucoseDispatch, connHandle, pAttr,
+                                       pValue, len, offset, method);
+}
+
+/*********************************************************************
+ * @fn      glucose_ReadFeature
+ *
+ * @brief   Read the Glucose Feature characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t glucose_ReadFeature(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t *pLen,
+                                     uint16_t offset, uint16_t maxLen,
+                                     uint8_t method)
+{
+  *pLen = 2;
+  pValue[0] = LO_UINT16(glucoseFeature);
+  pValue[1] = HI_UINT16(glucoseFeature);
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      glucose_WriteNtfConfig
+ *
+ * @brief   Write the Client Characteristic Configuration of the
+ *          Glucose Measurement or Measurement Context characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t glucose_WriteNtfConfig(uint16_t connHandle, gattAttribute_t *pAttr,
+                                        uint8_t *pValue, uint16_t len,
+                                        uint16_t offset, uint8_t method)
+{
+  bStatus_t status;
 
-  switch (uuid)
+  status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                          offset, GATT_CLIENT_CFG_NOTIFY);
+  if (status == SUCCESS)
   {
+    uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
 
-  case  GATT_CLIENT_CHAR_CFG_UUID:
-      // Glucose Notifications.
-      if ((pAttr->handle == glucoseAttrTbl[GLUCOSE_MEAS_CONFIG_POS].handle ||
-           pAttr->handle == glucoseAttrTbl[GLUCOSE_CONTEXT_CONFIG_POS].handle))
-      {
-        status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
-                                                 offset, GATT_CLIENT_CFG_NOTIFY);
-        if (status == SUCCESS)
-        {
-          uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
-
-          if(pAttr->handle == glucoseAttrTbl[GLUCOSE_MEAS_CONFIG_POS].handle)
-          {
-            (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_MEAS_NTF_DISABLED :
-                                                 GLUCOSE_MEAS_NTF_ENABLED, NULL, NULL);
-          }
-          else
-          {
-            (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_CONTEXT_NTF_DISABLED :
-                                                 GLUCOSE_CONTEXT_NTF_ENABLED, NULL, NULL);
-          }
-        }
-      }
-      // Glucose Indications.
-      else if (pAttr->handle == glucoseAttrTbl[GLUCOSE_CTL_PNT_CONFIG_POS].handle)
-      {
-        status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
-                                                 offset, GATT_CLIENT_CFG_INDICATE);
-        if (status == SUCCESS)
-        {
-            uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
-
-            (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_CTL_PNT_IND_DISABLED :
-                                                 GLUCOSE_CTL_PNT_IND_ENABLED, NULL, NULL);
-        }
-      }
-      else
-      {
-        status = ATT_ERR_INVALID_VALUE;
-      }
-    break;
-
-    case  RECORD_CTRL_PT_UUID:
-      if(len >= GLUCOSE_CTL_PNT_MIN_SIZE  && len <= GLUCOSE_CTL_PNT_MAX_SIZE)
-      {
-        uint8 opcode = pValue[0];
-
-        // If transfer in progress
-        if (opcode != CTL_PNT_OP_ABORT && glucoseSendAllRecords)
-        {
-          status = GLUCOSE_ERR_IN_PROGRESS;
-        }
-        // If CCC not configured for glucose measurement
-        else if (opcode == CTL_PNT_OP_REQ &&
-                 !((GATTServApp_ReadCharCfg(connHandle, glucoseControlConfig) &
-                     GATT_CLIENT_CFG_INDICATE)))
-        {
-          status = GLUCOSE_ERR_CCC_CONFIG;
-        }
-        else
-        {
-          (*glucoseServiceCB)(GLUCOSE_CTL_PNT_CMD, pValue, len);
-        }
-      }
-      else
-      {
-        status = ATT_ERR_INVALID_VALUE_SIZE;
-      }
-    break;
+    if (pAttr->pValue == (uint8 *)&glucoseMeasConfig)
+    {
+      (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_MEAS_NTF_DISABLED :
+                                           GLUCOSE_MEAS_NTF_ENABLED, NULL, NULL);
+    }
+    else
+    {
+      (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_CONTEXT_NTF_DISABLED :
+                                           GLUCOSE_CONTEXT_NTF_ENABLED, NULL, NULL);
+    }
+  }
 
-    default:
-      status = ATT_ERR_ATTR_NOT_FOUND;
-      break;
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      glucose_WriteCtlPntConfig
+ *
+ * @brief   Write the Client Characteristic Configuration of the
+ *          Record Access Control Point characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t glucose_WriteCtlPntConfig(uint16_t connHandle, gattAttribute_t *pAttr,
+                                           uint8_t *pValue, uint16_t len,
+                                           uint16_t offset, uint8_t method)
+{
+  bStatus_t status;
+
+  status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                          offset, GATT_CLIENT_CFG_INDICATE);
+  if (status == SUCCESS)
+  {
+    uint16 charCfg = BUILD_UINT16(pValue[0], pValue[1]);
+
+    (*glucoseServiceCB)((charCfg == 0) ? GLUCOSE_CTL_PNT_IND_DISABLED :
+                                         GLUCOSE_CTL_PNT_IND_ENABLED, NULL, NULL);
   }
 
   return (status);
 }
 
+/*********************************************************************
+ * @fn      glucose_WriteCtlPnt
+ *
+ * @brief   Write the Record Access Control Point characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t glucose_WriteCtlPnt(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t len,
+                                     uint16_t offset, uint8_t method)
+{
+  bStatus_t status = SUCCESS;
+
+  if(len >= GLUCOSE_CTL_PNT_MIN_SIZE  && len <= GLUCOSE_CTL_PNT_MAX_SIZE)
+  {
+    uint8 opcode = pValue[0];
+
+    // If transfer in progress
+    if (opcode != CTL_PNT_OP_ABORT && glucoseSendAllRecords)
+    {
+      status = GLUCOSE_ERR_IN_PROGRESS;
+    }
+    // If CCC not configured for glucose measurement
+    else if (opcode == CTL_PNT_OP_REQ &&
+             !((GATTServApp_ReadCharCfg(connHandle, glucoseControlConfig) &
+                 GATT_CLIENT_CFG_INDICATE)))
+    {
+      status = GLUCOSE_ERR_CCC_CONFIG;
+    }
+    else
+    {
+      (*glucoseServiceCB)(GLUCOSE_CTL_PNT_CMD, pValue, len);
+    }
+  }
+  else
+  {
+    status = ATT_ERR_INVALID_VALUE_SIZE;
+  }
+
+  return (status);
+}
 
 /*********************************************************************
 *********************************************************************/
@@ -46,6 +46,8 @@
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
 #include "icall_ble_api.h"
+#include "gattservapp_ext.h"
+#include "gatt_service_def.h"
 
 #ifdef SDI_USE_UART
 #include "inc/sdi_task.h"
@@ -69,9 +71,6 @@
  * CONSTANTS
  */
 
-#define SERVAPP_NUM_ATTR_SUPPORTED        11
-
-gattAttribute_t SerialPortServiceAttrTbl[SERVAPP_NUM_ATTR_SUPPORTED];
 /*********************************************************************
  * TYPEDEFS
  */
@@ -123,6 +122,15 @@ CONST uint8 SerialPortServiceConfigUUID[ATT_UUID_SIZE] =
   TI_BASE_UUID_128(SERIALPORTSERVICE_CONFIG_UUID)
 };
 
+// Serial Port Service UUID records, resolved by GATT_FindUUIDRec
+static const uint8 * const SerialPortServiceUUIDTbl[] =
+{
+  SerialPortServUUID,
+  SerialPortServiceDataUUID,
+  SerialPortServiceStatusUUID,
+  SerialPortServiceConfigUUID
+};
+
 
 /*********************************************************************
  * EXTERNAL VARIABLES
@@ -145,29 +153,17 @@ static SerialPortServiceCBs_t *SerialPortService_AppCBs = NULL;
 // Serial Port Profile Service attribute
 static CONST gattAttrType_t SerialPortService = { ATT_UUID_SIZE, SerialPortServUUID };
 
-// Serial Port Profile Characteristic Data Properties
-static uint8 SerialPortServiceDataProps = GATT_PROP_WRITE_NO_RSP | GATT_PROP_NOTIFY;
-
-// Serial Port Profile Characteristic Configuration Each client has its own
-// instantiation of the Client Characteristic Configuration. Reads of the
-// Client Characteristic Configuration only shows the configuration for
-// that client and writes only affect the configuration of that client.
-static gattCharCfg_t *SerialPortServiceDataConfig;
-
 // Characteristic Data Value
 uint8 SerialPortServiceData[SERIALPORTSERVICE_DATA_LEN] = {0,};
 
 // Serial Port Profile Characteristic Data User Description
-static uint8 SerialPortServiceDataUserDesp[21] = "Data Characteristic \0";
-
-// Serial Port Profile Characteristic Status Properties
-static uint8 SerialPortServiceStatusProps = GATT_PROP_READ;
+static CONST uint8 SerialPortServiceDataUserDesp[21] = "Data Characteristic \0";
 
 // Characteristic Status Value
 static uint8 SerialPortServiceStatus[SERIALPORTSERVICE_STATUS_LEN] = {0,0,0,0,0,0,0};
 
 // Serial Port Profile Characteristic Status User Description
-static uint8 SerialPortServiceStatusUserDesp[23] = "Status Characteristic \0";
+static CONST uint8 SerialPortServiceStatusUserDesp[23] = "Status Characteristic \0";
 
 static uint32 numTxBytes = 0;   //received on serial port, sent to central. since last status readout.
 static uint32 numRxBytes = 0;   //received from central, sent on serial port. since last status readout.
@@ -176,113 +172,56 @@ static uint32 numFramingError = 0;
 static uint32 numParityError = 0;
 static UART_Params SerialPortParams;
 
-// Serial Port Profile Characteristic Config Properties
-static uint8 SerialPortServiceConfigProps = GATT_PROP_READ | GATT_PROP_WRITE;
-
 // Characteristic Config Value
 static uint8 SerialPortServiceConfig[SERIALPORTSERVICE_CONFIG_LEN] = {0x2D,0x00,02};
 
 // Serial Port Profile Characteristic Config User Description
-static uint8 SerialPortServiceConfigUserDesp[23] = "Config Characteristic \0";
+static CONST uint8 SerialPortServiceConfigUserDesp[23] = "Config Characteristic \0";
 
 //Keep track of length
 static uint8 charDataValueLen = SERIALPORTSERVICE_DATA_LEN;
 
 /*********************************************************************
- * Profile Attributes - Table
+ * Profile Attributes - Definition
  */
 
-gattAttribute_t SerialPortServiceAttrTbl[SERVAPP_NUM_ATTR_SUPPORTED] =
-{
-  // Serial Port Profile Service
-  {
-    { ATT_BT_UUID_SIZE, primaryServiceUUID }, /* type */
-    GATT_PERMIT_READ,                         /* permissions */
-    0,                                        /* handle */
-    (uint8 *)&SerialPortService            /* pValue */
-  },
-
-    // Characteristic Data Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &SerialPortServiceDataProps
-    },
-
-      // Characteristic Data Value
-      {
-        { ATT_UUID_SIZE, SerialPortServiceDataUUID },
-        GATT_PERMIT_WRITE,
-        0,
-        SerialPortServiceData
-      },
-
-       // Characteristic Data configuration
-      {
-        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
-        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
-        0,
-        (uint8 *)&SerialPortServiceDataConfig
-      },
-
-      // Characteristic Data User Description
-      {
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ,
-        0,
-        SerialPortServiceDataUserDesp
-      },
-
-    // Characteristic Status Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &SerialPortServiceStatusProps
-    },
-
-      // Characteristic Status Value
-      {
-        { ATT_UUID_SIZE, SerialPortServiceStatusUUID },
-        GATT_PERMIT_READ,
-        0,
-        //&SerialPortServiceChar3
-        SerialPortServiceStatus
-      },
-
-      // Characteristic Status User Description
-      {
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ,
-        0,
-        SerialPortServiceStatusUserDesp
-      },
-
-    // Characteristic Config Declaration
-    {
-      { ATT_BT_UUID_SIZE, characterUUID },
-      GATT_PERMIT_READ,
-      0,
-      &SerialPortServiceConfigProps
-    },
+// Each client has its own instantiation of the Data Client Characteristic
+// Configuration. Reads of the Client Characteristic Configuration only
+// show the configuration for that client and writes only affect the
+// configuration of that client.
+#define SERIALPORTSERVICE_DEF(SERVICE, CHAR, CHAR_CCC, DESC)                    \
+  /* Serial Port Profile Service */                                             \
+  SERVICE( SERIALPORTSERVICE, SerialPortService )                               \
+  /* Characteristic Data */                                                     \
+  CHAR_CCC( SERIALPORTSERVICE_DATA, GATT_PROP_WRITE_NO_RSP | GATT_PROP_NOTIFY,  \
+            ATT_UUID_SIZE, SerialPortServiceDataUUID,                           \
+            GATT_PERMIT_WRITE, SerialPortServiceData,                           \
+            GATT_PERMIT_READ | GATT_PERMIT_WRITE, SerialPortServiceDataConfig ) \
+  DESC( SERIALPORTSERVICE_DATA, SerialPortServiceDataUserDesp )                 \
+  /* Characteristic Status */                                                   \
+  CHAR( SERIALPORTSERVICE_STATUS, GATT_PROP_READ,                               \
+        ATT_UUID_SIZE, SerialPortServiceStatusUUID,                             \
+        GATT_PERMIT_READ, SerialPortServiceStatus )                             \
+  DESC( SERIALPORTSERVICE_STATUS, SerialPortServiceStatusUserDesp )             \
+  /* Characteristic Config */                                                   \
+  CHAR( SERIALPORTSERVICE_CONFIG, GATT_PROP_READ | GATT_PROP_WRITE,             \
+        ATT_UUID_SIZE, SerialPortServiceConfigUUID,                             \
+        GATT_PERMIT_READ | GATT_PERMIT_WRITE, SerialPortServiceConfig )         \
+  DESC( SERIALPORTSERVICE_CONFIG, SerialPortServiceConfigUserDesp )
+
+// Characteristic properties (for declarations) and CCC tables
+GATT_SERVICE_DEF_VARS( SERIALPORTSERVICE_DEF )
+
+// Attribute positions in the table
+GATT_SERVICE_DEF_INDEX( SERIALPORTSERVICE_DEF, SERIALPORTSERVICE_NUM_ATTRS );
 
-      // Characteristic Value Config
-      {
-        { ATT_UUID_SIZE, SerialPortServiceConfigUUID },
-        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
-        0,
-        SerialPortServiceConfig
-      },
-
-      // Characteristic Config User Description
-      {
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ,
-        0,
-        SerialPortServiceConfigUserDesp
-      },
+/*********************************************************************
+ * Profile Attributes - Table
+ */
 
+gattAttribute_t SerialPortServiceAttrTbl[SERIALPORTSERVICE_NUM_ATTRS] =
+{
+  GATT_SERVICE_DEF_TABLE( SERIALPORTSERVICE_DEF )
 };
 
 /*********************************************************************
@@ -294,6 +233,41 @@ static bStatus_t SerialPortService_ReadAttrCB( uint16 connHandle, gattAttribute_
 static bStatus_t SerialPortService_WriteAttrCB( uint16 connHandle, gattAttribute_t *pAttr,
                                             uint8 *pValue, uint16 len, uint16 offset,
                                             uint8 method );
+static bStatus_t SerialPortService_ReadData( uint16 connHandle, gattAttribute_t *pAttr,
+                                             uint8 *pValue, uint16 *pLen, uint16 offset,
+                                             uint16 maxLen, uint8 method );
+static bStatus_t SerialPortService_ReadStatus( uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 *pValue, uint16 *pLen, uint16 offset,
+                                               uint16 maxLen, uint8 method );
+static bStatus_t SerialPortService_ReadConfig( uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 *pValue, uint16 *pLen, uint16 offset,
+                                               uint16 maxLen, uint8 method );
+static bStatus_t SerialPortService_WriteData( uint16 connHandle, gattAttribute_t *pAttr,
+                                              uint8 *pValue, uint16 len, uint16 offset,
+                                              uint8 method );
+static bStatus_t SerialPortService_WriteConfig( uint16 connHandle, gattAttribute_t *pAttr,
+                                                uint8 *pValue, uint16 len, uint16 offset,
+                                                uint8 method );
+static bStatus_t SerialPortService_WriteDataConfig( uint16 connHandle, gattAttribute_t *pAttr,
+                                                    uint8 *pValue, uint16 len, uint16 offset,
+                                                    uint8 method );
+static void SerialPortService_NotifyApp( uint8 paramID );
+
+/*********************************************************************
+ * Profile Attributes - Handlers
+ */
+
+// Per characteristic handlers, looked up by attribute handle.
+static CONST gattServAppAttrHandler_t SerialPortServiceAttrHandlers[] =
+{
+  { SerialPortServiceData,                 SerialPortService_ReadData,   SerialPortService_WriteData },
+  { (uint8 *)&SerialPortServiceDataConfig, NULL,                         SerialPortService_WriteDataConfig },
+  { SerialPortServiceStatus,               SerialPortService_ReadStatus, NULL },
+  { SerialPortServiceConfig,               SerialPortService_ReadConfig, SerialPortService_WriteConfig }
+};
+
+static uint8 SerialPortServiceHandlerIdx[SERIALPORTSERVICE_NUM_ATTRS];
+static gattServAppAttrDispatch_t SerialPortServiceDispatch;
 
 
 /*********************************************************************
@@ -346,11 +320,28 @@ bStatus_t SerialPortService_AddService( uint32 services )
 
   if ( services & SERIALPORTSERVICE_SERVICE )
   {
+    // Let the GATT server resolve the vendor UUIDs to this constant storage
+    VOID GATT_RegisterUUID128Tbl( SerialPortServiceUUIDTbl,
+                                  sizeof( SerialPortServiceUUIDTbl ) /
+                                  sizeof( SerialPortServiceUUIDTbl[0] ) );
+
     // Register GATT attribute list and CBs with GATT Server App
     status = GATTServApp_RegisterService( SerialPortServiceAttrTbl,
                                           GATT_NUM_ATTRS( SerialPortServiceAttrTbl ),
                                           16,
                                           &SerialPortServiceCBs );
+
+    if ( status == SUCCESS )
+    {
+      // Map the assigned handles to the characteristic handlers
+      status = GATTServApp_InitAttrDispatch( &SerialPortServiceDispatch,
+                                             SerialPortServiceAttrTbl,
+                                             GATT_NUM_ATTRS( SerialPortServiceAttrTbl ),
+                                             SerialPortServiceAttrHandlers,
+                                             sizeof( SerialPortServiceAttrHandlers ) /
+                                             sizeof( SerialPortServiceAttrHandlers[0] ),
+                                             SerialPortServiceHandlerIdx );
+    }
   }
   else
   {
@@ -744,8 +735,6 @@ static bStatus_t SerialPortService_ReadAttrCB( uint16 connHandle, gattAttribute_
                                            uint8 *pValue, uint16 *pLen, uint16 offset,
                                            uint16 maxLen, uint8 method )
 {
-  bStatus_t status = SUCCESS;
-
   // If attribute permissions require authorization to read, return error
   if ( gattPermitAuthorRead( pAttr->permissions ) )
   {
@@ -759,72 +748,11 @@ static bStatus_t SerialPortService_ReadAttrCB( uint16 connHandle, gattAttribute_
     return ( ATT_ERR_ATTR_NOT_LONG );
   }
 
-  if ( pAttr->type.len == ATT_UUID_SIZE )
-  {
-    // Get 16-bit UUID from 128-bit UUID
-    uint16 uuid = BUILD_UINT16( pAttr->type.uuid[12], pAttr->type.uuid[13]);
-
-    switch ( uuid )
-    {
-      // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
-      // gattserverapp handles those reads
-
-      // characteristics SERIALPORTSERVICE_STATUS_UUID and SERIALPORTSERVICE_CONFIG_UUID have read permissions
-      // characteristic SERIALPORTSERVICE_DATA_UUID does not have read permissions, but because it
-      //   can be sent as a notification, it is included here
-
-      case SERIALPORTSERVICE_DATA_UUID:
-        *pLen = charDataValueLen;
-        VOID memcpy( pValue, pAttr->pValue, charDataValueLen );
-        break;
-
-      case SERIALPORTSERVICE_STATUS_UUID:
-        *pLen = SERIALPORTSERVICE_STATUS_LEN;
-        VOID memcpy( pValue, pAttr->pValue, SERIALPORTSERVICE_STATUS_LEN );
-
-        //Reset all counters
-        numTxBytes = 0;
-        SerialPortServiceStatus[6] = 0x00;
-        SerialPortServiceStatus[5] = 0x00;
-        numRxBytes = 0;
-        SerialPortServiceStatus[4] = 0x00;
-        SerialPortServiceStatus[3] = 0x00;
-        numRFLinkOverRun = 0;
-        numFramingError = 0;
-        numParityError = 0;
-        break;
-      case SERIALPORTSERVICE_CONFIG_UUID:
-        *pLen = SERIALPORTSERVICE_CONFIG_LEN;
-        VOID memcpy( pValue, pAttr->pValue, SERIALPORTSERVICE_CONFIG_LEN );
-        break;
-
-      default:
-        // Should never get here! (characteristics 3 and 4 do not have read permissions)
-        *pLen = 0;
-        status = ATT_ERR_ATTR_NOT_FOUND;
-        break;
-    }
-  }
-  else if( pAttr->type.len == ATT_BT_UUID_SIZE)
-  {
-    uint16 uuid = BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1]);
-    switch ( uuid )
-    {
-      default:
-        // Should never get here!
-        *pLen = 0;
-        status = ATT_ERR_ATTR_NOT_FOUND;
-        break;
-    }
-  }
-  else
-  {
-    //neither 16-bit UUID nor 128bit UUID
-    *pLen = 0;
-    status = ATT_ERR_INVALID_HANDLE;
-  }
-
-  return ( status );
+  // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
+  // gattserverapp handles those reads
+  return ( GATTServApp_DispatchReadAttr( &SerialPortServiceDispatch, connHandle,
+                                         pAttr, pValue, pLen, offset, maxLen,
+                                         method ) );
 }
 
 /*********************************************************************
@@ -845,9 +773,6 @@ static bStatus_t SerialPortService_WriteAttrCB( uint16 connHandle, gattAttribute
                                             uint8 *pValue, uint16 len, uint16 offset,
                                             uint8 method )
 {
-  bStatus_t status = SUCCESS;
-  uint8 notifyApp = 0xFF;
-
   // If attribute permissions require authorization to write, return error
   if ( gattPermitAuthorWrite( pAttr->permissions ) )
   {
@@ -855,116 +780,227 @@ static bStatus_t SerialPortService_WriteAttrCB( uint16 connHandle, gattAttribute
     return ( ATT_ERR_INSUFFICIENT_AUTHOR );
   }
 
-  if ( pAttr->type.len == ATT_UUID_SIZE )
+  return ( GATTServApp_DispatchWriteAttr( &SerialPortServiceDispatch, connHandle,
+                                          pAttr, pValue, len, offset, method ) );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_ReadData
+ *
+ * @brief   Read the Data characteristic. It does not have read
+ *          permissions, but because it can be sent as a notification,
+ *          it is included here.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t SerialPortService_ReadData( uint16 connHandle, gattAttribute_t *pAttr,
+                                             uint8 *pValue, uint16 *pLen, uint16 offset,
+                                             uint16 maxLen, uint8 method )
+{
+  *pLen = charDataValueLen;
+  VOID memcpy( pValue, pAttr->pValue, charDataValueLen );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_ReadStatus
+ *
+ * @brief   Read the Status characteristic and reset its counters.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t SerialPortService_ReadStatus( uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 *pValue, uint16 *pLen, uint16 offset,
+                                               uint16 maxLen, uint8 method )
+{
+  *pLen = SERIALPORTSERVICE_STATUS_LEN;
+  VOID memcpy( pValue, pAttr->pValue, SERIALPORTSERVICE_STATUS_LEN );
+
+  //Reset all counters
+  numTxBytes = 0;
+  SerialPortServiceStatus[6] = 0x00;
+  SerialPortServiceStatus[5] = 0x00;
+  numRxBytes = 0;
+  SerialPortServiceStatus[4] = 0x00;
+  SerialPortServiceStatus[3] = 0x00;
+  numRFLinkOverRun = 0;
+  numFramingError = 0;
+  numParityError = 0;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_ReadConfig
+ *
+ * @brief   Read the Config characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t SerialPortService_ReadConfig( uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 *pValue, uint16 *pLen, uint16 offset,
+                                               uint16 maxLen, uint8 method )
+{
+  *pLen = SERIALPORTSERVICE_CONFIG_LEN;
+  VOID memcpy( pValue, pAttr->pValue, SERIALPORTSERVICE_CONFIG_LEN );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_WriteData
+ *
+ * @brief   Write the Data characteristic and forward it to the UART.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t SerialPortService_WriteData( uint16 connHandle, gattAttribute_t *pAttr,
+                                              uint8 *pValue, uint16 len, uint16 offset,
+                                              uint8 method )
+{
+  uint8 *pCurValue = (uint8 *)pAttr->pValue;
+
+  if ( offset != 0 )
   {
-    // 16-bit UUID
-    uint16 uuid = BUILD_UINT16( pAttr->type.uuid[12], pAttr->type.uuid[13]);
-    switch ( uuid )
-    {
-      case SERIALPORTSERVICE_DATA_UUID:
-        if ( offset == 0 )
-        {
-          if ( len > SERIALPORTSERVICE_DATA_LEN )
-          {
-            status = ATT_ERR_INVALID_VALUE_SIZE;
-          }
-        }
-        else
-        {
-          status = ATT_ERR_ATTR_NOT_LONG;
-        }
-
-        //Write the value
-        if ( status == SUCCESS )
-        {
-          uint8 *pCurValue = (uint8 *)pAttr->pValue;
-
-          //Copy/Store data to the GATT table entry
-          //memset(pCurValue, 0, SERIALPORTSERVICE_DATA_LEN);
-          memcpy(pCurValue, pValue, len);
+    return ( ATT_ERR_ATTR_NOT_LONG );
+  }
+
+  if ( len > SERIALPORTSERVICE_DATA_LEN )
+  {
+    return ( ATT_ERR_INVALID_VALUE_SIZE );
+  }
+
+  //Copy/Store data to the GATT table entry
+  memcpy(pCurValue, pValue, len);
 
 #ifdef SDI_USE_UART
-          //Send Data to UART
-          SDITask_sendToUART(pCurValue, len);
+  //Send Data to UART
+  SDITask_sendToUART(pCurValue, len);
 #endif
-          //Toggle LED to indicate data received from client
-          SPPBLEServer_toggleLed(Board_RLED, Board_LED_TOGGLE);
-
-          if (len > 0)
-          {
-           SerialPortService_AddStatusRXBytes( len );
-          }
-
-          //uncomment to notify application
-          //notifyApp = SERIALPORTSERVICE_CHAR_DATA;
-        }
-
-        break;
-
-      case SERIALPORTSERVICE_CONFIG_UUID:
-
-        //Validate the value
-        if ( offset == 0 )
-        {
-         if ( len != SERIALPORTSERVICE_CONFIG_LEN )
-         {
-            status = ATT_ERR_INVALID_VALUE_SIZE;
-         }
-        }
-        else
-        {
-         status = ATT_ERR_ATTR_NOT_LONG;
-        }
-
-        //Write the value
-        if ( status == SUCCESS )
-        {
-          uint8 *pCurValue = (uint8 *)pAttr->pValue;
-
-          memset(pCurValue, 0, SERIALPORTSERVICE_CONFIG_LEN);
-          memcpy(pCurValue, pValue, len);
-
-          //Configured in higher application layer
-          notifyApp = SERIALPORTSERVICE_CHAR_CONFIG;
-        }
-
-        break;
-
-      default:
-        // Should never get here! (characteristics 2 and 4 do not have write permissions)
-        status = ATT_ERR_ATTR_NOT_FOUND;
-        break;
-    }
-  }
-  else if (pAttr->type.len == ATT_BT_UUID_SIZE )
-  {
-    // 16-bit UUID
-    uint16 uuid = BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1]);
+  //Toggle LED to indicate data received from client
+  SPPBLEServer_toggleLed(Board_RLED, Board_LED_TOGGLE);
 
-    switch ( uuid )
-    {
-    case GATT_CLIENT_CHAR_CFG_UUID:
-       status = GATTServApp_ProcessCCCWriteReq( connHandle, pAttr, pValue, len,
-                                                 offset, GATT_CLIENT_CFG_NOTIFY );
-       break;
-    default:
-        status = ATT_ERR_ATTR_NOT_FOUND;
-        break;
-    }
+  if (len > 0)
+  {
+   SerialPortService_AddStatusRXBytes( len );
   }
-  else
+
+  //uncomment to notify application
+  //SerialPortService_NotifyApp( SERIALPORTSERVICE_CHAR_DATA );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_WriteConfig
+ *
+ * @brief   Write the Config characteristic and notify the application.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t SerialPortService_WriteConfig( uint16 connHandle, gattAttribute_t *pAttr,
+                                                uint8 *pValue, uint16 len, uint16 offset,
+                                                uint8 method )
+{
+  uint8 *pCurValue = (uint8 *)pAttr->pValue;
+
+  //Validate the value
+  if ( offset != 0 )
   {
-      //neither 16bit UUID nor 128bit UUID
-      status = ATT_ERR_INVALID_HANDLE;
+    return ( ATT_ERR_ATTR_NOT_LONG );
   }
 
-  // If a charactersitic value changed then callback function to notify application of change
-  if ( (notifyApp != 0xFF ) && SerialPortService_AppCBs && SerialPortService_AppCBs->pfnSerialPortServiceChange )
+  if ( len != SERIALPORTSERVICE_CONFIG_LEN )
   {
-    SerialPortService_AppCBs->pfnSerialPortServiceChange( notifyApp );
+    return ( ATT_ERR_INVALID_VALUE_SIZE );
   }
 
-  return ( status );
+  memset(pCurValue, 0, SERIALPORTSERVICE_CONFIG_LEN);
+  memcpy(pCurValue, pValue, len);
+
+  //Configured in higher application layer
+  SerialPortService_NotifyApp( SERIALPORTSERVICE_CHAR_CONFIG );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_WriteDataConfig
+ *
+ * @brief   Write the Client Characteristic Configuration of the Data
+ *          characteristic.
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS or Failure
+ */
+static bStatus_t SerialPortService_WriteDataConfig( uint16 connHandle, gattAttribute_t *pAttr,
+                                                    uint8 *pValue, uint16 len, uint16 offset,
+                                                    uint8 method )
+{
+  return ( GATTServApp_ProcessCCCWriteReq( connHandle, pAttr, pValue, len,
+                                           offset, GATT_CLIENT_CFG_NOTIFY ) );
+}
+
+/*********************************************************************
+ * @fn      SerialPortService_NotifyApp
+ *
+ * @brief   Tell the application that a characteristic value changed.
+ *
+ * @param   paramID - characteristic that changed
+ *
+ * @return  none
+ */
+static void SerialPortService_NotifyApp( uint8 paramID )
+{
+  if ( SerialPortService_AppCBs && SerialPortService_AppCBs->pfnSerialPortServiceChange )
+  {
+    SerialPortService_AppCBs->pfnSerialPortServiceChange( paramID );
+  }
 }
 
 /*********************************************************************
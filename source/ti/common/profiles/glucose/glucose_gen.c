@@ -0,0 +1,124 @@
+/******************************************************************************
+
+ @file       glucose_gen.c
+
+ @brief This file contains a generator of synthetic glucose records, used to
+        fill the record store with a log of a chosen size and shape.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2011-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+/* glucservice.h uses the ATT types */
+#include "icall_ble_api.h"
+#include "glucservice.h"
+
+#include "glucose_gen.h"
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      GlucoseGen_fill
+ *
+ * @brief   Append synthetic records to the record store. Field values
+ *          cycle through the template measurements and contexts, and
+ *          timestamps are pParams->period apart. Every contextEvery-th
+ *          record has a context, and every gapEvery-th record is deleted
+ *          again to leave a gap in the sequence numbers.
+ *
+ * @param   pParams - shape of the records
+ * @param   numRecords - number of records to append
+ *
+ * @return  number of records appended, deleted ones included
+ */
+uint16_t GlucoseGen_fill(const glucoseGenParams_t *pParams,
+                         uint16_t numRecords)
+{
+    glucoseStoreFilter_t gap = { .oper = CTL_PNT_OPER_RANGE,
+                                 .filterType = CTL_PNT_FILTER_SEQNUM };
+    glucoseRecord_t record;
+    uint16_t i;
+
+    for (i = 0; i < numRecords; i++)
+    {
+        record.meas = pParams->pMeas[i % pParams->numTemplates];
+        record.context = pParams->pContext[i % pParams->numTemplates];
+
+        UTC_convertUTCTime(&record.meas.baseTime,
+                           pParams->startTime + (UTCTime)i * pParams->period);
+        record.meas.timeOffset = 0;
+
+        record.meas.flags |= pParams->flagsSet;
+        record.meas.flags &= ~pParams->flagsClear;
+
+        if ((pParams->contextEvery != 0) &&
+            ((i % pParams->contextEvery) == 0))
+        {
+            record.meas.flags |= GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
+        }
+        else
+        {
+            record.meas.flags &= ~GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
+        }
+
+        if (GlucoseStore_append(&record) != SUCCESS)
+        {
+            break;
+        }
+
+        if ((pParams->gapEvery != 0) &&
+            ((i % pParams->gapEvery) == (pParams->gapEvery - 1)))
+        {
+            gap.seqNum1 = record.meas.seqNum;
+            gap.seqNum2 = record.meas.seqNum;
+            GlucoseStore_delete(&gap);
+        }
+    }
+
+    return i;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,101 @@
+/******************************************************************************
+
+ @file       glucose_gen.h
+
+ @brief This file contains the synthetic glucose record generator definitions
+        and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ 
+ Copyright (c) 2011-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+
+
+#ifndef GLUCOSE_GEN_H
+#define GLUCOSE_GEN_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "glucose_store.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Shape of the records appended by GlucoseGen_fill.
+typedef struct
+{
+    const glucoseMeas_t *pMeas;        // Measurements the records cycle through
+    const glucoseContext_t *pContext;  // Context of each measurement
+    uint8_t numTemplates;              // Entries in pMeas and pContext
+    UTCTime startTime;                 // Timestamp of the first record
+    uint32_t period;                   // Seconds between record timestamps
+    uint8_t flagsSet;                  // Measurement flags set in every record
+    uint8_t flagsClear;                // Measurement flags cleared in every record
+    uint16_t contextEvery;             // Every nth record has a context (0 for none)
+    uint16_t gapEvery;                 // Every nth record is deleted again (0 for none)
+} glucoseGenParams_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Append numRecords synthetic records to the record store. The store
+ * assigns sequence numbers, so a gap is left by deleting a record once it
+ * has been appended. Returns the number of records appended, deleted
+ * ones included.
+ */
+extern uint16_t GlucoseGen_fill(const glucoseGenParams_t *pParams,
+                                uint16_t numRecords);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GLUCOSE_GEN_H */
@@ -0,0 +1,1630 @@
+/******************************************************************************
+
+ @file       glucose_store.c
+
+ @brief This file contains a flash backed store for glucose records. Records
+        are appended to a circular log in an NVS region, and a small index
+        of the sectors in use is kept in RAM.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2011-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stddef.h>
+#include <string.h>
+
+#include <ti/drivers/NVS.h>
+
+/* glucservice.h uses the ATT types */
+#include "icall_ble_api.h"
+#include "glucservice.h"
+
+#include "glucose_store.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Byte offset of a slot within the NVS region.
+#define GLUCOSE_STORE_SLOT_OFFSET(sector, slot)                           \
+    (((sector) * glucoseStoreSectorSize) + sizeof(glucoseStoreSectorHdr_t) + \
+     ((slot) * sizeof(glucoseStoreSlot_t)))
+
+// Valid slot bitmap access.
+#define GLUCOSE_STORE_IS_VALID(pSector, slot)                              \
+    (((pSector)->validMap[(slot) / 32] >> ((slot) % 32)) & 1)
+
+#define GLUCOSE_STORE_SET_VALID(pSector, slot)                             \
+    ((pSector)->validMap[(slot) / 32] |= (1UL << ((slot) % 32)))
+
+#define GLUCOSE_STORE_CLR_VALID(pSector, slot)                             \
+    ((pSector)->validMap[(slot) / 32] &= ~(1UL << ((slot) % 32)))
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Sector header magic ("GLU3"). Changes with the sector format, so
+// sectors of an older format are treated as unused.
+#define GLUCOSE_STORE_MAGIC                   0x33554C47
+
+// Value of a header word that hasn't been written since the last erase.
+#define GLUCOSE_STORE_BLANK                   0xFFFFFFFF
+
+// Slot states. Flash bits can only be cleared without an erase, so each
+// state clears more bits of the state word than the one before it.
+#define GLUCOSE_STORE_SLOT_FREE               0xFFFFFFFF
+#define GLUCOSE_STORE_SLOT_VALID              0xFFFF0000
+#define GLUCOSE_STORE_SLOT_DELETED            0x00000000
+
+// Head sector value when nothing has been written yet.
+#define GLUCOSE_STORE_NO_SECTOR               0xFF
+
+// Record IDs start at 1 so that 0 can mean "before the first record".
+#define GLUCOSE_STORE_FIRST_REC_ID            1
+
+// Words in a sector's valid slot bitmap.
+#define GLUCOSE_STORE_MAP_WORDS    ((GLUCOSE_STORE_MAX_SLOTS + 31) / 32)
+
+// Filter keys.
+#define GLUCOSE_STORE_KEY_NONE                0
+#define GLUCOSE_STORE_KEY_SEQNUM              1
+#define GLUCOSE_STORE_KEY_TIME                2
+
+// Result of narrowing a sector to filter bounds.
+#define GLUCOSE_STORE_CLIP_NONE               0
+#define GLUCOSE_STORE_CLIP_PARTIAL            1
+#define GLUCOSE_STORE_CLIP_ALL                2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Header at the start of every sector. The erase count is written right
+// after an erase, and the magic is written last when the sector is started,
+// so a torn header write leaves the sector looking unused. Clearing the
+// retired word drops every record in the sector with a single write.
+typedef struct
+{
+    uint32_t magic;
+    uint32_t eraseCount;  // Number of times this sector has been erased
+    uint32_t sectorSeq;   // Increments each time a sector is started
+    uint32_t firstRecId;  // Record ID of the first slot in the sector
+    uint32_t retired;     // GLUCOSE_STORE_BLANK while the sector is in use
+} glucoseStoreSectorHdr_t;
+
+// A record slot. The state word is programmed after the rest of the slot,
+// so an interrupted append is never mistaken for a valid record.
+typedef struct
+{
+    uint32_t state;
+    UTCTime utcSecs;      // Base time plus time offset
+    uint16_t crc;
+    uint16_t reserved;
+    glucoseStoreWire_t wire;
+} glucoseStoreSlot_t;
+
+// RAM index entry for one sector.
+typedef struct
+{
+    uint32_t sectorSeq;   // 0 if the sector is not in use
+    uint32_t eraseCount;
+    uint32_t firstRecId;
+    uint16_t numUsed;     // Slots consumed: valid, deleted or discarded
+    uint16_t numValid;
+    UTCTime minTime;      // Earliest record time in the sector
+    UTCTime maxTime;      // Latest record time in the sector
+    bool timeOrdered;     // Records were appended in time order
+    bool erased;          // Blank apart from the erase count
+    uint32_t validMap[GLUCOSE_STORE_MAP_WORDS]; // Bit set per valid slot
+} glucoseStoreSector_t;
+
+// Filter resolved to inclusive bounds on one key.
+typedef struct
+{
+    uint8_t key;          // GLUCOSE_STORE_KEY_*
+    bool recIdWindow;     // Sequence numbers map onto loRecId..hiRecId
+    uint16_t loSeqNum;
+    uint16_t hiSeqNum;
+    uint32_t loRecId;
+    uint32_t hiRecId;
+    UTCTime loTime;
+    UTCTime hiTime;
+} glucoseStoreBounds_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static NVS_Handle glucoseStoreHandle = NULL;
+
+static uint32_t glucoseStoreSectorSize;
+static uint8_t glucoseStoreNumSectors;
+static uint16_t glucoseStoreSlotsPerSector;
+
+// Sector currently being appended to.
+static uint8_t glucoseStoreHead = GLUCOSE_STORE_NO_SECTOR;
+
+static uint32_t glucoseStoreNextRecId = GLUCOSE_STORE_FIRST_REC_ID;
+static uint32_t glucoseStoreNextSectorSeq = 1;
+
+static glucoseStoreSector_t glucoseStoreSectors[GLUCOSE_STORE_MAX_SECTORS];
+
+// Scratch slot, kept off the caller's task stack.
+static glucoseStoreSlot_t glucoseStoreSlot;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void GlucoseStore_encode(const glucoseRecord_t *pRec,
+                               glucoseStoreWire_t *pWire);
+static uint16_t GlucoseStore_calcCrc(const glucoseStoreSlot_t *pSlot);
+static bool GlucoseStore_isBlank(const glucoseStoreSlot_t *pSlot);
+static bStatus_t GlucoseStore_setSlotState(uint8_t sector, uint16_t slot,
+                                           uint32_t state);
+static bool GlucoseStore_readSlot(uint8_t sector, uint16_t slot);
+static uint8_t GlucoseStore_popCount(uint32_t word);
+static uint8_t GlucoseStore_countTrailingZeros(uint32_t word);
+static uint16_t GlucoseStore_nextValid(uint8_t sector, uint16_t start,
+                                       uint16_t end);
+static uint16_t GlucoseStore_countValid(uint8_t sector, uint16_t start,
+                                        uint16_t end);
+static void GlucoseStore_indexTime(glucoseStoreSector_t *pSector,
+                                   UTCTime time);
+static void GlucoseStore_scanSector(uint8_t sector);
+static void GlucoseStore_clearSector(glucoseStoreSector_t *pSector);
+static bStatus_t GlucoseStore_eraseSector(uint8_t sector);
+static bStatus_t GlucoseStore_retireSector(uint8_t sector);
+static bStatus_t GlucoseStore_startSector(void);
+static void GlucoseStore_getBounds(const glucoseStoreFilter_t *pFilter,
+                                   glucoseStoreBounds_t *pBounds);
+static bool GlucoseStore_match(const glucoseStoreBounds_t *pBounds);
+static uint16_t GlucoseStore_lowerBound(uint8_t sector, uint16_t lo,
+                                        uint16_t hi, UTCTime time);
+static uint8_t GlucoseStore_clip(const glucoseStoreBounds_t *pBounds,
+                                 uint8_t sector, uint16_t *pStart,
+                                 uint16_t *pEnd);
+static uint16_t GlucoseStore_scan(const glucoseStoreBounds_t *pBounds,
+                                  uint8_t sector, uint16_t start,
+                                  uint16_t end);
+static bool GlucoseStore_next(const glucoseStoreBounds_t *pBounds,
+                              uint32_t *pRecId, uint8_t *pSector);
+static bool GlucoseStore_last(uint32_t *pRecId, uint8_t *pSector);
+static bool GlucoseStore_select(const glucoseStoreFilter_t *pFilter,
+                                uint32_t *pRecId, uint8_t *pSector);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      GlucoseStore_init
+ *
+ * @brief   Open the NVS region and rebuild the sector index from the
+ *          headers and slots found in flash. Appends interrupted by a
+ *          reset are discarded.
+ *
+ * @param   nvsIndex - NVS driver index of the region to use
+ *
+ * @return  SUCCESS, or FAILURE if the region can't be opened or is too
+ *          small to hold a log
+ */
+bStatus_t GlucoseStore_init(uint_least8_t nvsIndex)
+{
+    NVS_Params params;
+    NVS_Attrs attrs;
+    glucoseStoreSectorHdr_t hdr;
+    uint32_t maxSectorSeq = 0;
+    uint8_t i;
+
+    NVS_init();
+    NVS_Params_init(&params);
+
+    glucoseStoreHandle = NVS_open(nvsIndex, &params);
+    if (glucoseStoreHandle == NULL)
+    {
+        return FAILURE;
+    }
+
+    NVS_getAttrs(glucoseStoreHandle, &attrs);
+
+    glucoseStoreSectorSize = attrs.sectorSize;
+    glucoseStoreNumSectors = attrs.regionSize / attrs.sectorSize;
+    if (glucoseStoreNumSectors > GLUCOSE_STORE_MAX_SECTORS)
+    {
+        glucoseStoreNumSectors = GLUCOSE_STORE_MAX_SECTORS;
+    }
+    glucoseStoreSlotsPerSector = (attrs.sectorSize - sizeof(hdr)) /
+                                 sizeof(glucoseStoreSlot_t);
+    if (glucoseStoreSlotsPerSector > GLUCOSE_STORE_MAX_SLOTS)
+    {
+        glucoseStoreSlotsPerSector = GLUCOSE_STORE_MAX_SLOTS;
+    }
+
+    // At least two sectors are needed, so that dropping the oldest sector
+    // never empties the log.
+    if (glucoseStoreNumSectors < 2)
+    {
+        NVS_close(glucoseStoreHandle);
+        glucoseStoreHandle = NULL;
+
+        return FAILURE;
+    }
+
+    // Start from an empty log, in case the region has been wiped since
+    // the last call.
+    glucoseStoreHead = GLUCOSE_STORE_NO_SECTOR;
+    glucoseStoreNextRecId = GLUCOSE_STORE_FIRST_REC_ID;
+    glucoseStoreNextSectorSeq = 1;
+
+    for (i = 0; i < glucoseStoreNumSectors; i++)
+    {
+        glucoseStoreSector_t *pSector = &glucoseStoreSectors[i];
+
+        memset(pSector, 0, sizeof(glucoseStoreSector_t));
+
+        NVS_read(glucoseStoreHandle, i * glucoseStoreSectorSize, &hdr,
+                 sizeof(hdr));
+
+        if (hdr.eraseCount != GLUCOSE_STORE_BLANK)
+        {
+            // Keep the erase count of torn headers too.
+            pSector->eraseCount = hdr.eraseCount;
+        }
+
+        if ((hdr.magic == GLUCOSE_STORE_MAGIC) &&
+            (hdr.retired == GLUCOSE_STORE_BLANK))
+        {
+            pSector->sectorSeq = hdr.sectorSeq;
+            pSector->firstRecId = hdr.firstRecId;
+
+            GlucoseStore_scanSector(i);
+
+            if (hdr.sectorSeq > maxSectorSeq)
+            {
+                maxSectorSeq = hdr.sectorSeq;
+                glucoseStoreHead = i;
+            }
+        }
+        else if ((hdr.magic == GLUCOSE_STORE_BLANK) &&
+                 (hdr.eraseCount != GLUCOSE_STORE_BLANK) &&
+                 (hdr.sectorSeq == GLUCOSE_STORE_BLANK) &&
+                 (hdr.firstRecId == GLUCOSE_STORE_BLANK) &&
+                 (hdr.retired == GLUCOSE_STORE_BLANK))
+        {
+            // The erase count is only written once an erase has completed.
+            pSector->erased = true;
+        }
+    }
+
+    if (glucoseStoreHead != GLUCOSE_STORE_NO_SECTOR)
+    {
+        glucoseStoreSector_t *pHead = &glucoseStoreSectors[glucoseStoreHead];
+
+        glucoseStoreNextSectorSeq = maxSectorSeq + 1;
+        glucoseStoreNextRecId = pHead->firstRecId + pHead->numUsed;
+    }
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_append
+ *
+ * @brief   Append a record to the log. When the log is full the oldest
+ *          sector is erased and its records are dropped. The sequence
+ *          number is assigned by the store.
+ *
+ * @param   pRec - record to append; seqNum is written back
+ *
+ * @return  SUCCESS or FAILURE
+ */
+bStatus_t GlucoseStore_append(glucoseRecord_t *pRec)
+{
+    glucoseStoreSector_t *pHead;
+    uint16_t slot;
+
+    if (glucoseStoreHandle == NULL)
+    {
+        return FAILURE;
+    }
+
+    if ((glucoseStoreHead == GLUCOSE_STORE_NO_SECTOR) ||
+        (glucoseStoreSectors[glucoseStoreHead].numUsed ==
+         glucoseStoreSlotsPerSector))
+    {
+        if (GlucoseStore_startSector() != SUCCESS)
+        {
+            return FAILURE;
+        }
+    }
+
+    pHead = &glucoseStoreSectors[glucoseStoreHead];
+    slot = pHead->numUsed;
+
+    pRec->meas.seqNum = (uint16_t)glucoseStoreNextRecId;
+
+    glucoseStoreSlot.state = GLUCOSE_STORE_SLOT_FREE;
+    glucoseStoreSlot.utcSecs = UTC_convertUTCSecs(&pRec->meas.baseTime) +
+                               pRec->meas.timeOffset;
+    glucoseStoreSlot.reserved = 0xFFFF;
+    GlucoseStore_encode(pRec, &glucoseStoreSlot.wire);
+    glucoseStoreSlot.crc = GlucoseStore_calcCrc(&glucoseStoreSlot);
+
+    // The slot is consumed even if the write fails.
+    pHead->numUsed++;
+    glucoseStoreNextRecId++;
+
+    if (NVS_write(glucoseStoreHandle,
+                  GLUCOSE_STORE_SLOT_OFFSET(glucoseStoreHead, slot) +
+                  sizeof(glucoseStoreSlot.state),
+                  &glucoseStoreSlot.utcSecs,
+                  sizeof(glucoseStoreSlot_t) - sizeof(glucoseStoreSlot.state),
+                  NVS_WRITE_POST_VERIFY) != NVS_STATUS_SUCCESS)
+    {
+        GlucoseStore_setSlotState(glucoseStoreHead, slot,
+                                  GLUCOSE_STORE_SLOT_DELETED);
+
+        return FAILURE;
+    }
+
+    // Commit.
+    if (GlucoseStore_setSlotState(glucoseStoreHead, slot,
+                                  GLUCOSE_STORE_SLOT_VALID) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    pHead->numValid++;
+    GLUCOSE_STORE_SET_VALID(pHead, slot);
+    GlucoseStore_indexTime(pHead, glucoseStoreSlot.utcSecs);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_getNumRecords
+ *
+ * @brief   Get the number of valid records in the store.
+ *
+ * @return  number of valid records
+ */
+uint16_t GlucoseStore_getNumRecords(void)
+{
+    uint16_t count = 0;
+    uint8_t i;
+
+    for (i = 0; i < glucoseStoreNumSectors; i++)
+    {
+        count += glucoseStoreSectors[i].numValid;
+    }
+
+    return count;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_find
+ *
+ * @brief   Find the next record that passes the filter. Only one record
+ *          is read at a time, so a report of any length needs no more
+ *          RAM than the caller's record and record ID.
+ *
+ * @param   pFilter - record filter
+ * @param   pRecId - in: ID of the last record returned, 0 to start.
+ *                   out: ID of the record found.
+ * @param   pWire - encoded record found
+ *
+ * @return  true if a record was found, false otherwise
+ */
+bool GlucoseStore_find(const glucoseStoreFilter_t *pFilter, uint32_t *pRecId,
+                       glucoseStoreWire_t *pWire)
+{
+    uint8_t sector;
+
+    if (GlucoseStore_select(pFilter, pRecId, &sector))
+    {
+        *pWire = glucoseStoreSlot.wire;
+
+        return true;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_count
+ *
+ * @brief   Count the records that pass the filter. Sectors that lie
+ *          entirely within the filter bounds are counted from the index
+ *          without reading flash.
+ *
+ * @param   pFilter - record filter
+ *
+ * @return  number of records
+ */
+uint16_t GlucoseStore_count(const glucoseStoreFilter_t *pFilter)
+{
+    glucoseStoreBounds_t bounds;
+    uint16_t count = 0;
+    uint8_t sector;
+
+    switch (pFilter->oper)
+    {
+    case CTL_PNT_OPER_ALL:
+        return GlucoseStore_getNumRecords();
+
+    case CTL_PNT_OPER_FIRST:
+    case CTL_PNT_OPER_LAST:
+        return (GlucoseStore_getNumRecords() > 0) ? 1 : 0;
+
+    default:
+        break;
+    }
+
+    GlucoseStore_getBounds(pFilter, &bounds);
+
+    for (sector = 0; sector < glucoseStoreNumSectors; sector++)
+    {
+        uint16_t start = 0;
+        uint16_t end = glucoseStoreSectors[sector].numUsed;
+
+        switch (GlucoseStore_clip(&bounds, sector, &start, &end))
+        {
+        case GLUCOSE_STORE_CLIP_ALL:
+            count += glucoseStoreSectors[sector].numValid;
+            break;
+
+        case GLUCOSE_STORE_CLIP_PARTIAL:
+            // A record ID window needs no record reads to count.
+            if ((bounds.key == GLUCOSE_STORE_KEY_SEQNUM) && bounds.recIdWindow)
+            {
+                count += GlucoseStore_countValid(sector, start, end);
+                break;
+            }
+
+            while ((start = GlucoseStore_scan(&bounds, sector, start,
+                                              end)) < end)
+            {
+                count++;
+                start++;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return count;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_delete
+ *
+ * @brief   Delete the records that pass the filter. Sectors other than
+ *          the head that lie entirely within the filter bounds are retired
+ *          with one header write each; other records are marked deleted
+ *          slot by slot. Nothing is erased here, so even deleting a full
+ *          log takes no more than a sector's worth of small writes. The
+ *          space is reclaimed by GlucoseStore_compact.
+ *
+ * @param   pFilter - record filter
+ *
+ * @return  number of records deleted
+ */
+uint16_t GlucoseStore_delete(const glucoseStoreFilter_t *pFilter)
+{
+    glucoseStoreBounds_t bounds;
+    uint32_t recId = 0;
+    uint16_t count = 0;
+    uint8_t sector;
+
+    if ((pFilter->oper != CTL_PNT_OPER_FIRST) &&
+        (pFilter->oper != CTL_PNT_OPER_LAST))
+    {
+        GlucoseStore_getBounds(pFilter, &bounds);
+
+        for (sector = 0; sector < glucoseStoreNumSectors; sector++)
+        {
+            uint16_t numValid = glucoseStoreSectors[sector].numValid;
+            uint16_t start = 0;
+            uint16_t end = glucoseStoreSectors[sector].numUsed;
+
+            if ((sector != glucoseStoreHead) &&
+                (GlucoseStore_clip(&bounds, sector, &start, &end) ==
+                 GLUCOSE_STORE_CLIP_ALL) &&
+                (GlucoseStore_retireSector(sector) == SUCCESS))
+            {
+                count += numValid;
+            }
+        }
+    }
+
+    while (GlucoseStore_select(pFilter, &recId, &sector))
+    {
+        glucoseStoreSector_t *pSector = &glucoseStoreSectors[sector];
+        uint16_t slot = (uint16_t)(recId - pSector->firstRecId);
+
+        if (GlucoseStore_setSlotState(sector, slot,
+                                      GLUCOSE_STORE_SLOT_DELETED) == SUCCESS)
+        {
+            pSector->numValid--;
+            GLUCOSE_STORE_CLR_VALID(pSector, slot);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_compact
+ *
+ * @brief   Erase one sector that holds no valid records, so that the
+ *          erase is done ahead of time rather than when an append needs
+ *          the sector. Sectors are checked in the order they will be
+ *          reused. Meant to be called repeatedly while the application is
+ *          idle, one erase at a time.
+ *
+ * @return  true if a sector was erased and more may be left to erase,
+ *          false if there is nothing left to do
+ */
+bool GlucoseStore_compact(void)
+{
+    uint8_t sector;
+    uint8_t i;
+
+    if (glucoseStoreHandle == NULL)
+    {
+        return false;
+    }
+
+    if (glucoseStoreHead == GLUCOSE_STORE_NO_SECTOR)
+    {
+        sector = 0;
+    }
+    else
+    {
+        sector = (glucoseStoreHead + 1) % glucoseStoreNumSectors;
+    }
+
+    for (i = 0; i < glucoseStoreNumSectors; i++)
+    {
+        glucoseStoreSector_t *pEntry = &glucoseStoreSectors[sector];
+
+        if ((sector != glucoseStoreHead) && !pEntry->erased &&
+            (pEntry->numValid == 0))
+        {
+            return (GlucoseStore_eraseSector(sector) == SUCCESS);
+        }
+
+        sector = (sector + 1) % glucoseStoreNumSectors;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      GlucoseStore_encode
+ *
+ * @brief   Encode a record as glucose measurement and context
+ *          characteristic values. This is done once, on append, so that
+ *          sending a stored record is a copy.
+ *
+ * @param   pRec - record
+ * @param   pWire - encoded record
+ *
+ * @return  none
+ */
+static void GlucoseStore_encode(const glucoseRecord_t *pRec,
+                               glucoseStoreWire_t *pWire)
+{
+    const glucoseMeas_t *pMeas = &pRec->meas;
+    const glucoseContext_t *pContext = &pRec->context;
+    uint8_t *p = pWire->meas;
+
+    memset(pWire, 0, sizeof(glucoseStoreWire_t));
+
+    // Flags 1 byte long.
+    *p++ = pMeas->flags;
+
+    // Sequence number.
+    *p++ = LO_UINT16(pMeas->seqNum);
+    *p++ = HI_UINT16(pMeas->seqNum);
+
+    // Base time; convert day and month from utc time to characteristic format.
+    *p++ = LO_UINT16(pMeas->baseTime.year);
+    *p++ = HI_UINT16(pMeas->baseTime.year);
+    *p++ = (pMeas->baseTime.month + 1);
+    *p++ = (pMeas->baseTime.day + 1);
+    *p++ = pMeas->baseTime.hour;
+    *p++ = pMeas->baseTime.minutes;
+    *p++ = pMeas->baseTime.seconds;
+
+    // Time offset.
+    if (pMeas->flags & GLUCOSE_MEAS_FLAG_TIME_OFFSET)
+    {
+        *p++ = LO_UINT16(pMeas->timeOffset);
+        *p++ = HI_UINT16(pMeas->timeOffset);
+    }
+
+    // Concentration.
+    if (pMeas->flags & GLUCOSE_MEAS_FLAG_CONCENTRATION)
+    {
+        *p++ = LO_UINT16(pMeas->concentration);
+        *p++ = HI_UINT16(pMeas->concentration);
+        *p++ = pMeas->typeSampleLocation;
+    }
+
+    if (pMeas->flags & GLUCOSE_MEAS_FLAG_STATUS_ANNUNCIATION)
+    {
+        *p++ = LO_UINT16(pMeas->sensorStatus);
+        *p++ = HI_UINT16(pMeas->sensorStatus);
+    }
+
+    pWire->measLen = (uint8_t)(p - pWire->meas);
+
+    if (!(pMeas->flags & GLUCOSE_MEAS_FLAG_CONTEXT_INFO))
+    {
+        return;
+    }
+
+    p = pWire->context;
+
+    // Flags 1 byte long.
+    *p++ = pContext->flags;
+
+    // Sequence number, shared with the measurement.
+    *p++ = LO_UINT16(pMeas->seqNum);
+    *p++ = HI_UINT16(pMeas->seqNum);
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_EXTENDED)
+    {
+        *p++ = pContext->extendedFlags;
+    }
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_CARBO)
+    {
+        *p++ = pContext->carboId;
+        *p++ = LO_UINT16(pContext->carboVal);
+        *p++ = HI_UINT16(pContext->carboVal);
+    }
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_MEAL)
+    {
+        *p++ = pContext->mealVal;
+    }
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_TESTER_HEALTH)
+    {
+        *p++ = pContext->TesterHealthVal;
+    }
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_EXERCISE)
+    {
+        *p++ = LO_UINT16(pContext->exerciseDuration);
+        *p++ = HI_UINT16(pContext->exerciseDuration);
+        *p++ = pContext->exerciseIntensity;
+    }
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_MEDICATION)
+    {
+        *p++ = pContext->medId;
+        *p++ = LO_UINT16(pContext->medVal);
+        *p++ = HI_UINT16(pContext->medVal);
+    }
+
+    if (pContext->flags & GLUCOSE_CONTEXT_FLAG_HbA1c)
+    {
+        *p++ = LO_UINT16(pContext->HbA1cVal);
+        *p++ = HI_UINT16(pContext->HbA1cVal);
+    }
+
+    pWire->contextLen = (uint8_t)(p - pWire->context);
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_calcCrc
+ *
+ * @brief   Calculate the CRC-16/CCITT of a slot's time and record.
+ *
+ * @param   pSlot - slot
+ *
+ * @return  CRC
+ */
+static uint16_t GlucoseStore_calcCrc(const glucoseStoreSlot_t *pSlot)
+{
+    const uint8_t *pTime = (const uint8_t *)&pSlot->utcSecs;
+    const uint8_t *pRec = (const uint8_t *)&pSlot->wire;
+    uint16_t crc = 0xFFFF;
+    uint16_t i;
+    uint8_t bit;
+
+    for (i = 0; i < sizeof(UTCTime) + sizeof(glucoseStoreWire_t); i++)
+    {
+        crc ^= (uint16_t)((i < sizeof(UTCTime)) ?
+                          pTime[i] : pRec[i - sizeof(UTCTime)]) << 8;
+
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_isBlank
+ *
+ * @brief   Check whether a slot is still erased.
+ *
+ * @param   pSlot - slot
+ *
+ * @return  true if every byte is 0xFF
+ */
+static bool GlucoseStore_isBlank(const glucoseStoreSlot_t *pSlot)
+{
+    const uint8_t *p = (const uint8_t *)pSlot;
+    uint16_t i;
+
+    for (i = 0; i < sizeof(glucoseStoreSlot_t); i++)
+    {
+        if (p[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_setSlotState
+ *
+ * @brief   Program a slot's state word.
+ *
+ * @param   sector - sector index
+ * @param   slot - slot index
+ * @param   state - GLUCOSE_STORE_SLOT_VALID or GLUCOSE_STORE_SLOT_DELETED
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t GlucoseStore_setSlotState(uint8_t sector, uint16_t slot,
+                                           uint32_t state)
+{
+    if (NVS_write(glucoseStoreHandle, GLUCOSE_STORE_SLOT_OFFSET(sector, slot),
+                  &state, sizeof(state), NVS_WRITE_POST_VERIFY)
+        != NVS_STATUS_SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_readSlot
+ *
+ * @brief   Read a slot into the scratch slot.
+ *
+ * @param   sector - sector index
+ * @param   slot - slot index
+ *
+ * @return  true if the slot holds a valid record
+ */
+static bool GlucoseStore_readSlot(uint8_t sector, uint16_t slot)
+{
+    NVS_read(glucoseStoreHandle, GLUCOSE_STORE_SLOT_OFFSET(sector, slot),
+             &glucoseStoreSlot, sizeof(glucoseStoreSlot_t));
+
+    return ((glucoseStoreSlot.state == GLUCOSE_STORE_SLOT_VALID) &&
+            (glucoseStoreSlot.crc == GlucoseStore_calcCrc(&glucoseStoreSlot)));
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_popCount
+ *
+ * @brief   Count the bits set in a word.
+ *
+ * @param   word - word
+ *
+ * @return  number of bits set
+ */
+static uint8_t GlucoseStore_popCount(uint32_t word)
+{
+    word = word - ((word >> 1) & 0x55555555);
+    word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+    word = (word + (word >> 4)) & 0x0F0F0F0F;
+
+    return (uint8_t)((word * 0x01010101) >> 24);
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_countTrailingZeros
+ *
+ * @brief   Find the lowest bit set in a word.
+ *
+ * @param   word - word, must not be 0
+ *
+ * @return  index of the lowest bit set
+ */
+static uint8_t GlucoseStore_countTrailingZeros(uint32_t word)
+{
+    static const uint8_t deBruijnBits[32] =
+    {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+
+    // Isolate the lowest bit and hash it to its index.
+    word = (uint32_t)((word & (~word + 1)) * 0x077CB531UL);
+
+    return deBruijnBits[word >> 27];
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_nextValid
+ *
+ * @brief   Find the first valid slot of a sector in a slot window, a word
+ *          of the valid slot bitmap at a time.
+ *
+ * @param   sector - sector index
+ * @param   start - first slot of the window
+ * @param   end - slot after the last slot of the window
+ *
+ * @return  slot index, or end if there is no valid slot in the window
+ */
+static uint16_t GlucoseStore_nextValid(uint8_t sector, uint16_t start,
+                                       uint16_t end)
+{
+    const uint32_t *pMap = glucoseStoreSectors[sector].validMap;
+    uint16_t word = start / 32;
+    uint32_t bits;
+
+    if (start >= end)
+    {
+        return end;
+    }
+
+    // Drop the bits below start in the first word.
+    bits = pMap[word] & ~((1UL << (start % 32)) - 1);
+
+    while (bits == 0)
+    {
+        if (++word >= (end + 31) / 32)
+        {
+            return end;
+        }
+
+        bits = pMap[word];
+    }
+
+    start = (word * 32) + GlucoseStore_countTrailingZeros(bits);
+
+    return (start < end) ? start : end;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_countValid
+ *
+ * @brief   Count the valid slots of a sector in a slot window.
+ *
+ * @param   sector - sector index
+ * @param   start - first slot of the window
+ * @param   end - slot after the last slot of the window
+ *
+ * @return  number of valid slots
+ */
+static uint16_t GlucoseStore_countValid(uint8_t sector, uint16_t start,
+                                        uint16_t end)
+{
+    const uint32_t *pMap = glucoseStoreSectors[sector].validMap;
+    uint16_t count = 0;
+    uint16_t word;
+
+    if (start >= end)
+    {
+        return 0;
+    }
+
+    for (word = start / 32; word <= (end - 1) / 32; word++)
+    {
+        uint32_t bits = pMap[word];
+
+        if (word == start / 32)
+        {
+            bits &= ~((1UL << (start % 32)) - 1);
+        }
+
+        if ((word == (end - 1) / 32) && ((end % 32) != 0))
+        {
+            bits &= (1UL << (end % 32)) - 1;
+        }
+
+        count += GlucoseStore_popCount(bits);
+    }
+
+    return count;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_indexTime
+ *
+ * @brief   Add a record time to a sector's index entry. Meters usually
+ *          log in time order, but the user time can be set backwards, so
+ *          ordering is tracked rather than assumed.
+ *
+ * @param   pSector - sector index entry
+ * @param   time - record time
+ *
+ * @return  none
+ */
+static void GlucoseStore_indexTime(glucoseStoreSector_t *pSector,
+                                   UTCTime time)
+{
+    if (time < pSector->maxTime)
+    {
+        pSector->timeOrdered = false;
+    }
+
+    if (time < pSector->minTime)
+    {
+        pSector->minTime = time;
+    }
+
+    if (time > pSector->maxTime)
+    {
+        pSector->maxTime = time;
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_scanSector
+ *
+ * @brief   Count the used and valid slots of a sector. A slot that was
+ *          partly written but never committed is marked deleted.
+ *
+ * @param   sector - sector index
+ *
+ * @return  none
+ */
+static void GlucoseStore_scanSector(uint8_t sector)
+{
+    glucoseStoreSector_t *pSector = &glucoseStoreSectors[sector];
+    uint16_t slot;
+
+    pSector->minTime = 0xFFFFFFFF;
+    pSector->maxTime = 0;
+    pSector->timeOrdered = true;
+    memset(pSector->validMap, 0, sizeof(pSector->validMap));
+
+    for (slot = 0; slot < glucoseStoreSlotsPerSector; slot++)
+    {
+        if (GlucoseStore_readSlot(sector, slot))
+        {
+            pSector->numValid++;
+            GLUCOSE_STORE_SET_VALID(pSector, slot);
+            GlucoseStore_indexTime(pSector, glucoseStoreSlot.utcSecs);
+        }
+        else if (glucoseStoreSlot.state == GLUCOSE_STORE_SLOT_FREE)
+        {
+            if (GlucoseStore_isBlank(&glucoseStoreSlot))
+            {
+                break;
+            }
+
+            GlucoseStore_setSlotState(sector, slot,
+                                      GLUCOSE_STORE_SLOT_DELETED);
+        }
+
+        pSector->numUsed = slot + 1;
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_clearSector
+ *
+ * @brief   Reset a sector's index entry to hold no records.
+ *
+ * @param   pSector - index entry
+ *
+ * @return  none
+ */
+static void GlucoseStore_clearSector(glucoseStoreSector_t *pSector)
+{
+    pSector->sectorSeq = 0;
+    pSector->numUsed = 0;
+    pSector->numValid = 0;
+    pSector->minTime = 0xFFFFFFFF;
+    pSector->maxTime = 0;
+    pSector->timeOrdered = true;
+    memset(pSector->validMap, 0, sizeof(pSector->validMap));
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_eraseSector
+ *
+ * @brief   Erase a sector and write back its erase count.
+ *
+ * @param   sector - sector index
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t GlucoseStore_eraseSector(uint8_t sector)
+{
+    glucoseStoreSector_t *pSector = &glucoseStoreSectors[sector];
+    uint32_t offset = sector * glucoseStoreSectorSize;
+
+    // Whatever the sector held is gone from here on.
+    GlucoseStore_clearSector(pSector);
+    pSector->erased = false;
+    pSector->eraseCount++;
+
+    if ((NVS_erase(glucoseStoreHandle, offset, glucoseStoreSectorSize)
+         != NVS_STATUS_SUCCESS) ||
+        (NVS_write(glucoseStoreHandle,
+                   offset + offsetof(glucoseStoreSectorHdr_t, eraseCount),
+                   &pSector->eraseCount, sizeof(pSector->eraseCount),
+                   NVS_WRITE_POST_VERIFY) != NVS_STATUS_SUCCESS))
+    {
+        return FAILURE;
+    }
+
+    pSector->erased = true;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_retireSector
+ *
+ * @brief   Drop every record in a sector by clearing its retired word.
+ *          The sector is left for GlucoseStore_compact to erase.
+ *
+ * @param   sector - sector index
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t GlucoseStore_retireSector(uint8_t sector)
+{
+    uint32_t retired = 0;
+
+    if (NVS_write(glucoseStoreHandle,
+                  (sector * glucoseStoreSectorSize) +
+                  offsetof(glucoseStoreSectorHdr_t, retired),
+                  &retired, sizeof(retired), NVS_WRITE_POST_VERIFY)
+        != NVS_STATUS_SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    GlucoseStore_clearSector(&glucoseStoreSectors[sector]);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_startSector
+ *
+ * @brief   Make the sector after the head the new head, erasing it first
+ *          unless compaction already has. Sectors are used in turn, so
+ *          the sector after the head is the oldest one and erases are
+ *          spread evenly over the region.
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t GlucoseStore_startSector(void)
+{
+    uint8_t sector;
+    glucoseStoreSector_t *pSector;
+    glucoseStoreSectorHdr_t hdr;
+    uint32_t offset;
+
+    if (glucoseStoreHead == GLUCOSE_STORE_NO_SECTOR)
+    {
+        sector = 0;
+    }
+    else
+    {
+        sector = (glucoseStoreHead + 1) % glucoseStoreNumSectors;
+    }
+
+    pSector = &glucoseStoreSectors[sector];
+    offset = sector * glucoseStoreSectorSize;
+
+    if (!pSector->erased && (GlucoseStore_eraseSector(sector) != SUCCESS))
+    {
+        return FAILURE;
+    }
+
+    pSector->erased = false;
+
+    hdr.magic = GLUCOSE_STORE_MAGIC;
+    hdr.sectorSeq = glucoseStoreNextSectorSeq;
+    hdr.firstRecId = glucoseStoreNextRecId;
+
+    // Write the header body first and the magic last.
+    if ((NVS_write(glucoseStoreHandle,
+                   offset + offsetof(glucoseStoreSectorHdr_t, sectorSeq),
+                   &hdr.sectorSeq, sizeof(hdr.sectorSeq) +
+                   sizeof(hdr.firstRecId), NVS_WRITE_POST_VERIFY)
+         != NVS_STATUS_SUCCESS) ||
+        (NVS_write(glucoseStoreHandle, offset, &hdr.magic,
+                   sizeof(hdr.magic), NVS_WRITE_POST_VERIFY)
+         != NVS_STATUS_SUCCESS))
+    {
+        return FAILURE;
+    }
+
+    pSector->sectorSeq = hdr.sectorSeq;
+    pSector->firstRecId = hdr.firstRecId;
+
+    glucoseStoreHead = sector;
+    glucoseStoreNextSectorSeq++;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_getBounds
+ *
+ * @brief   Resolve a filter into lower and upper bounds. Sequence numbers
+ *          are the low 16 bits of record IDs, so while the stored IDs
+ *          stay within one 64k block a sequence number filter is also a
+ *          record ID window that can be located without reading flash.
+ *
+ * @param   pFilter - record filter
+ * @param   pBounds - bounds
+ *
+ * @return  none
+ */
+static void GlucoseStore_getBounds(const glucoseStoreFilter_t *pFilter,
+                                   glucoseStoreBounds_t *pBounds)
+{
+    pBounds->key = GLUCOSE_STORE_KEY_NONE;
+    pBounds->recIdWindow = false;
+    pBounds->loSeqNum = 0;
+    pBounds->hiSeqNum = 0xFFFF;
+    pBounds->loTime = 0;
+    pBounds->hiTime = 0xFFFFFFFF;
+
+    switch (pFilter->oper)
+    {
+    case CTL_PNT_OPER_LESS_EQUAL:
+        pBounds->hiSeqNum = pFilter->seqNum1;
+        pBounds->hiTime = pFilter->time1;
+        break;
+
+    case CTL_PNT_OPER_GREATER_EQUAL:
+        pBounds->loSeqNum = pFilter->seqNum1;
+        pBounds->loTime = pFilter->time1;
+        break;
+
+    case CTL_PNT_OPER_RANGE:
+        pBounds->loSeqNum = pFilter->seqNum1;
+        pBounds->hiSeqNum = pFilter->seqNum2;
+        pBounds->loTime = pFilter->time1;
+        pBounds->hiTime = pFilter->time2;
+        break;
+
+    default:
+        return;
+    }
+
+    if (pFilter->filterType == CTL_PNT_FILTER_SEQNUM)
+    {
+        uint32_t firstRecId = glucoseStoreNextRecId;
+        uint32_t lastRecId = glucoseStoreNextRecId - 1;
+        uint8_t i;
+
+        pBounds->key = GLUCOSE_STORE_KEY_SEQNUM;
+
+        for (i = 0; i < glucoseStoreNumSectors; i++)
+        {
+            if ((glucoseStoreSectors[i].sectorSeq != 0) &&
+                (glucoseStoreSectors[i].firstRecId < firstRecId))
+            {
+                firstRecId = glucoseStoreSectors[i].firstRecId;
+            }
+        }
+
+        if ((firstRecId & 0xFFFF0000) == (lastRecId & 0xFFFF0000))
+        {
+            pBounds->recIdWindow = true;
+            pBounds->loRecId = (lastRecId & 0xFFFF0000) | pBounds->loSeqNum;
+            pBounds->hiRecId = (lastRecId & 0xFFFF0000) | pBounds->hiSeqNum;
+        }
+    }
+    else
+    {
+        pBounds->key = GLUCOSE_STORE_KEY_TIME;
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_match
+ *
+ * @brief   Check the record in the scratch slot against filter bounds.
+ *
+ * @param   pBounds - filter bounds
+ *
+ * @return  true if the record is within the bounds
+ */
+static bool GlucoseStore_match(const glucoseStoreBounds_t *pBounds)
+{
+    uint16_t seqNum = BUILD_UINT16(glucoseStoreSlot.wire.meas[1],
+                                   glucoseStoreSlot.wire.meas[2]);
+    UTCTime recordTime = glucoseStoreSlot.utcSecs;
+
+    switch (pBounds->key)
+    {
+    case GLUCOSE_STORE_KEY_SEQNUM:
+        return ((seqNum >= pBounds->loSeqNum) &&
+                (seqNum <= pBounds->hiSeqNum));
+
+    case GLUCOSE_STORE_KEY_TIME:
+        return ((recordTime >= pBounds->loTime) &&
+                (recordTime <= pBounds->hiTime));
+
+    default:
+        return true;
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_lowerBound
+ *
+ * @brief   Binary search a time ordered sector for the first slot that
+ *          is not earlier than a time. Slots without a valid record are
+ *          skipped over when probed.
+ *
+ * @param   sector - sector index
+ * @param   lo - first slot to search
+ * @param   hi - slot after the last slot to search
+ * @param   time - time to search for
+ *
+ * @return  slot index; all valid records before it are earlier than time
+ */
+static uint16_t GlucoseStore_lowerBound(uint8_t sector, uint16_t lo,
+                                        uint16_t hi, UTCTime time)
+{
+    while (lo < hi)
+    {
+        uint16_t mid = lo + ((hi - lo) / 2);
+        uint16_t probe = GlucoseStore_nextValid(sector, mid, hi);
+
+        if ((probe < hi) && GlucoseStore_readSlot(sector, probe) &&
+            (glucoseStoreSlot.utcSecs < time))
+        {
+            lo = probe + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_clip
+ *
+ * @brief   Narrow a slot window of a sector to the filter bounds, using
+ *          only the RAM index and, for time ordered sectors, a binary
+ *          search on entry to the sector.
+ *
+ * @param   pBounds - filter bounds
+ * @param   sector - sector index
+ * @param   pStart - in/out: first slot of the window
+ * @param   pEnd - in/out: slot after the last slot of the window
+ *
+ * @return  GLUCOSE_STORE_CLIP_NONE if no record in the window can pass,
+ *          GLUCOSE_STORE_CLIP_ALL if every valid record in the sector
+ *          passes, GLUCOSE_STORE_CLIP_PARTIAL otherwise
+ */
+static uint8_t GlucoseStore_clip(const glucoseStoreBounds_t *pBounds,
+                                 uint8_t sector, uint16_t *pStart,
+                                 uint16_t *pEnd)
+{
+    glucoseStoreSector_t *pEntry = &glucoseStoreSectors[sector];
+    uint32_t firstRecId = pEntry->firstRecId;
+    uint32_t lastRecId = firstRecId + pEntry->numUsed - 1;
+
+    if ((pEntry->numValid == 0) || (*pStart >= *pEnd))
+    {
+        return GLUCOSE_STORE_CLIP_NONE;
+    }
+
+    switch (pBounds->key)
+    {
+    case GLUCOSE_STORE_KEY_SEQNUM:
+        if (!pBounds->recIdWindow)
+        {
+            return GLUCOSE_STORE_CLIP_PARTIAL;
+        }
+
+        if ((pBounds->loRecId > lastRecId) || (pBounds->hiRecId < firstRecId))
+        {
+            return GLUCOSE_STORE_CLIP_NONE;
+        }
+
+        if ((pBounds->loRecId <= firstRecId) && (pBounds->hiRecId >= lastRecId))
+        {
+            return GLUCOSE_STORE_CLIP_ALL;
+        }
+
+        if (pBounds->loRecId > firstRecId + *pStart)
+        {
+            *pStart = (uint16_t)(pBounds->loRecId - firstRecId);
+        }
+
+        if (pBounds->hiRecId < firstRecId + *pEnd - 1)
+        {
+            *pEnd = (uint16_t)(pBounds->hiRecId - firstRecId + 1);
+        }
+
+        return (*pStart < *pEnd) ? GLUCOSE_STORE_CLIP_PARTIAL :
+                                   GLUCOSE_STORE_CLIP_NONE;
+
+    case GLUCOSE_STORE_KEY_TIME:
+        if ((pBounds->loTime > pEntry->maxTime) ||
+            (pBounds->hiTime < pEntry->minTime))
+        {
+            return GLUCOSE_STORE_CLIP_NONE;
+        }
+
+        if ((pBounds->loTime <= pEntry->minTime) &&
+            (pBounds->hiTime >= pEntry->maxTime))
+        {
+            return GLUCOSE_STORE_CLIP_ALL;
+        }
+
+        // Once past the lower bound of an ordered sector, every later
+        // record is too; only search when entering the sector.
+        if (pEntry->timeOrdered && (*pStart == 0))
+        {
+            *pStart = GlucoseStore_lowerBound(sector, 0, *pEnd,
+                                              pBounds->loTime);
+        }
+
+        return (*pStart < *pEnd) ? GLUCOSE_STORE_CLIP_PARTIAL :
+                                   GLUCOSE_STORE_CLIP_NONE;
+
+    default:
+        return GLUCOSE_STORE_CLIP_ALL;
+    }
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_scan
+ *
+ * @brief   Read slots of a sector into the scratch slot until a valid
+ *          record within the bounds is found. Scanning a time ordered
+ *          sector stops at the first record past the upper time bound.
+ *
+ * @param   pBounds - filter bounds
+ * @param   sector - sector index
+ * @param   start - first slot to read
+ * @param   end - slot after the last slot to read
+ *
+ * @return  slot of the record found, or end if none
+ */
+static uint16_t GlucoseStore_scan(const glucoseStoreBounds_t *pBounds,
+                                  uint8_t sector, uint16_t start,
+                                  uint16_t end)
+{
+    bool timeOrdered = (pBounds->key == GLUCOSE_STORE_KEY_TIME) &&
+                       glucoseStoreSectors[sector].timeOrdered;
+    uint16_t slot;
+
+    for (slot = GlucoseStore_nextValid(sector, start, end); slot < end;
+         slot = GlucoseStore_nextValid(sector, slot + 1, end))
+    {
+        if (GlucoseStore_readSlot(sector, slot))
+        {
+            if (timeOrdered && (glucoseStoreSlot.utcSecs > pBounds->hiTime))
+            {
+                break;
+            }
+
+            if (GlucoseStore_match(pBounds))
+            {
+                return slot;
+            }
+        }
+    }
+
+    return end;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_next
+ *
+ * @brief   Read the first valid record after a record ID that is within
+ *          the filter bounds into the scratch slot. Sectors are walked
+ *          from the oldest to the head.
+ *
+ * @param   pBounds - filter bounds
+ * @param   pRecId - in: record ID to search after. out: ID found.
+ * @param   pSector - sector of the record found
+ *
+ * @return  true if a record was found, false otherwise
+ */
+static bool GlucoseStore_next(const glucoseStoreBounds_t *pBounds,
+                              uint32_t *pRecId, uint8_t *pSector)
+{
+    uint8_t sector;
+    uint8_t i;
+
+    if (glucoseStoreHead == GLUCOSE_STORE_NO_SECTOR)
+    {
+        return false;
+    }
+
+    sector = (glucoseStoreHead + 1) % glucoseStoreNumSectors;
+
+    for (i = 0; i < glucoseStoreNumSectors; i++)
+    {
+        glucoseStoreSector_t *pEntry = &glucoseStoreSectors[sector];
+
+        if ((pEntry->numValid > 0) &&
+            (pEntry->firstRecId + pEntry->numUsed > *pRecId + 1))
+        {
+            uint16_t start = 0;
+            uint16_t end = pEntry->numUsed;
+
+            if (*pRecId >= pEntry->firstRecId)
+            {
+                start = (uint16_t)(*pRecId - pEntry->firstRecId + 1);
+            }
+
+            if (GlucoseStore_clip(pBounds, sector, &start, &end) !=
+                GLUCOSE_STORE_CLIP_NONE)
+            {
+                uint16_t slot = GlucoseStore_scan(pBounds, sector, start, end);
+
+                if (slot < end)
+                {
+                    *pRecId = pEntry->firstRecId + slot;
+                    *pSector = sector;
+
+                    return true;
+                }
+            }
+        }
+
+        sector = (sector + 1) % glucoseStoreNumSectors;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_last
+ *
+ * @brief   Read the newest valid record into the scratch slot.
+ *
+ * @param   pRecId - ID of the record found
+ * @param   pSector - sector of the record found
+ *
+ * @return  true if a record was found, false otherwise
+ */
+static bool GlucoseStore_last(uint32_t *pRecId, uint8_t *pSector)
+{
+    uint8_t sector = glucoseStoreHead;
+    uint8_t i;
+
+    if (glucoseStoreHead == GLUCOSE_STORE_NO_SECTOR)
+    {
+        return false;
+    }
+
+    for (i = 0; i < glucoseStoreNumSectors; i++)
+    {
+        glucoseStoreSector_t *pEntry = &glucoseStoreSectors[sector];
+
+        if (pEntry->numValid > 0)
+        {
+            uint16_t slot;
+
+            for (slot = pEntry->numUsed; slot > 0; slot--)
+            {
+                if (GLUCOSE_STORE_IS_VALID(pEntry, slot - 1) &&
+                    GlucoseStore_readSlot(sector, slot - 1))
+                {
+                    *pRecId = pEntry->firstRecId + slot - 1;
+                    *pSector = sector;
+
+                    return true;
+                }
+            }
+        }
+
+        sector = (sector + glucoseStoreNumSectors - 1) %
+                 glucoseStoreNumSectors;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * @fn      GlucoseStore_select
+ *
+ * @brief   Read the next record after a record ID that passes the filter
+ *          into the scratch slot.
+ *
+ * @param   pFilter - record filter
+ * @param   pRecId - in: record ID to search after, 0 to start.
+ *                   out: ID found.
+ * @param   pSector - sector of the record found
+ *
+ * @return  true if a record was found, false otherwise
+ */
+static bool GlucoseStore_select(const glucoseStoreFilter_t *pFilter,
+                                uint32_t *pRecId, uint8_t *pSector)
+{
+    glucoseStoreBounds_t bounds;
+
+    GlucoseStore_getBounds(pFilter, &bounds);
+
+    switch (pFilter->oper)
+    {
+    case CTL_PNT_OPER_FIRST:
+        return (*pRecId == 0) && GlucoseStore_next(&bounds, pRecId, pSector);
+
+    case CTL_PNT_OPER_LAST:
+        return (*pRecId == 0) && GlucoseStore_last(pRecId, pSector);
+
+    default:
+        return GlucoseStore_next(&bounds, pRecId, pSector);
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,194 @@
+/******************************************************************************
+
+ @file       glucose_store.h
+
+ @brief This file contains the flash backed glucose record store definitions
+        and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2011-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+
+
+#ifndef GLUCOSE_STORE_H
+#define GLUCOSE_STORE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+#include "utc_clock.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Maximum number of flash sectors tracked by the store. Sectors of the NVS
+// region beyond this are left unused.
+#define GLUCOSE_STORE_MAX_SECTORS             16
+
+// Maximum number of record slots used per sector. Slots of a sector beyond
+// this are left unused.
+#define GLUCOSE_STORE_MAX_SLOTS               96
+
+// Maximum encoded lengths of the measurement and context characteristics.
+#define GLUCOSE_STORE_MEAS_LEN                17
+#define GLUCOSE_STORE_CONTEXT_LEN             17
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Data in a glucose measurement as defined in the profile.
+typedef struct
+{
+    uint8_t flags;
+    uint16_t seqNum;
+    UTCTimeStruct baseTime;
+    int16_t timeOffset;
+    uint16_t concentration;
+    uint8_t typeSampleLocation;
+    uint16_t sensorStatus;
+} glucoseMeas_t;
+
+// Context data as defined in profile. The sequence number is shared with
+// the measurement it belongs to.
+typedef struct
+{
+    uint8_t flags;
+    uint8_t extendedFlags;
+    uint8_t carboId;
+    uint16_t carboVal;
+    uint8_t mealVal;
+    uint8_t TesterHealthVal;
+    uint16_t exerciseDuration;
+    uint8_t exerciseIntensity;
+    uint8_t medId;
+    uint16_t medVal;
+    uint16_t HbA1cVal;
+} glucoseContext_t;
+
+// A stored record: a measurement and its (optional) context.
+typedef struct
+{
+    glucoseMeas_t meas;
+    glucoseContext_t context;
+} glucoseRecord_t;
+
+// A stored record in its characteristic value encoding, ready to be sent.
+typedef struct
+{
+    uint8_t measLen;
+    uint8_t contextLen;   // 0 if the record has no context
+    uint8_t meas[GLUCOSE_STORE_MEAS_LEN];
+    uint8_t context[GLUCOSE_STORE_CONTEXT_LEN];
+} glucoseStoreWire_t;
+
+// Record selection, using the record access control point operator
+// (CTL_PNT_OPER_*) and filter type (CTL_PNT_FILTER_*) values.
+typedef struct
+{
+    uint8_t oper;
+    uint8_t filterType;
+    uint16_t seqNum1;
+    uint16_t seqNum2;
+    UTCTime time1;
+    UTCTime time2;
+} glucoseStoreFilter_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Open the NVS region and rebuild the record index from flash.
+ */
+extern bStatus_t GlucoseStore_init(uint_least8_t nvsIndex);
+
+/*
+ * Append a record to the log. The record's sequence number is assigned
+ * by the store and written back to pRec. Records are stored encoded.
+ */
+extern bStatus_t GlucoseStore_append(glucoseRecord_t *pRec);
+
+/*
+ * Get the number of valid records in the store.
+ */
+extern uint16_t GlucoseStore_getNumRecords(void);
+
+/*
+ * Find the next record after *pRecId that passes the filter. Start with
+ * *pRecId set to 0.
+ */
+extern bool GlucoseStore_find(const glucoseStoreFilter_t *pFilter,
+                              uint32_t *pRecId, glucoseStoreWire_t *pWire);
+
+/*
+ * Count the records that pass the filter.
+ */
+extern uint16_t GlucoseStore_count(const glucoseStoreFilter_t *pFilter);
+
+/*
+ * Delete the records that pass the filter. Nothing is erased; the space
+ * is reclaimed by GlucoseStore_compact.
+ */
+extern uint16_t GlucoseStore_delete(const glucoseStoreFilter_t *pFilter);
+
+/*
+ * Erase one sector that holds no valid records. Returns true while more
+ * may be left to erase.
+ */
+extern bool GlucoseStore_compact(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GLUCOSE_STORE_H */
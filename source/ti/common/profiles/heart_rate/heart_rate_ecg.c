@@ -0,0 +1,527 @@
+/******************************************************************************
+
+ @file       heart_rate_ecg.c
+
+ @brief This file contains a fixed-point ECG beat detector for the heart rate
+        sensor. Raw samples are band-pass filtered, differentiated, squared
+        and integrated over a moving window (after Pan and Tompkins), and
+        beats are picked from the result with adaptive thresholds. Only
+        integer adds, multiplies and shifts are used per sample.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2011-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "bcomdef.h"
+
+#include "heart_rate_ecg.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Convert a time in ms to samples at the configured rate.
+#define HEARTRATE_ECG_MS2SAMPLES(ms)                                      \
+    ((uint16_t) (((uint32_t) (ms) * heartRateEcg.sampleRate) / 1000))
+
+// Move avg 1/2^shift of the way to target, without overflow or sign
+// trouble on unsigned values.
+#define HEARTRATE_ECG_TRACK(avg, target, shift)                           \
+    ((target) > (avg) ? (avg) + (((target) - (avg)) >> (shift))           \
+                      : (avg) - (((avg) - (target)) >> (shift)))
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Filter windows as log2 of their length in samples at the lowest rates;
+// each is doubled from HEARTRATE_ECG_FAST_RATE up so their lengths in time
+// stay close. Powers of two keep the moving averages down to shifts.
+#define HEARTRATE_ECG_LP_SHIFT                3  // ~30 ms low-pass
+#define HEARTRATE_ECG_HP_SHIFT                5  // ~125 ms baseline
+#define HEARTRATE_ECG_MWI_SHIFT               5  // ~125 ms integration
+#define HEARTRATE_ECG_FAST_RATE               360
+
+// Longest windows, at the fast rates.
+#define HEARTRATE_ECG_LP_MAX         (1 << (HEARTRATE_ECG_LP_SHIFT + 1))
+#define HEARTRATE_ECG_HP_MAX         (1 << (HEARTRATE_ECG_HP_SHIFT + 1))
+#define HEARTRATE_ECG_MWI_MAX        (1 << (HEARTRATE_ECG_MWI_SHIFT + 1))
+
+// Derivative limit, so that its square scaled down by
+// HEARTRATE_ECG_SQ_SHIFT summed over the longest window fits in 32 bits.
+#define HEARTRATE_ECG_DERIV_LIMIT             16383
+#define HEARTRATE_ECG_SQ_SHIFT                6
+
+// Timing, in ms. No beat can follow another within the refractory period.
+// Thresholds are learned over HEARTRATE_ECG_LEARN_MS. With no beat for
+// HEARTRATE_ECG_MAX_RR_MS, contact is lost and the thresholds, which an
+// artefact may have thrown, are learned again.
+#define HEARTRATE_ECG_REFRACTORY_MS           200
+#define HEARTRATE_ECG_LEARN_MS                2000
+#define HEARTRATE_ECG_MAX_RR_MS               3000
+
+// Weight of a new peak in the signal and noise peak levels, as a shift.
+#define HEARTRATE_ECG_PEAK_SHIFT              3
+
+// Weight of a new RR-interval in the average, as a shift.
+#define HEARTRATE_ECG_RR_SHIFT                3
+
+// Weight of a new sample in the mean learned, as a shift.
+#define HEARTRATE_ECG_MEAN_SHIFT              6
+
+// Smallest band-passed R-wave taken for a beat, in raw sample counts
+// (0.1 mV at the 1000 counts/mV of the application's simulation). The
+// thresholds are relative, so without it the noise of a loose electrode
+// is learned and then detected as beats. Set it for the front end's gain.
+#ifndef HEARTRATE_ECG_MIN_QRS
+#define HEARTRATE_ECG_MIN_QRS                 100
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Detector state. Sample times are counted in samples.
+typedef struct
+{
+    // Fixed by the sample rate.
+    uint16_t sampleRate;
+    uint8_t lpShift;
+    uint8_t hpShift;
+    uint8_t mwiShift;
+    uint16_t refractory;
+    uint16_t learnLen;
+    uint16_t maxRr;
+    uint32_t rrScale;         // 1/1024 s per sample, Q16
+
+    // Band-pass filter: a short moving average for the low-pass, less a
+    // long moving average of that for the high-pass.
+    int16_t lpBuf[HEARTRATE_ECG_LP_MAX];
+    int32_t lpSum;
+    uint8_t lpIdx;
+    int16_t hpBuf[HEARTRATE_ECG_HP_MAX];
+    int32_t hpSum;
+    uint8_t hpIdx;
+
+    // Last four band-passed samples, newest first, for the derivative.
+    int32_t bp[4];
+    uint32_t amplitude;       // Magnitude of the last
+
+    // Moving window integration of the squared derivative.
+    uint32_t mwiBuf[HEARTRATE_ECG_MWI_MAX];
+    uint32_t mwiSum;
+    uint8_t mwiIdx;
+
+    // Peak picking. A peak is taken once the integrated signal has fallen
+    // to half of it, and the next peak is searched for once the signal has
+    // risen to twice the valley in between. The integrated peak is too
+    // flat to time a beat by, so it is timed by the largest band-passed
+    // sample (the R-wave) within.
+    uint32_t now;
+    bool searching;
+    uint32_t peak;
+    uint32_t valley;
+    uint32_t maxAmplitude;
+    uint32_t peakTime;
+
+    // Adaptive thresholds.
+    uint16_t learnLeft;       // Samples until the thresholds are seeded
+    uint32_t learnMax;
+    uint32_t learnMean;
+    uint32_t signalLvl;       // Running level of QRS peaks
+    uint32_t noiseLvl;        // Running level of other peaks
+    uint32_t threshold;
+
+    // Beats.
+    bool haveBeat;            // lastBeat is a beat, not the end of learning
+    uint32_t lastBeat;
+    uint16_t rrAvg;           // Running RR-interval, 0 until the first
+    uint16_t rrMissed;        // Time after a beat to search back from
+} heartRateEcg_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static heartRateEcg_t heartRateEcg;
+
+// Written by HeartRateEcg_process, read by the application.
+static volatile bool heartRateEcgContact = false;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint32_t HeartRateEcg_filter(int16_t sample);
+static bool HeartRateEcg_detect(uint32_t mwi, uint16_t *pRrInterval);
+static bool HeartRateEcg_classify(uint16_t *pRrInterval);
+static void HeartRateEcg_setThreshold(void);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      HeartRateEcg_init
+ *
+ * @brief   Reset the detector for ECG samples taken at sampleRate Hz.
+ *          Must not be called while samples are being processed.
+ *
+ * @param   sampleRate - sample rate in Hz, HEARTRATE_ECG_MIN_RATE to
+ *                       HEARTRATE_ECG_MAX_RATE
+ *
+ * @return  SUCCESS, or INVALIDPARAMETER if the rate is not supported
+ */
+bStatus_t HeartRateEcg_init(uint16_t sampleRate)
+{
+    uint8_t fast;
+
+    if ((sampleRate < HEARTRATE_ECG_MIN_RATE) ||
+        (sampleRate > HEARTRATE_ECG_MAX_RATE))
+    {
+        return INVALIDPARAMETER;
+    }
+
+    memset(&heartRateEcg, 0, sizeof(heartRateEcg));
+    heartRateEcgContact = false;
+
+    fast = (sampleRate >= HEARTRATE_ECG_FAST_RATE) ? 1 : 0;
+
+    heartRateEcg.sampleRate = sampleRate;
+    heartRateEcg.lpShift = HEARTRATE_ECG_LP_SHIFT + fast;
+    heartRateEcg.hpShift = HEARTRATE_ECG_HP_SHIFT + fast;
+    heartRateEcg.mwiShift = HEARTRATE_ECG_MWI_SHIFT + fast;
+    heartRateEcg.refractory =
+            HEARTRATE_ECG_MS2SAMPLES(HEARTRATE_ECG_REFRACTORY_MS);
+    heartRateEcg.learnLen = HEARTRATE_ECG_MS2SAMPLES(HEARTRATE_ECG_LEARN_MS);
+    heartRateEcg.learnLeft = heartRateEcg.learnLen;
+    heartRateEcg.maxRr = HEARTRATE_ECG_MS2SAMPLES(HEARTRATE_ECG_MAX_RR_MS);
+    heartRateEcg.rrScale = ((uint32_t) 1024 << 16) / sampleRate;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HeartRateEcg_process
+ *
+ * @brief   Process one raw ECG sample. Safe to call from interrupt
+ *          context: the work per sample is fixed, with no loops or
+ *          divisions. tests/host/heart_rate_ecg times it on the host;
+ *          the cycle count on the target has to be measured there.
+ *
+ * @param   sample - raw ECG sample
+ * @param   pRrInterval - RR-interval of the beat detected, 1/1024 s
+ *
+ * @return  true if a beat was detected and *pRrInterval set, false
+ *          otherwise. The first beat after contact is made only sets
+ *          the time for the next one.
+ */
+bool HeartRateEcg_process(int16_t sample, uint16_t *pRrInterval)
+{
+    if (heartRateEcg.sampleRate == 0)
+    {
+        return false;
+    }
+
+    heartRateEcg.now++;
+
+    return HeartRateEcg_detect(HeartRateEcg_filter(sample), pRrInterval);
+}
+
+/*********************************************************************
+ * @fn      HeartRateEcg_getContact
+ *
+ * @brief   Get the sensor contact status. Contact is made with the first
+ *          beat detected and lost when none follows within
+ *          HEARTRATE_ECG_MAX_RR_MS; a loose electrode shows no beats.
+ *
+ * @return  true if in contact, false otherwise
+ */
+bool HeartRateEcg_getContact(void)
+{
+    return heartRateEcgContact;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      HeartRateEcg_filter
+ *
+ * @brief   Run a sample through the filter chain: band-pass, five-point
+ *          derivative, squaring and moving window integration. The
+ *          integrated value is left scaled by the window length, as the
+ *          thresholds only compare it with itself.
+ *
+ * @param   sample - raw ECG sample
+ *
+ * @return  integrated QRS energy
+ */
+static uint32_t HeartRateEcg_filter(int16_t sample)
+{
+    heartRateEcg_t *pEcg = &heartRateEcg;
+    int32_t lp;
+    int32_t bp;
+    int32_t deriv;
+    uint32_t sq;
+
+    // Low-pass.
+    pEcg->lpSum += sample - pEcg->lpBuf[pEcg->lpIdx];
+    pEcg->lpBuf[pEcg->lpIdx] = sample;
+    pEcg->lpIdx = (pEcg->lpIdx + 1) & ((1 << pEcg->lpShift) - 1);
+    lp = pEcg->lpSum >> pEcg->lpShift;
+
+    // High-pass, by taking out the baseline centred on the sample, half
+    // the window back, so the filter doesn't skew the QRS complex.
+    pEcg->hpSum += lp - pEcg->hpBuf[pEcg->hpIdx];
+    pEcg->hpBuf[pEcg->hpIdx] = (int16_t) lp;
+    pEcg->hpIdx = (pEcg->hpIdx + 1) & ((1 << pEcg->hpShift) - 1);
+    bp = pEcg->hpBuf[(pEcg->hpIdx + (1 << (pEcg->hpShift - 1))) &
+                     ((1 << pEcg->hpShift) - 1)] -
+         (pEcg->hpSum >> pEcg->hpShift);
+
+    // Derivative: (2x[n] + x[n-1] - x[n-3] - 2x[n-4]), scaled up by 8.
+    deriv = (2 * bp) + pEcg->bp[0] - pEcg->bp[2] - (2 * pEcg->bp[3]);
+    pEcg->bp[3] = pEcg->bp[2];
+    pEcg->bp[2] = pEcg->bp[1];
+    pEcg->bp[1] = pEcg->bp[0];
+    pEcg->bp[0] = bp;
+    pEcg->amplitude = (uint32_t) ((bp < 0) ? -bp : bp);
+
+    if (deriv > HEARTRATE_ECG_DERIV_LIMIT)
+    {
+        deriv = HEARTRATE_ECG_DERIV_LIMIT;
+    }
+    else if (deriv < -HEARTRATE_ECG_DERIV_LIMIT)
+    {
+        deriv = -HEARTRATE_ECG_DERIV_LIMIT;
+    }
+
+    sq = (uint32_t) (deriv * deriv) >> HEARTRATE_ECG_SQ_SHIFT;
+
+    // Moving window integration.
+    pEcg->mwiSum += sq - pEcg->mwiBuf[pEcg->mwiIdx];
+    pEcg->mwiBuf[pEcg->mwiIdx] = sq;
+    pEcg->mwiIdx = (pEcg->mwiIdx + 1) & ((1 << pEcg->mwiShift) - 1);
+
+    return pEcg->mwiSum;
+}
+
+/*********************************************************************
+ * @fn      HeartRateEcg_detect
+ *
+ * @brief   Find the peaks of the integrated signal. Over the learning
+ *          period the signal is only measured, to seed the thresholds.
+ *
+ * @param   mwi - integrated QRS energy
+ * @param   pRrInterval - RR-interval of the beat detected, 1/1024 s
+ *
+ * @return  true if a beat was detected and *pRrInterval set
+ */
+static bool HeartRateEcg_detect(uint32_t mwi, uint16_t *pRrInterval)
+{
+    heartRateEcg_t *pEcg = &heartRateEcg;
+
+    if (pEcg->learnLeft > 0)
+    {
+        if (mwi > pEcg->learnMax)
+        {
+            pEcg->learnMax = mwi;
+        }
+
+        pEcg->learnMean = HEARTRATE_ECG_TRACK(pEcg->learnMean, mwi,
+                                              HEARTRATE_ECG_MEAN_SHIFT);
+
+        if (--pEcg->learnLeft == 0)
+        {
+            // A third of the largest peak, half of the mean.
+            pEcg->signalLvl = (pEcg->learnMax >> 2) + (pEcg->learnMax >> 4) +
+                              (pEcg->learnMax >> 6);
+            pEcg->noiseLvl = pEcg->learnMean >> 1;
+            pEcg->valley = mwi;
+            pEcg->searching = false;
+            pEcg->lastBeat = pEcg->now;
+            HeartRateEcg_setThreshold();
+        }
+
+        return false;
+    }
+
+    if ((pEcg->now - pEcg->lastBeat) > pEcg->maxRr)
+    {
+        pEcg->haveBeat = false;
+        pEcg->rrAvg = 0;
+        pEcg->learnLeft = pEcg->learnLen;
+        pEcg->learnMax = 0;
+        heartRateEcgContact = false;
+
+        return false;
+    }
+
+    if (pEcg->searching)
+    {
+        if (pEcg->amplitude > pEcg->maxAmplitude)
+        {
+            pEcg->maxAmplitude = pEcg->amplitude;
+            pEcg->peakTime = pEcg->now;
+        }
+
+        if (mwi > pEcg->peak)
+        {
+            pEcg->peak = mwi;
+        }
+        else if (mwi <= (pEcg->peak >> 1))
+        {
+            pEcg->searching = false;
+            pEcg->valley = mwi;
+
+            return HeartRateEcg_classify(pRrInterval);
+        }
+    }
+    else if (mwi < pEcg->valley)
+    {
+        pEcg->valley = mwi;
+    }
+    else if (mwi > (pEcg->valley << 1))
+    {
+        pEcg->searching = true;
+        pEcg->peak = mwi;
+        pEcg->maxAmplitude = pEcg->amplitude;
+        pEcg->peakTime = pEcg->now;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * @fn      HeartRateEcg_classify
+ *
+ * @brief   Decide whether the peak just found is a QRS complex, and
+ *          update the thresholds. Peaks within the refractory period
+ *          of a beat (T-waves) and peaks with an R-wave below
+ *          HEARTRATE_ECG_MIN_QRS are noise. When a beat is overdue, a
+ *          peak above half the threshold is taken, so that a single
+ *          small QRS is not missed.
+ *
+ * @param   pRrInterval - RR-interval of the beat detected, 1/1024 s
+ *
+ * @return  true if a beat was detected and *pRrInterval set
+ */
+static bool HeartRateEcg_classify(uint16_t *pRrInterval)
+{
+    heartRateEcg_t *pEcg = &heartRateEcg;
+    uint32_t since = pEcg->peakTime - pEcg->lastBeat;
+    uint32_t threshold = pEcg->threshold;
+    uint8_t shift = HEARTRATE_ECG_PEAK_SHIFT;
+    bool beat = false;
+
+    if (pEcg->haveBeat && (pEcg->rrAvg != 0) && (since > pEcg->rrMissed))
+    {
+        threshold >>= 1;
+        shift--;
+    }
+
+    if ((pEcg->haveBeat && (since < pEcg->refractory)) ||
+        (pEcg->peak < threshold) ||
+        (pEcg->maxAmplitude < HEARTRATE_ECG_MIN_QRS))
+    {
+        pEcg->noiseLvl = HEARTRATE_ECG_TRACK(pEcg->noiseLvl, pEcg->peak,
+                                             HEARTRATE_ECG_PEAK_SHIFT);
+    }
+    else
+    {
+        pEcg->signalLvl = HEARTRATE_ECG_TRACK(pEcg->signalLvl, pEcg->peak,
+                                              shift);
+
+        if (pEcg->haveBeat)
+        {
+            *pRrInterval = (uint16_t) (((since * pEcg->rrScale) + 0x8000) >>
+                                       16);
+            beat = true;
+
+            pEcg->rrAvg = (pEcg->rrAvg == 0) ? (uint16_t) since :
+                          HEARTRATE_ECG_TRACK(pEcg->rrAvg, (uint16_t) since,
+                                              HEARTRATE_ECG_RR_SHIFT);
+
+            // About 166% of the average.
+            pEcg->rrMissed = pEcg->rrAvg + (pEcg->rrAvg >> 1) +
+                             (pEcg->rrAvg >> 3);
+        }
+
+        pEcg->haveBeat = true;
+        pEcg->lastBeat = pEcg->peakTime;
+        heartRateEcgContact = true;
+    }
+
+    HeartRateEcg_setThreshold();
+
+    return beat;
+}
+
+/*********************************************************************
+ * @fn      HeartRateEcg_setThreshold
+ *
+ * @brief   Set the detection threshold a quarter of the way from the
+ *          noise level to the signal level.
+ *
+ * @return  none
+ */
+static void HeartRateEcg_setThreshold(void)
+{
+    heartRateEcg_t *pEcg = &heartRateEcg;
+
+    if (pEcg->signalLvl > pEcg->noiseLvl)
+    {
+        pEcg->threshold = pEcg->noiseLvl +
+                          ((pEcg->signalLvl - pEcg->noiseLvl) >> 2);
+    }
+    else
+    {
+        pEcg->threshold = pEcg->noiseLvl;
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
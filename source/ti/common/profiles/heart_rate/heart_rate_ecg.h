@@ -0,0 +1,101 @@
+/******************************************************************************
+
+ @file       heart_rate_ecg.h
+
+ @brief This file contains the fixed-point ECG beat detector definitions and
+        prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2011-2020, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+
+
+#ifndef HEART_RATE_ECG_H
+#define HEART_RATE_ECG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Supported ECG sample rates, in Hz.
+#define HEARTRATE_ECG_MIN_RATE                250
+#define HEARTRATE_ECG_MAX_RATE                500
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Reset the detector for ECG samples taken at sampleRate Hz. Beats are
+ * only reported after a short learning period.
+ */
+extern bStatus_t HeartRateEcg_init(uint16_t sampleRate);
+
+/*
+ * Process one raw ECG sample. Returns true when a beat is detected that
+ * follows another, with the RR-interval between them in 1/1024 s.
+ */
+extern bool HeartRateEcg_process(int16_t sample, uint16_t *pRrInterval);
+
+/*
+ * Get the sensor contact status: true while beats are being detected.
+ */
+extern bool HeartRateEcg_getContact(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEART_RATE_ECG_H */
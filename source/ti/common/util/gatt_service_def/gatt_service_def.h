@@ -0,0 +1,158 @@
+/**********************************************************************************************
+ * Filename:       gatt_service_def.h
+ *
+ * Description:    This file contains macros that generate a GATT service attribute
+ *                 table, its attribute index constants, its constant characteristic
+ *                 properties and its CCC table pointers from one declarative
+ *                 service definition, for use with either stack.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _GATTSERVICEDEF_H_
+#define _GATTSERVICEDEF_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdint.h>
+#include "icall_ble_api.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+/*
+ * A service is defined once as a list macro taking the four entry
+ * kinds below as arguments, for example:
+ *
+ *   #define MYSERVICE_DEF(SERVICE, CHAR, CHAR_CCC, DESC)                     \
+ *     SERVICE(  MYSERVICE, myServiceDecl )                                    \
+ *     CHAR(     MYSERVICE_DATAIN, GATT_PROP_WRITE, ATT_UUID_SIZE, dataInUUID,  \
+ *               GATT_PERMIT_WRITE, dataInVal )                                \
+ *     DESC(     MYSERVICE_DATAIN, dataInUserDesc )                            \
+ *     CHAR_CCC( MYSERVICE_DATAOUT, GATT_PROP_NOTIFY, ATT_UUID_SIZE,          \
+ *               dataOutUUID, 0, dataOutVal,                                  \
+ *               GATT_PERMIT_READ | GATT_PERMIT_WRITE, dataOutConfig )
+ *
+ * DESC adds a read only Characteristic User Description to the
+ * characteristic defined before it.
+ *
+ * The definition is then expanded into:
+ *
+ *   GATT_SERVICE_DEF_VARS( MYSERVICE_DEF )   - characteristic properties, in
+ *                                             flash, and the CCC table pointers
+ *   GATT_SERVICE_DEF_INDEX( MYSERVICE_DEF, MYSERVICE_NUM_ATTRS )
+ *                                           - <name>_SERVICE_IDX, <name>_DECL_IDX,
+ *                                             <name>_VALUE_IDX, <name>_CCC_IDX,
+ *                                             <name>_DESC_IDX and the attribute
+ *                                             count
+ *   GATT_SERVICE_DEF_TABLE( MYSERVICE_DEF )  - gattAttribute_t initializers
+ *
+ * The table itself stays in RAM, since GATTServApp_RegisterService()
+ * writes the attribute handles into it. The GATT server only reads the
+ * characteristic properties and the user descriptions, so the table
+ * casts their const away.
+ */
+
+// Characteristic properties and CCC table pointers
+#define GATT_SERVICE_DEF_VARS( def )                                                   \
+  def( GATT_SERVICE_DEF_VARS_SERVICE, GATT_SERVICE_DEF_VARS_CHAR,                      \
+       GATT_SERVICE_DEF_VARS_CHAR_CCC, GATT_SERVICE_DEF_VARS_DESC )
+
+// Attribute index constants
+#define GATT_SERVICE_DEF_INDEX( def, numAttrs )                                        \
+  enum                                                                                 \
+  {                                                                                    \
+    def( GATT_SERVICE_DEF_INDEX_SERVICE, GATT_SERVICE_DEF_INDEX_CHAR,                  \
+         GATT_SERVICE_DEF_INDEX_CHAR_CCC, GATT_SERVICE_DEF_INDEX_DESC )                \
+    numAttrs                                                                           \
+  }
+
+// Attribute table initializers
+#define GATT_SERVICE_DEF_TABLE( def )                                                  \
+  def( GATT_SERVICE_DEF_TABLE_SERVICE, GATT_SERVICE_DEF_TABLE_CHAR,                    \
+       GATT_SERVICE_DEF_TABLE_CHAR_CCC, GATT_SERVICE_DEF_TABLE_DESC )
+
+/*********************************************************************
+ * Entry expansions, not used directly
+ */
+
+#define GATT_SERVICE_DEF_VARS_SERVICE( name, decl )
+#define GATT_SERVICE_DEF_VARS_CHAR( name, props, uuidLen, uuid, perm, pValue )         \
+  static CONST uint8_t name##_PROPS = ( props );
+#define GATT_SERVICE_DEF_VARS_CHAR_CCC( name, props, uuidLen, uuid, perm, pValue,      \
+                                        cccPerm, pCharCfg )                             \
+  GATT_SERVICE_DEF_VARS_CHAR( name, props, uuidLen, uuid, perm, pValue )               \
+  static gattCharCfg_t *pCharCfg;
+#define GATT_SERVICE_DEF_VARS_DESC( name, pDesc )
+
+#define GATT_SERVICE_DEF_INDEX_SERVICE( name, decl )                                   \
+  name##_SERVICE_IDX,
+#define GATT_SERVICE_DEF_INDEX_CHAR( name, props, uuidLen, uuid, perm, pValue )        \
+  name##_DECL_IDX,                                                                     \
+  name##_VALUE_IDX,
+#define GATT_SERVICE_DEF_INDEX_CHAR_CCC( name, props, uuidLen, uuid, perm, pValue,     \
+                                         cccPerm, pCharCfg )                            \
+  GATT_SERVICE_DEF_INDEX_CHAR( name, props, uuidLen, uuid, perm, pValue )              \
+  name##_CCC_IDX,
+#define GATT_SERVICE_DEF_INDEX_DESC( name, pDesc )                                     \
+  name##_DESC_IDX,
+
+#define GATT_SERVICE_DEF_TABLE_SERVICE( name, decl )                                   \
+  { { ATT_BT_UUID_SIZE, primaryServiceUUID }, GATT_PERMIT_READ, 0, (uint8_t *)&(decl) },
+#define GATT_SERVICE_DEF_TABLE_CHAR( name, props, uuidLen, uuid, perm, pValue )        \
+  { { ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0,                          \
+    (uint8_t *)&name##_PROPS },                                                        \
+  { { ( uuidLen ), ( uuid ) }, ( perm ), 0, (uint8_t *)( pValue ) },
+#define GATT_SERVICE_DEF_TABLE_CHAR_CCC( name, props, uuidLen, uuid, perm, pValue,     \
+                                         cccPerm, pCharCfg )                            \
+  GATT_SERVICE_DEF_TABLE_CHAR( name, props, uuidLen, uuid, perm, pValue )              \
+  { { ATT_BT_UUID_SIZE, clientCharCfgUUID }, ( cccPerm ), 0, (uint8_t *)&(pCharCfg) },
+#define GATT_SERVICE_DEF_TABLE_DESC( name, pDesc )                                     \
+  { { ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, (uint8_t *)( pDesc ) },
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GATTSERVICEDEF_H_ */
@@ -0,0 +1,496 @@
+/**********************************************************************************************
+ * Filename:       gattservapp_ext.c
+ *
+ * Description:    This file contains GATT Server Application helpers built only on
+ *                 the public GATTServApp, GATT and linkDB API, for use with either
+ *                 stack.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+#include "gattservapp_ext.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Free CCC table entry, the two stacks give this handle different names
+#define GATTSERVAPP_EXT_INVALID_CONNHANDLE  0xFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static bStatus_t gattServApp_SendNotiIndCopy( uint16 connHandle, uint8 cccValue,
+                                              uint8 authenticated, gattAttribute_t *pAttr,
+                                              uint8 taskId, pfnGATTReadAttrCB_t pfnReadAttrCB,
+                                              attHandleValueNoti_t *pSrc, uint16 srcMaxLen );
+static bStatus_t gattServApp_SendBuf( uint16 connHandle, uint8 cccValue,
+                                      uint8 authenticated, attHandleValueNoti_t *pNoti,
+                                      uint8 taskId );
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      GATTServApp_ProcessCharCfgFanOut
+ *
+ * @brief   Process Client Characteristic Configuration change, reading
+ *          the characteristic value once for all subscribed clients.
+ *
+ *          The value is read into the buffer of the first subscribed
+ *          client and copied into the buffers of the other clients.
+ *          The first client's buffer is sent last, once it is no
+ *          longer needed as the copy source.
+ *
+ * @param   charCfgTbl - characteristic configuration table.
+ * @param   pValue - pointer to attribute value.
+ * @param   authenticated - whether an authenticated link is required.
+ * @param   attrTbl - attribute table.
+ * @param   numAttrs - number of attributes in attribute table.
+ * @param   taskId - task to be notified of confirmation.
+ * @param   pfnReadAttrCB - read callback function pointer.
+ * @param   pConnStatus - optional per client status, one entry per
+ *                        charCfgTbl entry. May be NULL.
+ *
+ * @return  SUCCESS if sent to every subscribed client, otherwise the
+ *          status of the first client that failed.
+ */
+bStatus_t GATTServApp_ProcessCharCfgFanOut( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                            uint8 authenticated, gattAttribute_t *attrTbl,
+                                            uint16 numAttrs, uint8 taskId,
+                                            pfnGATTReadAttrCB_t pfnReadAttrCB,
+                                            bStatus_t *pConnStatus )
+{
+  uint8 i;
+  uint8 src = linkDBNumConns;
+  uint8 srcCfg = GATT_CFG_NO_OPERATION;
+  uint16 srcMaxLen = 0;
+  attHandleValueNoti_t srcNoti;
+  bStatus_t status = SUCCESS;
+  gattAttribute_t *pAttr;
+
+  // Verify input parameters
+  if ( ( charCfgTbl == NULL ) || ( pValue == NULL ) ||
+       ( attrTbl == NULL )    || ( pfnReadAttrCB == NULL ) )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  if ( pConnStatus != NULL )
+  {
+    for ( i = 0; i < linkDBNumConns; i++ )
+    {
+      pConnStatus[i] = SUCCESS;
+    }
+  }
+
+  // Find the characteristic value attribute, it is the same for all clients
+  pAttr = GATTServApp_FindAttr( attrTbl, numAttrs, pValue );
+  if ( pAttr == NULL )
+  {
+    return ( status );
+  }
+
+  for ( i = 0; i < linkDBNumConns; i++ )
+  {
+    gattCharCfg_t *pItem = &(charCfgTbl[i]);
+    uint8 cfg = (uint8)( pItem->value & ( GATT_CLIENT_CFG_NOTIFY |
+                                          GATT_CLIENT_CFG_INDICATE ) );
+    bStatus_t connStatus = SUCCESS;
+
+    if ( ( pItem->connHandle == GATTSERVAPP_EXT_INVALID_CONNHANDLE ) ||
+         ( cfg == GATT_CFG_NO_OPERATION ) )
+    {
+      continue;
+    }
+
+    if ( src == linkDBNumConns )
+    {
+      // First subscribed client, serialise the value into its buffer
+      srcNoti.pValue = (uint8 *)GATT_bm_alloc( pItem->connHandle, ATT_HANDLE_VALUE_NOTI,
+                                               GATT_MAX_MTU, &srcMaxLen );
+      if ( srcNoti.pValue == NULL )
+      {
+        // Try the next client as the source
+        connStatus = bleNoResources;
+      }
+      else
+      {
+        connStatus = (*pfnReadAttrCB)( pItem->connHandle, pAttr, srcNoti.pValue,
+                                       &srcNoti.len, 0, srcMaxLen, GATT_LOCAL_READ );
+        if ( connStatus != SUCCESS )
+        {
+          uint8 j;
+
+          GATT_bm_free( (gattMsg_t *)&srcNoti, ATT_HANDLE_VALUE_NOTI );
+
+          // The value cannot be read for any of the remaining clients
+          for ( j = i; ( pConnStatus != NULL ) && ( j < linkDBNumConns ); j++ )
+          {
+            if ( ( charCfgTbl[j].connHandle != GATTSERVAPP_EXT_INVALID_CONNHANDLE ) &&
+                 ( charCfgTbl[j].value != GATT_CFG_NO_OPERATION ) )
+            {
+              pConnStatus[j] = connStatus;
+            }
+          }
+
+          return ( ( status != SUCCESS ) ? status : connStatus );
+        }
+
+        srcNoti.handle = pAttr->handle;
+        src = i;
+
+        // The source buffer carries the notification if enabled, else the
+        // indication. An indication enabled as well is sent from a copy.
+        srcCfg = ( cfg & GATT_CLIENT_CFG_NOTIFY ) ? GATT_CLIENT_CFG_NOTIFY
+                                                  : GATT_CLIENT_CFG_INDICATE;
+        cfg &= ~srcCfg;
+      }
+    }
+
+    if ( ( connStatus == SUCCESS ) && ( cfg & GATT_CLIENT_CFG_NOTIFY ) )
+    {
+      connStatus = gattServApp_SendNotiIndCopy( pItem->connHandle, GATT_CLIENT_CFG_NOTIFY,
+                                                authenticated, pAttr, taskId,
+                                                pfnReadAttrCB, &srcNoti, srcMaxLen );
+    }
+
+    if ( ( connStatus == SUCCESS ) && ( cfg & GATT_CLIENT_CFG_INDICATE ) )
+    {
+      connStatus = gattServApp_SendNotiIndCopy( pItem->connHandle, GATT_CLIENT_CFG_INDICATE,
+                                                authenticated, pAttr, taskId,
+                                                pfnReadAttrCB, &srcNoti, srcMaxLen );
+    }
+
+    if ( pConnStatus != NULL )
+    {
+      pConnStatus[i] = connStatus;
+    }
+
+    if ( status == SUCCESS )
+    {
+      status = connStatus;
+    }
+  } // for
+
+  if ( src < linkDBNumConns )
+  {
+    bStatus_t connStatus = gattServApp_SendBuf( charCfgTbl[src].connHandle, srcCfg,
+                                                authenticated, &srcNoti, taskId );
+    if ( connStatus != SUCCESS )
+    {
+      GATT_bm_free( (gattMsg_t *)&srcNoti, ATT_HANDLE_VALUE_NOTI );
+
+      if ( ( pConnStatus != NULL ) && ( pConnStatus[src] == SUCCESS ) )
+      {
+        pConnStatus[src] = connStatus;
+      }
+
+      if ( status == SUCCESS )
+      {
+        status = connStatus;
+      }
+    }
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      GATTServApp_InitAttrDispatch
+ *
+ * @brief   Map the attribute handles of a registered service to their
+ *          handlers, so that the service callbacks need not decode the
+ *          attribute type on every request.
+ *
+ * @param   pDispatch - dispatch table to initialize.
+ * @param   pAttrTbl - registered attribute table.
+ * @param   numAttrs - number of attributes in attribute table.
+ * @param   pHandlers - attribute handlers.
+ * @param   numHandlers - number of attribute handlers.
+ * @param   pHandlerIdx - storage for numAttrs handler indexes.
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or FAILURE
+ */
+bStatus_t GATTServApp_InitAttrDispatch( gattServAppAttrDispatch_t *pDispatch,
+                                        gattAttribute_t *pAttrTbl, uint16 numAttrs,
+                                        const gattServAppAttrHandler_t *pHandlers,
+                                        uint8 numHandlers, uint8 *pHandlerIdx )
+{
+  uint16 i;
+
+  // Verify input parameters
+  if ( ( pDispatch == NULL ) || ( pAttrTbl == NULL ) || ( numAttrs == 0 ) ||
+       ( pHandlers == NULL ) || ( pHandlerIdx == NULL ) ||
+       ( numHandlers >= GATTSERVAPP_NO_HANDLER ) )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  pDispatch->numAttrs = 0;
+
+  for ( i = 0; i < numAttrs; i++ )
+  {
+    uint8 j;
+
+    // The handle must give the attribute position
+    if ( pAttrTbl[i].handle != ( pAttrTbl[0].handle + i ) )
+    {
+      return ( FAILURE );
+    }
+
+    pHandlerIdx[i] = GATTSERVAPP_NO_HANDLER;
+
+    for ( j = 0; j < numHandlers; j++ )
+    {
+      if ( pHandlers[j].pValue == pAttrTbl[i].pValue )
+      {
+        pHandlerIdx[i] = j;
+        break;
+      }
+    }
+  }
+
+  pDispatch->startHandle = pAttrTbl[0].handle;
+  pDispatch->pHandlers = pHandlers;
+  pDispatch->pHandlerIdx = pHandlerIdx;
+  pDispatch->numAttrs = numAttrs;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      GATTServApp_FindAttrHandler
+ *
+ * @brief   Find the handlers of an attribute.
+ *
+ * @param   pDispatch - dispatch table.
+ * @param   pAttr - pointer to attribute.
+ *
+ * @return  Pointer to the attribute handlers. NULL, if none.
+ */
+const gattServAppAttrHandler_t *GATTServApp_FindAttrHandler( const gattServAppAttrDispatch_t *pDispatch,
+                                                             gattAttribute_t *pAttr )
+{
+  uint16 pos = pAttr->handle - pDispatch->startHandle;
+
+  if ( ( pos < pDispatch->numAttrs ) &&
+       ( pDispatch->pHandlerIdx[pos] != GATTSERVAPP_NO_HANDLER ) )
+  {
+    return ( &(pDispatch->pHandlers[pDispatch->pHandlerIdx[pos]]) );
+  }
+
+  return ( (gattServAppAttrHandler_t *)NULL );
+}
+
+/*********************************************************************
+ * @fn      GATTServApp_DispatchReadAttr
+ *
+ * @brief   Call the read handler of an attribute.
+ *
+ * @param   pDispatch - dispatch table.
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be read
+ * @param   pLen - length of data to be read
+ * @param   offset - offset of the first octet to be read
+ * @param   maxLen - maximum length of data to be read
+ * @param   method - type of read message
+ *
+ * @return  Status of the read handler, ATT_ERR_ATTR_NOT_FOUND if none.
+ */
+bStatus_t GATTServApp_DispatchReadAttr( const gattServAppAttrDispatch_t *pDispatch,
+                                        uint16 connHandle, gattAttribute_t *pAttr,
+                                        uint8 *pValue, uint16 *pLen, uint16 offset,
+                                        uint16 maxLen, uint8 method )
+{
+  const gattServAppAttrHandler_t *pHandler = GATTServApp_FindAttrHandler( pDispatch, pAttr );
+
+  if ( ( pHandler == NULL ) || ( pHandler->pfnReadAttrCB == NULL ) )
+  {
+    *pLen = 0;
+
+    return ( ATT_ERR_ATTR_NOT_FOUND );
+  }
+
+  return ( (*pHandler->pfnReadAttrCB)( connHandle, pAttr, pValue, pLen,
+                                       offset, maxLen, method ) );
+}
+
+/*********************************************************************
+ * @fn      GATTServApp_DispatchWriteAttr
+ *
+ * @brief   Call the write handler of an attribute.
+ *
+ * @param   pDispatch - dispatch table.
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  Status of the write handler, ATT_ERR_ATTR_NOT_FOUND if none.
+ */
+bStatus_t GATTServApp_DispatchWriteAttr( const gattServAppAttrDispatch_t *pDispatch,
+                                         uint16 connHandle, gattAttribute_t *pAttr,
+                                         uint8 *pValue, uint16 len, uint16 offset,
+                                         uint8 method )
+{
+  const gattServAppAttrHandler_t *pHandler = GATTServApp_FindAttrHandler( pDispatch, pAttr );
+
+  if ( ( pHandler == NULL ) || ( pHandler->pfnWriteAttrCB == NULL ) )
+  {
+    return ( ATT_ERR_ATTR_NOT_FOUND );
+  }
+
+  return ( (*pHandler->pfnWriteAttrCB)( connHandle, pAttr, pValue, len,
+                                        offset, method ) );
+}
+
+/*********************************************************************
+ * @fn      gattServApp_SendNotiIndCopy
+ *
+ * @brief   Send a copy of an already read characteristic value to a
+ *          client. The value is read again only if it may have been
+ *          truncated to a smaller ATT_MTU than this client's.
+ *
+ * @param   connHandle - connection handle.
+ * @param   cccValue - client characteristic configuration value.
+ * @param   authenticated - whether an authenticated link is required.
+ * @param   pAttr - pointer to attribute record.
+ * @param   taskId - task to be notified of confirmation.
+ * @param   pfnReadAttrCB - read callback function pointer.
+ * @param   pSrc - notification holding the read value.
+ * @param   srcMaxLen - maximum length the value was read with.
+ *
+ * @return  Success or Failure
+ */
+static bStatus_t gattServApp_SendNotiIndCopy( uint16 connHandle, uint8 cccValue,
+                                              uint8 authenticated, gattAttribute_t *pAttr,
+                                              uint8 taskId, pfnGATTReadAttrCB_t pfnReadAttrCB,
+                                              attHandleValueNoti_t *pSrc, uint16 srcMaxLen )
+{
+  attHandleValueNoti_t noti;
+  uint16 len;
+  bStatus_t status = SUCCESS;
+
+  noti.pValue = (uint8 *)GATT_bm_alloc( connHandle, ATT_HANDLE_VALUE_NOTI,
+                                        GATT_MAX_MTU, &len );
+  if ( noti.pValue == NULL )
+  {
+    return ( bleNoResources );
+  }
+
+  if ( ( pSrc->len >= srcMaxLen ) && ( len > srcMaxLen ) )
+  {
+    // The value may be longer than the copy, read it for this client
+    status = (*pfnReadAttrCB)( connHandle, pAttr, noti.pValue, &noti.len,
+                               0, len, GATT_LOCAL_READ );
+  }
+  else
+  {
+    noti.len = ( pSrc->len < len ) ? pSrc->len : len;
+    VOID memcpy( noti.pValue, pSrc->pValue, noti.len );
+  }
+
+  if ( status == SUCCESS )
+  {
+    noti.handle = pAttr->handle;
+
+    status = gattServApp_SendBuf( connHandle, cccValue, authenticated, &noti, taskId );
+  }
+
+  if ( status != SUCCESS )
+  {
+    GATT_bm_free( (gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI );
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      gattServApp_SendBuf
+ *
+ * @brief   Send a filled notification or indication buffer. The buffer
+ *          is owned by the stack on success, and by the caller otherwise.
+ *
+ * @param   connHandle - connection handle.
+ * @param   cccValue - client characteristic configuration value.
+ * @param   authenticated - whether an authenticated link is required.
+ * @param   pNoti - notification to send.
+ * @param   taskId - task to be notified of confirmation.
+ *
+ * @return  Success or Failure
+ */
+static bStatus_t gattServApp_SendBuf( uint16 connHandle, uint8 cccValue,
+                                      uint8 authenticated, attHandleValueNoti_t *pNoti,
+                                      uint8 taskId )
+{
+  if ( cccValue & GATT_CLIENT_CFG_NOTIFY )
+  {
+    return ( GATT_Notification( connHandle, pNoti, authenticated ) );
+  }
+  else // GATT_CLIENT_CFG_INDICATE
+  {
+    return ( GATT_Indication( connHandle, (attHandleValueInd_t *)pNoti,
+                              authenticated, taskId ) );
+  }
+}
+
+/****************************************************************************
+****************************************************************************/
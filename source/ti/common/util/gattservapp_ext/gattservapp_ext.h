@@ -0,0 +1,195 @@
+/**********************************************************************************************
+ * Filename:       gattservapp_ext.h
+ *
+ * Description:    This file contains GATT Server Application helpers built only on
+ *                 the public GATTServApp, GATT and linkDB API, for use with either
+ *                 stack.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef GATTSERVAPP_EXT_H
+#define GATTSERVAPP_EXT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "icall_ble_api.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Handler index of an attribute without handlers
+#define GATTSERVAPP_NO_HANDLER          0xFF
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ * Read and write handlers of one attribute, identified by the value
+ * pointer it has in the attribute table.
+ */
+typedef struct
+{
+  uint8 *pValue;                        //!< Attribute value pointer in the table
+  pfnGATTReadAttrCB_t pfnReadAttrCB;    //!< Read handler, NULL if not read here
+  pfnGATTWriteAttrCB_t pfnWriteAttrCB;  //!< Write handler, NULL if not written here
+} gattServAppAttrHandler_t;
+
+/**
+ * Attribute handlers of a service, indexed by attribute handle.
+ */
+typedef struct
+{
+  uint16 startHandle;                         //!< Handle of the first attribute
+  uint16 numAttrs;                            //!< Number of attributes
+  const gattServAppAttrHandler_t *pHandlers;  //!< Attribute handlers
+  uint8 *pHandlerIdx;                         //!< Handler index of each attribute
+} gattServAppAttrDispatch_t;
+
+/*********************************************************************
+ * VARIABLES
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/**
+ * @brief   Process Client Characteristic Configuration change, reading
+ *          the characteristic value once for all subscribed clients.
+ *
+ *          Unlike GATTServApp_ProcessCharCfg(), pfnReadAttrCB is called
+ *          once and the serialised value is copied into the notification
+ *          or indication of every client. It is only called again for a
+ *          client whose ATT_MTU allows more of a truncated value. Use it
+ *          only when the read callback returns the same value regardless
+ *          of the connection.
+ *
+ * @param   charCfgTbl - characteristic configuration table.
+ * @param   pValue - pointer to attribute value.
+ * @param   authenticated - whether an authenticated link is required.
+ * @param   attrTbl - attribute table.
+ * @param   numAttrs - number of attributes in attribute table.
+ * @param   taskId - task to be notified of confirmation.
+ * @param   pfnReadAttrCB - read callback function pointer.
+ * @param   pConnStatus - optional array of linkDBNumConns entries, one
+ *                        per charCfgTbl entry, receiving the status of
+ *                        each client. SUCCESS for entries without a
+ *                        subscribed client. May be NULL.
+ *
+ * @return  SUCCESS if the value was sent to every subscribed client,
+ *          otherwise the status of the first client that failed.
+ */
+extern bStatus_t GATTServApp_ProcessCharCfgFanOut( gattCharCfg_t *charCfgTbl,
+                                                   uint8 *pValue,
+                                                   uint8 authenticated,
+                                                   gattAttribute_t *attrTbl,
+                                                   uint16 numAttrs, uint8 taskId,
+                                                   pfnGATTReadAttrCB_t pfnReadAttrCB,
+                                                   bStatus_t *pConnStatus );
+
+/**
+ * @brief   Map the attribute handles of a registered service to their
+ *          handlers. Call once GATTServApp_RegisterService() has
+ *          assigned the handles.
+ *
+ * @param   pDispatch - dispatch table to initialize.
+ * @param   pAttrTbl - registered attribute table.
+ * @param   numAttrs - number of attributes in attribute table.
+ * @param   pHandlers - attribute handlers, at most 0xFE.
+ * @param   numHandlers - number of attribute handlers.
+ * @param   pHandlerIdx - storage for numAttrs handler indexes.
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or FAILURE if the service has no
+ *          contiguous handle range.
+ */
+extern bStatus_t GATTServApp_InitAttrDispatch( gattServAppAttrDispatch_t *pDispatch,
+                                               gattAttribute_t *pAttrTbl,
+                                               uint16 numAttrs,
+                                               const gattServAppAttrHandler_t *pHandlers,
+                                               uint8 numHandlers,
+                                               uint8 *pHandlerIdx );
+
+/**
+ * @brief   Find the handlers of an attribute.
+ *
+ * @param   pDispatch - dispatch table.
+ * @param   pAttr - pointer to attribute.
+ *
+ * @return  Pointer to the attribute handlers. NULL, if none.
+ */
+extern const gattServAppAttrHandler_t *GATTServApp_FindAttrHandler( const gattServAppAttrDispatch_t *pDispatch,
+                                                                    gattAttribute_t *pAttr );
+
+/**
+ * @brief   Call the read handler of an attribute.
+ *
+ * @return  Status of the read handler. ATT_ERR_ATTR_NOT_FOUND, if the
+ *          attribute has no read handler.
+ */
+extern bStatus_t GATTServApp_DispatchReadAttr( const gattServAppAttrDispatch_t *pDispatch,
+                                               uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 *pValue, uint16 *pLen, uint16 offset,
+                                               uint16 maxLen, uint8 method );
+
+/**
+ * @brief   Call the write handler of an attribute.
+ *
+ * @return  Status of the write handler. ATT_ERR_ATTR_NOT_FOUND, if the
+ *          attribute has no write handler.
+ */
+extern bStatus_t GATTServApp_DispatchWriteAttr( const gattServAppAttrDispatch_t *pDispatch,
+                                                uint16 connHandle, gattAttribute_t *pAttr,
+                                                uint8 *pValue, uint16 len, uint16 offset,
+                                                uint8 method );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GATTSERVAPP_EXT_H */
@@ -0,0 +1,279 @@
+/**********************************************************************************************
+ * Filename:       gatt_uuid_bench.c
+ *
+ * Description:    Host check and benchmark of the BLE stack GATT UUID record lookup.
+ *                 Every 16-bit record must resolve, registered 128-bit tables must
+ *                 resolve to their own storage, and the lookup time is reported.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "icall_ble_api.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+// 128-bit UUID tables registered by the check, all the stack can hold
+#define BENCH_NUM_TBLS              4
+#define BENCH_UUIDS_PER_TBL         4
+
+// Lookups timed per case
+#define BENCH_LOOKUPS               2000000
+
+#define BENCH_CHECK(cond)                                                  \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("  FAIL: %s (line %d)\n", #cond, __LINE__);             \
+            benchFailed++;                                                 \
+        }                                                                  \
+    } while (0)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static int benchFailed;
+
+// Every 16-bit UUID the stack keeps a record for
+static const uint16_t benchUUID16[] =
+{
+    GAP_SERVICE_UUID, GATT_SERVICE_UUID,
+    GATT_PRIMARY_SERVICE_UUID, GATT_SECONDARY_SERVICE_UUID, GATT_INCLUDE_UUID,
+    GATT_CHARACTER_UUID,
+    GATT_CHAR_EXT_PROPS_UUID, GATT_CHAR_USER_DESC_UUID, GATT_CLIENT_CHAR_CFG_UUID,
+    GATT_SERV_CHAR_CFG_UUID, GATT_CHAR_FORMAT_UUID, GATT_CHAR_AGG_FORMAT_UUID,
+    GATT_VALID_RANGE_UUID, GATT_EXT_REPORT_REF_UUID, GATT_REPORT_REF_UUID,
+    DEVICE_NAME_UUID, APPEARANCE_UUID, PERI_PRIVACY_FLAG_UUID, RECONNECT_ADDR_UUID,
+    PERI_CONN_PARAM_UUID, SERVICE_CHANGED_UUID, CENTRAL_ADDRESS_RESOLUTION_UUID,
+};
+
+#define BENCH_NUM_UUID16 (sizeof(benchUUID16) / sizeof(benchUUID16[0]))
+
+// 16-bit UUIDs without a record
+static const uint16_t benchMissUUID16[] = { 0x0000, 0x1802, 0x2A06, 0x2A19, 0xFFFF };
+
+// Vendor UUID records, in the style of a profile's 128-bit UUIDs
+static uint8_t benchUUID128[BENCH_NUM_TBLS][BENCH_UUIDS_PER_TBL][ATT_UUID_SIZE];
+static const uint8_t *benchTbls[BENCH_NUM_TBLS + 1][BENCH_UUIDS_PER_TBL];
+
+// Keeps the timed lookups from being optimised out
+static volatile uintptr_t benchSink;
+
+/*********************************************************************
+ * @fn      Bench_nowNs
+ */
+static uint64_t Bench_nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      Bench_makeUUID128
+ *
+ * @brief   Builds a TI base vendor UUID, the same copy must be found by
+ *          content only.
+ */
+static void Bench_makeUUID128(uint8_t *pUUID, uint16_t uuid)
+{
+    const uint8_t base[ATT_UUID_SIZE] = { TI_BASE_UUID_128(uuid) };
+
+    memcpy(pUUID, base, ATT_UUID_SIZE);
+}
+
+/*********************************************************************
+ * @fn      Bench_check16
+ */
+static void Bench_check16(void)
+{
+    uint8_t i;
+
+    printf("16-bit records\n");
+
+    for (i = 0; i < BENCH_NUM_UUID16; i++)
+    {
+        uint8_t uuid[ATT_BT_UUID_SIZE] = { LO_UINT16(benchUUID16[i]), HI_UINT16(benchUUID16[i]) };
+        const uint8 *pRec = GATT_FindUUIDRec(uuid, ATT_BT_UUID_SIZE);
+
+        BENCH_CHECK((pRec != NULL) && (pRec != uuid) && !memcmp(pRec, uuid, ATT_BT_UUID_SIZE));
+    }
+
+    for (i = 0; i < sizeof(benchMissUUID16) / sizeof(benchMissUUID16[0]); i++)
+    {
+        uint8_t uuid[ATT_BT_UUID_SIZE] = { LO_UINT16(benchMissUUID16[i]),
+                                           HI_UINT16(benchMissUUID16[i]) };
+
+        BENCH_CHECK(GATT_FindUUIDRec(uuid, ATT_BT_UUID_SIZE) == NULL);
+    }
+
+    // Only 16 and 128-bit UUIDs have records
+    BENCH_CHECK(GATT_FindUUIDRec(benchUUID128[0][0], 4) == NULL);
+
+    printf("  %u records found, %u unknown UUIDs missed\n", (unsigned)BENCH_NUM_UUID16,
+           (unsigned)(sizeof(benchMissUUID16) / sizeof(benchMissUUID16[0])));
+}
+
+/*********************************************************************
+ * @fn      Bench_check128
+ */
+static void Bench_check128(void)
+{
+    uint8_t query[ATT_UUID_SIZE];
+    uint8_t t, u;
+
+    printf("128-bit records\n");
+
+    // Nothing resolves before registration
+    memcpy(query, benchUUID128[0][0], ATT_UUID_SIZE);
+    BENCH_CHECK(GATT_FindUUIDRec(query, ATT_UUID_SIZE) == NULL);
+
+    BENCH_CHECK(GATT_RegisterUUID128Tbl(NULL, 1) == INVALIDPARAMETER);
+    BENCH_CHECK(GATT_RegisterUUID128Tbl(benchTbls[0], 0) == INVALIDPARAMETER);
+
+    for (t = 0; t < BENCH_NUM_TBLS; t++)
+    {
+        BENCH_CHECK(GATT_RegisterUUID128Tbl(benchTbls[t], BENCH_UUIDS_PER_TBL) == SUCCESS);
+    }
+
+    // Registering again is harmless, a table more is refused
+    BENCH_CHECK(GATT_RegisterUUID128Tbl(benchTbls[0], BENCH_UUIDS_PER_TBL) == SUCCESS);
+    BENCH_CHECK(GATT_RegisterUUID128Tbl(benchTbls[BENCH_NUM_TBLS], BENCH_UUIDS_PER_TBL) ==
+                bleNoResources);
+
+    // A copy of each UUID resolves to the registered storage
+    for (t = 0; t < BENCH_NUM_TBLS; t++)
+    {
+        for (u = 0; u < BENCH_UUIDS_PER_TBL; u++)
+        {
+            memcpy(query, benchUUID128[t][u], ATT_UUID_SIZE);
+            BENCH_CHECK(GATT_FindUUIDRec(query, ATT_UUID_SIZE) == benchUUID128[t][u]);
+        }
+    }
+
+    // The base with a different 16-bit part is not a match
+    Bench_makeUUID128(query, 0xBEEF);
+    BENCH_CHECK(GATT_FindUUIDRec(query, ATT_UUID_SIZE) == NULL);
+
+    // A deregistered table no longer resolves, the others still do
+    BENCH_CHECK(GATT_DeregisterUUID128Tbl(benchTbls[1]) == SUCCESS);
+    BENCH_CHECK(GATT_DeregisterUUID128Tbl(benchTbls[1]) == INVALIDPARAMETER);
+    memcpy(query, benchUUID128[1][2], ATT_UUID_SIZE);
+    BENCH_CHECK(GATT_FindUUIDRec(query, ATT_UUID_SIZE) == NULL);
+    memcpy(query, benchUUID128[2][2], ATT_UUID_SIZE);
+    BENCH_CHECK(GATT_FindUUIDRec(query, ATT_UUID_SIZE) == benchUUID128[2][2]);
+
+    // The freed slot takes a new table
+    BENCH_CHECK(GATT_RegisterUUID128Tbl(benchTbls[1], BENCH_UUIDS_PER_TBL) == SUCCESS);
+
+    printf("  %u tables of %u UUIDs registered and resolved\n",
+           BENCH_NUM_TBLS, BENCH_UUIDS_PER_TBL);
+}
+
+/*********************************************************************
+ * @fn      Bench_time
+ *
+ * @brief   Times lookups of a set of UUIDs, in turn.
+ */
+static void Bench_time(const char *pName, const uint8_t *pUUIDs, uint8_t numUUIDs, uint8_t len)
+{
+    uint64_t start = Bench_nowNs();
+    uint32_t i;
+
+    for (i = 0; i < BENCH_LOOKUPS; i++)
+    {
+        benchSink += (uintptr_t)GATT_FindUUIDRec(&pUUIDs[(i % numUUIDs) * len], len);
+    }
+
+    printf("  %-26s %6.1f ns/lookup\n", pName,
+           (double)(Bench_nowNs() - start) / BENCH_LOOKUPS);
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main(void)
+{
+    static uint8_t uuid16[BENCH_NUM_UUID16][ATT_BT_UUID_SIZE];
+    static uint8_t uuid128[BENCH_NUM_TBLS * BENCH_UUIDS_PER_TBL][ATT_UUID_SIZE];
+    static uint8_t miss128[BENCH_UUIDS_PER_TBL][ATT_UUID_SIZE];
+    uint8_t t, u;
+
+    for (t = 0; t <= BENCH_NUM_TBLS; t++)
+    {
+        for (u = 0; u < BENCH_UUIDS_PER_TBL; u++)
+        {
+            if (t < BENCH_NUM_TBLS)
+            {
+                Bench_makeUUID128(benchUUID128[t][u], 0xC000 + (t << 4) + u);
+                benchTbls[t][u] = benchUUID128[t][u];
+                memcpy(uuid128[t * BENCH_UUIDS_PER_TBL + u], benchUUID128[t][u], ATT_UUID_SIZE);
+            }
+            else
+            {
+                benchTbls[t][u] = benchUUID128[0][u];
+                Bench_makeUUID128(miss128[u], 0xD000 + u);
+            }
+        }
+    }
+
+    for (t = 0; t < BENCH_NUM_UUID16; t++)
+    {
+        uuid16[t][0] = LO_UINT16(benchUUID16[t]);
+        uuid16[t][1] = HI_UINT16(benchUUID16[t]);
+    }
+
+    Bench_check16();
+    Bench_check128();
+
+    printf("lookup time\n");
+    Bench_time("16-bit, all records", &uuid16[0][0], BENCH_NUM_UUID16, ATT_BT_UUID_SIZE);
+    Bench_time("128-bit, all tables", &uuid128[0][0],
+               BENCH_NUM_TBLS * BENCH_UUIDS_PER_TBL, ATT_UUID_SIZE);
+    Bench_time("128-bit, not registered", &miss128[0][0], BENCH_UUIDS_PER_TBL, ATT_UUID_SIZE);
+
+    printf(benchFailed ? "FAILED\n" : "PASSED\n");
+
+    return benchFailed ? 1 : 0;
+}
@@ -0,0 +1,349 @@
+/**********************************************************************************************
+ * Filename:       fanout_test.c
+ *
+ * Description:    Host check of GATTServApp_ProcessCharCfgFanOut. The battery service
+ *                 notifies its level to several clients on a simulated link, and a
+ *                 long value is fanned out over links of different ATT_MTU.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "ble_sim.h"
+#include "gattservapp_ext.h"
+#include "battservice.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+#define TEST_HEAP_SIZE              4096
+#define TEST_TX_BUFFERS             8
+#define TEST_NUM_LINKS              3
+
+// Long characteristic value, above the payload of a default ATT_MTU
+#define TEST_LONG_LEN               100
+
+#define TEST_CHECK(cond)                                                   \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("  FAIL: %s (line %d)\n", #cond, __LINE__);             \
+            testFailed++;                                                  \
+        }                                                                  \
+    } while (0)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Notifications received by the client of a link
+typedef struct
+{
+    uint16_t count;
+    uint16_t handle;
+    uint16_t len;
+    uint8_t  value[TEST_LONG_LEN];
+} TestRx_t;
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+extern CONST uint8_t battLevelUUID[];
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static int      testFailed;
+static TestRx_t testRx[BLESIM_MAX_LINKS];
+
+// Battery voltage returned to the battery service, 8 fractional bits
+static uint32_t testVoltage = (3 << 8) + 0x40;
+static uint32_t testVoltageReads;
+
+// Long value service
+static uint8_t        testServUUID[ATT_BT_UUID_SIZE]  = { 0xF0, 0xFF };
+static uint8_t        testValueUUID[ATT_BT_UUID_SIZE] = { 0xF1, 0xFF };
+static gattAttrType_t testService = { ATT_BT_UUID_SIZE, testServUUID };
+static uint8_t        testValueProps = GATT_PROP_NOTIFY;
+static uint8_t        testValue[TEST_LONG_LEN];
+static gattCharCfg_t *testValueConfig;
+static uint16_t       testValueReads;
+
+static gattAttribute_t testAttrTbl[] =
+{
+    { { ATT_BT_UUID_SIZE, primaryServiceUUID }, GATT_PERMIT_READ, 0, (uint8_t *)&testService },
+    { { ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &testValueProps },
+    { { ATT_BT_UUID_SIZE, testValueUUID }, 0, 0, testValue },
+    { { ATT_BT_UUID_SIZE, clientCharCfgUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0,
+      (uint8_t *)&testValueConfig },
+};
+
+/*********************************************************************
+ * Stack and profile callbacks
+ */
+
+uint32_t AONBatMonBatteryVoltageGet(void)
+{
+    testVoltageReads++;
+
+    return testVoltage;
+}
+
+static void Test_notification(uint16_t connHandle, attHandleValueNoti_t *pNoti)
+{
+    TestRx_t *pRx = &testRx[connHandle];
+
+    pRx->count++;
+    pRx->handle = pNoti->handle;
+    pRx->len    = pNoti->len;
+    memcpy(pRx->value, pNoti->pValue, (pNoti->len < TEST_LONG_LEN) ? pNoti->len : TEST_LONG_LEN);
+}
+
+static const BleSim_Callbacks_t testSimCBs =
+{
+    Test_notification,
+    NULL,
+    NULL
+};
+
+static bStatus_t Test_readAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                 uint8_t *pValue, uint16_t *pLen, uint16_t offset,
+                                 uint16_t maxLen, uint8_t method)
+{
+    (void)connHandle;
+    (void)method;
+
+    testValueReads++;
+
+    *pLen = (maxLen < TEST_LONG_LEN) ? maxLen : TEST_LONG_LEN;
+    memcpy(pValue, pAttr->pValue + offset, *pLen);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * Tests
+ */
+
+/*********************************************************************
+ * @fn      Test_connect
+ *
+ * @brief   Resets the simulation and connects a client per ATT_MTU.
+ */
+static void Test_connect(const uint16_t *pMtu)
+{
+    uint8_t i;
+
+    BleSim_init(TEST_HEAP_SIZE, TEST_TX_BUFFERS, 1, &testSimCBs);
+    memset(testRx, 0, sizeof(testRx));
+
+    for (i = 0; i < TEST_NUM_LINKS; i++)
+    {
+        BleSim_LinkParams_t params = { pMtu[i], 251, 7500, 4, 0.0 };
+
+        BleSim_connect(&params, i + 1);
+    }
+}
+
+/*********************************************************************
+ * @fn      Test_enableNotifications
+ *
+ * @brief   Writes the CCC from the client of a link.
+ */
+static void Test_enableNotifications(uint16_t connHandle, uint16_t cccHandle)
+{
+    uint8_t cfg[2] = { LO_UINT16(GATT_CLIENT_CFG_NOTIFY), HI_UINT16(GATT_CLIENT_CFG_NOTIFY) };
+    attWriteReq_t req;
+
+    BleSim_setRole(BLESIM_CENTRAL);
+
+    req.handle = cccHandle;
+    req.len    = sizeof(cfg);
+    req.pValue = GATT_bm_alloc(connHandle, ATT_WRITE_CMD, req.len, NULL);
+    req.sig    = FALSE;
+    req.cmd    = TRUE;
+    memcpy(req.pValue, cfg, req.len);
+
+    if (GATT_WriteNoRsp(connHandle, &req) != SUCCESS)
+    {
+        GATT_bm_free((gattMsg_t *)&req, ATT_WRITE_CMD);
+    }
+}
+
+/*********************************************************************
+ * @fn      Test_battLevel
+ *
+ * @brief   The battery level is measured and read once whatever the
+ *          number of subscribed clients, and every one of them is
+ *          notified.
+ */
+static void Test_battLevel(void)
+{
+    static const uint16_t mtu[TEST_NUM_LINKS] = { 23, 185, 247 };
+    uint16_t cccHandle, valueHandle;
+    uint8_t level;
+    uint8_t i;
+
+    printf("battery level fan-out\n");
+
+    Test_connect(mtu);
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    Batt_AddService();
+
+    valueHandle = BleSim_findAttrHandle(battLevelUUID, ATT_BT_UUID_SIZE);
+    cccHandle   = BleSim_findAttrHandle(clientCharCfgUUID, ATT_BT_UUID_SIZE);
+
+    for (i = 0; i < TEST_NUM_LINKS; i++)
+    {
+        Test_enableNotifications(i, cccHandle);
+    }
+    BleSim_runUntil(BleSim_now() + 20000);
+
+    // A lower voltage brings the level down from 100 % and notifies it
+    testVoltage      = 3 << 8;
+    testVoltageReads = 0;
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    Batt_MeasLevel();
+    BleSim_runUntil(BleSim_now() + 20000);
+
+    Batt_GetParameter(BATT_PARAM_LEVEL, &level);
+
+    printf("  level %u %%, %u voltage reads for %u clients\n",
+           level, testVoltageReads, TEST_NUM_LINKS);
+
+    TEST_CHECK(level < 100);
+    // One read to measure, one read to serialise the notification
+    TEST_CHECK(testVoltageReads == 2);
+
+    for (i = 0; i < TEST_NUM_LINKS; i++)
+    {
+        TEST_CHECK(testRx[i].count == 1);
+        TEST_CHECK(testRx[i].handle == valueHandle);
+        TEST_CHECK((testRx[i].len == 1) && (testRx[i].value[0] == level));
+    }
+}
+
+/*********************************************************************
+ * @fn      Test_longValue
+ *
+ * @brief   A value truncated to the first client's ATT_MTU is read again
+ *          for a client with a larger one, and copied otherwise.
+ */
+static void Test_longValue(const char *pName, const uint16_t *pMtu, uint16_t expectedReads)
+{
+    bStatus_t connStatus[BLESIM_MAX_LINKS];
+    bStatus_t status;
+    uint8_t i;
+
+    printf("long value fan-out, %s\n", pName);
+
+    Test_connect(pMtu);
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    testValueConfig = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) * linkDBNumConns);
+    GATTServApp_InitCharCfg(CONNHANDLE_INVALID, testValueConfig);
+    GATTServApp_RegisterService(testAttrTbl, GATT_NUM_ATTRS(testAttrTbl),
+                                GATT_MAX_ENCRYPT_KEY_SIZE, NULL);
+
+    // Subscribe the clients directly, the CCC write path is covered above
+    for (i = 0; i < TEST_NUM_LINKS; i++)
+    {
+        GATTServApp_WriteCharCfg(i, testValueConfig, GATT_CLIENT_CFG_NOTIFY);
+    }
+
+    for (i = 0; i < TEST_LONG_LEN; i++)
+    {
+        testValue[i] = i;
+    }
+    testValueReads = 0;
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    status = GATTServApp_ProcessCharCfgFanOut(testValueConfig, testValue, FALSE,
+                                              testAttrTbl, GATT_NUM_ATTRS(testAttrTbl),
+                                              INVALID_TASK_ID, Test_readAttrCB, connStatus);
+    BleSim_runUntil(BleSim_now() + 20000);
+
+    printf("  status 0x%02X, %u reads, lengths", status, testValueReads);
+    for (i = 0; i < TEST_NUM_LINKS; i++)
+    {
+        printf(" %u", testRx[i].len);
+    }
+    printf("\n");
+
+    TEST_CHECK(status == SUCCESS);
+    TEST_CHECK(testValueReads == expectedReads);
+
+    for (i = 0; i < TEST_NUM_LINKS; i++)
+    {
+        uint16_t len = ((pMtu[i] - 3) < TEST_LONG_LEN) ? (pMtu[i] - 3) : TEST_LONG_LEN;
+
+        TEST_CHECK(connStatus[i] == SUCCESS);
+        TEST_CHECK(testRx[i].count == 1);
+        TEST_CHECK(testRx[i].len == len);
+        TEST_CHECK(!memcmp(testRx[i].value, testValue, len));
+    }
+
+    GATTServApp_DeregisterService(testAttrTbl[0].handle, NULL);
+    ICall_free(testValueConfig);
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main(void)
+{
+    static const uint16_t largeFirst[TEST_NUM_LINKS] = { 247, 23, 185 };
+    static const uint16_t smallFirst[TEST_NUM_LINKS] = { 23, 247, 185 };
+
+    Test_battLevel();
+
+    // The whole value fits the first client's buffer, it is only copied
+    Test_longValue("largest ATT_MTU first", largeFirst, 1);
+
+    // Truncated for the first client, read again for each larger one
+    Test_longValue("smallest ATT_MTU first", smallFirst, 3);
+
+    printf(testFailed ? "FAILED\n" : "PASSED\n");
+
+    return testFailed ? 1 : 0;
+}
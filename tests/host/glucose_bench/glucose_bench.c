@@ -0,0 +1,868 @@
+/**********************************************************************************************
+ * Filename:       glucose_bench.c
+ *
+ * Description:    Record Access Control Point benchmark of the BLE5 glucose sensor.
+ *                 The record store is filled with synthetic records by GlucoseGen_fill
+ *                 on the simulated NVS flash, and every RACP opcode, operator and
+ *                 filter type is sent to GlucoseSensor_processCtlPntMsg. The records
+ *                 are reported to a central over sim/ble_sim.c and the benchmark reports
+ *                 the CPU time of the application, the notifications and indications
+ *                 received and the flash reads of each request.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ble_sim.h"
+#include "nvs_sim.h"
+
+// The control point handling of the application is static, so the
+// application is built into the benchmark.
+#include "glucose.c"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+// Heap of each device
+#define BENCH_HEAP_SIZE             8192
+
+// Controller TX buffers of each device
+#define BENCH_TX_BUFFERS            8
+
+// Record store flash, the largest region the NVS simulation has
+#define BENCH_SECTOR_SIZE           4096
+#define BENCH_NUM_SECTORS           16
+
+// Default shape of the synthetic records
+#define BENCH_NUM_RECORDS           1000
+#define BENCH_PERIOD_S              300
+#define BENCH_CONTEXT_EVERY         2
+#define BENCH_GAP_EVERY             10
+
+// Start of the synthetic timestamps, 2020-01-01 00:00:00
+#define BENCH_START_YEAR            2020
+
+// Longest a request may take on the link
+#define BENCH_TIMEOUT_US            600000000ULL
+
+// Connection events run before the abort of a report in progress is sent
+#define BENCH_ABORT_AFTER_EVENTS    2
+
+// Operands of a case
+#define BENCH_OPERAND_NONE          0
+#define BENCH_OPERAND_SEQNUM        1   // Sequence numbers of the records
+#define BENCH_OPERAND_TIME          2   // Timestamps of the records
+#define BENCH_OPERAND_REVERSED      3   // Sequence number range, upper bound first
+#define BENCH_OPERAND_BAD_FILTER    4   // Sequence number with an unknown filter type
+#define BENCH_OPERAND_BAD_TIME      5   // Timestamp with month 13
+
+// Filter type the profile doesn't define
+#define BENCH_FILTER_UNKNOWN        3
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// A control point request and the response expected to it
+typedef struct
+{
+    const char *name;
+    uint8_t     opcode;
+    uint8_t     oper;
+    uint8_t     operand;        // BENCH_OPERAND_*
+    uint8_t     rejectCode;     // Response code of a rejected request, 0 if
+                                // the response follows from the records
+    bool        abort;          // Abort the report after a few events
+} BenchCase_t;
+
+// What the central received for a request
+typedef struct
+{
+    uint32_t measNotis;
+    uint32_t contextNotis;
+    uint32_t indications;
+    uint32_t badRecords;        // Records outside the filter, out of order, or
+                                // contexts of another record
+    uint16_t lastSeqNum;
+    bool     done;              // Response to the request received
+    uint8_t  rsp[GLUCOSE_CTL_PNT_LEN];
+} BenchRx_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const BenchCase_t benchCases[] =
+{
+    { "REQ null",               CTL_PNT_OP_REQ,     CTL_PNT_OPER_NULL,          BENCH_OPERAND_NONE,       CTL_PNT_RSP_OPER_INVALID },
+    { "REQ all",                CTL_PNT_OP_REQ,     CTL_PNT_OPER_ALL,           BENCH_OPERAND_NONE },
+    { "REQ <= seq",             CTL_PNT_OP_REQ,     CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_SEQNUM },
+    { "REQ <= time",            CTL_PNT_OP_REQ,     CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_TIME },
+    { "REQ >= seq",             CTL_PNT_OP_REQ,     CTL_PNT_OPER_GREATER_EQUAL, BENCH_OPERAND_SEQNUM },
+    { "REQ >= time",            CTL_PNT_OP_REQ,     CTL_PNT_OPER_GREATER_EQUAL, BENCH_OPERAND_TIME },
+    { "REQ range seq",          CTL_PNT_OP_REQ,     CTL_PNT_OPER_RANGE,         BENCH_OPERAND_SEQNUM },
+    { "REQ range time",         CTL_PNT_OP_REQ,     CTL_PNT_OPER_RANGE,         BENCH_OPERAND_TIME },
+    { "REQ first",              CTL_PNT_OP_REQ,     CTL_PNT_OPER_FIRST,         BENCH_OPERAND_NONE },
+    { "REQ last",               CTL_PNT_OP_REQ,     CTL_PNT_OPER_LAST,          BENCH_OPERAND_NONE },
+    { "GET_NUM null",           CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_NULL,          BENCH_OPERAND_NONE,       CTL_PNT_RSP_OPER_INVALID },
+    { "GET_NUM all",            CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_ALL,           BENCH_OPERAND_NONE },
+    { "GET_NUM <= seq",         CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_SEQNUM },
+    { "GET_NUM <= time",        CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_TIME },
+    { "GET_NUM >= seq",         CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_GREATER_EQUAL, BENCH_OPERAND_SEQNUM },
+    { "GET_NUM >= time",        CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_GREATER_EQUAL, BENCH_OPERAND_TIME },
+    { "GET_NUM range seq",      CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_RANGE,         BENCH_OPERAND_SEQNUM },
+    { "GET_NUM range time",     CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_RANGE,         BENCH_OPERAND_TIME },
+    { "GET_NUM first",          CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_FIRST,         BENCH_OPERAND_NONE },
+    { "GET_NUM last",           CTL_PNT_OP_GET_NUM, CTL_PNT_OPER_LAST,          BENCH_OPERAND_NONE },
+    { "CLR null",               CTL_PNT_OP_CLR,     CTL_PNT_OPER_NULL,          BENCH_OPERAND_NONE,       CTL_PNT_RSP_OPER_INVALID },
+    { "CLR all",                CTL_PNT_OP_CLR,     CTL_PNT_OPER_ALL,           BENCH_OPERAND_NONE },
+    { "CLR <= seq",             CTL_PNT_OP_CLR,     CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_SEQNUM },
+    { "CLR <= time",            CTL_PNT_OP_CLR,     CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_TIME },
+    { "CLR >= seq",             CTL_PNT_OP_CLR,     CTL_PNT_OPER_GREATER_EQUAL, BENCH_OPERAND_SEQNUM },
+    { "CLR >= time",            CTL_PNT_OP_CLR,     CTL_PNT_OPER_GREATER_EQUAL, BENCH_OPERAND_TIME },
+    { "CLR range seq",          CTL_PNT_OP_CLR,     CTL_PNT_OPER_RANGE,         BENCH_OPERAND_SEQNUM },
+    { "CLR range time",         CTL_PNT_OP_CLR,     CTL_PNT_OPER_RANGE,         BENCH_OPERAND_TIME },
+    { "CLR first",              CTL_PNT_OP_CLR,     CTL_PNT_OPER_FIRST,         BENCH_OPERAND_NONE },
+    { "CLR last",               CTL_PNT_OP_CLR,     CTL_PNT_OPER_LAST,          BENCH_OPERAND_NONE },
+    { "ABORT null",             CTL_PNT_OP_ABORT,   CTL_PNT_OPER_NULL,          BENCH_OPERAND_NONE,       CTL_PNT_RSP_SUCCESS },
+    { "ABORT all",              CTL_PNT_OP_ABORT,   CTL_PNT_OPER_ALL,           BENCH_OPERAND_NONE,       CTL_PNT_RSP_OPER_INVALID },
+    { "ABORT report",           CTL_PNT_OP_ABORT,   CTL_PNT_OPER_NULL,          BENCH_OPERAND_NONE,       CTL_PNT_RSP_SUCCESS, TRUE },
+    { "REQ range reversed",     CTL_PNT_OP_REQ,     CTL_PNT_OPER_RANGE,         BENCH_OPERAND_REVERSED,   CTL_PNT_RSP_OPERAND_INVALID },
+    { "REQ <= unknown filter",  CTL_PNT_OP_REQ,     CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_BAD_FILTER, CTL_PNT_RSP_FILTER_NOT_SUPPORTED },
+    { "REQ <= bad time",        CTL_PNT_OP_REQ,     CTL_PNT_OPER_LESS_EQUAL,    BENCH_OPERAND_BAD_TIME,   CTL_PNT_RSP_NO_RECORDS },
+    { "REQ first with operand", CTL_PNT_OP_REQ,     CTL_PNT_OPER_FIRST,         BENCH_OPERAND_SEQNUM,     CTL_PNT_RSP_OPERAND_INVALID },
+    { "REQ unknown operator",   CTL_PNT_OP_REQ,     CTL_PNT_OPER_LAST + 1,      BENCH_OPERAND_NONE,       CTL_PNT_RSP_OPER_NOT_SUPPORTED },
+    { "unknown opcode",         CTL_PNT_OP_REQ_RSP + 1, CTL_PNT_OPER_ALL,       BENCH_OPERAND_NONE,       CTL_PNT_RSP_OPCODE_NOT_SUPPORTED },
+};
+
+#define BENCH_NUM_CASES             (sizeof(benchCases) / sizeof(benchCases[0]))
+
+// Shape of the synthetic records
+static glucoseGenParams_t benchGen;
+static uint16_t benchNumRecords = BENCH_NUM_RECORDS;
+
+// The glucose service needs an encrypted link to enable its notifications
+static BleSim_LinkParams_t benchLink = { 23, 27, 30000, 4, 0.0, TRUE };
+
+static uint16_t benchConnHandle;
+static uint16_t benchMeasHandle;
+static uint16_t benchContextHandle;
+static uint16_t benchCtlPntHandle;
+
+// Request being run and what it selects
+static const BenchCase_t *pBenchCase;
+static glucoseStoreFilter_t benchFilter;
+static BenchRx_t benchRx;
+
+// CPU time spent in the application
+static uint64_t benchCpuNs;
+
+static int benchFailed;
+
+/*********************************************************************
+ * @fn      Bench_cpuNs
+ */
+static uint64_t Bench_cpuNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      Bench_recordExists
+ *
+ * @brief   Whether the synthetic record with the given index is in the
+ *          store, that is, it wasn't deleted again by GlucoseGen_fill.
+ */
+static bool Bench_recordExists(uint16_t index)
+{
+    return (index < benchNumRecords) &&
+           ((benchGen.gapEvery == 0) ||
+            ((index % benchGen.gapEvery) != (benchGen.gapEvery - 1)));
+}
+
+/*********************************************************************
+ * @fn      Bench_seqNum
+ *
+ * @brief   Sequence number of a synthetic record. The store numbers the
+ *          records of an erased region from 1, deleted ones included.
+ */
+static uint16_t Bench_seqNum(uint16_t index)
+{
+    return index + 1;
+}
+
+/*********************************************************************
+ * @fn      Bench_time
+ */
+static UTCTime Bench_time(uint16_t index)
+{
+    return benchGen.startTime + (UTCTime)index * benchGen.period;
+}
+
+/*********************************************************************
+ * @fn      Bench_selects
+ *
+ * @brief   Whether the filter of the request selects a synthetic record,
+ *          FIRST and LAST left aside.
+ */
+static bool Bench_selects(uint16_t index)
+{
+    uint32_t key;
+    uint32_t lo = 0;
+    uint32_t hi = UINT32_MAX;
+
+    if (benchFilter.filterType == CTL_PNT_FILTER_TIME)
+    {
+        key = Bench_time(index);
+        lo = benchFilter.time1;
+        hi = benchFilter.time2;
+    }
+    else
+    {
+        key = Bench_seqNum(index);
+        lo = benchFilter.seqNum1;
+        hi = benchFilter.seqNum2;
+    }
+
+    switch (benchFilter.oper)
+    {
+    case CTL_PNT_OPER_LESS_EQUAL:
+        return key <= lo;
+
+    case CTL_PNT_OPER_GREATER_EQUAL:
+        return key >= lo;
+
+    case CTL_PNT_OPER_RANGE:
+        return (key >= lo) && (key <= hi);
+
+    default:
+        return TRUE;
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_countSelected
+ *
+ * @brief   Count the records the request selects, and those of them with
+ *          a context.
+ */
+static uint16_t Bench_countSelected(uint16_t *pNumContexts)
+{
+    int32_t first = -1;
+    int32_t last = -1;
+    uint16_t count = 0;
+    uint16_t i;
+
+    *pNumContexts = 0;
+
+    for (i = 0; i < benchNumRecords; i++)
+    {
+        if (Bench_recordExists(i) && Bench_selects(i))
+        {
+            if (first < 0)
+            {
+                first = i;
+            }
+            last = i;
+            count++;
+
+            if ((benchGen.contextEvery != 0) && ((i % benchGen.contextEvery) == 0))
+            {
+                (*pNumContexts)++;
+            }
+        }
+    }
+
+    if ((count > 0) && ((benchFilter.oper == CTL_PNT_OPER_FIRST) ||
+                        (benchFilter.oper == CTL_PNT_OPER_LAST)))
+    {
+        i = (benchFilter.oper == CTL_PNT_OPER_FIRST) ? first : last;
+
+        count = 1;
+        *pNumContexts = ((benchGen.contextEvery != 0) &&
+                         ((i % benchGen.contextEvery) == 0)) ? 1 : 0;
+
+        // Only the one record is selected
+        benchFilter.filterType = CTL_PNT_FILTER_SEQNUM;
+        benchFilter.seqNum1 = Bench_seqNum(i);
+        benchFilter.seqNum2 = Bench_seqNum(i);
+        benchFilter.oper = CTL_PNT_OPER_RANGE;
+    }
+
+    return count;
+}
+
+/*********************************************************************
+ * @fn      Bench_putTime
+ *
+ * @brief   Write a timestamp in control point format, month and day
+ *          counting from 1.
+ */
+static uint8_t *Bench_putTime(uint8_t *p, UTCTime time, bool valid)
+{
+    UTCTimeStruct t;
+
+    UTC_convertUTCTime(&t, time);
+
+    *p++ = LO_UINT16(t.year);
+    *p++ = HI_UINT16(t.year);
+    *p++ = valid ? (t.month + 1) : 13;
+    *p++ = t.day + 1;
+    *p++ = t.hour;
+    *p++ = t.minutes;
+    *p++ = t.seconds;
+
+    return p;
+}
+
+/*********************************************************************
+ * @fn      Bench_buildMsg
+ *
+ * @brief   Build the control point message of a case, and the filter
+ *          the benchmark checks the records against. Operators with one
+ *          bound use the middle record, ranges the records a quarter and
+ *          three quarters into the store.
+ */
+static void Bench_buildMsg(const BenchCase_t *pCase, glucoseCtlPntMsg_t *pMsg)
+{
+    uint16_t lo = benchNumRecords / 4;
+    uint16_t hi = (3 * benchNumRecords) / 4;
+    uint8_t *p = pMsg->data;
+
+    if (pCase->oper != CTL_PNT_OPER_RANGE)
+    {
+        lo = benchNumRecords / 2;
+    }
+    if (pCase->operand == BENCH_OPERAND_REVERSED)
+    {
+        uint16_t swap = lo;
+
+        lo = hi;
+        hi = swap;
+    }
+
+    memset(&benchFilter, 0, sizeof(benchFilter));
+    benchFilter.oper = pCase->oper;
+
+    *p++ = pCase->opcode;
+    *p++ = pCase->oper;
+
+    switch (pCase->operand)
+    {
+    case BENCH_OPERAND_SEQNUM:
+    case BENCH_OPERAND_REVERSED:
+    case BENCH_OPERAND_BAD_FILTER:
+        *p++ = (pCase->operand == BENCH_OPERAND_BAD_FILTER) ? BENCH_FILTER_UNKNOWN :
+                                                              CTL_PNT_FILTER_SEQNUM;
+        *p++ = LO_UINT16(Bench_seqNum(lo));
+        *p++ = HI_UINT16(Bench_seqNum(lo));
+        if (pCase->oper == CTL_PNT_OPER_RANGE)
+        {
+            *p++ = LO_UINT16(Bench_seqNum(hi));
+            *p++ = HI_UINT16(Bench_seqNum(hi));
+        }
+
+        benchFilter.filterType = CTL_PNT_FILTER_SEQNUM;
+        benchFilter.seqNum1 = Bench_seqNum(lo);
+        benchFilter.seqNum2 = Bench_seqNum(hi);
+        break;
+
+    case BENCH_OPERAND_TIME:
+    case BENCH_OPERAND_BAD_TIME:
+        *p++ = CTL_PNT_FILTER_TIME;
+        p = Bench_putTime(p, Bench_time(lo), pCase->operand == BENCH_OPERAND_TIME);
+        if (pCase->oper == CTL_PNT_OPER_RANGE)
+        {
+            p = Bench_putTime(p, Bench_time(hi), TRUE);
+        }
+
+        benchFilter.filterType = CTL_PNT_FILTER_TIME;
+        benchFilter.time1 = Bench_time(lo);
+        benchFilter.time2 = Bench_time(hi);
+        break;
+
+    default:
+        break;
+    }
+
+    pMsg->len = p - pMsg->data;
+}
+
+/*********************************************************************
+ * @fn      Bench_notification
+ *
+ * @brief   Count the notifications and indications the central receives,
+ *          and check the records against the filter of the request.
+ */
+static void Bench_notification(uint16_t connHandle, attHandleValueNoti_t *pNoti)
+{
+    uint16_t seqNum = (pNoti->len >= 3) ? BUILD_UINT16(pNoti->pValue[1], pNoti->pValue[2]) : 0;
+
+    (void)connHandle;
+
+    if (pNoti->handle == benchMeasHandle)
+    {
+        // Records are reported in sequence number order, each once
+        if (((benchRx.measNotis > 0) && (seqNum <= benchRx.lastSeqNum)) ||
+            !Bench_recordExists(seqNum - 1) || !Bench_selects(seqNum - 1))
+        {
+            benchRx.badRecords++;
+        }
+        benchRx.lastSeqNum = seqNum;
+        benchRx.measNotis++;
+    }
+    else if (pNoti->handle == benchContextHandle)
+    {
+        // A context follows the measurement of its record
+        if ((benchRx.measNotis == 0) || (seqNum != benchRx.lastSeqNum))
+        {
+            benchRx.badRecords++;
+        }
+
+        benchRx.contextNotis++;
+    }
+    else if ((pNoti->handle == benchCtlPntHandle) && (pNoti->len == GLUCOSE_CTL_PNT_LEN))
+    {
+        benchRx.indications++;
+
+        // The response to the request ends it; an aborted report gets none
+        if ((pNoti->pValue[0] == CTL_PNT_OP_NUM_RSP) ||
+            (pNoti->pValue[2] == pBenchCase->opcode))
+        {
+            memcpy(benchRx.rsp, pNoti->pValue, GLUCOSE_CTL_PNT_LEN);
+            benchRx.done = TRUE;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_connEvent
+ *
+ * @brief   Pass the peripheral's connection events to the application,
+ *          as the stack does with a report it allocates.
+ */
+static void Bench_connEvent(BleSim_Role_t role, Gap_ConnEventRpt_t *pReport)
+{
+    Gap_ConnEventRpt_t *pCopy;
+
+    if ((role == BLESIM_PERIPHERAL) &&
+        ((pCopy = ICall_malloc(sizeof(Gap_ConnEventRpt_t))) != NULL))
+    {
+        *pCopy = *pReport;
+        GlucoseSensor_connEvtCB(pCopy);
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_runApp
+ *
+ * @brief   Process the application's queued messages, as its task does.
+ */
+static void Bench_runApp(void)
+{
+    uint64_t start = Bench_cpuNs();
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+
+    while (!Queue_empty(appMsgQueueHandle))
+    {
+        glucoseEvt_t *pMsg = (glucoseEvt_t *)Util_dequeueMsg(appMsgQueueHandle);
+
+        if (pMsg)
+        {
+            GlucoseSensor_processAppMsg(pMsg);
+            ICall_free(pMsg);
+        }
+    }
+
+    benchCpuNs += Bench_cpuNs() - start;
+}
+
+/*********************************************************************
+ * @fn      Bench_runEvents
+ *
+ * @brief   Run connection events until the response to the request is
+ *          received, or the given number of events.
+ */
+static void Bench_runEvents(uint32_t maxEvents)
+{
+    uint64_t deadline = BleSim_now() + BENCH_TIMEOUT_US;
+
+    while (!benchRx.done && (maxEvents-- > 0) && (BleSim_now() < deadline))
+    {
+        BleSim_runUntil(BleSim_nextEventTime());
+        Bench_runApp();
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_writeCCC
+ */
+static void Bench_writeCCC(uint16_t cccHandle, uint16_t value)
+{
+    attWriteReq_t req;
+
+    BleSim_setRole(BLESIM_CENTRAL);
+
+    req.handle = cccHandle;
+    req.len    = 2;
+    req.pValue = GATT_bm_alloc(benchConnHandle, ATT_WRITE_CMD, req.len, NULL);
+    req.sig    = FALSE;
+    req.cmd    = TRUE;
+    req.pValue[0] = LO_UINT16(value);
+    req.pValue[1] = HI_UINT16(value);
+
+    if (GATT_WriteNoRsp(benchConnHandle, &req) != SUCCESS)
+    {
+        GATT_bm_free((gattMsg_t *)&req, ATT_WRITE_CMD);
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_fillStore
+ *
+ * @brief   Erase the flash and fill the record store with the synthetic
+ *          records.
+ *
+ * @return  TRUE if the store holds every record
+ */
+static bool Bench_fillStore(void)
+{
+    uint16_t expected = 0;
+    uint16_t i;
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    NvsSim_init(BENCH_SECTOR_SIZE, BENCH_NUM_SECTORS);
+
+    if ((GlucoseStore_init(GLUCOSE_STORE_NVS_INDEX) != SUCCESS) ||
+        (GlucoseGen_fill(&benchGen, benchNumRecords) != benchNumRecords))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < benchNumRecords; i++)
+    {
+        expected += Bench_recordExists(i);
+    }
+
+    return GlucoseStore_getNumRecords() == expected;
+}
+
+/*********************************************************************
+ * @fn      Bench_rspName
+ */
+static const char *Bench_rspName(const uint8_t *pRsp)
+{
+    static char name[16];
+
+    if (pRsp[0] == CTL_PNT_OP_NUM_RSP)
+    {
+        snprintf(name, sizeof(name), "num %u", BUILD_UINT16(pRsp[2], pRsp[3]));
+        return name;
+    }
+
+    switch (pRsp[3])
+    {
+    case CTL_PNT_RSP_SUCCESS:               return "success";
+    case CTL_PNT_RSP_OPCODE_NOT_SUPPORTED:  return "opcode n/s";
+    case CTL_PNT_RSP_OPER_INVALID:          return "oper invalid";
+    case CTL_PNT_RSP_OPER_NOT_SUPPORTED:    return "oper n/s";
+    case CTL_PNT_RSP_OPERAND_INVALID:       return "operand inv";
+    case CTL_PNT_RSP_NO_RECORDS:            return "no records";
+    case CTL_PNT_RSP_FILTER_NOT_SUPPORTED:  return "filter n/s";
+    default:
+        snprintf(name, sizeof(name), "code %u", pRsp[3]);
+        return name;
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_runCase
+ *
+ * @brief   Send a case's request to the application, report it to the
+ *          central and check the records and response received.
+ */
+static void Bench_runCase(const BenchCase_t *pCase)
+{
+    glucoseCtlPntMsg_t msg;
+    NvsSim_Stats_t before;
+    NvsSim_Stats_t after;
+    uint64_t startUs;
+    uint64_t start;
+    uint16_t numSelected;
+    uint16_t numContexts;
+    uint16_t numLeft;
+    uint8_t connIndex = GlucoseSensor_getConnIndex(benchConnHandle);
+    int failed = benchFailed;
+
+    if (!Bench_fillStore())
+    {
+        printf("%-24s store can't hold %u records\n", pCase->name, benchNumRecords);
+        benchFailed++;
+        return;
+    }
+
+    pBenchCase = pCase;
+    memset(&benchRx, 0, sizeof(benchRx));
+    benchCpuNs = 0;
+
+    Bench_buildMsg(pCase, &msg);
+    numSelected = Bench_countSelected(&numContexts);
+    numLeft = GlucoseStore_getNumRecords();
+
+    NvsSim_getStats(&before);
+    startUs = BleSim_now();
+
+    if (pCase->abort)
+    {
+        // Start a report of every record to abort
+        glucoseCtlPntMsg_t req = { 2, { CTL_PNT_OP_REQ, CTL_PNT_OPER_ALL } };
+
+        start = Bench_cpuNs();
+        GlucoseSensor_processCtlPntMsg(benchConnHandle, &req);
+        benchCpuNs += Bench_cpuNs() - start;
+
+        Bench_runEvents(BENCH_ABORT_AFTER_EVENTS);
+    }
+
+    start = Bench_cpuNs();
+    GlucoseSensor_processCtlPntMsg(benchConnHandle, &msg);
+    benchCpuNs += Bench_cpuNs() - start;
+
+    Bench_runEvents(UINT32_MAX);
+
+    NvsSim_getStats(&after);
+
+    // Checks
+    if (!benchRx.done || (benchRx.indications != 1) ||
+        GLUCOSE_SESSION_ACTIVE(&connList[connIndex].session))
+    {
+        benchFailed++;
+    }
+    else if (pCase->abort)
+    {
+        // Notifications queued ahead of the abort still go out
+        if ((benchRx.rsp[3] != CTL_PNT_RSP_SUCCESS) ||
+            (benchRx.measNotis >= numSelected) ||
+            (benchRx.measNotis > (BENCH_ABORT_AFTER_EVENTS + 1) * GLUCOSE_NOTI_PER_CONN_EVT))
+        {
+            benchFailed++;
+        }
+    }
+    else if (pCase->rejectCode != 0)
+    {
+        if ((benchRx.rsp[0] != CTL_PNT_OP_REQ_RSP) || (benchRx.rsp[3] != pCase->rejectCode) ||
+            (benchRx.measNotis != 0) || (GlucoseStore_getNumRecords() != numLeft))
+        {
+            benchFailed++;
+        }
+    }
+    else if (pCase->opcode == CTL_PNT_OP_GET_NUM)
+    {
+        if ((benchRx.rsp[0] != CTL_PNT_OP_NUM_RSP) ||
+            (BUILD_UINT16(benchRx.rsp[2], benchRx.rsp[3]) != numSelected))
+        {
+            benchFailed++;
+        }
+    }
+    else
+    {
+        uint8_t rspCode = (numSelected > 0) ? CTL_PNT_RSP_SUCCESS : CTL_PNT_RSP_NO_RECORDS;
+
+        if ((benchRx.rsp[0] != CTL_PNT_OP_REQ_RSP) || (benchRx.rsp[3] != rspCode))
+        {
+            benchFailed++;
+        }
+        if ((pCase->opcode == CTL_PNT_OP_REQ) &&
+            ((benchRx.measNotis != numSelected) || (benchRx.contextNotis != numContexts) ||
+             (benchRx.badRecords != 0)))
+        {
+            benchFailed++;
+        }
+        if ((pCase->opcode == CTL_PNT_OP_CLR) &&
+            (GlucoseStore_getNumRecords() != numLeft - numSelected))
+        {
+            benchFailed++;
+        }
+    }
+
+    printf("%-24s %6u %6u %6u %-13s %10.1f %10.1f %8u %s\n", pCase->name,
+           (pCase->rejectCode == 0) ? numSelected : 0,
+           benchRx.measNotis, benchRx.contextNotis,
+           benchRx.done ? Bench_rspName(benchRx.rsp) : "none",
+           (BleSim_now() - startUs) / 1000.0, benchCpuNs / 1000.0,
+           after.reads - before.reads, (benchFailed != failed) ? "FAIL" : "");
+}
+
+/*********************************************************************
+ * @fn      Bench_run
+ */
+static int Bench_run(void)
+{
+    static const uint8_t measUUID[] = { LO_UINT16(GLUCOSE_MEAS_UUID), HI_UINT16(GLUCOSE_MEAS_UUID) };
+    static const uint8_t contextUUID[] = { LO_UINT16(GLUCOSE_CONTEXT_UUID), HI_UINT16(GLUCOSE_CONTEXT_UUID) };
+    static const uint8_t ctlPntUUID[] = { LO_UINT16(RECORD_CTRL_PT_UUID), HI_UINT16(RECORD_CTRL_PT_UUID) };
+    const BleSim_Callbacks_t cbs = { Bench_notification, NULL, Bench_connEvent };
+    gapEstLinkReqEvent_t linkEvt;
+    uint64_t totalCpuNs = 0;
+    uint32_t totalNotis = 0;
+    uint8_t i;
+
+    BleSim_init(BENCH_HEAP_SIZE, BENCH_TX_BUFFERS, 1, &cbs);
+    NvsSim_init(BENCH_SECTOR_SIZE, BENCH_NUM_SECTORS);
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    GlucoseSensor_init();
+
+    if (!Bench_fillStore())
+    {
+        printf("the record store can't hold %u records\n", benchNumRecords);
+        return 2;
+    }
+
+    benchMeasHandle = BleSim_findAttrHandle(measUUID, ATT_BT_UUID_SIZE);
+    benchContextHandle = BleSim_findAttrHandle(contextUUID, ATT_BT_UUID_SIZE);
+    benchCtlPntHandle = BleSim_findAttrHandle(ctlPntUUID, ATT_BT_UUID_SIZE);
+
+    // Connect the central and let the application know
+    benchConnHandle = BleSim_connect(&benchLink, 1);
+
+    memset(&linkEvt, 0, sizeof(linkEvt));
+    linkEvt.hdr.event = GAP_MSG_EVENT;
+    linkEvt.hdr.status = SUCCESS;
+    linkEvt.opcode = GAP_LINK_ESTABLISHED_EVENT;
+    linkEvt.connectionHandle = benchConnHandle;
+    GlucoseSensor_processGapMessage((gapEventHdr_t *)&linkEvt);
+
+    // The client characteristic configurations follow the values
+    Bench_writeCCC(benchMeasHandle + 1, GATT_CLIENT_CFG_NOTIFY);
+    Bench_writeCCC(benchContextHandle + 1, GATT_CLIENT_CFG_NOTIFY);
+    Bench_writeCCC(benchCtlPntHandle + 1, GATT_CLIENT_CFG_INDICATE);
+    BleSim_runUntil(BleSim_nextEventTime());
+    Bench_runApp();
+
+    printf("%u records, %u s apart, context every %u, gap every %u, %u us interval\n",
+           benchNumRecords, benchGen.period, benchGen.contextEvery, benchGen.gapEvery,
+           benchLink.connIntervalUs);
+    printf("%-24s %6s %6s %6s %-13s %10s %10s %8s\n", "request", "select", "meas",
+           "ctx", "response", "link ms", "cpu us", "reads");
+
+    for (i = 0; i < BENCH_NUM_CASES; i++)
+    {
+        Bench_runCase(&benchCases[i]);
+
+        totalCpuNs += benchCpuNs;
+        totalNotis += benchRx.measNotis + benchRx.contextNotis + benchRx.indications;
+    }
+
+    printf("%u requests, %u notifications and indications, %.1f us cpu\n",
+           (unsigned)BENCH_NUM_CASES, totalNotis, totalCpuNs / 1000.0);
+    printf(benchFailed ? "FAILED\n" : "PASSED\n");
+
+    return benchFailed ? 1 : 0;
+}
+
+/*********************************************************************
+ * @fn      Bench_usage
+ */
+static void Bench_usage(const char *prog)
+{
+    printf("usage: %s [options]\n"
+           "  --records N         synthetic records in the store\n"
+           "  --period-s N        seconds between record timestamps\n"
+           "  --context-every N   every nth record has a context, 0 for none\n"
+           "  --gap-every N       every nth record is deleted again, 0 for none\n"
+           "  --flags-set N       measurement flags set in every record\n"
+           "  --flags-clear N     measurement flags cleared in every record\n"
+           "  --interval-us N     connection interval\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    UTCTimeStruct start = { 0, 0, 0, 0, 0, BENCH_START_YEAR };
+    int arg;
+
+    benchGen.pMeas = glucoseSeedMeas;
+    benchGen.pContext = glucoseSeedContext;
+    benchGen.numTemplates = SEED_REC_MAX;
+    benchGen.startTime = UTC_convertUTCSecs(&start);
+    benchGen.period = BENCH_PERIOD_S;
+    benchGen.contextEvery = BENCH_CONTEXT_EVERY;
+    benchGen.gapEvery = BENCH_GAP_EVERY;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        const char *opt = argv[arg];
+        const char *val = (arg + 1 < argc) ? argv[arg + 1] : NULL;
+
+        if (val == NULL)
+        {
+            Bench_usage(argv[0]);
+            return 2;
+        }
+        arg++;
+
+        if (!strcmp(opt, "--records"))            benchNumRecords       = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--period-s"))      benchGen.period       = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--context-every")) benchGen.contextEvery = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--gap-every"))     benchGen.gapEvery     = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--flags-set"))     benchGen.flagsSet     = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--flags-clear"))   benchGen.flagsClear   = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--interval-us"))   benchLink.connIntervalUs = strtoul(val, NULL, 0);
+        else
+        {
+            Bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((benchNumRecords < 4) || (benchLink.connIntervalUs == 0))
+    {
+        printf("invalid parameters\n");
+        return 2;
+    }
+
+    return Bench_run();
+}
@@ -0,0 +1,405 @@
+/**********************************************************************************************
+ * Filename:       glucose_store_test.c
+ *
+ * Description:    Host build of the flash backed glucose record store shared by the
+ *                 BLE stack and BLE5 glucose sensors, on a simulated NVS region.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "icall_ble_api.h"
+#include "nvs_sim.h"
+#include "glucservice.h"
+#include "glucose_store.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+#define TEST_SECTOR_SIZE            4096
+#define TEST_NUM_SECTORS            4
+
+// Power cut rounds, each deleting, compacting and appending
+#define TEST_POWER_CUT_ROUNDS       2000
+
+#define TEST_CHECK(cond)                                                   \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("  FAIL: %s (line %d)\n", #cond, __LINE__);             \
+            testFailed++;                                                  \
+        }                                                                  \
+    } while (0)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static int testFailed;
+
+/*********************************************************************
+ * Clock
+ */
+
+// Seconds since 2000, with 31 day months. Only the order of the times
+// matters to the store.
+UTCTime UTC_convertUTCSecs(UTCTimeStruct *tm)
+{
+    UTCTime days = ((tm->year - 2000) * 12 + tm->month) * 31 + tm->day;
+
+    return ((days * 24 + tm->hour) * 60 + tm->minutes) * 60 + tm->seconds;
+}
+
+/*********************************************************************
+ * Tests
+ */
+
+/*********************************************************************
+ * @fn      Test_record
+ *
+ * @brief   Builds the measurement taken n minutes after the first, with
+ *          a context every other record.
+ */
+static glucoseRecord_t Test_record(uint32_t n)
+{
+    glucoseRecord_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+
+    rec.meas.flags = GLUCOSE_MEAS_FLAG_CONCENTRATION;
+    rec.meas.baseTime.year = 2020;
+    rec.meas.baseTime.day = (n / 1440) % 28;
+    rec.meas.baseTime.hour = (n / 60) % 24;
+    rec.meas.baseTime.minutes = n % 60;
+    rec.meas.concentration = 100 + (n % 50);
+
+    if (n & 1)
+    {
+        rec.meas.flags |= GLUCOSE_MEAS_FLAG_CONTEXT_INFO;
+        rec.context.flags = GLUCOSE_CONTEXT_FLAG_MEAL;
+        rec.context.mealVal = 1;
+    }
+
+    return rec;
+}
+
+/*********************************************************************
+ * @fn      Test_seqNum
+ *
+ * @brief   Sequence number of an encoded record.
+ */
+static uint16_t Test_seqNum(const glucoseStoreWire_t *pWire)
+{
+    return BUILD_UINT16(pWire->meas[1], pWire->meas[2]);
+}
+
+/*********************************************************************
+ * @fn      Test_checkOrder
+ *
+ * @brief   Walks every record, checking that record IDs and sequence
+ *          numbers increase, and returns how many were found.
+ */
+static uint16_t Test_checkOrder(void)
+{
+    glucoseStoreFilter_t all = { CTL_PNT_OPER_ALL };
+    glucoseStoreWire_t wire;
+    uint32_t recId = 0;
+    uint32_t lastRecId = 0;
+    uint16_t found = 0;
+
+    while (GlucoseStore_find(&all, &recId, &wire))
+    {
+        TEST_CHECK(recId > lastRecId);
+        TEST_CHECK(Test_seqNum(&wire) == (uint16_t)recId);
+        lastRecId = recId;
+        found++;
+    }
+
+    return found;
+}
+
+/*********************************************************************
+ * @fn      Test_filters
+ *
+ * @brief   Records are found in order, by sequence number and by time.
+ */
+static void Test_filters(void)
+{
+    glucoseStoreFilter_t filter;
+    glucoseStoreWire_t wire;
+    glucoseRecord_t rec;
+    uint32_t recId;
+    uint16_t inRange;
+    uint32_t i;
+
+    printf("append and filter\n");
+
+    NvsSim_init(TEST_SECTOR_SIZE, TEST_NUM_SECTORS);
+    TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+
+    for (i = 0; i < 100; i++)
+    {
+        rec = Test_record(i);
+        TEST_CHECK(GlucoseStore_append(&rec) == SUCCESS);
+        TEST_CHECK(rec.meas.seqNum == i + 1);
+    }
+
+    TEST_CHECK(GlucoseStore_getNumRecords() == 100);
+    TEST_CHECK(Test_checkOrder() == 100);
+
+    memset(&filter, 0, sizeof(filter));
+    filter.oper = CTL_PNT_OPER_RANGE;
+    filter.filterType = CTL_PNT_FILTER_SEQNUM;
+    filter.seqNum1 = 10;
+    filter.seqNum2 = 20;
+    inRange = GlucoseStore_count(&filter);
+    TEST_CHECK(inRange == 11);
+
+    // Minutes 30 and after are sequence numbers 31 and after
+    memset(&filter, 0, sizeof(filter));
+    filter.oper = CTL_PNT_OPER_GREATER_EQUAL;
+    filter.filterType = CTL_PNT_FILTER_TIME;
+    rec = Test_record(30);
+    filter.time1 = UTC_convertUTCSecs(&rec.meas.baseTime);
+    TEST_CHECK(GlucoseStore_count(&filter) == 70);
+
+    memset(&filter, 0, sizeof(filter));
+    filter.oper = CTL_PNT_OPER_FIRST;
+    recId = 0;
+    TEST_CHECK(GlucoseStore_find(&filter, &recId, &wire));
+    TEST_CHECK(Test_seqNum(&wire) == 1);
+    TEST_CHECK(wire.contextLen == 0);
+
+    filter.oper = CTL_PNT_OPER_LAST;
+    recId = 0;
+    TEST_CHECK(GlucoseStore_find(&filter, &recId, &wire));
+    TEST_CHECK(Test_seqNum(&wire) == 100);
+    TEST_CHECK(wire.contextLen != 0);
+
+    // The log is rebuilt from flash and the numbering carries on
+    TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+    TEST_CHECK(GlucoseStore_getNumRecords() == 100);
+
+    rec = Test_record(100);
+    TEST_CHECK(GlucoseStore_append(&rec) == SUCCESS);
+    TEST_CHECK(rec.meas.seqNum == 101);
+
+    printf("  %u records, %u found by range\n", GlucoseStore_getNumRecords(), inRange);
+}
+
+/*********************************************************************
+ * @fn      Test_wrap
+ *
+ * @brief   A full log drops its oldest sector and keeps the newest
+ *          records contiguous.
+ */
+static void Test_wrap(void)
+{
+    glucoseStoreFilter_t last = { CTL_PNT_OPER_LAST };
+    glucoseStoreFilter_t first = { CTL_PNT_OPER_FIRST };
+    glucoseStoreWire_t wire;
+    glucoseRecord_t rec;
+    NvsSim_Stats_t stats;
+    uint32_t recId;
+    uint16_t firstSeqNum, lastSeqNum, numRecords;
+    uint32_t i;
+
+    printf("wrap around\n");
+
+    NvsSim_init(TEST_SECTOR_SIZE, TEST_NUM_SECTORS);
+    TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+
+    for (i = 0; i < 2000; i++)
+    {
+        rec = Test_record(i);
+        TEST_CHECK(GlucoseStore_append(&rec) == SUCCESS);
+    }
+
+    numRecords = GlucoseStore_getNumRecords();
+
+    recId = 0;
+    TEST_CHECK(GlucoseStore_find(&first, &recId, &wire));
+    firstSeqNum = Test_seqNum(&wire);
+    recId = 0;
+    TEST_CHECK(GlucoseStore_find(&last, &recId, &wire));
+    lastSeqNum = Test_seqNum(&wire);
+
+    NvsSim_getStats(&stats);
+    printf("  %u records kept, sequence numbers %u to %u, %u sector erases\n",
+           numRecords, firstSeqNum, lastSeqNum, stats.erases);
+
+    TEST_CHECK(numRecords < 2000);
+    TEST_CHECK(lastSeqNum == 2000);
+    TEST_CHECK(lastSeqNum - firstSeqNum + 1 == numRecords);
+    TEST_CHECK(Test_checkOrder() == numRecords);
+}
+
+/*********************************************************************
+ * @fn      Test_delete
+ *
+ * @brief   Deleted records are gone after a reset and their sectors are
+ *          erased by compaction.
+ */
+static void Test_delete(void)
+{
+    glucoseStoreFilter_t filter;
+    glucoseStoreFilter_t all = { CTL_PNT_OPER_ALL };
+    glucoseRecord_t rec;
+    uint16_t deleted, compacted = 0;
+    uint32_t i;
+
+    printf("delete and compact\n");
+
+    NvsSim_init(TEST_SECTOR_SIZE, TEST_NUM_SECTORS);
+    TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+
+    for (i = 0; i < 300; i++)
+    {
+        rec = Test_record(i);
+        TEST_CHECK(GlucoseStore_append(&rec) == SUCCESS);
+    }
+
+    memset(&filter, 0, sizeof(filter));
+    filter.oper = CTL_PNT_OPER_LESS_EQUAL;
+    filter.filterType = CTL_PNT_FILTER_SEQNUM;
+    filter.seqNum1 = 200;
+
+    deleted = GlucoseStore_delete(&filter);
+    while (GlucoseStore_compact())
+    {
+        compacted++;
+    }
+
+    TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+
+    printf("  %u deleted, %u records left, %u compaction steps\n",
+           deleted, GlucoseStore_getNumRecords(), compacted);
+
+    TEST_CHECK(deleted == 200);
+    TEST_CHECK(GlucoseStore_getNumRecords() == 100);
+    TEST_CHECK(Test_checkOrder() == 100);
+
+    TEST_CHECK(GlucoseStore_delete(&all) == 100);
+    TEST_CHECK(GlucoseStore_getNumRecords() == 0);
+
+    rec = Test_record(300);
+    TEST_CHECK(GlucoseStore_append(&rec) == SUCCESS);
+    TEST_CHECK(rec.meas.seqNum == 301);
+}
+
+/*********************************************************************
+ * @fn      Test_powerCut
+ *
+ * @brief   Power cuts in the middle of deletes, compactions and appends
+ *          leave a log that rebuilds with ordered records and no
+ *          deleted record coming back.
+ */
+static void Test_powerCut(void)
+{
+    glucoseStoreFilter_t filter;
+    glucoseRecord_t rec;
+    uint32_t n = 0;
+    uint32_t round;
+    uint16_t before;
+    int j, numAppends;
+
+    printf("power cuts\n");
+
+    NvsSim_init(TEST_SECTOR_SIZE, TEST_NUM_SECTORS);
+    srand(3);
+
+    for (round = 0; round < TEST_POWER_CUT_ROUNDS; round++)
+    {
+        TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+        before = GlucoseStore_getNumRecords();
+
+        memset(&filter, 0, sizeof(filter));
+        filter.oper = CTL_PNT_OPER_LESS_EQUAL;
+        filter.filterType = CTL_PNT_FILTER_SEQNUM;
+        filter.seqNum1 = (uint16_t)(n - (rand() % 200));
+
+        NvsSim_setPowerCut(rand() % 60);
+        GlucoseStore_delete(&filter);
+        while (GlucoseStore_compact())
+        {
+        }
+        NvsSim_setPowerCut(NVSSIM_NO_POWER_CUT);
+
+        TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+        TEST_CHECK(GlucoseStore_getNumRecords() <= before);
+        TEST_CHECK(Test_checkOrder() == GlucoseStore_getNumRecords());
+
+        numAppends = rand() % 150;
+        for (j = 0; j < numAppends; j++)
+        {
+            rec = Test_record(n++);
+
+            NvsSim_setPowerCut((rand() % 50 == 0) ? (rand() % 40) : NVSSIM_NO_POWER_CUT);
+            GlucoseStore_append(&rec);
+            NvsSim_setPowerCut(NVSSIM_NO_POWER_CUT);
+
+            if (rand() % 30 == 0)
+            {
+                TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+            }
+        }
+    }
+
+    TEST_CHECK(GlucoseStore_init(0) == SUCCESS);
+    TEST_CHECK(Test_checkOrder() == GlucoseStore_getNumRecords());
+
+    printf("  %u rounds, %u records left\n", TEST_POWER_CUT_ROUNDS,
+           GlucoseStore_getNumRecords());
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main(void)
+{
+    Test_filters();
+    Test_wrap();
+    Test_delete();
+    Test_powerCut();
+
+    printf(testFailed ? "FAILED\n" : "PASSED\n");
+
+    return testFailed ? 1 : 0;
+}
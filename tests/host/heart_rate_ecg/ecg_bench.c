@@ -0,0 +1,834 @@
+/**********************************************************************************************
+ * Filename:       ecg_bench.c
+ *
+ * Description:    Host check and benchmark of the heart rate sensor's ECG beat detector.
+ *                 The ECG is synthetic: P, QRS and T waves placed at known beat times,
+ *                 over a rate that climbs and falls, with baseline wander, mains hum,
+ *                 noise and a lead-off. Detections are scored against the beat times,
+ *                 and the time and host timestamp counter ticks per sample are reported.
+ *                 They are host figures only; cycles on the CC2640R2 have to be
+ *                 measured on the target. A recording can be run instead with --file,
+ *                 which is only reported, as there are no beat times to score it by.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC              1
+#else
+#define BENCH_HAVE_TSC              0
+#endif
+
+#include "heart_rate_ecg.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+// ADC counts per mV of the synthetic ECG, as in the application's simulation
+#define BENCH_COUNTS_PER_MV         1000.0
+
+// Beats within this long of the start or the end of a lead-off are not
+// scored: the detector learns for 2 s, and the first beat after that only
+// sets the time of the next.
+#define BENCH_SETTLE_MS             4000
+
+// A detection is matched to the last beat at most this long before it
+#define BENCH_MATCH_MS              400
+
+// Checks on the synthetic ECG
+#define BENCH_MAX_MISSED_PCT        1.0
+#define BENCH_MAX_FALSE_PCT         1.0
+#define BENCH_MAX_MEAN_RR_ERR_MS    5.0
+#define BENCH_MAX_RR_ERR_MS         20.0
+
+// Timed passes over the record, the fastest is reported, and passes
+// timing each sample on its own
+#define BENCH_TIMED_PASSES          20
+#define BENCH_WORST_PASSES          5
+
+#define BENCH_PI                    3.14159265358979323846
+
+#define BENCH_CHECK(cond)                                                  \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("  FAIL: %s (line %d)\n", #cond, __LINE__);             \
+            benchFailed++;                                                 \
+        }                                                                  \
+    } while (0)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Part of the synthetic record. The rate moves linearly from startBpm to
+// endBpm; a lead-off has no beats.
+typedef struct
+{
+    uint32_t durationMs;
+    uint16_t startBpm;
+    uint16_t endBpm;
+    bool leadOff;
+} benchSegment_t;
+
+// Wave of the synthetic PQRST complex, a Gaussian around the R-wave
+typedef struct
+{
+    double mv;              // Amplitude
+    double offsetS;         // Centre, from the R-wave
+    double widthS;          // Standard deviation
+} benchWave_t;
+
+typedef struct
+{
+    double time;            // R-wave, s
+    double rr;              // From the beat before, s
+    double scale;           // Amplitude scale
+    bool scored;
+    bool matched;
+} benchBeat_t;
+
+typedef struct
+{
+    uint32_t sample;        // Index of the sample it was reported on
+    uint16_t rrInterval;    // 1/1024 s
+} benchDetection_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static int benchFailed;
+
+// Rest, exercise up to 170 bpm, recovery, a loose electrode and rest again
+static const benchSegment_t benchSegments[] =
+{
+    { 40000,  62,  62, false },
+    { 40000,  62, 170, false },
+    { 30000, 170, 170, false },
+    { 30000, 170,  48, false },
+    {  6000,   0,   0, true  },
+    { 30000,  48,  75, false },
+};
+
+#define BENCH_NUM_SEGMENTS (sizeof(benchSegments) / sizeof(benchSegments[0]))
+
+// P, Q, R, S and T. The T-wave is placed by the RR-interval instead.
+static const benchWave_t benchWaves[] =
+{
+    {  0.15, -0.160, 0.020 },
+    { -0.10, -0.030, 0.008 },
+    {  1.20,  0.000, 0.010 },
+    { -0.30,  0.030, 0.010 },
+    {  0.35,  0.000, 0.045 },
+};
+
+#define BENCH_NUM_WAVES (sizeof(benchWaves) / sizeof(benchWaves[0]))
+#define BENCH_T_WAVE    (BENCH_NUM_WAVES - 1)
+
+// Noise, in uV rms, and mains hum
+static double benchNoiseUv = 20.0;
+static double benchMainsUv = 30.0;
+static double benchMainsHz = 50.0;
+
+static uint32_t benchSeed = 1;
+
+// Record run
+static int16_t *benchSamples;
+static uint32_t benchNumSamples;
+static benchBeat_t *benchBeats;
+static uint32_t benchNumBeats;
+static benchDetection_t *benchDetections;
+static uint32_t benchNumDetections;
+
+// Keeps the timed passes from being optimised out
+static volatile uint32_t benchSink;
+
+/*********************************************************************
+ * @fn      Bench_nowNs
+ */
+static uint64_t Bench_nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      Bench_ticks
+ *
+ * @brief   Host timestamp counter. It counts at a fixed rate on most
+ *          hosts, which need not be the core clock.
+ */
+static uint64_t Bench_ticks(void)
+{
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/*********************************************************************
+ * @fn      Bench_random
+ *
+ * @brief   Uniform in [0, 1), reproducible from benchSeed.
+ */
+static double Bench_random(void)
+{
+    benchSeed = benchSeed * 1664525u + 1013904223u;
+
+    return (benchSeed >> 8) / 16777216.0;
+}
+
+/*********************************************************************
+ * @fn      Bench_gaussian
+ */
+static double Bench_gaussian(void)
+{
+    double u = Bench_random();
+
+    if (u < 1e-12)
+    {
+        u = 1e-12;
+    }
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * BENCH_PI * Bench_random());
+}
+
+/*********************************************************************
+ * @fn      Bench_segmentAt
+ *
+ * @brief   Find the segment of the record at time t.
+ *
+ * @return  Segment index, BENCH_NUM_SEGMENTS past the end.
+ */
+static uint8_t Bench_segmentAt(double t, double *pStart)
+{
+    double start = 0.0;
+    uint8_t i;
+
+    for (i = 0; i < BENCH_NUM_SEGMENTS; i++)
+    {
+        double end = start + benchSegments[i].durationMs / 1000.0;
+
+        if (t < end)
+        {
+            break;
+        }
+        start = end;
+    }
+
+    *pStart = start;
+
+    return i;
+}
+
+/*********************************************************************
+ * @fn      Bench_makeBeats
+ *
+ * @brief   Place the R-waves of the record. The rate follows the
+ *          segments, with a respiratory swing of 4% and some jitter;
+ *          the amplitude swings with respiration as well.
+ */
+static void Bench_makeBeats(double durationS)
+{
+    double t = 0.5;
+    double last = 0.0;
+    uint32_t maxBeats = (uint32_t)(durationS * 4) + 1;
+
+    benchBeats = calloc(maxBeats, sizeof(benchBeat_t));
+    benchNumBeats = 0;
+
+    while (t < durationS)
+    {
+        double start;
+        uint8_t seg = Bench_segmentAt(t, &start);
+        const benchSegment_t *pSeg = &benchSegments[seg];
+        double bpm;
+        double rr;
+
+        if (pSeg->leadOff)
+        {
+            // Resume half a second into the next segment
+            t = start + pSeg->durationMs / 1000.0 + 0.5;
+            last = 0.0;
+            continue;
+        }
+
+        bpm = pSeg->startBpm + (pSeg->endBpm - pSeg->startBpm) *
+              (t - start) / (pSeg->durationMs / 1000.0);
+
+        if (benchNumBeats < maxBeats)
+        {
+            benchBeat_t *pBeat = &benchBeats[benchNumBeats++];
+
+            pBeat->time = t;
+            pBeat->rr = (last > 0.0) ? t - last : 0.0;
+            pBeat->scale = 1.0 + 0.15 * sin(2.0 * BENCH_PI * t / 4.0);
+        }
+
+        rr = (60.0 / bpm) * (1.0 + 0.04 * sin(2.0 * BENCH_PI * t / 4.0)) +
+             0.004 * Bench_gaussian();
+        last = t;
+        t += rr;
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_isSettling
+ *
+ * @brief   Whether time t is within BENCH_SETTLE_MS of the start of the
+ *          record or of the end of a lead-off.
+ */
+static bool Bench_isSettling(double t)
+{
+    double start = 0.0;
+    double settled = BENCH_SETTLE_MS / 1000.0;
+    uint8_t i;
+
+    for (i = 0; i < BENCH_NUM_SEGMENTS; i++)
+    {
+        start += benchSegments[i].durationMs / 1000.0;
+
+        if (benchSegments[i].leadOff && (t >= start))
+        {
+            settled = start + BENCH_SETTLE_MS / 1000.0;
+        }
+    }
+
+    return t < settled;
+}
+
+/*********************************************************************
+ * @fn      Bench_makeEcg
+ *
+ * @brief   Build the synthetic record at sampleRate Hz.
+ */
+static void Bench_makeEcg(uint16_t sampleRate)
+{
+    double durationS = 0.0;
+    uint32_t first = 0;
+    uint32_t n;
+    uint8_t i;
+
+    for (i = 0; i < BENCH_NUM_SEGMENTS; i++)
+    {
+        durationS += benchSegments[i].durationMs / 1000.0;
+    }
+
+    Bench_makeBeats(durationS);
+
+    // Beats too close to the end to be detected within it are not scored
+    for (n = 0; n < benchNumBeats; n++)
+    {
+        benchBeats[n].scored = !Bench_isSettling(benchBeats[n].time) &&
+                               (benchBeats[n].time < durationS - BENCH_MATCH_MS / 1000.0);
+    }
+
+    benchNumSamples = (uint32_t)(durationS * sampleRate);
+    benchSamples = malloc(benchNumSamples * sizeof(int16_t));
+
+    for (n = 0; n < benchNumSamples; n++)
+    {
+        double t = (double)n / sampleRate;
+        double mv;
+        double start;
+        uint32_t b;
+
+        // Baseline wander, from breathing and movement, and mains hum
+        mv = 0.25 * sin(2.0 * BENCH_PI * 0.25 * t) +
+             0.10 * sin(2.0 * BENCH_PI * 0.05 * t) +
+             (benchMainsUv / 1000.0) * sin(2.0 * BENCH_PI * benchMainsHz * t) +
+             (benchNoiseUv / 1000.0) * Bench_gaussian();
+
+        // A loose electrode floats: no ECG, and more hum
+        if (benchSegments[Bench_segmentAt(t, &start)].leadOff)
+        {
+            mv += 2.0 * (benchMainsUv / 1000.0) * sin(2.0 * BENCH_PI * benchMainsHz * t);
+        }
+
+        // Complexes of the beats within a second of the sample
+        while ((first < benchNumBeats) && (benchBeats[first].time < t - 1.0))
+        {
+            first++;
+        }
+
+        for (b = first; (b < benchNumBeats) && (benchBeats[b].time < t + 1.0); b++)
+        {
+            const benchBeat_t *pBeat = &benchBeats[b];
+            double rr = (pBeat->rr > 0.0) ? pBeat->rr : 1.0;
+
+            for (i = 0; i < BENCH_NUM_WAVES; i++)
+            {
+                const benchWave_t *pWave = &benchWaves[i];
+                // The QT interval shortens with the RR-interval (Bazett)
+                double offset = (i == BENCH_T_WAVE) ? 0.30 * sqrt(rr) : pWave->offsetS;
+                double x = (t - pBeat->time - offset) / pWave->widthS;
+
+                mv += pBeat->scale * pWave->mv * exp(-0.5 * x * x);
+            }
+        }
+
+        mv *= BENCH_COUNTS_PER_MV;
+        benchSamples[n] = (int16_t)((mv > 32767.0) ? 32767 :
+                                    (mv < -32768.0) ? -32768 : lrint(mv));
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_loadFile
+ *
+ * @brief   Load a recording of raw little-endian int16 samples.
+ *
+ * @return  true if any sample was read
+ */
+static bool Bench_loadFile(const char *pPath)
+{
+    FILE *pFile = fopen(pPath, "rb");
+    uint8_t raw[2];
+    uint32_t size = 0;
+
+    if (pFile == NULL)
+    {
+        return false;
+    }
+
+    benchNumSamples = 0;
+    benchSamples = NULL;
+
+    while (fread(raw, 1, sizeof(raw), pFile) == sizeof(raw))
+    {
+        if (benchNumSamples == size)
+        {
+            size = size ? size * 2 : 65536;
+            benchSamples = realloc(benchSamples, size * sizeof(int16_t));
+        }
+        benchSamples[benchNumSamples++] = (int16_t)(raw[0] | (raw[1] << 8));
+    }
+
+    fclose(pFile);
+
+    return benchNumSamples > 0;
+}
+
+/*********************************************************************
+ * @fn      Bench_detect
+ *
+ * @brief   Run the record through the detector once, keeping the
+ *          detections and the contact status after every sample.
+ */
+static void Bench_detect(uint16_t sampleRate, bool *pContact)
+{
+    uint32_t n;
+
+    free(benchDetections);
+    benchDetections = calloc(benchNumSamples, sizeof(benchDetection_t));
+    benchNumDetections = 0;
+
+    BENCH_CHECK(HeartRateEcg_init(sampleRate) == SUCCESS);
+
+    for (n = 0; n < benchNumSamples; n++)
+    {
+        uint16_t rrInterval;
+
+        if (HeartRateEcg_process(benchSamples[n], &rrInterval))
+        {
+            benchDetections[benchNumDetections].sample = n;
+            benchDetections[benchNumDetections].rrInterval = rrInterval;
+            benchNumDetections++;
+        }
+
+        pContact[n] = HeartRateEcg_getContact();
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_time
+ *
+ * @brief   Time the detector over the record. The mean is taken from
+ *          the fastest of BENCH_TIMED_PASSES passes. The worst sample
+ *          is timed on its own, timestamp counter reads included.
+ */
+static void Bench_time(uint16_t sampleRate)
+{
+    double bestNs = 0.0;
+    double bestTicks = 0.0;
+    uint64_t *pTicks = malloc(benchNumSamples * sizeof(uint64_t));
+    uint64_t worstTicks = 0;
+    uint32_t pass;
+    uint32_t n;
+
+    for (pass = 0; pass < BENCH_TIMED_PASSES; pass++)
+    {
+        uint64_t startNs;
+        uint64_t startTicks;
+        double ns;
+        double ticks;
+
+        HeartRateEcg_init(sampleRate);
+
+        startNs = Bench_nowNs();
+        startTicks = Bench_ticks();
+
+        for (n = 0; n < benchNumSamples; n++)
+        {
+            uint16_t rrInterval;
+
+            benchSink += HeartRateEcg_process(benchSamples[n], &rrInterval);
+        }
+
+        ticks = (double)(Bench_ticks() - startTicks) / benchNumSamples;
+        ns = (double)(Bench_nowNs() - startNs) / benchNumSamples;
+
+        if ((pass == 0) || (ns < bestNs))
+        {
+            bestNs = ns;
+            bestTicks = ticks;
+        }
+    }
+
+    // Each sample's best of BENCH_WORST_PASSES, so that preemption and
+    // page faults are not taken for the detector
+    for (pass = 0; pass < BENCH_WORST_PASSES; pass++)
+    {
+        HeartRateEcg_init(sampleRate);
+
+        for (n = 0; n < benchNumSamples; n++)
+        {
+            uint16_t rrInterval;
+            uint64_t start = Bench_ticks();
+            uint64_t ticks;
+
+            benchSink += HeartRateEcg_process(benchSamples[n], &rrInterval);
+            ticks = Bench_ticks() - start;
+
+            if ((pass == 0) || (ticks < pTicks[n]))
+            {
+                pTicks[n] = ticks;
+            }
+        }
+    }
+
+    for (n = 0; n < benchNumSamples; n++)
+    {
+        worstTicks = (pTicks[n] > worstTicks) ? pTicks[n] : worstTicks;
+    }
+
+    free(pTicks);
+
+    printf("  host time        %.1f ns/sample, %.4f%% of the sample period\n",
+           bestNs, bestNs * sampleRate / 1e7);
+
+    if (BENCH_HAVE_TSC)
+    {
+        printf("  host TSC ticks   %.1f/sample mean, %llu worst sample (not CC2640R2 cycles)\n",
+               bestTicks, (unsigned long long)worstTicks);
+    }
+    else
+    {
+        printf("  host TSC ticks   not available on this host\n");
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_score
+ *
+ * @brief   Score the detections against the beats of the synthetic
+ *          record, and the contact status against its lead-off.
+ */
+static void Bench_score(uint16_t sampleRate, const bool *pContact)
+{
+    uint32_t falseDetections = 0;
+    uint32_t missed = 0;
+    uint32_t scored = 0;
+    uint32_t rrCount = 0;
+    double rrErrSum = 0.0;
+    double rrErrMax = 0.0;
+    double start = 0.0;
+    uint32_t lostAfterSettle = 0;
+    uint32_t b = 0;
+    uint32_t d;
+    uint32_t n;
+    uint8_t i;
+
+    for (d = 0; d < benchNumDetections; d++)
+    {
+        double t = (double)benchDetections[d].sample / sampleRate;
+        benchBeat_t *pBeat;
+
+        // The last beat before the detection
+        while ((b + 1 < benchNumBeats) && (benchBeats[b + 1].time <= t))
+        {
+            b++;
+        }
+        pBeat = &benchBeats[b];
+
+        if ((pBeat->time > t) || pBeat->matched ||
+            (t - pBeat->time > BENCH_MATCH_MS / 1000.0))
+        {
+            falseDetections++;
+            continue;
+        }
+
+        pBeat->matched = true;
+
+        if (pBeat->scored && (pBeat->rr > 0.0))
+        {
+            double err = fabs(benchDetections[d].rrInterval / 1024.0 - pBeat->rr) * 1000.0;
+
+            rrErrSum += err;
+            rrErrMax = (err > rrErrMax) ? err : rrErrMax;
+            rrCount++;
+        }
+    }
+
+    for (b = 0; b < benchNumBeats; b++)
+    {
+        if (benchBeats[b].scored)
+        {
+            scored++;
+            missed += benchBeats[b].matched ? 0 : 1;
+        }
+    }
+
+    // Contact must be lost by the end of a lead-off, and held once the
+    // detector has settled again.
+    for (i = 0; i < BENCH_NUM_SEGMENTS; i++)
+    {
+        start += benchSegments[i].durationMs / 1000.0;
+
+        if (benchSegments[i].leadOff)
+        {
+            n = (uint32_t)(start * sampleRate) - 1;
+            printf("  contact          %s at the end of the %u ms lead-off\n",
+                   pContact[n] ? "held" : "lost", benchSegments[i].durationMs);
+            BENCH_CHECK(!pContact[n]);
+        }
+    }
+
+    for (n = 0; n < benchNumSamples; n++)
+    {
+        double t = (double)n / sampleRate;
+        double segStart;
+
+        if (!Bench_isSettling(t) && !benchSegments[Bench_segmentAt(t, &segStart)].leadOff &&
+            !pContact[n])
+        {
+            lostAfterSettle++;
+        }
+    }
+
+    printf("  beats            %u, %u scored\n", benchNumBeats, scored);
+    printf("  detections       %u, %u missed (%.2f%%), %u false (%.2f%%)\n",
+           benchNumDetections, missed, scored ? 100.0 * missed / scored : 0.0,
+           falseDetections, scored ? 100.0 * falseDetections / scored : 0.0);
+    printf("  RR error         %.2f ms mean, %.2f ms max over %u intervals\n",
+           rrCount ? rrErrSum / rrCount : 0.0, rrErrMax, rrCount);
+    printf("  contact lost     %u samples outside lead-off and settling\n", lostAfterSettle);
+
+    BENCH_CHECK(scored > 0);
+    BENCH_CHECK(100.0 * missed <= BENCH_MAX_MISSED_PCT * scored);
+    BENCH_CHECK(100.0 * falseDetections <= BENCH_MAX_FALSE_PCT * scored);
+    BENCH_CHECK(rrCount > 0);
+    BENCH_CHECK(rrErrSum <= BENCH_MAX_MEAN_RR_ERR_MS * rrCount);
+    BENCH_CHECK(rrErrMax <= BENCH_MAX_RR_ERR_MS);
+    BENCH_CHECK(lostAfterSettle == 0);
+    BENCH_CHECK(pContact[benchNumSamples - 1]);
+}
+
+/*********************************************************************
+ * @fn      Bench_report
+ *
+ * @brief   Report the detections of a recording, which has no beat
+ *          times to score them by.
+ */
+static void Bench_report(const bool *pContact)
+{
+    uint32_t rrSum = 0;
+    uint32_t d;
+
+    for (d = 0; d < benchNumDetections; d++)
+    {
+        rrSum += benchDetections[d].rrInterval;
+    }
+
+    printf("  detections       %u\n", benchNumDetections);
+    if (benchNumDetections > 0)
+    {
+        printf("  mean rate        %.1f bpm\n",
+               60.0 * 1024.0 * benchNumDetections / rrSum);
+    }
+    printf("  contact          %s at the end\n",
+           pContact[benchNumSamples - 1] ? "held" : "lost");
+}
+
+/*********************************************************************
+ * @fn      Bench_run
+ *
+ * @brief   Run the synthetic record, or the recording if pPath is set,
+ *          at sampleRate Hz.
+ */
+static void Bench_run(uint16_t sampleRate, const char *pPath)
+{
+    bool *pContact;
+
+    if (pPath != NULL)
+    {
+        printf("%s at %u Hz, %u samples\n", pPath, sampleRate, benchNumSamples);
+    }
+    else
+    {
+        Bench_makeEcg(sampleRate);
+        printf("synthetic ECG at %u Hz, %.0f s, %.0f uV rms noise, %.0f uV %.0f Hz hum\n",
+               sampleRate, (double)benchNumSamples / sampleRate, benchNoiseUv,
+               benchMainsUv, benchMainsHz);
+    }
+
+    pContact = calloc(benchNumSamples, sizeof(bool));
+
+    Bench_detect(sampleRate, pContact);
+
+    if (pPath != NULL)
+    {
+        Bench_report(pContact);
+    }
+    else
+    {
+        Bench_score(sampleRate, pContact);
+    }
+
+    Bench_time(sampleRate);
+
+    free(pContact);
+
+    if (pPath == NULL)
+    {
+        free(benchSamples);
+        free(benchBeats);
+        benchSamples = NULL;
+        benchBeats = NULL;
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_usage
+ */
+static void Bench_usage(const char *prog)
+{
+    printf("usage: %s [options]\n"
+           "  --rate N            sample rate, %u to %u Hz; 250 and 500 if not set\n"
+           "  --noise-uv N        synthetic noise, uV rms\n"
+           "  --mains-uv N        synthetic mains hum, uV\n"
+           "  --mains-hz N        synthetic mains frequency\n"
+           "  --seed N            synthetic noise and jitter seed\n"
+           "  --file PATH         raw little-endian int16 recording instead, at --rate\n",
+           prog, HEARTRATE_ECG_MIN_RATE, HEARTRATE_ECG_MAX_RATE);
+}
+
+int main(int argc, char **argv)
+{
+    const char *pPath = NULL;
+    uint32_t rate = 0;
+    uint32_t seed = 1;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        const char *opt = argv[arg];
+        const char *val = (arg + 1 < argc) ? argv[arg + 1] : NULL;
+
+        if (val == NULL)
+        {
+            Bench_usage(argv[0]);
+            return 2;
+        }
+        arg++;
+
+        if (!strcmp(opt, "--rate"))          rate         = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--noise-uv")) benchNoiseUv = strtod(val, NULL);
+        else if (!strcmp(opt, "--mains-uv")) benchMainsUv = strtod(val, NULL);
+        else if (!strcmp(opt, "--mains-hz")) benchMainsHz = strtod(val, NULL);
+        else if (!strcmp(opt, "--seed"))     seed         = strtoul(val, NULL, 0);
+        else if (!strcmp(opt, "--file"))     pPath        = val;
+        else
+        {
+            Bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (((rate != 0) &&
+         ((rate < HEARTRATE_ECG_MIN_RATE) || (rate > HEARTRATE_ECG_MAX_RATE))) ||
+        ((pPath != NULL) && (rate == 0)))
+    {
+        printf("invalid parameters\n");
+        return 2;
+    }
+
+    if ((pPath != NULL) && !Bench_loadFile(pPath))
+    {
+        printf("can't read %s\n", pPath);
+        return 2;
+    }
+
+    if (rate != 0)
+    {
+        benchSeed = seed;
+        Bench_run((uint16_t)rate, pPath);
+    }
+    else
+    {
+        benchSeed = seed;
+        Bench_run(HEARTRATE_ECG_MIN_RATE, NULL);
+        benchSeed = seed;
+        Bench_run(HEARTRATE_ECG_MAX_RATE, NULL);
+    }
+
+    printf(benchFailed ? "FAILED\n" : "PASSED\n");
+
+    return benchFailed ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+/**********************************************************************************************
+ * Filename:       serial_port_test.c
+ *
+ * Description:    Host build of the BLE stack serial port service. Client writes
+ *                 are dispatched by handle to the characteristic handlers and the
+ *                 data characteristic is notified through its read handler.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "ble_sim.h"
+#include "board.h"
+#include "spp_ble_server.h"
+#include "serial_port_service.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+#define TEST_HEAP_SIZE              4096
+#define TEST_TX_BUFFERS             8
+
+#define TEST_CHECK(cond)                                                   \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("  FAIL: %s (line %d)\n", #cond, __LINE__);             \
+            testFailed++;                                                  \
+        }                                                                  \
+    } while (0)
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+extern CONST uint8 SerialPortServiceDataUUID[];
+extern CONST uint8 SerialPortServiceConfigUUID[];
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static int      testFailed;
+
+// Notifications received by the client
+static uint16_t testRxCount;
+static uint16_t testRxHandle;
+static uint16_t testRxLen;
+static uint8_t  testRxValue[SERIALPORTSERVICE_DATA_LEN];
+
+// Calls from the service to the application
+static uint16_t testLedToggles;
+static uint16_t testConfigChanges;
+
+/*********************************************************************
+ * Stack, application and profile callbacks
+ */
+
+void SPPBLEServer_toggleLed(uint8_t led, uint8_t state)
+{
+    if ((led == Board_RLED) && (state == Board_LED_TOGGLE))
+    {
+        testLedToggles++;
+    }
+}
+
+static void Test_notification(uint16_t connHandle, attHandleValueNoti_t *pNoti)
+{
+    (void)connHandle;
+
+    testRxCount++;
+    testRxHandle = pNoti->handle;
+    testRxLen    = pNoti->len;
+    memcpy(testRxValue, pNoti->pValue, pNoti->len);
+}
+
+static const BleSim_Callbacks_t testSimCBs =
+{
+    Test_notification,
+    NULL,
+    NULL
+};
+
+static void Test_serialPortChange(uint8 paramID)
+{
+    if (paramID == SERIALPORTSERVICE_CHAR_CONFIG)
+    {
+        testConfigChanges++;
+    }
+}
+
+static SerialPortServiceCBs_t testServiceCBs =
+{
+    Test_serialPortChange
+};
+
+/*********************************************************************
+ * Tests
+ */
+
+/*********************************************************************
+ * @fn      Test_write
+ *
+ * @brief   Writes an attribute from the client and runs the link until
+ *          the write has reached the service.
+ */
+static void Test_write(uint16_t handle, const uint8_t *pValue, uint16_t len)
+{
+    attWriteReq_t req;
+
+    BleSim_setRole(BLESIM_CENTRAL);
+
+    req.handle = handle;
+    req.len    = len;
+    req.pValue = GATT_bm_alloc(0, ATT_WRITE_CMD, req.len, NULL);
+    req.sig    = FALSE;
+    req.cmd    = TRUE;
+    memcpy(req.pValue, pValue, req.len);
+
+    if (GATT_WriteNoRsp(0, &req) != SUCCESS)
+    {
+        GATT_bm_free((gattMsg_t *)&req, ATT_WRITE_CMD);
+    }
+
+    BleSim_runUntil(BleSim_now() + 20000);
+}
+
+/*********************************************************************
+ * @fn      Test_notify
+ *
+ * @brief   Sets the data characteristic and returns the number of
+ *          notifications the client received.
+ */
+static uint16_t Test_notify(const uint8_t *pValue, uint8_t len)
+{
+    testRxCount = 0;
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    TEST_CHECK(SerialPortService_SetParameter(SERIALPORTSERVICE_CHAR_DATA, len,
+                                              (void *)pValue) == SUCCESS);
+    BleSim_runUntil(BleSim_now() + 20000);
+
+    return testRxCount;
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main(void)
+{
+    static const uint8_t cccNotify[2]  = { LO_UINT16(GATT_CLIENT_CFG_NOTIFY),
+                                           HI_UINT16(GATT_CLIENT_CFG_NOTIFY) };
+    static const uint8_t cccIndicate[2] = { LO_UINT16(GATT_CLIENT_CFG_INDICATE),
+                                            HI_UINT16(GATT_CLIENT_CFG_INDICATE) };
+    static const uint8_t cccOff[2]     = { 0, 0 };
+    static const uint8_t config[SERIALPORTSERVICE_CONFIG_LEN] = { 0x01, 0x20, 0x0A };
+    BleSim_LinkParams_t params = { 247, 251, 7500, 4, 0.0 };
+    uint8_t value[SERIALPORTSERVICE_DATA_LEN];
+    uint8_t status[SERIALPORTSERVICE_STATUS_LEN];
+    uint16_t dataHandle, cccHandle, configHandle;
+    uint8_t i;
+
+    printf("serial port service dispatch\n");
+
+    BleSim_init(TEST_HEAP_SIZE, TEST_TX_BUFFERS, 1, &testSimCBs);
+    BleSim_connect(&params, 1);
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    TEST_CHECK(SerialPortService_AddService(SERIALPORTSERVICE_SERVICE) == SUCCESS);
+    TEST_CHECK(SerialPortService_RegisterAppCBs(&testServiceCBs) == SUCCESS);
+
+    dataHandle   = BleSim_findAttrHandle(SerialPortServiceDataUUID, ATT_UUID_SIZE);
+    cccHandle    = BleSim_findAttrHandle(clientCharCfgUUID, ATT_BT_UUID_SIZE);
+    configHandle = BleSim_findAttrHandle(SerialPortServiceConfigUUID, ATT_UUID_SIZE);
+
+    // Generated table: data value, CCC and user description, then the
+    // status and config characteristics with their user descriptions
+    TEST_CHECK(dataHandle != GATT_INVALID_HANDLE);
+    TEST_CHECK(cccHandle == dataHandle + 1);
+    TEST_CHECK(BleSim_findAttrHandle(charUserDescUUID, ATT_BT_UUID_SIZE) == dataHandle + 2);
+    TEST_CHECK(configHandle == dataHandle + 7);
+    TEST_CHECK(SerialPortServiceAttrTbl[SERVAPP_NUM_ATTR_SUPPORTED - 1].handle == configHandle + 1);
+    TEST_CHECK(!strcmp((const char *)SerialPortServiceAttrTbl[SERVAPP_NUM_ATTR_SUPPORTED - 1].pValue,
+                       "Config Characteristic "));
+
+    for (i = 0; i < sizeof(value); i++)
+    {
+        value[i] = i;
+    }
+
+    // Data written by the client is stored, counted and shown on the LED
+    Test_write(dataHandle, value, 20);
+    SerialPortService_GetParameter(SERIALPORTSERVICE_CHAR_STATUS, status);
+
+    printf("  data write: %u LED toggles, %u bytes received\n",
+           testLedToggles, BUILD_UINT16(status[4], status[3]));
+
+    TEST_CHECK(testLedToggles == 1);
+    TEST_CHECK(BUILD_UINT16(status[4], status[3]) == 20);
+
+    // A config write is passed on to the application
+    Test_write(configHandle, config, sizeof(config));
+    SerialPortService_GetParameter(SERIALPORTSERVICE_CHAR_CONFIG, value);
+
+    printf("  config write: %u application callbacks\n", testConfigChanges);
+
+    TEST_CHECK(testConfigChanges == 1);
+    TEST_CHECK(!memcmp(value, config, sizeof(config)));
+
+    for (i = 0; i < sizeof(value); i++)
+    {
+        value[i] = 0xFF - i;
+    }
+
+    // Nothing is sent until the client subscribes
+    TEST_CHECK(Test_notify(value, 40) == 0);
+
+    // The CCC only accepts notifications
+    Test_write(cccHandle, cccIndicate, sizeof(cccIndicate));
+    TEST_CHECK(Test_notify(value, 40) == 0);
+
+    Test_write(cccHandle, cccNotify, sizeof(cccNotify));
+    TEST_CHECK(Test_notify(value, 40) == 1);
+
+    printf("  data notification: handle 0x%04X, %u bytes\n", testRxHandle, testRxLen);
+
+    TEST_CHECK(testRxHandle == dataHandle);
+    TEST_CHECK(testRxLen == 40);
+    TEST_CHECK(!memcmp(testRxValue, value, 40));
+
+    Test_write(cccHandle, cccOff, sizeof(cccOff));
+    TEST_CHECK(Test_notify(value, 40) == 0);
+
+    printf(testFailed ? "FAILED\n" : "PASSED\n");
+
+    return testFailed ? 1 : 0;
+}
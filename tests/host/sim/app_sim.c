@@ -0,0 +1,276 @@
+/**********************************************************************************************
+ * Filename:       app_sim.c
+ *
+ * Description:    This file contains the stack, service and board calls of the applications
+ *                 built on the host that the link simulation doesn't act on. They succeed
+ *                 and do nothing: GAP links are made with BleSim_connect and their events
+ *                 are passed to the application by the host program.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "icall_ble_api.h"
+#include "devinfoservice.h"
+#include "board_key.h"
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8 appSimDevAddr[B_ADDR_LEN];
+
+/*********************************************************************
+ * GAP
+ */
+
+bStatus_t GAP_DeviceInit(uint8 profileRole, uint8 taskID,
+                         GAP_Addr_Modes_t addrMode, uint8 *pRandomAddr)
+{
+    (void)profileRole;
+    (void)taskID;
+    (void)addrMode;
+    (void)pRandomAddr;
+
+    return SUCCESS;
+}
+
+uint8 *GAP_GetDevAddress(uint8 wantIA)
+{
+    (void)wantIA;
+
+    return appSimDevAddr;
+}
+
+void GAP_RegisterForMsgs(uint8 taskID)
+{
+    (void)taskID;
+}
+
+bStatus_t GAP_SetParamValue(uint16 paramID, uint16 paramValue)
+{
+    (void)paramID;
+    (void)paramValue;
+
+    return SUCCESS;
+}
+
+bStatus_t GAP_UpdateLinkParamReq(gapUpdateLinkParamReq_t *pParams)
+{
+    (void)pParams;
+
+    return SUCCESS;
+}
+
+bStatus_t GAP_UpdateLinkParamReqReply(gapUpdateLinkParamReqReply_t *pParams)
+{
+    (void)pParams;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * GapAdv
+ */
+
+bStatus_t GapAdv_create(pfnGapCB_t cb, GapAdv_params_t *pAdvParam,
+                        uint8 *pAdvHandle)
+{
+    static uint8 nextHandle;
+
+    (void)cb;
+    (void)pAdvParam;
+
+    *pAdvHandle = nextHandle++;
+
+    return SUCCESS;
+}
+
+bStatus_t GapAdv_loadByHandle(uint8 handle, GapAdv_dataTypes_t dataType,
+                              uint16 len, uint8 *pBuf)
+{
+    (void)handle;
+    (void)dataType;
+    (void)len;
+    (void)pBuf;
+
+    return SUCCESS;
+}
+
+bStatus_t GapAdv_setEventMask(uint8 handle, uint32 mask)
+{
+    (void)handle;
+    (void)mask;
+
+    return SUCCESS;
+}
+
+bStatus_t GapAdv_enable(uint8 handle, GapAdv_enableOptions_t enableOptions,
+                        uint16 durationOrMaxEvents)
+{
+    (void)handle;
+    (void)enableOptions;
+    (void)durationOrMaxEvents;
+
+    return SUCCESS;
+}
+
+bStatus_t GapAdv_disable(uint8 handle)
+{
+    (void)handle;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * GAP bond manager
+ */
+
+bStatus_t GAPBondMgr_SetParameter(uint16 param, uint8 len, void *pValue)
+{
+    (void)param;
+    (void)len;
+    (void)pValue;
+
+    return SUCCESS;
+}
+
+void GAPBondMgr_Register(gapBondCBs_t *pCB)
+{
+    (void)pCB;
+}
+
+bStatus_t GAPBondMgr_PasscodeRsp(uint16 connectionHandle, uint8 status,
+                                 uint32 passcode)
+{
+    (void)connectionHandle;
+    (void)status;
+    (void)passcode;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * GAP GATT server, GATT client and GATT server application
+ */
+
+bStatus_t GGS_AddService(uint32 services)
+{
+    (void)services;
+
+    return SUCCESS;
+}
+
+bStatus_t GGS_SetParameter(uint8 param, uint8 len, void *value)
+{
+    (void)param;
+    (void)len;
+    (void)value;
+
+    return SUCCESS;
+}
+
+void GATT_InitClient(void)
+{
+}
+
+void GATT_RegisterForMsgs(uint8 taskId)
+{
+    (void)taskId;
+}
+
+bStatus_t GATTServApp_AddService(uint32 services)
+{
+    (void)services;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * HCI
+ */
+
+bStatus_t HCI_ReadRssiCmd(uint16 connHandle)
+{
+    (void)connHandle;
+
+    return SUCCESS;
+}
+
+bStatus_t HCI_LE_ReadLocalSupportedFeaturesCmd(void)
+{
+    return SUCCESS;
+}
+
+bStatus_t HCI_LE_WriteSuggestedDefaultDataLenCmd(uint16 txOctets, uint16 txTime)
+{
+    (void)txOctets;
+    (void)txTime;
+
+    return SUCCESS;
+}
+
+bStatus_t HCI_EXT_SetLocalSupportedFeaturesCmd(uint8 *pLocalFeatures)
+{
+    (void)pLocalFeatures;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * Device information service
+ */
+
+bStatus_t DevInfo_AddService(void)
+{
+    return SUCCESS;
+}
+
+bStatus_t DevInfo_SetParameter(uint8 param, uint8 len, void *value)
+{
+    (void)param;
+    (void)len;
+    (void)value;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * Board keys
+ */
+
+void Board_initKeys(keysPressedCB_t appKeyCB)
+{
+    (void)appKeyCB;
+}
@@ -0,0 +1,898 @@
+/**********************************************************************************************
+ * Filename:       ble_sim.c
+ *
+ * Description:    Simulated BLE link for host builds of the profiles.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "ble_sim.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+// L2CAP basic header carried in front of every ATT PDU
+#define BLESIM_L2CAP_HDR_SIZE       4
+
+// ATT opcode and attribute handle in front of notifications and writes
+#define BLESIM_ATT_HDR_SIZE         3
+
+// Heap block header and alignment
+#define BLESIM_HEAP_HDR_SIZE        8
+#define BLESIM_HEAP_ALIGN           8
+
+// Registered services
+#define BLESIM_MAX_SERVICES         16
+
+// Direction of a PDU on a link
+#define BLESIM_C2P                  0   // Central to peripheral
+#define BLESIM_P2C                  1   // Peripheral to central
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Heap block header, ahead of the block handed out
+typedef struct
+{
+    uint32_t size;
+    uint8_t  role;
+} BleSim_Block_t;
+
+// ATT PDU queued in a controller
+typedef struct BleSim_Pdu
+{
+    struct BleSim_Pdu *pNext;
+    uint8_t  opcode;
+    uint8_t  owner;             // Role whose heap holds pValue
+    uint16_t handle;
+    uint16_t len;
+    uint8_t *pValue;
+    uint16_t fragsLeft;         // LL packets still to be acknowledged
+} BleSim_Pdu_t;
+
+typedef struct
+{
+    BleSim_Pdu_t *pHead;
+    BleSim_Pdu_t *pTail;
+} BleSim_Queue_t;
+
+typedef struct
+{
+    bool                inUse;
+    uint8_t             peerId;
+    BleSim_LinkParams_t params;
+    uint64_t            nextEvent;
+    uint16_t            eventCounter;
+    BleSim_Queue_t      queue[2];
+} BleSim_Link_t;
+
+typedef struct
+{
+    gattAttribute_t        *pAttrs;
+    uint16_t                numAttrs;
+    const gattServiceCBs_t *pCBs;
+} BleSim_Service_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+uint8 linkDBNumConns = BLESIM_MAX_LINKS;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static BleSim_Callbacks_t simCBs;
+static BleSim_Role_t      simRole = BLESIM_PERIPHERAL;
+static uint64_t           simTime = 0;
+static uint64_t           simRandState = 1;
+
+static BleSim_HeapStats_t simHeap[BLESIM_NUM_ROLES];
+
+// Controller TX buffers of each direction, shared by all links
+static uint8_t            simTxBuffers;
+static uint16_t           simTxBuffersUsed[2];
+
+static BleSim_Link_t      simLinks[BLESIM_MAX_LINKS];
+
+static BleSim_Service_t   simServices[BLESIM_MAX_SERVICES];
+static uint16_t           simNextHandle = GATT_MIN_HANDLE;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      BleSim_random
+ *
+ * @brief   Returns a uniformly distributed number in [0, 1).
+ */
+static double BleSim_random(void)
+{
+    // xorshift64*
+    simRandState ^= simRandState >> 12;
+    simRandState ^= simRandState << 25;
+    simRandState ^= simRandState >> 27;
+
+    return (double)((simRandState * 0x2545F4914F6CDD1DULL) >> 11) / (double)(1ULL << 53);
+}
+
+/*********************************************************************
+ * @fn      BleSim_getLink
+ *
+ * @brief   Returns the link of a connection handle if it is up.
+ */
+static BleSim_Link_t *BleSim_getLink(uint16_t connHandle)
+{
+    if ((connHandle < BLESIM_MAX_LINKS) && simLinks[connHandle].inUse)
+    {
+        return &simLinks[connHandle];
+    }
+
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      BleSim_alloc
+ *
+ * @brief   Allocates a block from the heap of a role.
+ */
+static void *BleSim_alloc(BleSim_Role_t role, uint32_t size)
+{
+    BleSim_HeapStats_t *pHeap = &simHeap[role];
+    uint32_t cost = BLESIM_HEAP_HDR_SIZE +
+                    ((size + BLESIM_HEAP_ALIGN - 1) & ~(uint32_t)(BLESIM_HEAP_ALIGN - 1));
+    BleSim_Block_t *pBlock;
+
+    if ((pHeap->used + cost) > pHeap->heapSize)
+    {
+        pHeap->allocFailures++;
+        return NULL;
+    }
+
+    pBlock = malloc(sizeof(BleSim_Block_t) + size);
+    if (pBlock == NULL)
+    {
+        abort();
+    }
+
+    pBlock->size = cost;
+    pBlock->role = role;
+
+    pHeap->used += cost;
+    pHeap->allocs++;
+    if (pHeap->used > pHeap->peakUsed)
+    {
+        pHeap->peakUsed = pHeap->used;
+    }
+
+    return (pBlock + 1);
+}
+
+/*********************************************************************
+ * @fn      BleSim_free
+ *
+ * @brief   Returns a block to the heap it was allocated from.
+ */
+static void BleSim_free(void *p)
+{
+    BleSim_Block_t *pBlock;
+
+    if (p == NULL)
+    {
+        return;
+    }
+
+    pBlock = ((BleSim_Block_t *)p) - 1;
+    simHeap[pBlock->role].used -= pBlock->size;
+
+    free(pBlock);
+}
+
+/*********************************************************************
+ * @fn      BleSim_findAttr
+ *
+ * @brief   Finds a registered attribute by handle.
+ */
+static gattAttribute_t *BleSim_findAttr(uint16_t handle, const gattServiceCBs_t **ppCBs)
+{
+    uint8_t i;
+    uint16_t j;
+
+    for (i = 0; i < BLESIM_MAX_SERVICES; i++)
+    {
+        BleSim_Service_t *pService = &simServices[i];
+
+        for (j = 0; j < pService->numAttrs; j++)
+        {
+            if (pService->pAttrs[j].handle == handle)
+            {
+                *ppCBs = pService->pCBs;
+                return &pService->pAttrs[j];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      BleSim_queuePdu
+ *
+ * @brief   Hands an ATT PDU to the controller of the sending role.
+ *
+ * @return  SUCCESS, bleNotConnected, bleInvalidMtuSize or
+ *          MSG_BUFFER_NOT_AVAIL if the controller TX buffers are taken
+ */
+static bStatus_t BleSim_queuePdu(uint16_t connHandle, uint8_t dir, uint8_t opcode,
+                                 uint16_t handle, uint16_t len, uint8_t *pValue)
+{
+    BleSim_Link_t *pLink = BleSim_getLink(connHandle);
+    BleSim_Queue_t *pQueue;
+    BleSim_Pdu_t *pPdu;
+    uint16_t frags;
+
+    if (pLink == NULL)
+    {
+        return bleNotConnected;
+    }
+
+    if ((len + BLESIM_ATT_HDR_SIZE) > pLink->params.mtu)
+    {
+        return bleInvalidMtuSize;
+    }
+
+    pQueue = &pLink->queue[dir];
+    frags  = (len + BLESIM_ATT_HDR_SIZE + BLESIM_L2CAP_HDR_SIZE + pLink->params.txOctets - 1) /
+             pLink->params.txOctets;
+
+    if ((simTxBuffersUsed[dir] + frags) > simTxBuffers)
+    {
+        return MSG_BUFFER_NOT_AVAIL;
+    }
+
+    pPdu = calloc(1, sizeof(BleSim_Pdu_t));
+    if (pPdu == NULL)
+    {
+        abort();
+    }
+
+    pPdu->opcode    = opcode;
+    pPdu->owner     = (dir == BLESIM_C2P) ? BLESIM_CENTRAL : BLESIM_PERIPHERAL;
+    pPdu->handle    = handle;
+    pPdu->len       = len;
+    pPdu->pValue    = pValue;
+    pPdu->fragsLeft = frags;
+
+    if (pQueue->pTail != NULL)
+    {
+        pQueue->pTail->pNext = pPdu;
+    }
+    else
+    {
+        pQueue->pHead = pPdu;
+    }
+    pQueue->pTail = pPdu;
+    simTxBuffersUsed[dir] += frags;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      BleSim_flushQueue
+ *
+ * @brief   Drops the PDUs a link has queued in a controller.
+ */
+static void BleSim_flushQueue(BleSim_Link_t *pLink, uint8_t dir)
+{
+    BleSim_Queue_t *pQueue = &pLink->queue[dir];
+
+    while (pQueue->pHead != NULL)
+    {
+        BleSim_Pdu_t *pPdu = pQueue->pHead;
+
+        pQueue->pHead = pPdu->pNext;
+        simTxBuffersUsed[dir] -= pPdu->fragsLeft;
+        BleSim_free(pPdu->pValue);
+        free(pPdu);
+    }
+
+    pQueue->pTail = NULL;
+}
+
+/*********************************************************************
+ * @fn      BleSim_deliver
+ *
+ * @brief   Passes a PDU that has fully arrived to the receiving role.
+ */
+static void BleSim_deliver(uint16_t connHandle, BleSim_Pdu_t *pPdu)
+{
+    if (pPdu->opcode == ATT_WRITE_CMD)
+    {
+        const gattServiceCBs_t *pCBs = NULL;
+        gattAttribute_t *pAttr = BleSim_findAttr(pPdu->handle, &pCBs);
+        uint8_t writePermit = GATT_PERMIT_WRITE;
+
+        // Pairing is not simulated, an encrypted link is also authenticated
+        if (BleSim_getLink(connHandle)->params.encrypted)
+        {
+            writePermit |= GATT_PERMIT_ENCRYPT_WRITE | GATT_PERMIT_AUTHEN_WRITE;
+        }
+
+        BleSim_setRole(BLESIM_PERIPHERAL);
+
+        // A write command gets no response, errors are dropped
+        if ((pAttr != NULL) && (pAttr->permissions & writePermit) &&
+            (pCBs != NULL) && (pCBs->pfnWriteAttrCB != NULL))
+        {
+            pCBs->pfnWriteAttrCB(connHandle, pAttr, pPdu->pValue, pPdu->len, 0, ATT_WRITE_CMD);
+        }
+    }
+    else if (simCBs.pfnNotification != NULL)
+    {
+        attHandleValueNoti_t noti;
+
+        noti.handle = pPdu->handle;
+        noti.len    = pPdu->len;
+        noti.pValue = pPdu->pValue;
+
+        BleSim_setRole(BLESIM_CENTRAL);
+        simCBs.pfnNotification(connHandle, &noti);
+    }
+
+    BleSim_free(pPdu->pValue);
+    free(pPdu);
+}
+
+/*********************************************************************
+ * @fn      BleSim_runEvent
+ *
+ * @brief   Runs a connection event of a link. Each packet exchange
+ *          carries an LL packet in each direction, a packet received
+ *          with a CRC error is sent again in the next exchange. PDUs are
+ *          delivered, and completed packets reported, once the event is
+ *          over.
+ */
+static void BleSim_runEvent(uint16_t connHandle)
+{
+    BleSim_Link_t *pLink = &simLinks[connHandle];
+    BleSim_Pdu_t *pDelivered = NULL;
+    BleSim_Pdu_t **ppLast = &pDelivered;
+    uint16_t completed[2] = { 0, 0 };
+    uint16_t packets = 0;
+    uint16_t errors = 0;
+    uint8_t i, dir;
+
+    for (i = 0; i < pLink->params.pktsPerEvent; i++)
+    {
+        bool moreData = FALSE;
+
+        for (dir = 0; dir < 2; dir++)
+        {
+            BleSim_Queue_t *pQueue = &pLink->queue[dir];
+            BleSim_Pdu_t *pPdu = pQueue->pHead;
+
+            if (pPdu == NULL)
+            {
+                continue;
+            }
+
+            moreData = TRUE;
+            packets++;
+
+            if (BleSim_random() < pLink->params.lossRate)
+            {
+                errors++;
+                continue;
+            }
+
+            completed[dir]++;
+            simTxBuffersUsed[dir]--;
+
+            if (--pPdu->fragsLeft == 0)
+            {
+                pQueue->pHead = pPdu->pNext;
+                if (pQueue->pHead == NULL)
+                {
+                    pQueue->pTail = NULL;
+                }
+
+                pPdu->pNext = NULL;
+                *ppLast = pPdu;
+                ppLast = &pPdu->pNext;
+            }
+        }
+
+        if (!moreData)
+        {
+            break;
+        }
+    }
+
+    pLink->eventCounter++;
+    pLink->nextEvent += pLink->params.connIntervalUs;
+
+    while (pDelivered != NULL)
+    {
+        BleSim_Pdu_t *pNext = pDelivered->pNext;
+
+        // The link may have been taken down by the previous delivery
+        if (pLink->inUse)
+        {
+            BleSim_deliver(connHandle, pDelivered);
+        }
+        else
+        {
+            BleSim_free(pDelivered->pValue);
+            free(pDelivered);
+        }
+        pDelivered = pNext;
+    }
+
+    if (!pLink->inUse)
+    {
+        return;
+    }
+
+    if (simCBs.pfnCompletedPackets != NULL)
+    {
+        if (completed[BLESIM_P2C] > 0)
+        {
+            BleSim_setRole(BLESIM_PERIPHERAL);
+            simCBs.pfnCompletedPackets(BLESIM_PERIPHERAL, connHandle, completed[BLESIM_P2C]);
+        }
+        if (completed[BLESIM_C2P] > 0)
+        {
+            BleSim_setRole(BLESIM_CENTRAL);
+            simCBs.pfnCompletedPackets(BLESIM_CENTRAL, connHandle, completed[BLESIM_C2P]);
+        }
+    }
+
+    if (simCBs.pfnConnEvent != NULL)
+    {
+        BleSim_Role_t role;
+
+        for (role = BLESIM_PERIPHERAL; (role < BLESIM_NUM_ROLES) && pLink->inUse; role++)
+        {
+            Gap_ConnEventRpt_t report;
+
+            memset(&report, 0, sizeof(report));
+            report.handle       = connHandle;
+            report.packets      = packets;
+            report.errors       = errors;
+            report.eventCounter = pLink->eventCounter;
+            report.timeStamp    = (uint32_t)(simTime / BLESIM_TICK_PERIOD_US);
+
+            BleSim_setRole(role);
+            simCBs.pfnConnEvent(role, &report);
+        }
+    }
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void BleSim_init(uint32_t heapSize, uint8_t txBuffers, uint32_t seed,
+                 const BleSim_Callbacks_t *pCBs)
+{
+    uint16_t i;
+    BleSim_Role_t role;
+
+    for (i = 0; i < BLESIM_MAX_LINKS; i++)
+    {
+        if (simLinks[i].inUse)
+        {
+            BleSim_disconnect(i);
+        }
+    }
+
+    for (role = BLESIM_PERIPHERAL; role < BLESIM_NUM_ROLES; role++)
+    {
+        memset(&simHeap[role], 0, sizeof(BleSim_HeapStats_t));
+        simHeap[role].heapSize = heapSize;
+    }
+
+    simTxBuffers        = txBuffers;
+    simTxBuffersUsed[0] = 0;
+    simTxBuffersUsed[1] = 0;
+
+    memset(simServices, 0, sizeof(simServices));
+    simNextHandle = GATT_MIN_HANDLE;
+
+    memset(&simCBs, 0, sizeof(simCBs));
+    if (pCBs != NULL)
+    {
+        simCBs = *pCBs;
+    }
+
+    simTime      = 0;
+    simRandState = ((uint64_t)seed << 1) | 1;
+    simRole      = BLESIM_PERIPHERAL;
+}
+
+void BleSim_setRole(BleSim_Role_t role)
+{
+    simRole = role;
+}
+
+uint16_t BleSim_connect(const BleSim_LinkParams_t *pParams, uint8_t peerId)
+{
+    uint16_t i;
+
+    for (i = 0; i < BLESIM_MAX_LINKS; i++)
+    {
+        BleSim_Link_t *pLink = &simLinks[i];
+
+        if (!pLink->inUse)
+        {
+            memset(pLink, 0, sizeof(BleSim_Link_t));
+
+            pLink->inUse        = TRUE;
+            pLink->peerId       = peerId;
+            pLink->params       = *pParams;
+            // Spread the anchor points of the links over the interval
+            pLink->nextEvent    = simTime + pParams->connIntervalUs +
+                                  (i * pParams->connIntervalUs) / BLESIM_MAX_LINKS;
+
+            return i;
+        }
+    }
+
+    return CONNHANDLE_INVALID;
+}
+
+void BleSim_disconnect(uint16_t connHandle)
+{
+    BleSim_Link_t *pLink = BleSim_getLink(connHandle);
+    uint8_t i;
+    uint16_t j;
+
+    if (pLink == NULL)
+    {
+        return;
+    }
+
+    BleSim_flushQueue(pLink, BLESIM_C2P);
+    BleSim_flushQueue(pLink, BLESIM_P2C);
+    pLink->inUse = FALSE;
+
+    // The GATT server forgets the CCCs of a peer that is not bonded
+    for (i = 0; i < BLESIM_MAX_SERVICES; i++)
+    {
+        for (j = 0; j < simServices[i].numAttrs; j++)
+        {
+            gattAttribute_t *pAttr = &simServices[i].pAttrs[j];
+
+            if ((pAttr->type.len == ATT_BT_UUID_SIZE) &&
+                !memcmp(pAttr->type.uuid, clientCharCfgUUID, ATT_BT_UUID_SIZE))
+            {
+                GATTServApp_InitCharCfg(connHandle, GATT_CCC_TBL(pAttr->pValue));
+            }
+        }
+    }
+}
+
+uint64_t BleSim_now(void)
+{
+    return simTime;
+}
+
+uint64_t BleSim_nextEventTime(void)
+{
+    uint64_t next = UINT64_MAX;
+    uint16_t i;
+
+    for (i = 0; i < BLESIM_MAX_LINKS; i++)
+    {
+        if (simLinks[i].inUse && (simLinks[i].nextEvent < next))
+        {
+            next = simLinks[i].nextEvent;
+        }
+    }
+
+    return next;
+}
+
+void BleSim_runUntil(uint64_t timeUs)
+{
+    uint64_t next;
+
+    while ((next = BleSim_nextEventTime()) <= timeUs)
+    {
+        uint16_t i;
+
+        simTime = next;
+
+        for (i = 0; i < BLESIM_MAX_LINKS; i++)
+        {
+            if (simLinks[i].inUse && (simLinks[i].nextEvent == next))
+            {
+                BleSim_runEvent(i);
+            }
+        }
+    }
+
+    simTime = timeUs;
+}
+
+uint16_t BleSim_findAttrHandle(const uint8_t *pUUID, uint8_t len)
+{
+    uint8_t i;
+    uint16_t j;
+
+    for (i = 0; i < BLESIM_MAX_SERVICES; i++)
+    {
+        for (j = 0; j < simServices[i].numAttrs; j++)
+        {
+            gattAttribute_t *pAttr = &simServices[i].pAttrs[j];
+
+            if ((pAttr->type.len == len) && !memcmp(pAttr->type.uuid, pUUID, len))
+            {
+                return pAttr->handle;
+            }
+        }
+    }
+
+    return GATT_INVALID_HANDLE;
+}
+
+void BleSim_getHeapStats(BleSim_Role_t role, BleSim_HeapStats_t *pStats)
+{
+    *pStats = simHeap[role];
+}
+
+/*********************************************************************
+ * ICall
+ */
+
+void *ICall_malloc(uint_least16_t size)
+{
+    return BleSim_alloc(simRole, size);
+}
+
+void ICall_free(void *msg)
+{
+    BleSim_free(msg);
+}
+
+void ICall_getHeapStats(ICall_heapStats_t *stats)
+{
+    stats->totalSize       = simHeap[simRole].heapSize;
+    stats->totalFreeSize   = simHeap[simRole].heapSize - simHeap[simRole].used;
+    stats->largestFreeSize = stats->totalFreeSize;
+}
+
+ICall_CSState ICall_enterCriticalSection(void)
+{
+    return 0;
+}
+
+void ICall_leaveCriticalSection(ICall_CSState key)
+{
+    (void)key;
+}
+
+uint_fast32_t ICall_getTicks(void)
+{
+    return (uint_fast32_t)(uint32_t)(simTime / BLESIM_TICK_PERIOD_US);
+}
+
+uint_fast32_t ICall_getTickPeriod(void)
+{
+    return BLESIM_TICK_PERIOD_US;
+}
+
+/*********************************************************************
+ * linkDB
+ */
+
+uint8 linkDB_State(uint16 connectionHandle, uint8 state)
+{
+    return (BleSim_getLink(connectionHandle) != NULL) == (state == LINK_CONNECTED);
+}
+
+uint8 linkDB_NumActive(void)
+{
+    uint8 num = 0;
+    uint16_t i;
+
+    for (i = 0; i < BLESIM_MAX_LINKS; i++)
+    {
+        num += simLinks[i].inUse ? 1 : 0;
+    }
+
+    return num;
+}
+
+bStatus_t linkDB_GetInfo(uint16 connectionHandle, linkDBInfo_t *pInfo)
+{
+    BleSim_Link_t *pLink = BleSim_getLink(connectionHandle);
+
+    if (pLink == NULL)
+    {
+        return bleNotConnected;
+    }
+
+    memset(pInfo, 0, sizeof(linkDBInfo_t));
+    pInfo->stateFlags   = LINK_CONNECTED;
+    pInfo->addr[0]      = pLink->peerId;
+    pInfo->connInterval = (uint16)(pLink->params.connIntervalUs / 1250);
+    pInfo->MTU          = pLink->params.mtu;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * GATT
+ */
+
+void *GATT_bm_alloc(uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc)
+{
+    BleSim_Link_t *pLink = BleSim_getLink(connHandle);
+    uint8_t *pBuf;
+
+    if (pLink == NULL)
+    {
+        return NULL;
+    }
+
+    // Notifications and writes are cut to what fits the ATT MTU
+    if ((opcode == ATT_HANDLE_VALUE_NOTI) || (opcode == ATT_HANDLE_VALUE_IND) ||
+        (opcode == ATT_WRITE_CMD) || (opcode == ATT_WRITE_REQ))
+    {
+        if (size > (pLink->params.mtu - BLESIM_ATT_HDR_SIZE))
+        {
+            size = pLink->params.mtu - BLESIM_ATT_HDR_SIZE;
+        }
+    }
+
+    pBuf = BleSim_alloc(simRole, size);
+
+    if ((pBuf != NULL) && (pSizeAlloc != NULL))
+    {
+        *pSizeAlloc = size;
+    }
+
+    return pBuf;
+}
+
+void GATT_bm_free(gattMsg_t *pMsg, uint8 opcode)
+{
+    (void)opcode;
+
+    // Notifications, indications and writes keep their value at the same place
+    BleSim_free(pMsg->handleValueNoti.pValue);
+    pMsg->handleValueNoti.pValue = NULL;
+}
+
+bStatus_t GATT_Notification(uint16 connHandle, attHandleValueNoti_t *pNoti, uint8 authenticated)
+{
+    (void)authenticated;
+
+    return BleSim_queuePdu(connHandle, BLESIM_P2C, ATT_HANDLE_VALUE_NOTI,
+                           pNoti->handle, pNoti->len, pNoti->pValue);
+}
+
+bStatus_t GATT_Indication(uint16 connHandle, attHandleValueInd_t *pInd, uint8 authenticated, uint8 taskId)
+{
+    (void)authenticated;
+    (void)taskId;
+
+    // Delivered like a notification, the confirmation is not simulated
+    return BleSim_queuePdu(connHandle, BLESIM_P2C, ATT_HANDLE_VALUE_IND,
+                           pInd->handle, pInd->len, pInd->pValue);
+}
+
+bStatus_t GATT_WriteNoRsp(uint16 connHandle, attWriteReq_t *pReq)
+{
+    return BleSim_queuePdu(connHandle, BLESIM_C2P, ATT_WRITE_CMD,
+                           pReq->handle, pReq->len, pReq->pValue);
+}
+
+/*********************************************************************
+ * GATTServApp
+ */
+
+bStatus_t GATTServApp_RegisterService(gattAttribute_t *pAttrs, uint16 numAttrs,
+                                      uint8 encKeySize, CONST gattServiceCBs_t *pServiceCBs)
+{
+    uint8_t i;
+    uint16_t j;
+
+    (void)encKeySize;
+
+    for (i = 0; i < BLESIM_MAX_SERVICES; i++)
+    {
+        if (simServices[i].pAttrs == NULL)
+        {
+            simServices[i].pAttrs   = pAttrs;
+            simServices[i].numAttrs = numAttrs;
+            simServices[i].pCBs     = pServiceCBs;
+
+            for (j = 0; j < numAttrs; j++)
+            {
+                pAttrs[j].handle = simNextHandle++;
+            }
+
+            return SUCCESS;
+        }
+    }
+
+    return bleNoResources;
+}
+
+bStatus_t GATTServApp_DeregisterService(uint16 handle, gattAttribute_t **p2pAttrs)
+{
+    uint8_t i;
+
+    for (i = 0; i < BLESIM_MAX_SERVICES; i++)
+    {
+        if ((simServices[i].pAttrs != NULL) && (simServices[i].pAttrs[0].handle == handle))
+        {
+            if (p2pAttrs != NULL)
+            {
+                *p2pAttrs = simServices[i].pAttrs;
+            }
+
+            memset(&simServices[i], 0, sizeof(BleSim_Service_t));
+
+            return SUCCESS;
+        }
+    }
+
+    return FAILURE;
+}
+
+/*********************************************************************
+ * GAP
+ */
+
+bStatus_t Gap_RegisterConnEventCb(pfnGapConnEvtCB_t cb, uint8 action, uint16 connHandle)
+{
+    (void)cb;
+    (void)action;
+    (void)connHandle;
+
+    // Connection events are always reported through BleSim_Callbacks_t
+    return SUCCESS;
+}
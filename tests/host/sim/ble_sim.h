@@ -0,0 +1,186 @@
+/**********************************************************************************************
+ * Filename:       ble_sim.h
+ *
+ * Description:    Simulated BLE link for host builds of the profiles. It stands in
+ *                 for the ICall heap, linkDB, the GATT server and the controller of
+ *                 both ends of one or more connections.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _BLE_SIM_H_
+#define _BLE_SIM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include "icall_ble_api.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Connections that can be up at the same time, also linkDBNumConns
+#define BLESIM_MAX_LINKS            4
+
+// Microseconds per ICall tick, as on the CC26xx
+#define BLESIM_TICK_PERIOD_US       10
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// End of the link a call into the stack is made from. The peripheral
+// runs the GATT server, the central the GATT client.
+typedef enum
+{
+    BLESIM_PERIPHERAL = 0,
+    BLESIM_CENTRAL,
+    BLESIM_NUM_ROLES
+} BleSim_Role_t;
+
+// Connection parameters
+typedef struct
+{
+    uint16_t mtu;               // ATT MTU
+    uint16_t txOctets;          // LL payload size, 27 to 251
+    uint32_t connIntervalUs;    // Connection interval
+    uint8_t  pktsPerEvent;      // LL packet exchanges per connection event
+    double   lossRate;          // Share of LL packets received with a CRC error and resent
+    bool     encrypted;         // Writes needing encryption or authentication are accepted
+} BleSim_LinkParams_t;
+
+// Events reported to the host side of the roles
+typedef struct
+{
+    // A notification has been received by the central
+    void (*pfnNotification)(uint16_t connHandle, attHandleValueNoti_t *pNoti);
+    // LL packets sent by a role have been acknowledged by its peer
+    void (*pfnCompletedPackets)(BleSim_Role_t role, uint16_t connHandle, uint16_t numPkts);
+    // A connection event has ended
+    void (*pfnConnEvent)(BleSim_Role_t role, Gap_ConnEventRpt_t *pReport);
+} BleSim_Callbacks_t;
+
+// Heap usage of a role
+typedef struct
+{
+    uint32_t heapSize;          // Size of the heap
+    uint32_t used;              // Bytes allocated, allocation overhead included
+    uint32_t peakUsed;          // Largest value of used
+    uint32_t allocs;            // Successful allocations
+    uint32_t allocFailures;     // Allocations refused for lack of heap
+} BleSim_HeapStats_t;
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*
+ * BleSim_init - Resets the simulation. Each role gets a heap and a pool of
+ *               controller TX buffers, shared by all its links, of the
+ *               given size.
+ *
+ *    heapSize  - heap size of each role in bytes
+ *    txBuffers - controller TX buffers of each role
+ *    seed      - seed of the packet loss generator
+ *    pCBs      - event callbacks, may be NULL
+ */
+extern void     BleSim_init(uint32_t heapSize, uint8_t txBuffers, uint32_t seed,
+                            const BleSim_Callbacks_t *pCBs);
+
+/*
+ * BleSim_setRole - Selects the role whose heap and stack the following calls use.
+ *                  Callbacks are made with the role they are addressed to selected.
+ */
+extern void     BleSim_setRole(BleSim_Role_t role);
+
+/*
+ * BleSim_connect - Establishes a connection to the peer with the given address.
+ *                  The lowest free connection handle is used.
+ *
+ *    pParams - connection parameters
+ *    peerId  - last byte of the peer address, both ends see the same address
+ *
+ *    returns - connection handle, CONNHANDLE_INVALID if all links are up
+ */
+extern uint16_t BleSim_connect(const BleSim_LinkParams_t *pParams, uint8_t peerId);
+
+/*
+ * BleSim_disconnect - Terminates a connection. Packets still queued in the
+ *                     controllers are lost and the CCCs of the connection
+ *                     are cleared.
+ */
+extern void     BleSim_disconnect(uint16_t connHandle);
+
+/*
+ * BleSim_now - Returns the simulation time in microseconds.
+ */
+extern uint64_t BleSim_now(void);
+
+/*
+ * BleSim_nextEventTime - Returns the time of the next connection event,
+ *                        UINT64_MAX if no link is up.
+ */
+extern uint64_t BleSim_nextEventTime(void);
+
+/*
+ * BleSim_runUntil - Runs the connection events due until the given time
+ *                   and advances the simulation time to it.
+ */
+extern void     BleSim_runUntil(uint64_t timeUs);
+
+/*
+ * BleSim_findAttrHandle - Returns the handle of the first registered attribute
+ *                         of the given type, GATT_INVALID_HANDLE if none.
+ */
+extern uint16_t BleSim_findAttrHandle(const uint8_t *pUUID, uint8_t len);
+
+/*
+ * BleSim_getHeapStats - Copies the heap usage of a role.
+ */
+extern void     BleSim_getHeapStats(BleSim_Role_t role, BleSim_HeapStats_t *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLE_SIM_H_ */
@@ -0,0 +1,227 @@
+/**********************************************************************************************
+ * Filename:       gattservapp_util_sim.c
+ *
+ * Description:    GATTServApp CCC and attribute helpers for host builds that do
+ *                 not link a stack's gattservapp_util.c. Same behaviour as the
+ *                 stack's implementation.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "icall_ble_api.h"
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static gattCharCfg_t *gattServAppSim_FindCharCfgItem( uint16 connHandle,
+                                                      gattCharCfg_t *charCfgTbl )
+{
+  uint8 i;
+
+  for ( i = 0; i < linkDBNumConns; i++ )
+  {
+    if ( charCfgTbl[i].connHandle == connHandle )
+    {
+      return ( &(charCfgTbl[i]) );
+    }
+  }
+
+  return ( (gattCharCfg_t *)NULL );
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void GATTServApp_InitCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+  if ( connHandle == INVALID_CONNHANDLE )
+  {
+    uint8 i;
+
+    for ( i = 0; i < linkDBNumConns; i++ )
+    {
+      charCfgTbl[i].connHandle = INVALID_CONNHANDLE;
+      charCfgTbl[i].value = GATT_CFG_NO_OPERATION;
+    }
+  }
+  else
+  {
+    gattCharCfg_t *pItem = gattServAppSim_FindCharCfgItem( connHandle, charCfgTbl );
+
+    if ( pItem != NULL )
+    {
+      pItem->connHandle = INVALID_CONNHANDLE;
+      pItem->value = GATT_CFG_NO_OPERATION;
+    }
+  }
+}
+
+uint16 GATTServApp_ReadCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+  gattCharCfg_t *pItem = gattServAppSim_FindCharCfgItem( connHandle, charCfgTbl );
+
+  return ( (pItem != NULL) ? (uint16)(pItem->value) : (uint16)GATT_CFG_NO_OPERATION );
+}
+
+uint8 GATTServApp_WriteCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl, uint16 value )
+{
+  gattCharCfg_t *pItem = gattServAppSim_FindCharCfgItem( connHandle, charCfgTbl );
+
+  if ( pItem == NULL )
+  {
+    pItem = gattServAppSim_FindCharCfgItem( INVALID_CONNHANDLE, charCfgTbl );
+    if ( pItem == NULL )
+    {
+      return ( ATT_ERR_INSUFFICIENT_RESOURCES );
+    }
+
+    pItem->connHandle = connHandle;
+  }
+
+  pItem->value = value;
+
+  return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_ProcessCCCWriteReq( uint16 connHandle, gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint16 len, uint16 offset,
+                                          uint16 validCfg )
+{
+  uint16 value;
+
+  if ( offset != 0 )
+  {
+    return ( ATT_ERR_ATTR_NOT_LONG );
+  }
+
+  if ( len != 2 )
+  {
+    return ( ATT_ERR_INVALID_VALUE_SIZE );
+  }
+
+  value = BUILD_UINT16( pValue[0], pValue[1] );
+  if ( ( value & ~validCfg ) != 0 )
+  {
+    return ( ATT_ERR_INVALID_VALUE );
+  }
+
+  if ( GATTServApp_ReadCharCfg( connHandle, GATT_CCC_TBL( pAttr->pValue ) ) != value )
+  {
+    return ( GATTServApp_WriteCharCfg( connHandle, GATT_CCC_TBL( pAttr->pValue ), value ) );
+  }
+
+  return ( SUCCESS );
+}
+
+gattAttribute_t *GATTServApp_FindAttr( gattAttribute_t *pAttrTbl, uint16 numAttrs, uint8 *pValue )
+{
+  uint16 i;
+
+  for ( i = 0; i < numAttrs; i++ )
+  {
+    if ( pAttrTbl[i].pValue == pValue )
+    {
+      return ( &(pAttrTbl[i]) );
+    }
+  }
+
+  return ( (gattAttribute_t *)NULL );
+}
+
+bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                      uint8 authenticated, gattAttribute_t *attrTbl,
+                                      uint16 numAttrs, uint8 taskId,
+                                      pfnGATTReadAttrCB_t pfnReadAttrCB )
+{
+  bStatus_t status = SUCCESS;
+  gattAttribute_t *pAttr;
+  uint8 i;
+
+  (void)taskId;
+
+  if ( ( charCfgTbl == NULL ) || ( pValue == NULL ) ||
+       ( attrTbl == NULL )    || ( pfnReadAttrCB == NULL ) )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  pAttr = GATTServApp_FindAttr( attrTbl, numAttrs, pValue );
+  if ( pAttr == NULL )
+  {
+    return ( status );
+  }
+
+  // Notifications only, the value is read again for each client
+  for ( i = 0; i < linkDBNumConns; i++ )
+  {
+    gattCharCfg_t *pItem = &(charCfgTbl[i]);
+
+    if ( ( pItem->connHandle != INVALID_CONNHANDLE ) &&
+         ( pItem->value & GATT_CLIENT_CFG_NOTIFY ) )
+    {
+      attHandleValueNoti_t noti;
+      bStatus_t notiStatus;
+      uint16 len;
+
+      noti.pValue = (uint8 *)GATT_bm_alloc( pItem->connHandle, ATT_HANDLE_VALUE_NOTI,
+                                            GATT_MAX_MTU, &len );
+      if ( noti.pValue == NULL )
+      {
+        status |= bleNoResources;
+        continue;
+      }
+
+      notiStatus = (*pfnReadAttrCB)( pItem->connHandle, pAttr, noti.pValue, &noti.len,
+                                     0, len, GATT_LOCAL_READ );
+      if ( notiStatus == SUCCESS )
+      {
+        noti.handle = pAttr->handle;
+        notiStatus = GATT_Notification( pItem->connHandle, &noti, authenticated );
+      }
+
+      if ( notiStatus != SUCCESS )
+      {
+        GATT_bm_free( (gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI );
+      }
+
+      status |= notiStatus;
+    }
+  }
+
+  return ( status );
+}
@@ -0,0 +1,221 @@
+/**********************************************************************************************
+ * Filename:       nvs_sim.c
+ *
+ * Description:    This file contains a simulated NVS flash region. Writes can only
+ *                 clear bits, erases set a whole sector to 0xFF, and the power can be
+ *                 cut in the middle of an operation.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "nvs_sim.h"
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8_t        nvsSimFlash[NVSSIM_MAX_REGION_SIZE];
+static uint32_t       nvsSimSectorSize;
+static uint32_t       nvsSimRegionSize;
+static int32_t        nvsSimBudget = NVSSIM_NO_POWER_CUT;
+static NvsSim_Stats_t nvsSimStats;
+
+// Any non NULL handle, the region is the same for every index
+static uint8_t        nvsSimHandle;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      NvsSim_powerCut
+ *
+ * @brief   Uses up one operation of the power cut budget.
+ *
+ * @return  true if the power is cut before the operation.
+ */
+static bool NvsSim_powerCut(void)
+{
+    if (nvsSimBudget == 0)
+    {
+        return true;
+    }
+
+    if (nvsSimBudget > 0)
+    {
+        nvsSimBudget--;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void NvsSim_init(uint32_t sectorSize, uint8_t numSectors)
+{
+    nvsSimSectorSize = sectorSize;
+    nvsSimRegionSize = sectorSize * numSectors;
+    if (nvsSimRegionSize > NVSSIM_MAX_REGION_SIZE)
+    {
+        nvsSimRegionSize = NVSSIM_MAX_REGION_SIZE - (NVSSIM_MAX_REGION_SIZE % sectorSize);
+    }
+
+    memset(nvsSimFlash, 0xFF, sizeof(nvsSimFlash));
+    memset(&nvsSimStats, 0, sizeof(nvsSimStats));
+    nvsSimBudget = NVSSIM_NO_POWER_CUT;
+}
+
+void NvsSim_setPowerCut(int32_t budget)
+{
+    nvsSimBudget = budget;
+}
+
+void NvsSim_getStats(NvsSim_Stats_t *pStats)
+{
+    *pStats = nvsSimStats;
+}
+
+/*********************************************************************
+ * NVS driver
+ */
+
+void NVS_init(void)
+{
+}
+
+void NVS_Params_init(NVS_Params *params)
+{
+    params->custom = NULL;
+}
+
+NVS_Handle NVS_open(uint_least8_t index, NVS_Params *params)
+{
+    (void)index;
+    (void)params;
+
+    return (nvsSimRegionSize != 0) ? (NVS_Handle)&nvsSimHandle : NULL;
+}
+
+void NVS_close(NVS_Handle handle)
+{
+    (void)handle;
+}
+
+void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *attrs)
+{
+    (void)handle;
+
+    attrs->regionBase = nvsSimFlash;
+    attrs->regionSize = nvsSimRegionSize;
+    attrs->sectorSize = nvsSimSectorSize;
+}
+
+int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer, size_t bufferSize)
+{
+    (void)handle;
+
+    if (offset + bufferSize > nvsSimRegionSize)
+    {
+        return NVS_STATUS_INV_OFFSET;
+    }
+
+    nvsSimStats.reads++;
+    nvsSimStats.bytesRead += bufferSize;
+    memcpy(buffer, &nvsSimFlash[offset], bufferSize);
+
+    return NVS_STATUS_SUCCESS;
+}
+
+int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer, size_t bufferSize,
+                       uint_fast16_t flags)
+{
+    const uint8_t *pSrc = (const uint8_t *)buffer;
+    size_t i;
+
+    (void)handle;
+
+    if (offset + bufferSize > nvsSimRegionSize)
+    {
+        return NVS_STATUS_INV_OFFSET;
+    }
+
+    nvsSimStats.writes++;
+
+    for (i = 0; i < bufferSize; i++)
+    {
+        if (NvsSim_powerCut())
+        {
+            return NVS_STATUS_ERROR;
+        }
+
+        // Programming can only clear bits
+        nvsSimFlash[offset + i] &= pSrc[i];
+        nvsSimStats.bytesWritten++;
+    }
+
+    if ((flags & NVS_WRITE_POST_VERIFY) &&
+        memcmp(&nvsSimFlash[offset], buffer, bufferSize))
+    {
+        return NVS_STATUS_ERROR;
+    }
+
+    return NVS_STATUS_SUCCESS;
+}
+
+int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size)
+{
+    (void)handle;
+
+    if ((offset % nvsSimSectorSize) || (size % nvsSimSectorSize) ||
+        (offset + size > nvsSimRegionSize))
+    {
+        return NVS_STATUS_INV_OFFSET;
+    }
+
+    if (NvsSim_powerCut())
+    {
+        return NVS_STATUS_ERROR;
+    }
+
+    nvsSimStats.erases += size / nvsSimSectorSize;
+    memset(&nvsSimFlash[offset], 0xFF, size);
+
+    return NVS_STATUS_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/**********************************************************************************************
+ * Filename:       nvs_sim.h
+ *
+ * Description:    This file contains the control interface of the simulated NVS
+ *                 flash region.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _NVS_SIM_H_
+#define _NVS_SIM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <ti/drivers/NVS.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Largest simulated region
+#define NVSSIM_MAX_REGION_SIZE      (64 * 1024)
+
+// Unlimited byte operations before a power cut
+#define NVSSIM_NO_POWER_CUT         (-1)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Flash operations made since the last NvsSim_init
+typedef struct
+{
+    uint32_t reads;             // NVS_read calls
+    uint32_t bytesRead;
+    uint32_t writes;            // NVS_write calls
+    uint32_t bytesWritten;
+    uint32_t erases;            // Sectors erased
+} NvsSim_Stats_t;
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*
+ * NvsSim_init - Erases the region and clears the statistics. Every
+ *               NVS index opens the same region.
+ *
+ *    sectorSize - erase sector size in bytes
+ *    numSectors - sectors in the region
+ */
+extern void NvsSim_init(uint32_t sectorSize, uint8_t numSectors);
+
+/*
+ * NvsSim_setPowerCut - Cuts the power after the given number of byte
+ *                      writes and sector erases. A cut write leaves the
+ *                      bytes before the cut written, and a cut erase
+ *                      leaves the sector as it was. Further operations
+ *                      fail until this is called again.
+ *
+ *    budget - operations before the cut, or NVSSIM_NO_POWER_CUT
+ */
+extern void NvsSim_setPowerCut(int32_t budget);
+
+/*
+ * NvsSim_getStats - Returns the flash operations made so far.
+ */
+extern void NvsSim_getStats(NvsSim_Stats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NVS_SIM_H_ */
@@ -0,0 +1,277 @@
+/**********************************************************************************************
+ * Filename:       rtos_sim.c
+ *
+ * Description:    This file contains simulated TI-RTOS kernel objects and application
+ *                 utilities for host builds of the applications. Tasks never run and clocks
+ *                 never expire: the host program calls the application functions itself, and
+ *                 collects the events and messages the application posts to its own task.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/sysbios/knl/Task.h>
+
+#include "icall.h"
+#include "util.h"
+#include "ble_sim.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Message queued by Util_enqueueMsg
+typedef struct
+{
+    Queue_Elem elem;
+    uint8_t   *pData;
+} RtosSim_QueueRec_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+uint32_t Clock_tickPeriod = BLESIM_TICK_PERIOD_US;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Event of the one application registered with ICall
+static Event_Struct rtosSimAppEvent;
+
+/*********************************************************************
+ * Task
+ */
+
+void Task_Params_init(Task_Params *pParams)
+{
+    memset(pParams, 0, sizeof(Task_Params));
+}
+
+void Task_construct(Task_Struct *pTask, Task_FuncPtr fxn,
+                    const Task_Params *pParams, void *pEb)
+{
+    (void)pParams;
+    (void)pEb;
+
+    // Never run, the host program calls the application itself
+    pTask->fxn = fxn;
+}
+
+/*********************************************************************
+ * Clock
+ */
+
+uint32_t Clock_getTicks(void)
+{
+    return (uint32_t)ICall_getTicks();
+}
+
+void Clock_destruct(Clock_Struct *pClock)
+{
+    if (pClock != NULL)
+    {
+        pClock->active = false;
+    }
+}
+
+/*********************************************************************
+ * Event
+ */
+
+void Event_post(Event_Handle handle, uint32_t eventMask)
+{
+    handle->posted |= eventMask;
+}
+
+uint32_t Event_pend(Event_Handle handle, uint32_t andMask,
+                    uint32_t orMask, uint32_t timeout)
+{
+    uint32_t events = handle->posted & orMask;
+
+    (void)andMask;
+    (void)timeout;
+
+    handle->posted &= ~events;
+
+    return events;
+}
+
+/*********************************************************************
+ * Queue
+ */
+
+bool Queue_empty(Queue_Handle handle)
+{
+    return (handle->pHead == NULL);
+}
+
+void Queue_put(Queue_Handle handle, Queue_Elem *pElem)
+{
+    pElem->next = NULL;
+
+    if (handle->pTail != NULL)
+    {
+        handle->pTail->next = pElem;
+    }
+    else
+    {
+        handle->pHead = pElem;
+    }
+    handle->pTail = pElem;
+}
+
+Queue_Elem *Queue_get(Queue_Handle handle)
+{
+    Queue_Elem *pElem = handle->pHead;
+
+    if (pElem != NULL)
+    {
+        handle->pHead = pElem->next;
+        if (handle->pHead == NULL)
+        {
+            handle->pTail = NULL;
+        }
+    }
+
+    return pElem;
+}
+
+/*********************************************************************
+ * Util
+ */
+
+Clock_Struct *Util_constructClock(Clock_Struct *pClock, Clock_FuncPtr clockCB,
+                                  uint32_t clockDuration, uint32_t clockPeriod,
+                                  uint8_t startFlag, UArg arg)
+{
+    pClock->fxn     = clockCB;
+    pClock->arg     = arg;
+    pClock->timeout = clockDuration;
+    pClock->period  = clockPeriod;
+    pClock->active  = startFlag;
+
+    return pClock;
+}
+
+void Util_startClock(Clock_Struct *pClock)
+{
+    pClock->active = true;
+}
+
+void Util_stopClock(Clock_Struct *pClock)
+{
+    pClock->active = false;
+}
+
+bool Util_isActive(Clock_Struct *pClock)
+{
+    return pClock->active;
+}
+
+Queue_Handle Util_constructQueue(Queue_Struct *pQueue)
+{
+    pQueue->pHead = NULL;
+    pQueue->pTail = NULL;
+
+    return pQueue;
+}
+
+uint8_t Util_enqueueMsg(Queue_Handle msgQueue, Event_Handle event, uint8_t *pMsg)
+{
+    RtosSim_QueueRec_t *pRec = malloc(sizeof(RtosSim_QueueRec_t));
+
+    if (pRec == NULL)
+    {
+        return FALSE;
+    }
+
+    pRec->pData = pMsg;
+    Queue_put(msgQueue, &pRec->elem);
+
+    if (event != NULL)
+    {
+        Event_post(event, UTIL_QUEUE_EVENT_ID);
+    }
+
+    return TRUE;
+}
+
+uint8_t *Util_dequeueMsg(Queue_Handle msgQueue)
+{
+    RtosSim_QueueRec_t *pRec = (RtosSim_QueueRec_t *)Queue_get(msgQueue);
+    uint8_t *pData = NULL;
+
+    if (pRec != NULL)
+    {
+        pData = pRec->pData;
+        free(pRec);
+    }
+
+    return pData;
+}
+
+/*********************************************************************
+ * ICall
+ */
+
+ICall_Errno ICall_registerApp(ICall_EntityID *pEntity, ICall_SyncHandle *pSyncHandle)
+{
+    memset(&rtosSimAppEvent, 0, sizeof(rtosSimAppEvent));
+
+    *pEntity = 0;
+    *pSyncHandle = &rtosSimAppEvent;
+
+    return ICALL_ERRNO_SUCCESS;
+}
+
+ICall_Errno ICall_fetchServiceMsg(ICall_ServiceEnum *pSrc, ICall_EntityID *pDest,
+                                  void **ppMsg)
+{
+    (void)pSrc;
+    (void)pDest;
+    (void)ppMsg;
+
+    // Stack messages are passed to the application by the host program
+    return ICALL_ERRNO_NOMSG;
+}
+
+void ICall_freeMsg(void *msg)
+{
+    ICall_free(msg);
+}
@@ -0,0 +1,819 @@
+/**********************************************************************************************
+ * Filename:       stream_bench.c
+ *
+ * Description:    Throughput benchmark of the Simple Stream profiles on a simulated
+ *                 link. The server and client profiles stream to each other through
+ *                 sim/ble_sim.c and the benchmark reports goodput, end-to-end latency
+ *                 percentiles and heap usage for a set of workload shapes.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream_bench.h"
+#include "simple_stream_profile_server.h"
+
+/*********************************************************************
+ * DEFINES
+ */
+
+// Heap of each device
+#define BENCH_HEAP_SIZE             12288
+
+// Server queue watermarks used by producers that write as fast as they can
+#define BENCH_HIGH_WATERMARK        4096
+#define BENCH_LOW_WATERMARK         1024
+
+// Client queue depth kept by producers that write as fast as they can
+#define BENCH_CLIENT_QUEUE          4096
+
+// Heap the profiles leave free for the stack
+#define BENCH_HEAP_HEADROOM         1024
+
+// Time allowed for the queues to drain once the producers have stopped
+#define BENCH_DRAIN_MS              2000
+
+// Largest message a workload writes
+#define BENCH_MAX_MSG_LEN           2048
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Workload shape and the limits it is checked against
+typedef struct
+{
+    const char         *name;
+    const char         *description;
+    bool                upload;         // Client writes to the server instead of being notified
+    bool                reliable;       // Reliable stream mode
+    uint8_t             numLinks;
+    BleSim_LinkParams_t link;
+    uint8_t             txBuffers;      // Controller TX buffers of each device
+    uint16_t            msgLen;         // Bytes per SimpleStream*_sendData call
+    uint32_t            msgPeriodUs;    // 0 to write whenever the profile takes data
+    uint32_t            durationMs;     // Time the producers run
+    uint32_t            reconnectAtMs;  // Time the first link is dropped, 0 for never
+    uint32_t            downtimeMs;     // Time until it is reconnected
+    // Limits, only checked with the default parameters
+    uint32_t            minGoodputKbps;
+    uint32_t            maxP99LatencyMs;
+    uint32_t            maxHeapPeak;    // Heap used by the sending device
+} BenchWorkload_t;
+
+// Latency of a message, recorded once its last byte has been received
+typedef struct
+{
+    uint32_t endOffset;
+    uint64_t queuedAt;
+} BenchMsg_t;
+
+// Stream state of a link
+typedef struct
+{
+    uint16_t    connHandle;
+    uint8_t     peerId;
+    uint32_t    txBytes;        // Bytes taken by the sending profile
+    uint32_t    rxBytes;        // Bytes received in order
+    uint32_t    badBytes;       // Bytes received with the wrong content
+    BenchMsg_t *pMsgs;          // Messages waiting for their last byte
+    uint32_t    msgHead;
+    uint32_t    msgTail;
+    uint32_t    msgCap;
+} BenchLink_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const BenchWorkload_t benchWorkloads[] =
+{
+    {
+        "notify_bulk", "server notifies as fast as the link allows, 2M-like link",
+        FALSE, FALSE, 1,
+        { 247, 251, 7500, 6, 0.0 }, 8,
+        244, 0, 5000, 0, 0,
+        1250, 40, 8000
+    },
+    {
+        "notify_small", "20 byte sensor reading every 10 ms over a default MTU",
+        FALSE, FALSE, 1,
+        { 23, 27, 30000, 4, 0.0 }, 8,
+        20, 10000, 5000, 0, 0,
+        12, 40, 300
+    },
+    {
+        "notify_burst", "2 KB burst every 250 ms",
+        FALSE, FALSE, 1,
+        { 247, 251, 15000, 4, 0.0 }, 8,
+        2048, 250000, 5000, 0, 0,
+        55, 60, 5000
+    },
+    {
+        "notify_multilink", "three clients notified at full rate",
+        FALSE, FALSE, 3,
+        { 185, 251, 20000, 4, 0.0 }, 8,
+        180, 0, 5000, 0, 0,
+        650, 80, 8000
+    },
+    {
+        "write_bulk", "client writes without response as fast as its credits allow",
+        TRUE, FALSE, 1,
+        { 247, 251, 7500, 6, 0.0 }, 8,
+        244, 0, 5000, 0, 0,
+        1250, 40, 8000
+    },
+    {
+        "reliable_reconnect", "reliable mode on a lossy link that drops once",
+        FALSE, TRUE, 1,
+        { 247, 251, 15000, 4, 0.1 }, 8,
+        200, 0, 5000, 2000, 300,
+        250, 600, 10500
+    },
+};
+
+#define BENCH_NUM_WORKLOADS (sizeof(benchWorkloads) / sizeof(benchWorkloads[0]))
+
+static BenchWorkload_t benchWl;
+static BenchLink_t     benchLinks[BLESIM_MAX_LINKS];
+
+// Set while the server has refused data and not yet called back
+static bool     benchThrottled;
+
+// Set by the server when an ack has been received
+static bool     benchAckPending;
+
+// Latency samples in microseconds
+static uint32_t *benchLatency;
+static uint32_t  benchLatencyCount;
+static uint32_t  benchLatencyCap;
+
+static uint64_t  benchLastRx;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Bench_pattern
+ *
+ * @brief   Returns the byte at a stream offset of a link.
+ */
+static uint8_t Bench_pattern(uint8_t link, uint32_t offset)
+{
+    return (uint8_t)((offset % 251) ^ (link * 0x5A));
+}
+
+/*********************************************************************
+ * @fn      Bench_findLink
+ *
+ * @brief   Returns the index of the link a connection belongs to.
+ */
+static int Bench_findLink(uint16_t connHandle)
+{
+    uint8_t i;
+
+    for (i = 0; i < benchWl.numLinks; i++)
+    {
+        if (benchLinks[i].connHandle == connHandle)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*********************************************************************
+ * @fn      Bench_receive
+ *
+ * @brief   Checks received stream data and records the latency of the
+ *          messages it completes.
+ */
+static void Bench_receive(uint16_t connHandle, uint8_t *pData, uint16_t len)
+{
+    int idx = Bench_findLink(connHandle);
+    BenchLink_t *pLink;
+    uint16_t i;
+
+    if (idx < 0)
+    {
+        return;
+    }
+
+    pLink = &benchLinks[idx];
+
+    for (i = 0; i < len; i++)
+    {
+        if (pData[i] != Bench_pattern(idx, pLink->rxBytes + i))
+        {
+            pLink->badBytes++;
+        }
+    }
+    pLink->rxBytes += len;
+    benchLastRx = BleSim_now();
+
+    while ((pLink->msgHead != pLink->msgTail) &&
+           (pLink->pMsgs[pLink->msgHead].endOffset <= pLink->rxBytes))
+    {
+        if (benchLatencyCount == benchLatencyCap)
+        {
+            benchLatencyCap = benchLatencyCap ? (benchLatencyCap * 2) : 1024;
+            benchLatency    = realloc(benchLatency, benchLatencyCap * sizeof(uint32_t));
+        }
+
+        benchLatency[benchLatencyCount++] =
+            (uint32_t)(BleSim_now() - pLink->pMsgs[pLink->msgHead].queuedAt);
+        pLink->msgHead++;
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_send
+ *
+ * @brief   Writes a message to a link through the sending profile.
+ *
+ * @return  TRUE if the profile took the message
+ */
+static bool Bench_send(uint8_t idx)
+{
+    static uint8_t msg[BENCH_MAX_MSG_LEN];
+    BenchLink_t *pLink = &benchLinks[idx];
+    bool accepted;
+    uint16_t i;
+
+    if (pLink->connHandle == CONNHANDLE_INVALID)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < benchWl.msgLen; i++)
+    {
+        msg[i] = Bench_pattern(idx, pLink->txBytes + i);
+    }
+
+    if (benchWl.upload)
+    {
+        accepted = BenchClient_send(pLink->connHandle, msg, benchWl.msgLen);
+    }
+    else
+    {
+        SimpleStreamServerStats_t stats;
+        uint32_t queued;
+
+        BleSim_setRole(BLESIM_PERIPHERAL);
+
+        // The status does not tell a refused write from a queued one that
+        // could not be sent yet
+        SimpleStreamServer_getStats(&stats);
+        queued = stats.bytesQueued;
+        SimpleStreamServer_sendData(pLink->connHandle, msg, benchWl.msgLen);
+        SimpleStreamServer_getStats(&stats);
+
+        accepted = (stats.bytesQueued != queued);
+
+        // A refused producer waits for pfnQueueLowCb, which only comes
+        // while there is data in the queue
+        benchThrottled = !accepted && (SimpleStreamServer_getQueuedBytes() > 0);
+    }
+
+    if (!accepted)
+    {
+        return FALSE;
+    }
+
+    pLink->txBytes += benchWl.msgLen;
+
+    if (pLink->msgTail == pLink->msgCap)
+    {
+        pLink->msgCap = pLink->msgCap ? (pLink->msgCap * 2) : 1024;
+        pLink->pMsgs  = realloc(pLink->pMsgs, pLink->msgCap * sizeof(BenchMsg_t));
+    }
+    pLink->pMsgs[pLink->msgTail].endOffset = pLink->txBytes;
+    pLink->pMsgs[pLink->msgTail].queuedAt  = BleSim_now();
+    pLink->msgTail++;
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      Bench_fill
+ *
+ * @brief   Writes to the links in turn, a message each, until the
+ *          sending profile refuses data or its queue is full.
+ */
+static void Bench_fill(void)
+{
+    bool progress = TRUE;
+    uint8_t i;
+
+    while (progress && !benchThrottled)
+    {
+        progress = FALSE;
+
+        for (i = 0; (i < benchWl.numLinks) && !benchThrottled; i++)
+        {
+            if (benchWl.upload)
+            {
+                BenchClientStats_t stats;
+
+                BenchClient_getStats(&stats);
+                if ((stats.bytesQueued - stats.bytesSent + benchWl.msgLen) > BENCH_CLIENT_QUEUE)
+                {
+                    continue;
+                }
+            }
+
+            if (Bench_send(i))
+            {
+                progress = TRUE;
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * Simulation and profile callbacks
+ */
+
+static void Bench_notificationCB(uint16_t connHandle, attHandleValueNoti_t *pNoti)
+{
+    uint8_t *pData;
+    uint16_t len;
+
+    if (BenchClient_receive(connHandle, pNoti, &pData, &len))
+    {
+        Bench_receive(connHandle, pData, len);
+    }
+}
+
+static void Bench_completedPacketsCB(BleSim_Role_t role, uint16_t connHandle, uint16_t numPkts)
+{
+    if (role == BLESIM_PERIPHERAL)
+    {
+        SimpleStreamServer_processCompletedPackets(connHandle, numPkts);
+    }
+    else
+    {
+        BenchClient_completedPackets(connHandle, numPkts);
+    }
+}
+
+static void Bench_connEventCB(BleSim_Role_t role, Gap_ConnEventRpt_t *pReport)
+{
+    if (role == BLESIM_PERIPHERAL)
+    {
+        SimpleStreamServer_processConnEvt(pReport);
+    }
+    else
+    {
+        BenchClient_connEvent(pReport);
+    }
+}
+
+static void Bench_serverIncomingCB(uint16_t connHandle, uint8_t paramID, uint16_t len, uint8_t *pValue)
+{
+    (void)paramID;
+
+    Bench_receive(connHandle, pValue, len);
+}
+
+static void Bench_serverQueueLowCB(uint32_t queuedBytes)
+{
+    (void)queuedBytes;
+
+    benchThrottled = FALSE;
+}
+
+static void Bench_serverAckCB(uint16_t connHandle, uint8_t opcode, uint32_t offset)
+{
+    (void)connHandle;
+    (void)opcode;
+    (void)offset;
+
+    benchAckPending = TRUE;
+}
+
+static SimpleStreamServerCBs_t benchServerCBs =
+{
+    NULL,
+    Bench_serverIncomingCB,
+    Bench_serverQueueLowCB,
+    Bench_serverAckCB
+};
+
+static const BleSim_Callbacks_t benchSimCBs =
+{
+    Bench_notificationCB,
+    Bench_completedPacketsCB,
+    Bench_connEventCB
+};
+
+/*********************************************************************
+ * @fn      Bench_connect
+ *
+ * @brief   Connects a link and subscribes the client to the server.
+ */
+static void Bench_connect(uint8_t idx)
+{
+    BenchLink_t *pLink = &benchLinks[idx];
+
+    pLink->connHandle = BleSim_connect(&benchWl.link, pLink->peerId);
+
+    BenchClient_connect(pLink->connHandle, benchWl.link.txOctets, benchWl.reliable);
+}
+
+/*********************************************************************
+ * @fn      Bench_disconnect
+ *
+ * @brief   Drops a link, as seen by both applications.
+ */
+static void Bench_disconnect(uint8_t idx)
+{
+    BleSim_disconnect(benchLinks[idx].connHandle);
+    benchLinks[idx].connHandle = CONNHANDLE_INVALID;
+
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    SimpleStreamServer_disconnectStream();
+
+    BenchClient_disconnect();
+}
+
+/*********************************************************************
+ * @fn      Bench_percentile
+ */
+static uint32_t Bench_percentile(uint32_t pct)
+{
+    uint32_t idx;
+
+    if (benchLatencyCount == 0)
+    {
+        return 0;
+    }
+
+    idx = (uint32_t)(((uint64_t)benchLatencyCount * pct + 99) / 100);
+
+    return benchLatency[(idx > 0) ? (idx - 1) : 0];
+}
+
+static int Bench_compareU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*********************************************************************
+ * @fn      Bench_run
+ *
+ * @brief   Runs a workload and reports its figures.
+ *
+ * @return  0 if the workload met its limits or they were not checked
+ */
+static int Bench_run(uint32_t heapSize, uint32_t seed, bool checkLimits)
+{
+    uint64_t start, end, drain, nextMsg, reconnectAt;
+    uint64_t dropped = UINT64_MAX;
+    BleSim_HeapStats_t heap[BLESIM_NUM_ROLES];
+    SimpleStreamServerStats_t srvStats;
+    BenchClientStats_t cliStats;
+    uint32_t txBytes = 0, rxBytes = 0, badBytes = 0;
+    uint32_t goodputKbps, p99Ms;
+    uint8_t i;
+    int failed = 0;
+
+    BleSim_init(heapSize, benchWl.txBuffers, seed, &benchSimCBs);
+
+    // Server device
+    BleSim_setRole(BLESIM_PERIPHERAL);
+    SimpleStreamServer_AddService(0);
+    SimpleStreamServer_RegisterAppCBs(&benchServerCBs);
+    SimpleStreamServer_setHeadroomLimit(BENCH_HEAP_HEADROOM);
+    SimpleStreamServer_setWatermarks(BENCH_HIGH_WATERMARK, BENCH_LOW_WATERMARK);
+    SimpleStreamServer_setReliableMode(benchWl.reliable, 0);
+
+    SimpleStreamServer_resetStats();
+
+    // Client device, the discovery results are taken from the server
+    BenchClient_init(benchWl.reliable, benchWl.txBuffers, BENCH_HEAP_HEADROOM,
+                     BleSim_findAttrHandle(SimpleStreamServer_DataInUUID, ATT_UUID_SIZE),
+                     BleSim_findAttrHandle(SimpleStreamServer_DataOutUUID, ATT_UUID_SIZE));
+
+    for (i = 0; i < benchWl.numLinks; i++)
+    {
+        benchLinks[i].peerId = i + 1;
+        Bench_connect(i);
+    }
+
+    // Data sent before a client has enabled notifications is dropped, so
+    // the producers start once every link had its first connection event
+    BleSim_runUntil((uint64_t)benchWl.link.connIntervalUs * 2);
+
+    start       = BleSim_now();
+    end         = start + (uint64_t)benchWl.durationMs * 1000;
+    drain       = end + (uint64_t)BENCH_DRAIN_MS * 1000;
+    nextMsg     = start;
+    reconnectAt = benchWl.reconnectAtMs ?
+                  (start + (uint64_t)benchWl.reconnectAtMs * 1000) : UINT64_MAX;
+
+    while (BleSim_now() < drain)
+    {
+        bool producing = (BleSim_now() < end);
+        uint64_t next = BleSim_nextEventTime();
+
+        if (producing && (benchWl.msgPeriodUs != 0) && (nextMsg < next))
+        {
+            next = nextMsg;
+        }
+        if (reconnectAt < next)
+        {
+            next = reconnectAt;
+        }
+        if ((dropped != UINT64_MAX) && (dropped + (uint64_t)benchWl.downtimeMs * 1000 < next))
+        {
+            next = dropped + (uint64_t)benchWl.downtimeMs * 1000;
+        }
+        if (next > drain)
+        {
+            next = drain;
+        }
+
+        BleSim_runUntil(next);
+
+        if (BleSim_now() == reconnectAt)
+        {
+            Bench_disconnect(0);
+            reconnectAt = UINT64_MAX;
+            dropped     = BleSim_now();
+        }
+        else if ((dropped != UINT64_MAX) &&
+                 (BleSim_now() == dropped + (uint64_t)benchWl.downtimeMs * 1000))
+        {
+            Bench_connect(0);
+            dropped = UINT64_MAX;
+        }
+
+        if (benchAckPending)
+        {
+            benchAckPending = FALSE;
+            BleSim_setRole(BLESIM_PERIPHERAL);
+            SimpleStreamServer_processStream();
+        }
+
+        if (producing)
+        {
+            if (benchWl.msgPeriodUs != 0)
+            {
+                if (BleSim_now() >= nextMsg)
+                {
+                    for (i = 0; i < benchWl.numLinks; i++)
+                    {
+                        Bench_send(i);
+                    }
+                    nextMsg += benchWl.msgPeriodUs;
+                }
+            }
+            else
+            {
+                Bench_fill();
+            }
+        }
+        else
+        {
+            bool done = TRUE;
+
+            for (i = 0; i < benchWl.numLinks; i++)
+            {
+                done = done && (benchLinks[i].rxBytes >= benchLinks[i].txBytes);
+            }
+
+            if (done)
+            {
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < benchWl.numLinks; i++)
+    {
+        txBytes  += benchLinks[i].txBytes;
+        rxBytes  += benchLinks[i].rxBytes;
+        badBytes += benchLinks[i].badBytes;
+    }
+
+    qsort(benchLatency, benchLatencyCount, sizeof(uint32_t), Bench_compareU32);
+
+    BleSim_getHeapStats(BLESIM_PERIPHERAL, &heap[BLESIM_PERIPHERAL]);
+    BleSim_getHeapStats(BLESIM_CENTRAL, &heap[BLESIM_CENTRAL]);
+    SimpleStreamServer_getStats(&srvStats);
+    BenchClient_getStats(&cliStats);
+
+    goodputKbps = (benchLastRx > start) ?
+                  (uint32_t)(((uint64_t)rxBytes * 8 * 1000) / (benchLastRx - start)) : 0;
+    p99Ms       = Bench_percentile(99) / 1000;
+
+    printf("%s: %s\n", benchWl.name, benchWl.description);
+    printf("  link      : %u link(s), MTU %u, %u LL octets, interval %.2f ms, %u packets/event, "
+           "%u TX buffers, loss %.1f%%\n",
+           benchWl.numLinks, benchWl.link.mtu, benchWl.link.txOctets,
+           benchWl.link.connIntervalUs / 1000.0, benchWl.link.pktsPerEvent,
+           benchWl.txBuffers, benchWl.link.lossRate * 100.0);
+    printf("  goodput   : %u kbit/s (%u of %u bytes delivered, %u corrupted)\n",
+           goodputKbps, rxBytes, txBytes, badBytes);
+    printf("  latency   : p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms (%u messages)\n",
+           Bench_percentile(50) / 1000.0, Bench_percentile(90) / 1000.0,
+           Bench_percentile(99) / 1000.0, Bench_percentile(100) / 1000.0, benchLatencyCount);
+    printf("  heap      : server peak %u of %u bytes, client peak %u of %u bytes\n",
+           heap[BLESIM_PERIPHERAL].peakUsed, heapSize, heap[BLESIM_CENTRAL].peakUsed, heapSize);
+    printf("  server    : %u notifications, %u bytes resent, %u alloc failures, %u sends refused, "
+           "min free heap %u\n",
+           srvStats.packetsSent, srvStats.bytesResent, srvStats.allocFailures,
+           srvStats.sendsRejected, (srvStats.minFreeHeap == UINT32_MAX) ? 0 : srvStats.minFreeHeap);
+    printf("  client    : %u writes, %u credit stalls, %u alloc failures, %u sends refused, "
+           "min free heap %u\n",
+           cliStats.packetsSent, cliStats.creditStalls, cliStats.allocFailures,
+           cliStats.sendsRejected, (cliStats.minFreeHeap == UINT32_MAX) ? 0 : cliStats.minFreeHeap);
+
+    // Data must arrive complete and in order whatever the parameters
+    if ((rxBytes != txBytes) || (badBytes != 0))
+    {
+        printf("  FAIL: stream data lost or corrupted\n");
+        failed = 1;
+    }
+
+    if (checkLimits)
+    {
+        uint32_t heapPeak = heap[benchWl.upload ? BLESIM_CENTRAL : BLESIM_PERIPHERAL].peakUsed;
+
+        if (goodputKbps < benchWl.minGoodputKbps)
+        {
+            printf("  FAIL: goodput below %u kbit/s\n", benchWl.minGoodputKbps);
+            failed = 1;
+        }
+        if (p99Ms > benchWl.maxP99LatencyMs)
+        {
+            printf("  FAIL: p99 latency above %u ms\n", benchWl.maxP99LatencyMs);
+            failed = 1;
+        }
+        if (heapPeak > benchWl.maxHeapPeak)
+        {
+            printf("  FAIL: sender heap peak above %u bytes\n", benchWl.maxHeapPeak);
+            failed = 1;
+        }
+    }
+    else
+    {
+        printf("  limits not checked, parameters were overridden\n");
+    }
+
+    printf("  %s\n", failed ? "FAILED" : "PASSED");
+
+    return failed;
+}
+
+static void Bench_usage(const char *prog)
+{
+    uint8_t i;
+
+    printf("usage: %s [options] <workload>\n"
+           "  --mtu N             ATT MTU\n"
+           "  --tx-octets N       LL payload size\n"
+           "  --interval-us N     connection interval\n"
+           "  --pkts-per-event N  packet exchanges per connection event\n"
+           "  --tx-buffers N      controller TX buffers of each device\n"
+           "  --loss P            share of LL packets received with a CRC error\n"
+           "  --msg-len N         bytes per write\n"
+           "  --period-us N       time between writes, 0 to write as fast as possible\n"
+           "  --duration-ms N     time the producers run\n"
+           "  --heap N            heap size of each device\n"
+           "  --seed N            seed of the loss generator\n"
+           "The workload limits are only checked with the default parameters.\n"
+           "workloads:\n", prog);
+
+    for (i = 0; i < BENCH_NUM_WORKLOADS; i++)
+    {
+        printf("  %-20s %s\n", benchWorkloads[i].name, benchWorkloads[i].description);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = NULL;
+    uint32_t heapSize = BENCH_HEAP_SIZE;
+    uint32_t seed = 1;
+    bool overridden = FALSE;
+    uint8_t i;
+    int arg;
+
+    // Options are applied once the workload is known
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (argv[arg][0] != '-')
+        {
+            name = argv[arg];
+        }
+        else if (arg + 1 < argc)
+        {
+            arg++;
+        }
+    }
+
+    for (i = 0; (name != NULL) && (i < BENCH_NUM_WORKLOADS); i++)
+    {
+        if (!strcmp(name, benchWorkloads[i].name))
+        {
+            break;
+        }
+    }
+
+    if ((name == NULL) || (i == BENCH_NUM_WORKLOADS))
+    {
+        Bench_usage(argv[0]);
+        return 2;
+    }
+
+    benchWl = benchWorkloads[i];
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        const char *opt = argv[arg];
+        const char *val = (arg + 1 < argc) ? argv[arg + 1] : NULL;
+
+        if (opt[0] != '-')
+        {
+            continue;
+        }
+        if (val == NULL)
+        {
+            Bench_usage(argv[0]);
+            return 2;
+        }
+        arg++;
+        overridden = TRUE;
+
+        if (!strcmp(opt, "--mtu"))                 benchWl.link.mtu            = atoi(val);
+        else if (!strcmp(opt, "--tx-octets"))      benchWl.link.txOctets       = atoi(val);
+        else if (!strcmp(opt, "--interval-us"))    benchWl.link.connIntervalUs = atoi(val);
+        else if (!strcmp(opt, "--pkts-per-event")) benchWl.link.pktsPerEvent   = atoi(val);
+        else if (!strcmp(opt, "--tx-buffers"))     benchWl.txBuffers           = atoi(val);
+        else if (!strcmp(opt, "--loss"))           benchWl.link.lossRate       = atof(val);
+        else if (!strcmp(opt, "--msg-len"))        benchWl.msgLen              = atoi(val);
+        else if (!strcmp(opt, "--period-us"))      benchWl.msgPeriodUs         = atoi(val);
+        else if (!strcmp(opt, "--duration-ms"))    benchWl.durationMs          = atoi(val);
+        else if (!strcmp(opt, "--heap"))           heapSize                    = atoi(val);
+        else if (!strcmp(opt, "--seed"))           seed                        = atoi(val);
+        else
+        {
+            Bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((benchWl.msgLen == 0) || (benchWl.msgLen > BENCH_MAX_MSG_LEN) ||
+        (benchWl.link.mtu < ATT_MTU_SIZE) || (benchWl.link.txOctets < 27) ||
+        (benchWl.link.txOctets > 251) || (benchWl.link.pktsPerEvent == 0) ||
+        (benchWl.txBuffers == 0) || (benchWl.link.connIntervalUs == 0))
+    {
+        printf("invalid parameters\n");
+        return 2;
+    }
+
+    return Bench_run(heapSize, seed, !overridden);
+}
@@ -0,0 +1,80 @@
+/**********************************************************************************************
+ * Filename:       stream_bench.h
+ *
+ * Description:    Client side of the Simple Stream benchmark. The client profile
+ *                 is driven from its own file since its header cannot be included
+ *                 next to the server's.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _STREAM_BENCH_H_
+#define _STREAM_BENCH_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ble_sim.h"
+
+// Client statistics reported by the benchmark
+typedef struct
+{
+    uint32_t bytesQueued;
+    uint32_t bytesSent;
+    uint32_t packetsSent;
+    uint32_t minFreeHeap;
+    uint16_t allocFailures;
+    uint16_t creditStalls;
+    uint16_t sendsRejected;
+} BenchClientStats_t;
+
+extern void BenchClient_init(bool reliable, uint8_t creditWindow, uint16_t headroom,
+                             uint16_t dataInHandle, uint16_t dataOutHandle);
+extern void BenchClient_connect(uint16_t connHandle, uint16_t txOctets, bool reliable);
+extern void BenchClient_disconnect(void);
+extern bool BenchClient_send(uint16_t connHandle, uint8_t *pData, uint16_t len);
+extern bool BenchClient_receive(uint16_t connHandle, attHandleValueNoti_t *pNoti,
+                                uint8_t **ppData, uint16_t *pLen);
+extern void BenchClient_completedPackets(uint16_t connHandle, uint16_t numPkts);
+extern void BenchClient_connEvent(Gap_ConnEventRpt_t *pReport);
+extern void BenchClient_getStats(BenchClientStats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _STREAM_BENCH_H_ */
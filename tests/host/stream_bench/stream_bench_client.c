@@ -0,0 +1,138 @@
+/**********************************************************************************************
+ * Filename:       stream_bench_client.c
+ *
+ * Description:    Client side of the Simple Stream benchmark.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "stream_bench.h"
+#include "simple_stream_profile_client.h"
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void BenchClient_init(bool reliable, uint8_t creditWindow, uint16_t headroom,
+                      uint16_t dataInHandle, uint16_t dataOutHandle)
+{
+    BleSim_setRole(BLESIM_CENTRAL);
+
+    // Discovery results
+    streamServiceHandle.chars[0].handle     = dataInHandle;
+    streamServiceHandle.chars[1].handle     = dataOutHandle;
+    streamServiceHandle.chars[1].cccdHandle = dataOutHandle + 1;
+
+    SimpleStreamClient_setHeadroomLimit(headroom);
+    SimpleStreamClient_setCreditWindow(creditWindow);
+    SimpleStreamClient_setReliableMode(reliable, 0);
+    SimpleStreamClient_resetStats();
+}
+
+void BenchClient_connect(uint16_t connHandle, uint16_t txOctets, bool reliable)
+{
+    BleSim_setRole(BLESIM_CENTRAL);
+
+    SimpleStreamClient_setTxOctets(connHandle, txOctets);
+    SimpleStreamClient_enableNotifications(connHandle);
+
+    if (reliable)
+    {
+        SimpleStreamClient_resumeStream(connHandle);
+    }
+}
+
+void BenchClient_disconnect(void)
+{
+    BleSim_setRole(BLESIM_CENTRAL);
+    SimpleStreamClient_disconnectStream();
+}
+
+bool BenchClient_send(uint16_t connHandle, uint8_t *pData, uint16_t len)
+{
+    SimpleStreamClientStats_t stats;
+    uint32_t queued;
+
+    BleSim_setRole(BLESIM_CENTRAL);
+
+    SimpleStreamClient_getStats(&stats);
+    queued = stats.bytesQueued;
+
+    SimpleStreamClient_sendData(connHandle, pData, len);
+
+    // The status does not tell a refused write from a queued one that
+    // could not be sent yet
+    SimpleStreamClient_getStats(&stats);
+
+    return (stats.bytesQueued != queued);
+}
+
+bool BenchClient_receive(uint16_t connHandle, attHandleValueNoti_t *pNoti,
+                         uint8_t **ppData, uint16_t *pLen)
+{
+    if (pNoti->handle != streamServiceHandle.chars[1].handle)
+    {
+        return FALSE;
+    }
+
+    return (SimpleStreamClient_processIncoming(connHandle, pNoti->pValue, pNoti->len,
+                                               ppData, pLen) == SUCCESS) && (*pLen > 0);
+}
+
+void BenchClient_completedPackets(uint16_t connHandle, uint16_t numPkts)
+{
+    SimpleStreamClient_processCompletedPackets(connHandle, numPkts);
+}
+
+void BenchClient_connEvent(Gap_ConnEventRpt_t *pReport)
+{
+    SimpleStreamClient_processConnEvt(pReport);
+}
+
+void BenchClient_getStats(BenchClientStats_t *pStats)
+{
+    SimpleStreamClientStats_t stats;
+
+    SimpleStreamClient_getStats(&stats);
+
+    pStats->bytesQueued   = stats.bytesQueued;
+    pStats->bytesSent     = stats.bytesSent;
+    pStats->packetsSent   = stats.packetsSent;
+    pStats->minFreeHeap   = stats.minFreeHeap;
+    pStats->allocFailures = stats.allocFailures;
+    pStats->creditStalls  = stats.creditStalls;
+    pStats->sendsRejected = stats.sendsRejected;
+}
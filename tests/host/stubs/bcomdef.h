@@ -0,0 +1,64 @@
+/**********************************************************************************************
+ * Filename:       bcomdef.h
+ *
+ * Description:    Host build stand-in for the SDK's bcomdef.h.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _BCOMDEF_H_
+#define _BCOMDEF_H_
+
+#include "comdef.h"
+
+typedef Status_t bStatus_t;
+typedef Status_t status_t;
+
+// BLE status return values
+#define bleInvalidTaskID          INVALID_TASK
+#define bleNotReady               0x10
+#define bleAlreadyInRequestedMode 0x11
+#define bleIncorrectMode          0x12
+#define bleMemAllocError          0x13
+#define bleNotConnected           0x14
+#define bleNoResources            0x15
+#define blePending                0x16
+#define bleTimeout                0x17
+#define bleInvalidRange           0x18
+#define bleLinkEncrypted          0x19
+#define bleProcedureComplete      0x1A
+#define bleInvalidMtuSize         0x40
+
+#define B_ADDR_LEN                6
+
+#endif /* _BCOMDEF_H_ */
@@ -0,0 +1,94 @@
+/**********************************************************************************************
+ * Filename:       comdef.h
+ *
+ * Description:    Host build stand-in for the SDK's comdef.h.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _COMDEF_H_
+#define _COMDEF_H_
+
+#include "hal_types.h"
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define VOID (void)
+
+// Generic status return values
+#define SUCCESS                   0x00
+#define FAILURE                   0x01
+#define INVALIDPARAMETER          0x02
+#define INVALID_TASK              0x03
+#define MSG_BUFFER_NOT_AVAIL      0x04
+#define INVALID_MSG_POINTER       0x05
+#define INVALID_EVENT_ID          0x06
+#define INVALID_INTERRUPT_ID      0x07
+#define NO_TIMER_AVAIL            0x08
+#define NV_ITEM_UNINIT            0x09
+#define NV_OPER_FAILED            0x0A
+#define INVALID_MEM_SIZE          0x0B
+#define NV_BAD_ITEM_LEN           0x0C
+
+typedef uint8 Status_t;
+
+#define BUILD_UINT32(Byte0, Byte1, Byte2, Byte3) \
+          ((uint32)((uint32)((Byte0) & 0x00FF) \
+          + ((uint32)((Byte1) & 0x00FF) << 8) \
+          + ((uint32)((Byte2) & 0x00FF) << 16) \
+          + ((uint32)((Byte3) & 0x00FF) << 24)))
+
+#define BUILD_UINT16(loByte, hiByte) \
+          ((uint16)(((loByte) & 0x00FF) + (((hiByte) & 0x00FF) << 8)))
+
+#define HI_UINT16(a) (((a) >> 8) & 0xFF)
+#define LO_UINT16(a) ((a) & 0xFF)
+
+#define BREAK_UINT32( var, ByteNum ) \
+          (uint8)((uint32)(((var) >>((ByteNum) * 8)) & 0x00FF))
+
+#ifndef MIN
+#define MIN(n,m)   (((n) < (m)) ? (n) : (m))
+#endif
+
+#ifndef MAX
+#define MAX(n,m)   (((n) < (m)) ? (m) : (n))
+#endif
+
+#endif /* _COMDEF_H_ */
@@ -0,0 +1,195 @@
+/**********************************************************************************************
+ * Filename:       gap.h
+ *
+ * Description:    Host build stand-in for the SDK's gap.h. It declares the GAP events and
+ *                 calls of the peripheral applications built on the host. The calls are
+ *                 accepted by sim/app_sim.c; links are made by the link simulation instead.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef GAP_H
+#define GAP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "osal.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// OSAL event of GAP messages
+#define GAP_MSG_EVENT                       0xD0
+
+// GAP message opcodes
+#define GAP_DEVICE_INIT_DONE_EVENT          0x00
+#define GAP_LINK_ESTABLISHED_EVENT          0x05
+#define GAP_LINK_TERMINATED_EVENT           0x06
+#define GAP_LINK_PARAM_UPDATE_EVENT         0x07
+#define GAP_UPDATE_LINK_PARAM_REQ_EVENT     0x12
+
+// GAP profile roles
+#define GAP_PROFILE_PERIPHERAL              0x04
+
+// GAP parameters
+#define GAP_PARAM_LINK_UPDATE_DECISION      0x20
+#define GAP_UPDATE_REQ_PASS_TO_APP          0x03
+
+#define GAP_DEVICE_NAME_LEN                 21
+
+// Advertising data types
+#define GAP_ADTYPE_FLAGS                        0x01
+#define GAP_ADTYPE_16BIT_MORE                   0x02
+#define GAP_ADTYPE_16BIT_COMPLETE               0x03
+#define GAP_ADTYPE_LOCAL_NAME_SHORT             0x08
+#define GAP_ADTYPE_LOCAL_NAME_COMPLETE          0x09
+#define GAP_ADTYPE_POWER_LEVEL                  0x0A
+#define GAP_ADTYPE_SLAVE_CONN_INTERVAL_RANGE    0x12
+#define GAP_ADTYPE_FLAGS_LIMITED                0x01
+#define GAP_ADTYPE_FLAGS_GENERAL                0x02
+#define GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED    0x04
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Own address mode
+typedef enum
+{
+  ADDRMODE_PUBLIC = 0,
+  ADDRMODE_RANDOM,
+  ADDRMODE_RP_WITH_PUBLIC_ID,
+  ADDRMODE_RP_WITH_RANDOM_ID
+} GAP_Addr_Modes_t;
+
+// Header of the GAP messages
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 opcode;
+} gapEventHdr_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 opcode;
+  uint8 devAddr[B_ADDR_LEN];
+  uint16 dataPktLen;
+  uint8 numDataPkts;
+} gapDeviceInitDoneEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 opcode;
+  uint8 devAddrType;
+  uint8 devAddr[B_ADDR_LEN];
+  uint16 connectionHandle;
+  uint8 connRole;
+  uint16 connInterval;
+  uint16 connLatency;
+  uint16 connTimeout;
+  uint8 clockAccuracy;
+} gapEstLinkReqEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 opcode;
+  uint16 connectionHandle;
+  uint8 reason;
+} gapTerminateLinkEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 opcode;
+  uint8 status;
+  uint16 connectionHandle;
+  uint16 connInterval;
+  uint16 connLatency;
+  uint16 connTimeout;
+} gapLinkUpdateEvent_t;
+
+typedef struct
+{
+  uint16 connectionHandle;
+  uint16 intervalMin;
+  uint16 intervalMax;
+  uint16 connLatency;
+  uint16 connTimeout;
+} gapUpdateLinkParamReq_t;
+
+typedef struct
+{
+  uint16 connectionHandle;
+  uint16 intervalMin;
+  uint16 intervalMax;
+  uint16 connLatency;
+  uint16 connTimeout;
+  uint8 signalIdentifier;
+  uint8 accepted;
+} gapUpdateLinkParamReqReply_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 opcode;
+  gapUpdateLinkParamReq_t req;
+} gapUpdateLinkParamReqEvent_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+extern bStatus_t GAP_DeviceInit(uint8 profileRole, uint8 taskID,
+                                GAP_Addr_Modes_t addrMode, uint8 *pRandomAddr);
+extern uint8    *GAP_GetDevAddress(uint8 wantIA);
+extern void      GAP_RegisterForMsgs(uint8 taskID);
+extern bStatus_t GAP_SetParamValue(uint16 paramID, uint16 paramValue);
+extern bStatus_t GAP_UpdateLinkParamReq(gapUpdateLinkParamReq_t *pParams);
+extern bStatus_t GAP_UpdateLinkParamReqReply(gapUpdateLinkParamReqReply_t *pParams);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GAP_H */
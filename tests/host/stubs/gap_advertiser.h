@@ -0,0 +1,111 @@
+/**********************************************************************************************
+ * Filename:       gap_advertiser.h
+ *
+ * Description:    Host build stand-in for the SDK's gap_advertiser.h. Advertising sets are
+ *                 accepted by sim/app_sim.c but never advertise; links are made by the link
+ *                 simulation instead.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef GAP_ADVERTISER_H
+#define GAP_ADVERTISER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define GAP_ADV_EVT_MASK_START_AFTER_ENABLE     (1UL << 0)
+#define GAP_ADV_EVT_MASK_END_AFTER_DISABLE      (1UL << 1)
+#define GAP_ADV_EVT_MASK_SET_TERMINATED         (1UL << 6)
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Only the advertising type is kept of the default parameter sets
+#define GAPADV_PARAMS_LEGACY_SCANN_CONN   { 0x0013 }
+#define GAPADV_PARAMS_AE_LONG_RANGE_CONN  { 0x0001 }
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef enum
+{
+  GAP_ADV_DATA_TYPE_ADV,
+  GAP_ADV_DATA_TYPE_SCAN_RSP
+} GapAdv_dataTypes_t;
+
+typedef enum
+{
+  GAP_ADV_ENABLE_OPTIONS_USE_MAX,
+  GAP_ADV_ENABLE_OPTIONS_USE_DURATION,
+  GAP_ADV_ENABLE_OPTIONS_USE_MAX_EVENTS
+} GapAdv_enableOptions_t;
+
+typedef struct
+{
+  uint16 eventProps;
+} GapAdv_params_t;
+
+typedef void (*pfnGapCB_t)(uint32 event, void *pBuf, uintptr_t arg);
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+extern bStatus_t GapAdv_create(pfnGapCB_t cb, GapAdv_params_t *pAdvParam,
+                               uint8 *pAdvHandle);
+extern bStatus_t GapAdv_loadByHandle(uint8 handle, GapAdv_dataTypes_t dataType,
+                                     uint16 len, uint8 *pBuf);
+extern bStatus_t GapAdv_setEventMask(uint8 handle, uint32 mask);
+extern bStatus_t GapAdv_enable(uint8 handle, GapAdv_enableOptions_t enableOptions,
+                               uint16 durationOrMaxEvents);
+extern bStatus_t GapAdv_disable(uint8 handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GAP_ADVERTISER_H */
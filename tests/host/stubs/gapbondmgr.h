@@ -0,0 +1,105 @@
+/**********************************************************************************************
+ * Filename:       gapbondmgr.h
+ *
+ * Description:    Host build stand-in for the SDK's gapbondmgr.h. The bond manager calls
+ *                 are accepted by sim/app_sim.c; links are never paired.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef GAPBONDMGR_H
+#define GAPBONDMGR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Parameters
+#define GAPBOND_PAIRING_MODE                0x400
+#define GAPBOND_MITM_PROTECTION             0x402
+#define GAPBOND_IO_CAPABILITIES             0x403
+#define GAPBOND_BONDING_ENABLED             0x406
+
+#define GAPBOND_PAIRING_MODE_WAIT_FOR_REQ   0x01
+
+#define GAPBOND_IO_CAP_DISPLAY_ONLY         0x00
+#define GAPBOND_IO_CAP_NO_INPUT_NO_OUTPUT   0x03
+
+// Pairing states
+#define GAPBOND_PAIRING_STATE_STARTED       0x00
+#define GAPBOND_PAIRING_STATE_COMPLETE      0x01
+#define GAPBOND_PAIRING_STATE_BONDED        0x02
+
+#define B_APP_DEFAULT_PASSCODE              123456
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef void (*pfnPasscodeCB_t)(uint8 *deviceAddr, uint16 connectionHandle,
+                                uint8 uiInputs, uint8 uiOutputs,
+                                uint32 numComparison);
+
+typedef void (*pfnPairStateCB_t)(uint16 connectionHandle, uint8 state,
+                                 uint8 status);
+
+typedef struct
+{
+  pfnPasscodeCB_t  passcodeCB;
+  pfnPairStateCB_t pairStateCB;
+} gapBondCBs_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+extern bStatus_t GAPBondMgr_SetParameter(uint16 param, uint8 len, void *pValue);
+extern void      GAPBondMgr_Register(gapBondCBs_t *pCB);
+extern bStatus_t GAPBondMgr_PasscodeRsp(uint16 connectionHandle, uint8 status,
+                                        uint32 passcode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GAPBONDMGR_H */
@@ -0,0 +1,103 @@
+/**********************************************************************************************
+ * Filename:       hci.h
+ *
+ * Description:    Host build stand-in for the SDK's hci.h. It declares the HCI events and
+ *                 commands of the applications built on the host; the commands are accepted by
+ *                 sim/app_sim.c.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef HCI_H
+#define HCI_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "osal.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// OSAL event of HCI events passed to GAP applications
+#define HCI_GAP_EVENT_EVENT                     0x13
+
+#define HCI_COMMAND_COMPLETE_EVENT_CODE         0x0E
+
+#define HCI_LE_READ_LOCAL_SUPPORTED_FEATURES    0x2003
+
+#define LL_FEATURE_CONN_PARAMS_REQ              0x02
+
+#define HCI_PHY_1_MBPS                          0x01
+#define HCI_PHY_2_MBPS                          0x02
+#define HCI_PHY_CODED                           0x04
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define CLR_FEATURE_FLAG( flags, flag )  ( (flags) &= ~(flag) )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 numHciCmdPkt;
+  uint16 cmdOpcode;
+  uint8 *pReturnParam;
+} hciEvt_CmdComplete_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+extern bStatus_t HCI_ReadRssiCmd(uint16 connHandle);
+extern bStatus_t HCI_LE_ReadLocalSupportedFeaturesCmd(void);
+extern bStatus_t HCI_LE_WriteSuggestedDefaultDataLenCmd(uint16 txOctets, uint16 txTime);
+extern bStatus_t HCI_EXT_SetLocalSupportedFeaturesCmd(uint8 *pLocalFeatures);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HCI_H */
@@ -0,0 +1,62 @@
+/**********************************************************************************************
+ * Filename:       hiddev.h
+ *
+ * Description:    Host build stand-in for the SDK HID device definitions used by
+ *                 the battery service.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef HIDDEV_H
+#define HIDDEV_H
+
+#include "icall_ble_api.h"
+
+// Report Reference descriptor
+#define HID_REPORT_REF_LEN              2
+#define HID_REPORT_TYPE_INPUT           1
+
+// Protocol modes
+#define HID_PROTOCOL_MODE_REPORT        0x01
+
+// HID report mapping table
+typedef struct
+{
+  uint16 handle;                // Handle of report characteristic
+  gattAttribute_t *pCccdAttr;   // Pointer to CCCD attribute for report characteristic
+  uint8 id;                     // Report ID
+  uint8 type;                   // Report type
+  uint8 mode;                   // Protocol mode (report or boot)
+} hidRptMap_t;
+
+#endif /* HIDDEV_H */
@@ -0,0 +1,109 @@
+/**********************************************************************************************
+ * Filename:       icall.h
+ *
+ * Description:    Host build stand-in for the SDK's icall.h. The heap, the
+ *                 critical sections and the tick counter are provided by the link
+ *                 simulation in sim/ble_sim.c, the application registration and
+ *                 messages by sim/rtos_sim.c.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef _ICALL_H_
+#define _ICALL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <ti/sysbios/knl/Event.h>
+
+#define ICALL_ERRNO_SUCCESS             0
+#define ICALL_ERRNO_NOMSG               (-4)
+
+#define ICALL_SERVICE_CLASS_BLE         0x0010
+
+// Event posted when a stack message is queued for the application
+#define ICALL_MSG_EVENT_ID              Event_Id_31
+
+#define ICALL_TIMEOUT_FOREVER           0xFFFFFFFF
+
+typedef uint8_t      ICall_EntityID;
+typedef uint32_t     ICall_CSState;
+typedef int_fast16_t ICall_Errno;
+typedef uint16_t     ICall_ServiceEnum;
+typedef Event_Handle ICall_SyncHandle;
+
+// Header of a stack message
+typedef struct
+{
+  uint8_t event;
+  uint8_t status;
+} ICall_Hdr;
+
+// HCI extension event, only its header is read
+typedef struct
+{
+  ICall_Hdr hdr;
+} ICall_HciExtEvt;
+
+// Heap statistics, see ICall_getHeapStats
+typedef struct
+{
+  uint32_t totalSize;
+  uint32_t totalFreeSize;
+  uint32_t largestFreeSize;
+} ICall_heapStats_t;
+
+extern void          *ICall_malloc(uint_least16_t size);
+extern void           ICall_free(void *msg);
+extern void           ICall_getHeapStats(ICall_heapStats_t *stats);
+extern ICall_CSState  ICall_enterCriticalSection(void);
+extern void           ICall_leaveCriticalSection(ICall_CSState key);
+extern uint_fast32_t  ICall_getTicks(void);
+extern uint_fast32_t  ICall_getTickPeriod(void);
+
+extern ICall_Errno    ICall_registerApp(ICall_EntityID *pEntity, ICall_SyncHandle *pSyncHandle);
+extern ICall_Errno    ICall_fetchServiceMsg(ICall_ServiceEnum *pSrc, ICall_EntityID *pDest,
+                                            void **ppMsg);
+extern void           ICall_freeMsg(void *msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ICALL_H_ */
@@ -0,0 +1,352 @@
+/**********************************************************************************************
+ * Filename:       icall_ble_api.h
+ *
+ * Description:    Host build stand-in for the SDK's icall_ble_api.h. It declares
+ *                 the subset of the ATT, GATT, GATTServApp, GAP and linkDB API used
+ *                 by the profiles built on the host. The API is implemented by the
+ *                 link simulation in sim/ble_sim.c, the calls of the applications
+ *                 it doesn't act on by sim/app_sim.c.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef ICALLBLEAPI_H
+#define ICALLBLEAPI_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "osal.h"
+#include "icall.h"
+#include "gap.h"
+#include "gap_advertiser.h"
+#include "gapbondmgr.h"
+#include "gapgattserver.h"
+#include "hci.h"
+#include "gatt_uuid.h"
+#include "gatt_profile_uuid.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// ATT
+#define ATT_BT_UUID_SIZE                2
+#define ATT_UUID_SIZE                   16
+#define ATT_OPCODE_SIZE                 1
+#define ATT_WRITE_REQ_HDR_SIZE          3
+#define ATT_MTU_SIZE                    23
+
+#define ATT_ERROR_RSP                   0x01
+#define ATT_EXCHANGE_MTU_REQ            0x02
+#define ATT_READ_REQ                    0x0A
+#define ATT_READ_RSP                    0x0B
+#define ATT_READ_BLOB_REQ               0x0C
+#define ATT_WRITE_REQ                   0x12
+#define ATT_WRITE_RSP                   0x13
+#define ATT_PREPARE_WRITE_REQ           0x16
+#define ATT_EXECUTE_WRITE_REQ           0x18
+#define ATT_HANDLE_VALUE_NOTI           0x1B
+#define ATT_HANDLE_VALUE_IND            0x1D
+#define ATT_HANDLE_VALUE_CFM            0x1E
+#define ATT_WRITE_CMD                   0x52
+
+#define ATT_ERR_INVALID_HANDLE          0x01
+#define ATT_ERR_READ_NOT_PERMITTED      0x02
+#define ATT_ERR_WRITE_NOT_PERMITTED     0x03
+#define ATT_ERR_INVALID_PDU             0x04
+#define ATT_ERR_INSUFFICIENT_AUTHEN     0x05
+#define ATT_ERR_UNSUPPORTED_REQ         0x06
+#define ATT_ERR_INVALID_OFFSET          0x07
+#define ATT_ERR_INSUFFICIENT_AUTHOR     0x08
+#define ATT_ERR_PREPARE_QUEUE_FULL      0x09
+#define ATT_ERR_ATTR_NOT_FOUND          0x0A
+#define ATT_ERR_ATTR_NOT_LONG           0x0B
+#define ATT_ERR_INSUFFICIENT_KEY_SIZE   0x0C
+#define ATT_ERR_INVALID_VALUE_SIZE      0x0D
+#define ATT_ERR_UNLIKELY                0x0E
+#define ATT_ERR_INSUFFICIENT_ENCRYPT    0x0F
+#define ATT_ERR_UNSUPPORTED_GRP_TYPE    0x10
+#define ATT_ERR_INSUFFICIENT_RESOURCES  0x11
+#define ATT_ERR_INVALID_VALUE           0x80
+
+// GATT
+#define GATT_PERMIT_READ                0x01
+#define GATT_PERMIT_WRITE               0x02
+#define GATT_PERMIT_AUTHEN_READ         0x04
+#define GATT_PERMIT_AUTHEN_WRITE        0x08
+#define GATT_PERMIT_AUTHOR_READ         0x10
+#define GATT_PERMIT_AUTHOR_WRITE        0x20
+#define GATT_PERMIT_ENCRYPT_READ        0x40
+#define GATT_PERMIT_ENCRYPT_WRITE       0x80
+
+#define GATT_PROP_BCAST                 0x01
+#define GATT_PROP_READ                  0x02
+#define GATT_PROP_WRITE_NO_RSP          0x04
+#define GATT_PROP_WRITE                 0x08
+#define GATT_PROP_NOTIFY                0x10
+#define GATT_PROP_INDICATE              0x20
+#define GATT_PROP_AUTHEN                0x40
+#define GATT_PROP_EXTENDED              0x80
+
+#define GATT_CFG_NO_OPERATION           0x0000
+#define GATT_CLIENT_CFG_NOTIFY          0x0001
+#define GATT_CLIENT_CFG_INDICATE        0x0002
+
+#define GATT_INVALID_HANDLE             0x0000
+#define GATT_MIN_HANDLE                 0x0001
+#define GATT_MAX_HANDLE                 0xFFFF
+#define GATT_MAX_ENCRYPT_KEY_SIZE       16
+#define GATT_LOCAL_READ                 0xFF
+#define GATT_ALL_SERVICES               0xFFFFFFFF
+
+// OSAL event of GATT messages
+#define GATT_MSG_EVENT                  0xB0
+#define GATT_MAX_MTU                    0xFFFF
+
+// Task that is not notified of indication confirmations
+#define INVALID_TASK_ID                 0xFF
+
+// Characteristic presentation format
+#define GATT_FORMAT_UINT8               0x04
+#define GATT_NS_BT_SIG                  0x01
+
+// Connection handles
+#define CONNHANDLE_INVALID              0xFFFF
+#define INVALID_CONNHANDLE              0xFFFF
+#define LINKDB_CONNHANDLE_INVALID       0xFFFF
+#define CONNHANDLE_ALL                  0xFFFE
+#define LINKDB_CONNHANDLE_ALL           0xFFFE
+
+// linkDB states
+#define LINK_NOT_CONNECTED              0x00
+#define LINK_CONNECTED                  0x01
+
+// Gap_RegisterConnEventCb actions
+#define GAP_CB_REGISTER                 0x01
+#define GAP_CB_UNREGISTER               0x00
+
+// Base 128-bit UUID: F000XXXX-0451-4000-B000-000000000000
+#define TI_BASE_UUID_128( uuid )  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB0, \
+                                  0x00, 0x40, 0x51, 0x04, LO_UINT16( uuid ), HI_UINT16( uuid ), 0x00, 0xF0
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define GATT_NUM_ATTRS( attrs )   ( sizeof( attrs ) / sizeof( gattAttribute_t ) )
+
+#define GATT_SERVICE_HANDLE( attrs )  ( (attrs)[0].handle )
+
+// The CCC attribute value is a pointer to the CCC table
+#define GATT_CCC_TBL( pValue )    ( (gattCharCfg_t *)(*((uintptr_t *)(pValue))) )
+
+#define linkDB_Up( connHandle )   linkDB_State( (connHandle), LINK_CONNECTED )
+
+#define gattPermitAuthorRead( a )   ( (a) & GATT_PERMIT_AUTHOR_READ )
+#define gattPermitAuthorWrite( a )  ( (a) & GATT_PERMIT_AUTHOR_WRITE )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint8 len;
+  const uint8 *uuid;
+} gattAttrType_t;
+
+typedef struct attAttribute_t
+{
+  gattAttrType_t type;
+  uint8 permissions;
+  uint16 handle;
+  uint8 *pValue;
+} gattAttribute_t;
+
+typedef struct
+{
+  uint16 connHandle;
+  uint8  value;
+} gattCharCfg_t;
+
+typedef struct
+{
+  uint8 format;
+  int8 exponent;
+  uint16 unit;
+  uint8 nameSpace;
+  uint16 desc;
+} gattCharFormat_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 len;
+  uint8 *pValue;
+} attHandleValueNoti_t;
+
+typedef attHandleValueNoti_t attHandleValueInd_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 len;
+  uint8 *pValue;
+  uint8 sig;
+  uint8 cmd;
+} attWriteReq_t;
+
+typedef union
+{
+  attHandleValueNoti_t handleValueNoti;
+  attHandleValueInd_t  handleValueInd;
+  attWriteReq_t        writeReq;
+} gattMsg_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint16 connHandle;
+  uint8 method;
+  gattMsg_t msg;
+} gattMsgEvent_t;
+
+typedef bStatus_t (*pfnGATTReadAttrCB_t)( uint16 connHandle, gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint16 *pLen, uint16 offset,
+                                          uint16 maxLen, uint8 method );
+
+typedef bStatus_t (*pfnGATTWriteAttrCB_t)( uint16 connHandle, gattAttribute_t *pAttr,
+                                           uint8 *pValue, uint16 len, uint16 offset,
+                                           uint8 method );
+
+typedef bStatus_t (*pfnGATTAuthorizeAttrCB_t)( uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 opcode );
+
+typedef struct
+{
+  pfnGATTReadAttrCB_t      pfnReadAttrCB;
+  pfnGATTWriteAttrCB_t     pfnWriteAttrCB;
+  pfnGATTAuthorizeAttrCB_t pfnAuthorizeAttrCB;
+} gattServiceCBs_t;
+
+typedef struct
+{
+  uint8  stateFlags;
+  uint8  addrType;
+  uint8  addr[B_ADDR_LEN];
+  uint16 connInterval;
+  uint16 connLatency;
+  uint16 connTimeout;
+  uint16 MTU;
+} linkDBInfo_t;
+
+typedef struct
+{
+  uint8  status;
+  uint16 handle;
+  uint8  channel;
+  uint8  phy;
+  int8   lastRssi;
+  uint16 packets;
+  uint16 errors;
+  uint8  nextTaskType;
+  uint32 nextTaskTime;
+  uint16 eventCounter;
+  uint32 timeStamp;
+  uint8  eventType;
+} Gap_ConnEventRpt_t;
+
+typedef void (*pfnGapConnEvtCB_t)( Gap_ConnEventRpt_t *pReport );
+
+/*********************************************************************
+ * VARIABLES
+ */
+
+// Number of connections the stack supports
+extern uint8 linkDBNumConns;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+// linkDB
+extern uint8     linkDB_State( uint16 connectionHandle, uint8 state );
+extern uint8     linkDB_NumActive( void );
+extern bStatus_t linkDB_GetInfo( uint16 connectionHandle, linkDBInfo_t *pInfo );
+
+// GATT
+extern void     *GATT_bm_alloc( uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc );
+extern void      GATT_bm_free( gattMsg_t *pMsg, uint8 opcode );
+extern bStatus_t GATT_Notification( uint16 connHandle, attHandleValueNoti_t *pNoti, uint8 authenticated );
+extern bStatus_t GATT_Indication( uint16 connHandle, attHandleValueInd_t *pInd,
+                                  uint8 authenticated, uint8 taskId );
+extern bStatus_t GATT_WriteNoRsp( uint16 connHandle, attWriteReq_t *pReq );
+extern void      GATT_InitClient( void );
+extern void      GATT_RegisterForMsgs( uint8 taskId );
+
+// GATTServApp
+extern bStatus_t GATTServApp_AddService( uint32 services );
+extern bStatus_t GATTServApp_RegisterService( gattAttribute_t *pAttrs, uint16 numAttrs,
+                                              uint8 encKeySize, CONST gattServiceCBs_t *pServiceCBs );
+extern bStatus_t GATTServApp_DeregisterService( uint16 handle, gattAttribute_t **p2pAttrs );
+extern gattAttribute_t *GATTServApp_FindAttr( gattAttribute_t *pAttrTbl, uint16 numAttrs,
+                                              uint8 *pValue );
+extern void      GATTServApp_InitCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl );
+extern uint16    GATTServApp_ReadCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl );
+extern uint8     GATTServApp_WriteCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl, uint16 value );
+extern bStatus_t GATTServApp_ProcessCCCWriteReq( uint16 connHandle, gattAttribute_t *pAttr,
+                                                 uint8 *pValue, uint16 len, uint16 offset,
+                                                 uint16 validCfg );
+extern bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                             uint8 authenticated, gattAttribute_t *attrTbl,
+                                             uint16 numAttrs, uint8 taskId,
+                                             pfnGATTReadAttrCB_t pfnReadAttrCB );
+
+// GAP
+extern bStatus_t Gap_RegisterConnEventCb( pfnGapConnEvtCB_t cb, uint8 action, uint16 connHandle );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ICALLBLEAPI_H */
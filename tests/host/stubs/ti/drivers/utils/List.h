@@ -0,0 +1,97 @@
+/**********************************************************************************************
+ * Filename:       List.h
+ *
+ * Description:    Host build stand-in for the TI driver List utility, with the
+ *                 same API and semantics.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef ti_drivers_utils_List__include
+#define ti_drivers_utils_List__include
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct List_Elem {
+    struct List_Elem *next;
+    struct List_Elem *prev;
+} List_Elem;
+
+typedef struct List_List {
+    List_Elem *head;
+    List_Elem *tail;
+} List_List;
+
+extern void       List_clearList(List_List *list);
+extern List_Elem *List_get(List_List *list);
+extern void       List_insert(List_List *list, List_Elem *newElem, List_Elem *curElem);
+extern void       List_put(List_List *list, List_Elem *elem);
+extern void       List_putHead(List_List *list, List_Elem *elem);
+extern void       List_remove(List_List *list, List_Elem *elem);
+
+static inline bool List_empty(List_List *list)
+{
+    return (list->head == NULL);
+}
+
+static inline List_Elem *List_head(List_List *list)
+{
+    return (list->head);
+}
+
+static inline List_Elem *List_next(List_Elem *elem)
+{
+    return (elem->next);
+}
+
+static inline List_Elem *List_prev(List_Elem *elem)
+{
+    return (elem->prev);
+}
+
+static inline List_Elem *List_tail(List_List *list)
+{
+    return (list->tail);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ti_drivers_utils_List__include */
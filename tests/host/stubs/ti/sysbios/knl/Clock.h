@@ -0,0 +1,66 @@
+/**********************************************************************************************
+ * Filename:       Clock.h
+ *
+ * Description:    Host build stand-in for the TI-RTOS Clock module, simulated by
+ *                 sim/rtos_sim.c. Clocks are started and stopped but never expire.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef ti_sysbios_knl_Clock__include
+#define ti_sysbios_knl_Clock__include
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <xdc/std.h>
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct Clock_Struct
+{
+    Clock_FuncPtr fxn;
+    UArg          arg;
+    uint32_t      timeout;      // Ticks until the clock fires
+    uint32_t      period;       // Ticks between firings, 0 for one-shot
+    bool          active;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+// Microseconds per clock tick
+extern uint32_t Clock_tickPeriod;
+
+extern uint32_t Clock_getTicks(void);
+extern void     Clock_destruct(Clock_Struct *pClock);
+
+#endif /* ti_sysbios_knl_Clock__include */
@@ -0,0 +1,70 @@
+/**********************************************************************************************
+ * Filename:       Event.h
+ *
+ * Description:    Host build stand-in for the TI-RTOS Event module, simulated by
+ *                 sim/rtos_sim.c. Events are only posted and collected, nothing pends.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef ti_sysbios_knl_Event__include
+#define ti_sysbios_knl_Event__include
+
+#include <stdint.h>
+#include <xdc/std.h>
+
+#define Event_Id_NONE       0
+#define Event_Id_00         (1UL << 0)
+#define Event_Id_01         (1UL << 1)
+#define Event_Id_02         (1UL << 2)
+#define Event_Id_03         (1UL << 3)
+#define Event_Id_30         (1UL << 30)
+#define Event_Id_31         (1UL << 31)
+
+typedef struct Event_Struct
+{
+    uint32_t posted;
+} Event_Struct;
+
+typedef Event_Struct *Event_Handle;
+
+extern void     Event_post(Event_Handle handle, uint32_t eventMask);
+
+/*
+ * Event_pend - Returns and clears the posted events of orMask without
+ *              blocking. The andMask and timeout are ignored.
+ */
+extern uint32_t Event_pend(Event_Handle handle, uint32_t andMask,
+                           uint32_t orMask, uint32_t timeout);
+
+#endif /* ti_sysbios_knl_Event__include */
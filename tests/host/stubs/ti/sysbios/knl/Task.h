@@ -0,0 +1,64 @@
+/**********************************************************************************************
+ * Filename:       Task.h
+ *
+ * Description:    Host build stand-in for the TI-RTOS Task module. Tasks are never run on
+ *                 the host; the host program calls the application functions itself.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef ti_sysbios_knl_Task__include
+#define ti_sysbios_knl_Task__include
+
+#include <stddef.h>
+#include <xdc/std.h>
+
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct Task_Params
+{
+    void   *stack;
+    size_t  stackSize;
+    int     priority;
+} Task_Params;
+
+typedef struct Task_Struct
+{
+    Task_FuncPtr fxn;
+} Task_Struct;
+
+extern void Task_Params_init(Task_Params *pParams);
+extern void Task_construct(Task_Struct *pTask, Task_FuncPtr fxn,
+                           const Task_Params *pParams, void *pEb);
+
+#endif /* ti_sysbios_knl_Task__include */
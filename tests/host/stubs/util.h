@@ -0,0 +1,73 @@
+/**********************************************************************************************
+ * Filename:       util.h
+ *
+ * Description:    Host build stand-in for the SDK application util.h. The clock and queue
+ *                 helpers used by the applications built on the host are simulated by
+ *                 sim/rtos_sim.c.
+ *
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************************************/
+
+
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/knl/Queue.h>
+#include <ti/drivers/utils/List.h>
+
+// Event posted when a message is queued for the application
+#define UTIL_QUEUE_EVENT_ID         Event_Id_30
+
+// Header of a message queued for the application
+typedef struct
+{
+    uint8_t event;
+    uint8_t state;
+} appEvtHdr_t;
+
+extern Clock_Struct *Util_constructClock(Clock_Struct *pClock, Clock_FuncPtr clockCB,
+                                         uint32_t clockDuration, uint32_t clockPeriod,
+                                         uint8_t startFlag, UArg arg);
+extern void          Util_startClock(Clock_Struct *pClock);
+extern void          Util_stopClock(Clock_Struct *pClock);
+extern bool          Util_isActive(Clock_Struct *pClock);
+
+extern Queue_Handle  Util_constructQueue(Queue_Struct *pQueue);
+extern uint8_t       Util_enqueueMsg(Queue_Handle msgQueue, Event_Handle event, uint8_t *pMsg);
+extern uint8_t      *Util_dequeueMsg(Queue_Handle msgQueue);
+
+#endif /* UTIL_H */